@@ -34,6 +34,16 @@ static struct Options
     bool disableCmd{};
 } g_options{};
 
+static rls::ELinkTransport ReadLinkTransport(const YAML::Node &config)
+{
+    std::string transport = yaml::GetString(config, "linkTransport");
+    if (transport == "udp")
+        return rls::ELinkTransport::UDP;
+    if (transport == "shm")
+        return rls::ELinkTransport::SHARED_MEMORY;
+    throw std::runtime_error("Invalid linkTransport: " + transport);
+}
+
 static nr::gnb::GnbConfig *ReadConfigYaml()
 {
     auto *result = new nr::gnb::GnbConfig();
@@ -56,6 +66,8 @@ static nr::gnb::GnbConfig *ReadConfigYaml()
         result->gtpAdvertiseIp = yaml::GetIpAddress(config, "gtpAdvertiseIp");
 
     result->ignoreStreamIds = yaml::GetBool(config, "ignoreStreamIds");
+    if (yaml::HasField(config, "linkTransport"))
+        result->linkTransport = ReadLinkTransport(config);
     result->pagingDrx = EPagingDrx::V128;
     result->name = "UERANSIM-gnb-" + std::to_string(result->plmn.mcc) + "-" + std::to_string(result->plmn.mnc) + "-" +
                    std::to_string(result->getGnbId()); // NOTE: Avoid using "/" dir separator character.
@@ -154,6 +154,10 @@ void GnbCmdHandler::handleCmdImpl(NmGnbCliCommand &msg)
         }
         break;
     }
+    case app::GnbCliCommand::MAC_STATS: {
+        sendError(msg.address, "MAC scheduling is not supported");
+        break;
+    }
     }
 }
 
@@ -245,7 +245,7 @@ void RlsControlTask::onAckSendTimerExpired()
 
     for (auto &item : copy)
     {
-        if (!item.second.empty())
+        if (item.second.empty())
             continue;
 
         rls::RlsPduTransmissionAck msg{m_sti};
@@ -11,7 +11,6 @@
 #include <cmath>
 #include <cstdint>
 #include <cstring>
-#include <set>
 
 #include <gnb/nts.hpp>
 #include <utils/common.hpp>
@@ -20,9 +19,8 @@
 
 static constexpr const int BUFFER_SIZE = 16384;
 
-static constexpr const int LOOP_PERIOD = 1000;
 static constexpr const int RECEIVE_TIMEOUT = 200;
-static constexpr const int HEARTBEAT_THRESHOLD = 2000; // (LOOP_PERIOD + RECEIVE_TIMEOUT)'dan büyük olmalı
+static constexpr const int LIVENESS_TICK = 100; // granularity of the heartbeat timeouts
 
 static constexpr const int MIN_ALLOWED_DBM = -120;
 
@@ -42,13 +40,15 @@ namespace nr::gnb
 {
 
 RlsUdpTask::RlsUdpTask(TaskBase *base, uint64_t sti, Vector3 phyLocation)
-    : m_server{}, m_ctlTask{}, m_sti{sti}, m_phyLocation{phyLocation}, m_lastLoop{}, m_stiToUe{}, m_ueMap{}, m_newIdCounter{}
+    : m_transport{}, m_ctlTask{}, m_sti{sti}, m_phyLocation{phyLocation}, m_now{}, m_stiToUe{},
+      m_ueMap{}, m_ueAddresses{}, m_ueIds{},
+      m_liveness{LIVENESS_TICK, rls::HeartbeatTimeout(rls::HEARTBEAT_MAX_INTERVAL)}, m_lostUes{}, m_newIdCounter{}
 {
     m_logger = base->logBase->makeUniqueLogger("rls-udp");
 
     try
     {
-        m_server = new udp::UdpServer(base->config->linkIp, cons::RadioLinkPort);
+        m_transport = rls::RlsTransport::Create(base->config->linkTransport, base->config->linkIp, cons::RadioLinkPort);
     }
     catch (const LibError &e)
     {
@@ -64,17 +64,15 @@ void RlsUdpTask::onStart()
 
 void RlsUdpTask::onLoop()
 {
-    auto current = utils::CurrentTimeMillis();
-    if (current - m_lastLoop > LOOP_PERIOD)
-    {
-        m_lastLoop = current;
-        heartbeatCycle(current);
-    }
-
     uint8_t buffer[BUFFER_SIZE];
     InetAddress peerAddress;
 
-    int size = m_server->Receive(buffer, BUFFER_SIZE, RECEIVE_TIMEOUT, peerAddress);
+    int size = m_transport->receive(buffer, BUFFER_SIZE, RECEIVE_TIMEOUT, peerAddress);
+
+    // A single clock read per loop, for the liveness of both the lost UEs and the sender
+    m_now = utils::CurrentTimeMillis();
+    heartbeatCycle(m_now);
+
     if (size > 0)
     {
         auto rlsMsg = rls::DecodeRlsMessage(OctetView{buffer, static_cast<size_t>(size)});
@@ -87,94 +85,147 @@ void RlsUdpTask::onLoop()
 
 void RlsUdpTask::onQuit()
 {
-    delete m_server;
+    m_transport.reset();
 }
 
 void RlsUdpTask::receiveRlsPdu(const InetAddress &addr, std::unique_ptr<rls::RlsMessage> &&msg)
 {
     if (msg->msgType == rls::EMessageType::HEARTBEAT)
     {
-        int dbm = EstimateSimulatedDbm(m_phyLocation, ((const rls::RlsHeartBeat &)*msg).simPos);
+        auto &heartbeat = (const rls::RlsHeartBeat &)*msg;
+
+        int dbm = EstimateSimulatedDbm(m_phyLocation, heartbeat.simPos);
         if (dbm < MIN_ALLOWED_DBM)
         {
             // if the simulated signal strength is such low, then ignore this message
             return;
         }
 
-        if (m_stiToUe.count(msg->sti))
-        {
-            int ueId = m_stiToUe[msg->sti];
-            m_ueMap[ueId].address = addr;
-            m_ueMap[ueId].lastSeen = utils::CurrentTimeMillis();
-        }
-        else
-        {
-            int ueId = ++m_newIdCounter;
-
-            m_stiToUe[msg->sti] = ueId;
-            m_ueMap[ueId].address = addr;
-            m_ueMap[ueId].lastSeen = utils::CurrentTimeMillis();
-
-            auto w = std::make_unique<NmGnbRlsToRls>(NmGnbRlsToRls::SIGNAL_DETECTED);
-            w->ueId = ueId;
-            m_ctlTask->push(std::move(w));
-        }
+        handleHeartbeat(addr, msg->sti, heartbeat.interval);
 
         rls::RlsHeartBeatAck ack{m_sti};
         ack.dbm = dbm;
 
-        sendRlsPdu(addr, ack);
+        sendRlsPdu(addr, ack, msg->sti);
         return;
     }
 
-    if (!m_stiToUe.count(msg->sti))
+    if (msg->msgType == rls::EMessageType::HEARTBEAT_AGGREGATE)
+    {
+        // Heartbeats of the UEs of a single process, acknowledged together
+        rls::RlsHeartBeatAckAggregate ack{m_sti};
+        for (auto &entry : ((const rls::RlsHeartBeatAggregate &)*msg).entries)
+        {
+            int dbm = EstimateSimulatedDbm(m_phyLocation, entry.simPos);
+            if (dbm < MIN_ALLOWED_DBM)
+                continue;
+
+            handleHeartbeat(addr.withPort(entry.port), entry.sti, entry.interval);
+            ack.entries.push_back(rls::RlsHeartBeatAckEntry{entry.sti, dbm});
+        }
+
+        if (!ack.entries.empty())
+            sendRlsPdu(addr, ack, 0);
+        return;
+    }
+
+    auto sti = m_stiToUe.find(msg->sti);
+
+    if (sti == m_stiToUe.end())
     {
         // if no HB received yet, and the message is not HB, then ignore the message
         return;
     }
 
+    // Any traffic of the UE keeps it alive
+    int ueId = sti->second;
+    auto &ue = m_ueMap[ueId];
+    m_liveness.refresh(ue.liveness, m_now, ue.timeout);
+
     auto w = std::make_unique<NmGnbRlsToRls>(NmGnbRlsToRls::RECEIVE_RLS_MESSAGE);
-    w->ueId = m_stiToUe[msg->sti];
+    w->ueId = ueId;
     w->msg = std::move(msg);
     m_ctlTask->push(std::move(w));
 }
 
-void RlsUdpTask::sendRlsPdu(const InetAddress &addr, const rls::RlsMessage &msg)
+int RlsUdpTask::handleHeartbeat(const InetAddress &addr, uint64_t sti, int interval)
+{
+    int64_t timeout = rls::HeartbeatTimeout(interval);
+
+    auto it = m_stiToUe.find(sti);
+    if (it != m_stiToUe.end())
+    {
+        int ueId = it->second;
+
+        auto &ue = m_ueMap[ueId];
+        ue.address = addr;
+        ue.timeout = timeout;
+        m_ueAddresses[ue.index] = addr;
+        m_liveness.refresh(ue.liveness, m_now, timeout);
+        return ueId;
+    }
+
+    int ueId = ++m_newIdCounter;
+    m_stiToUe.emplace(sti, ueId);
+
+    auto &ue = m_ueMap[ueId];
+    ue.sti = sti;
+    ue.address = addr;
+    ue.timeout = timeout;
+    ue.index = m_ueAddresses.size();
+    ue.liveness = m_liveness.add(ueId, m_now, timeout);
+    m_ueAddresses.push_back(addr);
+    m_ueIds.push_back(ueId);
+
+    auto w = std::make_unique<NmGnbRlsToRls>(NmGnbRlsToRls::SIGNAL_DETECTED);
+    w->ueId = ueId;
+    m_ctlTask->push(std::move(w));
+    return ueId;
+}
+
+void RlsUdpTask::sendRlsPdu(const InetAddress &addr, const rls::RlsMessage &msg, uint64_t destination)
 {
     OctetString stream;
     rls::EncodeRlsMessage(msg, stream);
 
-    m_server->Send(addr, stream.data(), static_cast<size_t>(stream.length()));
+    // UEs of an nr-ue process may share a single end-point, which demultiplexes by the destination
+    if (destination != 0)
+        rls::EncodeRlsDestinationBlock(destination, stream);
+
+    m_transport->send(addr, stream.data(), static_cast<size_t>(stream.length()));
 }
 
 void RlsUdpTask::heartbeatCycle(int64_t time)
 {
-    std::set<int> lostUeId{};
-    std::set<uint64_t> lostSti{};
+    m_lostUes.clear();
+    m_liveness.expire(time, m_lostUes);
 
-    for (auto &item : m_ueMap)
+    for (int ueId : m_lostUes)
     {
-        if (time - item.second.lastSeen > HEARTBEAT_THRESHOLD)
-        {
-            lostUeId.insert(item.first);
-            lostSti.insert(item.second.sti);
-        }
-    }
-
-    for (uint64_t sti : lostSti)
-        m_stiToUe.erase(sti);
-
-    for (int ueId : lostUeId)
-        m_ueMap.erase(ueId);
+        removeUe(ueId);
 
-    for (int ueId : lostUeId)
-    {
         auto w = std::make_unique<NmGnbRlsToRls>(NmGnbRlsToRls::SIGNAL_LOST);
         w->ueId = ueId;
         m_ctlTask->push(std::move(w));
     }
 }
 
+void RlsUdpTask::removeUe(int ueId)
+{
+    // The last entry takes the place of the removed one, so that the address list stays contiguous
+    auto &ue = m_ueMap[ueId];
+    size_t index = ue.index;
+    m_stiToUe.erase(ue.sti);
+
+    m_ueAddresses[index] = m_ueAddresses.back();
+    m_ueIds[index] = m_ueIds.back();
+    m_ueMap[m_ueIds[index]].index = index;
+
+    m_ueAddresses.pop_back();
+    m_ueIds.pop_back();
+    m_ueMap.erase(ueId);
+}
+
 void RlsUdpTask::initialize(NtsTask *ctlTask)
 {
     m_ctlTask = ctlTask;
@@ -184,8 +235,11 @@ void RlsUdpTask::send(int ueId, const rls::RlsMessage &msg)
 {
     if (ueId == 0)
     {
-        for (auto &ue : m_ueMap)
-            send(ue.first, msg);
+        // Encoded once for all UEs
+        OctetString stream;
+        rls::EncodeRlsMessage(msg, stream);
+
+        m_transport->sendBatch(m_ueAddresses, stream.data(), static_cast<size_t>(stream.length()));
         return;
     }
 
@@ -195,7 +249,7 @@ void RlsUdpTask::send(int ueId, const rls::RlsMessage &msg)
         return;
     }
 
-    sendRlsPdu(m_ueMap[ueId].address, msg);
+    sendRlsPdu(m_ueMap[ueId].address, msg, m_ueMap[ueId].sti);
 }
 
 } // namespace nr::gnb
@@ -9,12 +9,15 @@
 #pragma once
 
 #include <cstdint>
+#include <memory>
 #include <unordered_map>
 #include <vector>
 
 #include <gnb/types.hpp>
+#include <lib/rls/rls_heartbeat.hpp>
+#include <lib/rls/rls_liveness.hpp>
 #include <lib/rls/rls_pdu.hpp>
-#include <lib/udp/server.hpp>
+#include <lib/rls/rls_transport.hpp>
 #include <utils/nts.hpp>
 
 namespace nr::gnb
@@ -27,18 +30,24 @@ class RlsUdpTask : public NtsTask
     {
         uint64_t sti{};
         InetAddress address;
-        int64_t lastSeen{};
+        size_t index{};    // in m_ueAddresses
+        size_t liveness{}; // handle in m_liveness
+        int64_t timeout{}; // of the liveness, by the heartbeat interval of the UE
     };
 
   private:
     std::unique_ptr<Logger> m_logger;
-    udp::UdpServer *m_server;
+    std::unique_ptr<rls::RlsTransport> m_transport;
     NtsTask *m_ctlTask;
     uint64_t m_sti;
     Vector3 m_phyLocation;
-    int64_t m_lastLoop;
+    int64_t m_now; // time of the current loop
     std::unordered_map<uint64_t, int> m_stiToUe;
     std::unordered_map<int, UeInfo> m_ueMap;
+    std::vector<InetAddress> m_ueAddresses; // broadcast targets, contiguous for a single batch send
+    std::vector<int> m_ueIds;               // UE of each entry of m_ueAddresses
+    rls::LivenessWheel m_liveness;
+    std::vector<int> m_lostUes; // reused by each heartbeat cycle
     int m_newIdCounter;
 
   public:
@@ -52,8 +61,10 @@ class RlsUdpTask : public NtsTask
 
   private:
     void receiveRlsPdu(const InetAddress &addr, std::unique_ptr<rls::RlsMessage> &&msg);
-    void sendRlsPdu(const InetAddress &addr, const rls::RlsMessage &msg);
+    int handleHeartbeat(const InetAddress &addr, uint64_t sti, int interval);
+    void sendRlsPdu(const InetAddress &addr, const rls::RlsMessage &msg, uint64_t destination);
     void heartbeatCycle(int64_t time);
+    void removeUe(int ueId);
 
   public:
     void initialize(NtsTask *ctlTask);
@@ -12,6 +12,7 @@
 
 #include <lib/app/monitor.hpp>
 #include <lib/asn/utils.hpp>
+#include <lib/rls/rls_transport.hpp>
 #include <utils/common_types.hpp>
 #include <utils/logger.hpp>
 #include <utils/network.hpp>
@@ -314,6 +315,7 @@ struct GnbConfig
     std::string gtpIp{};
     std::optional<std::string> gtpAdvertiseIp{};
     bool ignoreStreamIds{};
+    rls::ELinkTransport linkTransport{};
 
     /* Assigned by program */
     std::string name{};
@@ -9,6 +9,7 @@
 #include "eea3.hpp"
 #include "zuc.hpp"
 
+#include <cstring>
 #include <endian.h>
 #include <vector>
 
@@ -64,9 +65,11 @@ uint32_t EIA3(const uint8_t *pKey, uint32_t count, uint32_t direction, uint32_t
     z = new uint32_t[L];
     ZUC(pKey, IV, z, L);
 
+    // The message may end in the middle of a word, only its own bytes are read
     std::vector<uint32_t> data_htobe32(length / 32 + 1);
+    std::memcpy(data_htobe32.data(), pData, (length + 7) / 8);
     for (uint32_t j = 0; j < (length + 31) / 32; j++)
-        data_htobe32[j] = htobe32(pData[j]);
+        data_htobe32[j] = htobe32(data_htobe32[j]);
 
     T = 0;
     for (i = 0; i < length; i++)
@@ -111,8 +114,18 @@ void EEA3(const uint8_t *pKey, uint32_t count, uint32_t bearer, uint32_t directi
     iv[15] = iv[7];
 
     ZUC(pKey, iv, z, L);
-    for (i = 0; i < L; i++)
+    for (i = 0; i + 1 < L; i++)
         pData[i] = be32toh(htobe32(pData[i]) ^ z[i]);
+
+    // The last word may be partial, the bytes after the message are not touched
+    if (L > 0)
+    {
+        uint32_t last = 0;
+        size_t tail = (length + 7) / 8 - 4 * (L - 1);
+        std::memcpy(&last, pData + L - 1, tail);
+        last = be32toh(htobe32(last) ^ z[L - 1]);
+        std::memcpy(pData + L - 1, &last, tail);
+    }
     delete[] z;
 }
 
@@ -77,18 +77,50 @@ static uint8_t MULxPOW(uint8_t V, uint8_t i, uint8_t c)
         return MULx(MULxPOW(V, i - 1, c), c);
 }
 
-static uint32_t MULalpha(uint8_t c)
+static uint32_t ComputeMULalpha(uint8_t c)
 {
     return ((((uint32_t)MULxPOW(c, 23, 0xa9)) << 24) | (((uint32_t)MULxPOW(c, 245, 0xa9)) << 16) |
             (((uint32_t)MULxPOW(c, 48, 0xa9)) << 8) | (((uint32_t)MULxPOW(c, 239, 0xa9))));
 }
 
-static uint32_t DIValpha(uint8_t c)
+static uint32_t ComputeDIValpha(uint8_t c)
 {
     return ((((uint32_t)MULxPOW(c, 16, 0xa9)) << 24) | (((uint32_t)MULxPOW(c, 39, 0xa9)) << 16) |
             (((uint32_t)MULxPOW(c, 6, 0xa9)) << 8) | (((uint32_t)MULxPOW(c, 64, 0xa9))));
 }
 
+// MULalpha and DIValpha are needed at every clock of the LFSR, they are computed once for all byte values
+struct AlphaTables
+{
+    uint32_t mul[256];
+    uint32_t div[256];
+
+    AlphaTables() : mul{}, div{}
+    {
+        for (int i = 0; i < 256; i++)
+        {
+            mul[i] = ComputeMULalpha(static_cast<uint8_t>(i));
+            div[i] = ComputeDIValpha(static_cast<uint8_t>(i));
+        }
+    }
+};
+
+static const AlphaTables &GetAlphaTables()
+{
+    static const AlphaTables tables{};
+    return tables;
+}
+
+static uint32_t MULalpha(uint8_t c)
+{
+    return GetAlphaTables().mul[c];
+}
+
+static uint32_t DIValpha(uint8_t c)
+{
+    return GetAlphaTables().div[c];
+}
+
 static uint32_t S1(uint32_t w)
 {
     uint8_t r0 = 0, r1 = 0, r2 = 0, r3 = 0;
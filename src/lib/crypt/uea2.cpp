@@ -27,13 +27,10 @@ void crypto::uea2::F8(const u8 *pKey, u32 count, u32 bearer, u32 dir, u8 *pData,
     crypto::snow3g::Initialize(K, IV);
     KS = new u32[n];
     crypto::snow3g::GenerateKeyStream((u32 *)KS, n);
-    for (int i = 0; i < n; i++)
-    {
-        pData[4 * i + 0] ^= (u8)(KS[i] >> 24) & 0xff;
-        pData[4 * i + 1] ^= (u8)(KS[i] >> 16) & 0xff;
-        pData[4 * i + 2] ^= (u8)(KS[i] >> 8) & 0xff;
-        pData[4 * i + 3] ^= (u8)(KS[i]) & 0xff;
-    }
+    // The last word may be partial, the bytes after the message are not touched
+    u32 bytes = (length + 7) / 8;
+    for (u32 i = 0; i < bytes; i++)
+        pData[i] ^= (u8)(KS[i / 4] >> (24 - 8 * (i % 4))) & 0xff;
     delete[] KS;
 }
 
@@ -45,20 +42,16 @@ static u64 MUL64x(u64 V, u64 c)
         return V << 1;
 }
 
-static u64 MUL64xPOW(u64 V, u8 i, u64 c)
-{
-    if (i == 0)
-        return V;
-    else
-        return MUL64x(MUL64xPOW(V, i - 1, c), c);
-}
-
 static u64 MUL64(u64 V, u64 P, u64 c)
 {
+    // V * x^i is carried from one bit of P to the next instead of being recomputed for each of them
     u64 result = 0;
     for (int i = 0; i < 64; i++)
+    {
         if ((P >> i) & 0x1)
-            result ^= MUL64xPOW(V, i, c);
+            result ^= V;
+        V = MUL64x(V, c);
+    }
     return result;
 }
 
@@ -134,6 +134,31 @@ AmdPdu *RlcEncoder::DecodeAmd(uint8_t *data, int size, bool isShortSn)
     return pdu;
 }
 
+bool RlcEncoder::DecodeAmdHeader(const uint8_t *data, int size, bool isShortSn, AmdHeader &header)
+{
+    if (size < 1 || data[0] >> 7 != 1)
+        return false;
+
+    uint8_t octet = data[0];
+    header.p = (octet >> 6) & 0b1;
+    header.si = static_cast<ESegmentInfo>(bits::BitRange8<4, 5>(octet));
+    header.so = 0;
+    header.size = (isShortSn ? 2 : 3) + (si::requiresSo(header.si) ? 2 : 0);
+
+    if (size < header.size)
+        return false;
+
+    header.sn = isShortSn ? bits::BitRange8<0, 3>(octet) : bits::BitRange8<0, 1>(octet);
+    header.sn = (header.sn << 8) | data[1];
+    if (!isShortSn)
+        header.sn = (header.sn << 8) | data[2];
+
+    if (si::requiresSo(header.si))
+        header.so = (data[header.size - 2] << 8) | data[header.size - 1];
+
+    return true;
+}
+
 int RlcEncoder::EncodeAmd(uint8_t *buffer, bool isShortSn, ESegmentInfo si, int so, int sn, uint8_t *data, int size,
                           bool p)
 {
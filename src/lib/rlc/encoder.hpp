@@ -20,6 +20,7 @@ class RlcEncoder
     static int EncodeUmd(uint8_t *buffer, bool isShortSn, ESegmentInfo si, int so, int sn, uint8_t *data, int size);
 
     static AmdPdu *DecodeAmd(uint8_t *data, int size, bool isShortSn);
+    static bool DecodeAmdHeader(const uint8_t *data, int size, bool isShortSn, AmdHeader &header);
     static int EncodeAmd(uint8_t *buffer, bool isShortSn, ESegmentInfo si, int so, int sn, uint8_t *data, int size,
                          bool p);
 
@@ -10,13 +10,28 @@
 #include "encoder.hpp"
 #include "func.hpp"
 
+#include <algorithm>
 #include <cassert>
+#include <limits>
 
-#define REASSEMBLE_BUFFER_LEN 32768
+static constexpr const int INITIAL_WINDOW_CAPACITY = 64;
+static constexpr const int MAX_SPARE_BUFFERS = 256;
+static constexpr const int MAX_SDU_SIZE = 0xFFFF; // SO is 16-bit
+static constexpr const int STATUS_HEADER_SIZE = 3;
 
 namespace rlc
 {
 
+static int NackBlockSize(const NackBlock &block, bool isShortSn)
+{
+    int size = isShortSn ? 2 : 3;
+    if (block.soStart != -1)
+        size += 4;
+    if (block.nackRange != -1)
+        size += 1;
+    return size;
+}
+
 //======================================================================================================
 //                                     INITIALIZATION RELATED
 //======================================================================================================
@@ -26,19 +41,17 @@ AmEntity::AmEntity(IRlcConsumer *consumer, int snLength, int txMaxSize, int rxMa
     : IRlcEntity(consumer), snLength(snLength), snModulus(1 << snLength), windowSize((1 << snLength) / 2),
       txMaxSize(txMaxSize), rxMaxSize(rxMaxSize), pollPdu(pollPdu), pollByte(pollByte),
       maxRetThreshold(maxRetThreshold), txNext(0), txNextAck(0), pollSn(0), pduWithoutPoll(0), byteWithoutPoll(0),
-      txCurrentSize(0), txBuffer{}, rxCurrentSize(0), rxBuffer{}, retBuffer{}, waitBuffer{}, ackBuffer{}, rxNext(0),
-      rxNextHighest(0), rxHighestStatus(0), rxNextStatusTrigger(0), statusTriggered(false), forcePoll(false),
-      tCurrent(0), pollRetransmitTimer(pollRetransmitPeriod), reassemblyTimer(reassemblyPeriod),
-      statusProhibitTimer(statusProhibitPeriod)
+      txCurrentSize(0), txPendingBytes(0), txOffset(0), txPending{}, txWindow(INITIAL_WINDOW_CAPACITY), retQueue{},
+      spareBuffers{}, nackBitmap(static_cast<size_t>(windowSize / 64)), rxCurrentSize(0),
+      rxWindow(INITIAL_WINDOW_CAPACITY), rxNext(0), rxNextHighest(0), rxHighestStatus(0), rxNextStatusTrigger(0),
+      statusTriggered(false), forcePoll(false), status{}, tCurrent(0), pollRetransmitTimer(pollRetransmitPeriod),
+      reassemblyTimer(reassemblyPeriod), statusProhibitTimer(statusProhibitPeriod)
 {
     assert(snLength == 12 || snLength == 18);
     clearEntity();
 }
 
-AmEntity::~AmEntity()
-{
-    clearEntity();
-}
+AmEntity::~AmEntity() = default;
 
 void AmEntity::clearEntity()
 {
@@ -49,14 +62,15 @@ void AmEntity::clearEntity()
     byteWithoutPoll = 0;
 
     txCurrentSize = 0;
-    txBuffer.clearAndDelete();
+    txPendingBytes = 0;
+    txOffset = 0;
+    txPending.clear();
+    txWindow.reset(INITIAL_WINDOW_CAPACITY);
+    retQueue.clear();
+    std::fill(nackBitmap.begin(), nackBitmap.end(), 0);
 
     rxCurrentSize = 0;
-    rxBuffer.clearAndDelete();
-
-    retBuffer.clearAndDelete();
-    waitBuffer.clearAndDelete();
-    ackBuffer.clearAndDelete();
+    rxWindow.reset(INITIAL_WINDOW_CAPACITY);
 
     rxNext = 0;
     rxNextHighest = 0;
@@ -110,46 +124,46 @@ bool AmEntity::windowStalling()
 
 bool AmEntity::pollControlForTransmissionOrRetransmission()
 {
-    return (txBuffer.isEmpty() && retBuffer.isEmpty()) || windowStalling();
+    return (txPending.empty() && txOffset == 0 && retQueue.empty()) || windowStalling();
 }
 
 //======================================================================================================
 //                                              INTERNAL
 //======================================================================================================
 
-bool AmEntity::areAllSegmentsInAck(int sn)
+bool AmEntity::isDelivered(int sn)
 {
-    int ackCount = 0, refCount = -1;
+    auto &sdu = rxWindow[sn];
+    return sdu.inUse && sdu.sn == sn && sdu.delivered;
+}
 
-    auto cursor = ackBuffer.getFirst();
-    while (cursor != nullptr)
-    {
-        RlcSdu *sdu = cursor->value->sdu;
-        if (snCompareTx(sdu->sn, sn) > 0)
-            break;
-        if (snCompareTx(sdu->sn, sn) == 0)
-        {
-            if (refCount == -1)
-                refCount = sdu->_refCount;
-            ackCount++;
-        }
-        cursor = cursor->getNext();
-    }
+bool AmEntity::hasMissingSegment(int sn)
+{
+    // There is a missing byte segment before the last byte of all received segments of the SDU
+    auto &sdu = rxWindow[sn];
+    return sdu.inUse && sdu.sn == sn && !sdu.delivered && !sdu.received.empty() &&
+           (sdu.received.starts[0] > 0 || sdu.received.count > 1);
+}
 
-    return ackCount == refCount;
+bool AmEntity::isNacked(int sn)
+{
+    int bit = sn & (windowSize - 1);
+    return nackBitmap[bit >> 6] & (uint64_t{1} << (bit & 63));
 }
 
-int AmEntity::sduListCompare(const RlcSduSegment &a, const RlcSduSegment &b)
+bool AmEntity::testAndSetNacked(int sn)
 {
-    if (a.sdu->sn == b.sdu->sn)
-        return a.so - b.so;
-    return snCompareTx(a.sdu->sn, b.sdu->sn);
+    int bit = sn & (windowSize - 1);
+    uint64_t mask = uint64_t{1} << (bit & 63);
+    bool res = nackBitmap[bit >> 6] & mask;
+    nackBitmap[bit >> 6] |= mask;
+    return res;
 }
 
-void AmEntity::insertToList(LinkedList<RlcSduSegment> &list, RlcSduSegment *segment)
+void AmEntity::clearNacked(int sn)
 {
-    auto comp = [this](const RlcSduSegment &a, const RlcSduSegment &b) { return sduListCompare(a, b); };
-    func::InsertSortedLinkedList(list, segment, ILambdaComparator<RlcSduSegment, decltype(comp)>{comp});
+    int bit = sn & (windowSize - 1);
+    nackBitmap[bit >> 6] &= ~(uint64_t{1} << (bit & 63));
 }
 
 //======================================================================================================
@@ -163,9 +177,9 @@ void AmEntity::receivePdu(uint8_t *data, int size)
 
     if (data[0] >> 7)
     {
-        auto *pdu = RlcEncoder::DecodeAmd(data, size, snLength == 12);
-        if (pdu)
-            receiveAmdPdu(pdu);
+        AmdHeader header{};
+        if (RlcEncoder::DecodeAmdHeader(data, size, snLength == 12, header))
+            receiveAmdPdu(header, data + header.size, size - header.size);
     }
     else
     {
@@ -177,34 +191,36 @@ void AmEntity::receivePdu(uint8_t *data, int size)
 
         auto *pdu = RlcEncoder::DecodeStatus(data, size, snLength == 12);
         if (pdu)
-            receiveStatusPdu(pdu);
+        {
+            receiveStatusPdu(*pdu);
+            delete pdu;
+        }
     }
 }
 
-void AmEntity::receiveAmdPdu(AmdPdu *pdu)
+void AmEntity::receiveAmdPdu(const AmdHeader &header, const uint8_t *data, int size)
 {
     // 5.3.4 ... if the AMD PDU is to be discarded as specified in clause 5.2.3.2.2; or ....
-    auto discard = [this, pdu]() {
-        if (pdu->p)
+    auto discard = [this, &header]() {
+        if (header.p)
             statusTriggered = true;
-        delete pdu;
     };
 
-    if (si::requiresSo(pdu->si) && pdu->so == 0)
+    if (si::requiresSo(header.si) && header.so == 0)
     {
         // Bad SO value, discard PDU.
         discard();
         return;
     }
 
-    if (pdu->size == 0)
+    if (size == 0 || header.so + size > MAX_SDU_SIZE)
     {
-        // No data, discard PDU.
+        // No data or bytes beyond the largest SDU, discard PDU.
         discard();
         return;
     }
 
-    if (rxCurrentSize + pdu->size > rxMaxSize)
+    if (rxCurrentSize + size > rxMaxSize)
     {
         // No room in RX buffer, discard PDU.
         discard();
@@ -212,34 +228,59 @@ void AmEntity::receiveAmdPdu(AmdPdu *pdu)
     }
 
     // Discard if x falls outside of the receiving window
-    if (!isInReceiveWindow(pdu->sn))
+    if (!isInReceiveWindow(header.sn))
     {
         discard();
         return;
     }
 
+    rxWindow.reserve(rxNext, modulusRx(header.sn) + 1, snModulus);
+    auto &sdu = rxWindow[header.sn];
+    if (!sdu.inUse || sdu.sn != header.sn)
+    {
+        sdu.inUse = true;
+        sdu.delivered = false;
+        sdu.sn = header.sn;
+        sdu.size = -1;
+        sdu.buffered = 0;
+        sdu.received.clear();
+    }
+
     // if byte segment numbers y to z of the RLC SDU with SN = x have been received before:
     //  discard the received AMD PDU
-    if (func::IsAlreadyReceived(rxBuffer, pdu->sn, pdu->so, pdu->size))
+    int end = header.so + size;
+    if (sdu.delivered || sdu.received.covers(header.so, end))
+    {
+        discard();
+        return;
+    }
+
+    // An SDU received in more pieces than its inline segment list holds waits for the retransmission instead
+    if (!sdu.received.add(header.so, end))
     {
         discard();
         return;
     }
 
     // Place the received AMD PDU in the reception buffer
-    rxCurrentSize +=
-        func::InsertToRxBuffer(rxBuffer, pdu, ISnCompare([this](int a, int b) { return snCompareRx(a, b); }));
+    if (sdu.data.size() < static_cast<size_t>(end))
+        sdu.data.resize(static_cast<size_t>(end));
+    std::memcpy(sdu.data.data() + header.so, data, static_cast<size_t>(size));
+    if (si::hasLast(header.si))
+        sdu.size = end;
+    sdu.buffered += size;
+    rxCurrentSize += size;
 
     // Actions when an AMD PDU is placed in the reception buffer
-    actionsOnReception(*pdu);
+    actionsOnReception(header.sn);
 
     // Continue 5.3.4
-    if (pdu->p)
+    if (header.p)
     {
         int v = (rxNext + windowSize) % snModulus;
 
         // if x < RX_Highest_Status or x >= RX_Next + AM_Window_Size:
-        if (snCompareRx(pdu->sn, rxHighestStatus) < 0 || snCompareRx(pdu->sn, v) >= 0)
+        if (snCompareRx(header.sn, rxHighestStatus) < 0 || snCompareRx(header.sn, v) >= 0)
         {
             // trigger a STATUS report
             statusTriggered = true;
@@ -255,33 +296,28 @@ void AmEntity::receiveAmdPdu(AmdPdu *pdu)
     }
 }
 
-void AmEntity::actionsOnReception(AmdPdu &pdu)
+void AmEntity::actionsOnReception(int x)
 {
-    int x = pdu.sn;
-
     // if x >= RX_Next_Highest update RX_Next_Highest to x+ 1.
     if (snCompareRx(x, rxNextHighest) >= 0)
         rxNextHighest = (x + 1) % snModulus;
 
-    if (func::IsAllSegmentsReceived(rxBuffer, x))
+    auto &sdu = rxWindow[x];
+    if (sdu.size >= 0 && sdu.received.isSingle(0, sdu.size))
     {
         // Reassemble the RLC SDU from all byte segments with SN = x, remove RLC headers and deliver
-        //  the reassembled RLC SDU to upper layer.
-        uint8_t reassembleBuffer[REASSEMBLE_BUFFER_LEN];
-        int reassembled = func::Reassemble(rxBuffer, pdu.sn, reassembleBuffer);
-        rxCurrentSize -= reassembled;
-        if (reassembled > 0)
-            consumer->deliverSdu(this, reassembleBuffer, reassembled);
+        //  the reassembled RLC SDU to upper layer. The byte segments are already in place in the SDU buffer.
+        sdu.delivered = true;
+        rxCurrentSize -= sdu.buffered;
+        consumer->deliverSdu(this, sdu.data.data(), sdu.size);
 
         // If x = RX_Highest_Status, update RX_Highest_Status to the SN of the first RLC SDU with
         //  SN > current RX_Highest_Status for which not all bytes have been received.
         if (x == rxHighestStatus)
         {
             int n = rxHighestStatus;
-            while (func::IsDelivered(rxBuffer, n))
-            {
+            while (isDelivered(n))
                 n = (n + 1) % snModulus;
-            }
             rxHighestStatus = n;
         }
 
@@ -289,13 +325,9 @@ void AmEntity::actionsOnReception(AmdPdu &pdu)
         //  for which not all bytes have been received.
         if (x == rxNext)
         {
-            while (!rxBuffer.isEmpty() && rxBuffer.getFirst()->value->isProcessed &&
-                   rxBuffer.getFirst()->value->sn == rxNext)
+            while (isDelivered(rxNext))
             {
-                do
-                {
-                    delete rxBuffer.removeFirst();
-                } while (!rxBuffer.isEmpty() && rxBuffer.getFirst()->value->sn == rxNext);
+                rxWindow[rxNext].inUse = false;
                 rxNext = (rxNext + 1) % snModulus;
             }
         }
@@ -308,7 +340,7 @@ void AmEntity::actionsOnReception(AmdPdu &pdu)
             ||
             // if RX_Next_Status_Trigger = RX_Next + 1 and there is no missing byte segment of the SDU
             //  associated with SN = RX_Next before the last byte of all received segments of this SDU; or
-            (rxNextStatusTrigger == (rxNext + 1) % snModulus && !func::HasMissingSegment(rxBuffer, rxNext)) ||
+            (rxNextStatusTrigger == (rxNext + 1) % snModulus && !hasMissingSegment(rxNext)) ||
             // if RX_Next_Status_Trigger falls outside of the receiving window and RX_Next_Status_Trigger
             //  is not equal to RX_Next + AM_Window_Size:
             (!isInReceiveWindow(rxNextStatusTrigger) && rxNextStatusTrigger != (rxNext + windowSize) % snModulus))
@@ -326,7 +358,7 @@ void AmEntity::actionsOnReception(AmdPdu &pdu)
         if (snCompareRx(rxNextHighest, (rxNext + 1) % snModulus) > 0
             // if RX_Next_Highest = RX_Next + 1 and there is at least one missing byte segment of the SDU
             //  associated with SN = RX_Next before the last byte of all received segments of this SDU:
-            || (rxNextHighest == (rxNext + 1) % snModulus && func::HasMissingSegment(rxBuffer, rxNext)))
+            || (rxNextHighest == (rxNext + 1) % snModulus && hasMissingSegment(rxNext)))
         {
 
             // Start t-Reassembly
@@ -337,20 +369,21 @@ void AmEntity::actionsOnReception(AmdPdu &pdu)
     }
 }
 
-void AmEntity::receiveStatusPdu(StatusPdu *pdu)
+void AmEntity::receiveStatusPdu(const StatusPdu &pdu)
 {
+    // ACK_SN outside of [TX_Next_Ack, TX_Next] belongs to an outdated or corrupted STATUS PDU.
+    if (snCompareTx(pdu.ackSn, txNext) > 0)
+        return;
+
     // If the STATUS report comprises a positive or negative acknowledgement for the RLC SDU
     //  with sequence number equal to POLL_SN:
     //  -    if    t-PollRetransmit is running:
     //  -    stop and reset t-PollRetransmit.
-    if (snCompareTx(pollSn, pdu->ackSn) < 0)
+    if (snCompareTx(pollSn, pdu.ackSn) < 0)
         pollRetransmitTimer.stop();
 
-    ackReceived(pdu->ackSn);
-
-    Snset alreadyRetIncremented;
-
-    for (auto &nackBlock : pdu->nackBlocks)
+    // NACKs first, so that the SNs below ACK_SN they leave marked in the bitmap are not acknowledged
+    for (auto &nackBlock : pdu.nackBlocks)
     {
         int nackSn = nackBlock.nackSn;
         int soStart = nackBlock.soStart;
@@ -363,145 +396,104 @@ void AmEntity::receiveStatusPdu(StatusPdu *pdu)
         }
         else
         {
-            if (soEnd == 0xffff)
-                soEnd = -1;
+            // SOend is inclusive, make it exclusive
+            soEnd = soEnd == 0xffff ? -1 : soEnd + 1;
         }
 
         int range = nackBlock.nackRange == -1 ? 1 : nackBlock.nackRange;
 
         for (int i = 0; i < range; i++)
-        {
-            nackReceived((nackSn + i) % snModulus, i == 0 ? soStart : 0, i == range - 1 ? soEnd : -1,
-                         alreadyRetIncremented);
-        }
+            nackReceived((nackSn + i) % snModulus, i == 0 ? soStart : 0, i == range - 1 ? soEnd : -1);
 
         // Similar as above
         if (snCompareTx(nackSn, pollSn) <= 0 && snCompareTx(pollSn, (nackSn + range) % snModulus) < 0)
             pollRetransmitTimer.stop();
     }
 
+    ackReceived(pdu.ackSn);
+
+    for (auto &nackBlock : pdu.nackBlocks)
+    {
+        int range = nackBlock.nackRange == -1 ? 1 : nackBlock.nackRange;
+        for (int i = 0; i < range; i++)
+            clearNacked((nackBlock.nackSn + i) % snModulus);
+    }
+
     checkForSuccessIndication();
 }
 
 void AmEntity::ackReceived(int ackSn)
 {
-    Snset alreadyDec;
-
-    auto cursor = waitBuffer.getFirst();
-    while (cursor != nullptr)
+    for (int sn = txNextAck; sn != txNext && snCompareTx(sn, ackSn) < 0; sn = (sn + 1) % snModulus)
     {
-        auto segment = cursor->value;
-        if (snCompareTx(segment->sdu->sn, ackSn) < 0)
-        {
-            waitBuffer.removeAndIncrement(cursor);
-            insertToList(ackBuffer, segment);
-        }
-        else
-        {
-            cursor = cursor->getNext();
-        }
-    }
+        auto &sdu = txWindow[sn];
+        if (sdu.acked || isNacked(sn))
+            continue;
 
-    cursor = retBuffer.getFirst();
-    while (cursor != nullptr)
-    {
-        auto segment = cursor->value;
-        if (snCompareTx(segment->sdu->sn, ackSn) < 0)
+        // Acknowledged before its pending retransmission went out, the retransmission does not count.
+        if (!sdu.retx.empty())
         {
-            if (!alreadyDec[segment->sdu->sn])
-            {
-                segment->sdu->retransmissionCount--;
-                alreadyDec[segment->sdu->sn] = true;
-            }
-            retBuffer.removeAndIncrement(cursor);
-            insertToList(ackBuffer, segment);
-        }
-        else
-        {
-            cursor = cursor->getNext();
+            sdu.retx.clear();
+            sdu.retransmissionCount--;
         }
+
+        sdu.acked = true;
     }
 }
 
-void AmEntity::nackReceived(int nackSn, int soStart, int soEnd, AmEntity::Snset &alreadyRetIncremented)
+void AmEntity::nackReceived(int nackSn, int soStart, int soEnd)
 {
     if (snCompareTx(txNextAck, nackSn) > 0 || snCompareTx(nackSn, txNext) >= 0)
         return;
 
-    auto cursor = waitBuffer.getFirst();
+    auto &sdu = txWindow[nackSn];
+    if (!sdu.inUse || sdu.sn != nackSn || sdu.acked)
+        return;
 
-    while (cursor != nullptr)
-    {
-        auto segment = cursor->value;
-        if (segment->sdu->sn == nackSn)
-        {
-            if (func::SoOverlap(soStart, soEnd, segment->so, segment->so + segment->size - 1))
-            {
-                waitBuffer.removeAndIncrement(cursor);
-                considerRetransmission(segment, !alreadyRetIncremented[nackSn]);
-                alreadyRetIncremented[nackSn] = true;
-            }
-            else
-            {
-                cursor = cursor->getNext();
-            }
-        }
-        else
-        {
-            cursor = cursor->getNext();
-        }
-    }
+    int end = soEnd == -1 || soEnd > sdu.size ? sdu.size : soEnd;
+    if (soStart >= end)
+        return;
 
-    cursor = ackBuffer.getFirst();
-    while (cursor != nullptr)
-    {
-        auto segment = cursor->value;
+    bool alreadyIncremented = testAndSetNacked(nackSn);
+    if (sdu.retx.covers(soStart, end))
+        return;
 
-        if (segment->sdu->sn == nackSn)
-        {
-            if (func::SoOverlap(soStart, soEnd, segment->so, segment->so + segment->size - 1))
-            {
-                ackBuffer.removeAndIncrement(cursor);
-                considerRetransmission(segment, !alreadyRetIncremented[nackSn]);
-                alreadyRetIncremented[nackSn] = true;
-            }
-            else
-            {
-                cursor = cursor->getNext();
-            }
-        }
-        else
-        {
-            cursor = cursor->getNext();
-        }
-    }
+    considerRetransmission(sdu, soStart, end, !alreadyIncremented);
 }
 
-void AmEntity::considerRetransmission(RlcSduSegment *segment, bool updateRetX)
+void AmEntity::considerRetransmission(TxSdu &sdu, int start, int end, bool updateRetX)
 {
     if (updateRetX)
     {
-        segment->sdu->retransmissionCount++;
-        if (segment->sdu->retransmissionCount >= maxRetThreshold)
+        sdu.retransmissionCount++;
+        if (sdu.retransmissionCount >= maxRetThreshold)
             consumer->maxRetransmissionReached(this);
     }
-    insertToList(retBuffer, segment);
+
+    sdu.retx.addCoalescing(start, end);
+    if (!sdu.queued)
+    {
+        sdu.queued = true;
+        retQueue.push_back(sdu.sn);
+    }
 }
 
 void AmEntity::checkForSuccessIndication()
 {
-    auto cursor = ackBuffer.getFirst();
-
     // TODO: Currently sequential succ indication, but not immediate.
-    while (cursor != nullptr && cursor->value->sdu->sn == txNextAck && areAllSegmentsInAck(cursor->value->sdu->sn))
+    while (txNextAck != txNext && txWindow[txNextAck].acked)
     {
-        txCurrentSize -= cursor->value->sdu->size;
-        int sn = cursor->value->sdu->sn;
+        auto &sdu = txWindow[txNextAck];
+        txCurrentSize -= sdu.size;
+
+        consumer->sduSuccessfulDelivery(this, sdu.sduId);
 
-        consumer->sduSuccessfulDelivery(this, cursor->value->sdu->sduId);
+        sdu.inUse = false;
+        sdu.acked = false;
+        if (spareBuffers.size() < MAX_SPARE_BUFFERS)
+            spareBuffers.push_back(std::move(sdu.data));
+        sdu.data = {};
 
-        while (cursor != nullptr && cursor->value->sdu->sn == sn)
-            delete ackBuffer.removeAndIncrement(cursor);
         txNextAck = (txNextAck + 1) % snModulus;
     }
 }
@@ -527,7 +519,7 @@ int AmEntity::createPdu(uint8_t *buffer, int maxSize)
             return res;
     }
 
-    if (!retBuffer.isEmpty())
+    if (!retQueue.empty())
     {
         int res = createRetPdu(buffer, maxSize);
         if (res != 0)
@@ -537,107 +529,88 @@ int AmEntity::createPdu(uint8_t *buffer, int maxSize)
     return createTxPdu(buffer, maxSize);
 }
 
-int AmEntity::createStatusPdu(uint8_t *buffer, int maxSize, bool noSideEffect)
+bool AmEntity::addNackBlock(const NackBlock &block, int maxSize, int &size)
 {
-    if (maxSize < 3)
-        return 0;
-
-    StatusPdu pdu;
+    int blockSize = NackBlockSize(block, snLength == 12);
+    if (size + blockSize > maxSize)
+    {
+        // The SNs from this one on are neither acknowledged nor NACKed
+        status.ackSn = block.nackSn;
+        return false;
+    }
 
-    int startSn = rxNext;
-    int startSo = 0;
+    status.nackBlocks.push_back(block);
+    size += blockSize;
+    return true;
+}
 
-    // Find NACK blocks
-    while (true)
+bool AmEntity::addNackRange(int nackSn, int count, int maxSize, int &size)
+{
+    // Since the NACK range is 8-bit. We must limit to 255, and cut if needed.
+    while (count > 0)
     {
-        if (snCompareRx(startSn, rxHighestStatus) >= 0)
-            break;
-
-        MissingBlock missing{};
-        if (!func::FindMissingBlock(rxBuffer, startSn, startSo, (rxHighestStatus - 1 + snModulus) % snModulus, 0xFFFF,
-                                    snModulus, missing))
-            break;
+        int range = std::min(count, 255);
+        if (!addNackBlock(NackBlock{nackSn, -1, -1, range == 1 ? -1 : range}, maxSize, size))
+            return false;
+        nackSn = (nackSn + range) % snModulus;
+        count -= range;
+    }
+    return true;
+}
 
-        NackBlock block{};
-        block.nackSn = missing.snStart;
-        block.nackRange =
-            missing.snStart == missing.snEnd ? -1 : (missing.snEnd - missing.snStart + snModulus) % snModulus + 1;
+int AmEntity::buildStatusPdu(int maxSize)
+{
+    if (maxSize < STATUS_HEADER_SIZE)
+        return 0;
 
-        // Since the NACK range is 8-bit. We must limit to 255, and cut if needed.
-        if (block.nackRange > 255)
-        {
-            if (missing.soStart == 0 && missing.soEnd == 0xFFFF)
-            {
-                block.soStart = -1;
-                block.soEnd = -1;
-            }
-            else
-            {
-                block.soStart = missing.soStart;
-                block.soEnd = 0xFFFF;
-            }
+    status.ackSn = rxHighestStatus;
+    status.nackBlocks.clear();
 
-            block.nackRange = 255;
-            startSn = (missing.snStart + 256) % snModulus;
-            startSo = 0;
+    int size = STATUS_HEADER_SIZE;
+    int missingSn = rxNext;
+    int missingCount = 0;
 
-            pdu.nackBlocks.push_back(block);
+    for (int sn = rxNext; sn != rxHighestStatus; sn = (sn + 1) % snModulus)
+    {
+        auto &sdu = rxWindow[sn];
 
-            if (pdu.calculatedSize(snLength == 12) > maxSize)
-            {
-                pdu.nackBlocks.pop_back();
-                break;
-            }
-        }
-        else
+        // SDUs with no byte received are NACKed together in ranges
+        if (!sdu.inUse || sdu.sn != sn)
         {
-            if (missing.soStart == 0 && missing.soEnd == 0xFFFF)
-            {
-                block.soStart = -1;
-                block.soEnd = -1;
-            }
-            else
-            {
-                block.soStart = missing.soStart;
-                block.soEnd = missing.soEnd;
-            }
-
-            pdu.nackBlocks.push_back(block);
-
-            if (pdu.calculatedSize(snLength == 12) > maxSize)
-            {
-                pdu.nackBlocks.pop_back();
-                break;
-            }
-
-            if (missing.soNext == -1 && missing.snNext == -1)
-                break;
-
-            startSn = missing.snNext;
-            startSo = missing.soNext;
+            if (missingCount == 0)
+                missingSn = sn;
+            missingCount++;
+            continue;
         }
-    }
 
-    // Then find the ACK_SN
-    int ackSn = rxNext;
+        if (!addNackRange(missingSn, missingCount, maxSize, size))
+            return size;
+        missingCount = 0;
 
-    if (!noSideEffect)
-    {
-        auto cursor = rxBuffer.getFirst();
-        while (cursor != nullptr)
+        if (sdu.delivered)
+            continue;
+
+        // The gaps between the received byte segments
+        int so = 0;
+        for (int i = 0; i < sdu.received.count; i++)
         {
-            if (snCompareRx(cursor->value->sn, rxHighestStatus) >= 0)
-                break;
-            if (snCompareRx(cursor->value->sn, rxNext) >= 0)
-            {
-                if (cursor->value->isProcessed)
-                    ackSn = (cursor->value->sn + 1) % snModulus;
-            }
-            cursor = cursor->getNext();
+            if (sdu.received.starts[i] > so &&
+                !addNackBlock(NackBlock{sn, so, sdu.received.starts[i] - 1, -1}, maxSize, size))
+                return size;
+            so = sdu.received.ends[i];
         }
+        if ((sdu.size == -1 || so < sdu.size) && !addNackBlock(NackBlock{sn, so, 0xFFFF, -1}, maxSize, size))
+            return size;
     }
 
-    pdu.ackSn = ackSn;
+    addNackRange(missingSn, missingCount, maxSize, size);
+    return size;
+}
+
+int AmEntity::createStatusPdu(uint8_t *buffer, int maxSize, bool noSideEffect)
+{
+    if (buildStatusPdu(maxSize) == 0)
+        return 0;
 
     if (!noSideEffect)
     {
@@ -647,34 +620,46 @@ int AmEntity::createStatusPdu(uint8_t *buffer, int maxSize, bool noSideEffect)
     }
 
     // Finally encode the status PDU
-    return RlcEncoder::EncodeStatus(buffer, pdu, snLength == 12);
+    return RlcEncoder::EncodeStatus(buffer, status, snLength == 12);
 }
 
 int AmEntity::createRetPdu(uint8_t *buffer, int maxSize)
 {
-    auto segment = retBuffer.getFirstElement();
-    if (segment == nullptr)
+    // Drop the SNs acknowledged since they were queued
+    while (!retQueue.empty())
+    {
+        auto &sdu = txWindow[retQueue.front()];
+        if (sdu.inUse && sdu.sn == retQueue.front() && !sdu.acked && !sdu.retx.empty())
+            break;
+        if (sdu.sn == retQueue.front())
+            sdu.queued = false;
+        retQueue.pop_front();
+    }
+
+    if (retQueue.empty())
         return 0;
 
-    int headerSize = func::AmdPduHeaderSize(snLength, segment->si);
+    auto &sdu = txWindow[retQueue.front()];
+    int so = sdu.retx.starts[0];
+    int headerSize = func::AmdPduHeaderSize(snLength, so == 0 ? ESegmentInfo::FULL : ESegmentInfo::LAST);
 
     // Fragmentation is irrelevant since no byte fits the size.
     if (headerSize + 1 > maxSize)
         return 0;
 
-    retBuffer.removeFirst();
-
     // Perform segmentation if it is needed
-    if (headerSize + segment->size > maxSize)
+    int size = std::min(sdu.retx.ends[0] - so, maxSize - headerSize);
+    ESegmentInfo si = so + size == sdu.size ? ESegmentInfo::FULL : ESegmentInfo::FIRST;
+    if (so != 0)
+        si = si::asNotFirst(si);
+
+    sdu.retx.consumeFront(size);
+    if (sdu.retx.empty())
     {
-        auto next = func::AmPerformSegmentation(segment, maxSize, snLength);
-        if (next == nullptr)
-            return 0;
-        retBuffer.addFirst(next);
+        sdu.queued = false;
+        retQueue.pop_front();
     }
 
-    insertToList(waitBuffer, segment);
-
     bool includePoll = pollControlForTransmissionOrRetransmission();
 
     if (forcePoll)
@@ -683,7 +668,7 @@ int AmEntity::createRetPdu(uint8_t *buffer, int maxSize)
         forcePoll = false;
     }
 
-    return generateAmdForSdu(*segment, includePoll, buffer);
+    return generateAmd(sdu, si, so, size, includePoll, buffer);
 }
 
 int AmEntity::createTxPdu(uint8_t *buffer, int maxSize)
@@ -691,32 +676,50 @@ int AmEntity::createTxPdu(uint8_t *buffer, int maxSize)
     if (windowStalling())
         return 0;
 
-    auto segment = txBuffer.getFirstElement();
-    if (segment == nullptr)
+    if (txOffset == 0 && txPending.empty())
         return 0;
 
-    int headerSize = func::AmdPduHeaderSize(snLength, segment->si);
+    int headerSize = func::AmdPduHeaderSize(snLength, txOffset == 0 ? ESegmentInfo::FULL : ESegmentInfo::LAST);
 
     // Fragmentation is irrelevant since no byte fits the size.
     if (headerSize + 1 > maxSize)
         return 0;
 
-    segment->sdu->sn = txNext;
-    txBuffer.removeFirst();
+    txWindow.reserve(txNextAck, modulusTx(txNext) + 1, snModulus);
+    auto &sdu = txWindow[txNext];
 
-    // Perform segmentation if it is needed
-    if (headerSize + segment->size > maxSize)
+    if (txOffset == 0)
     {
-        auto next = func::AmPerformSegmentation(segment, maxSize, snLength);
-        if (next == nullptr)
-            return 0;
-        txBuffer.addFirst(next);
+        auto &pending = txPending.front();
+        sdu.data.swap(pending.data);
+        sdu.size = static_cast<int>(sdu.data.size());
+        sdu.sduId = pending.sduId;
+        sdu.sn = txNext;
+        sdu.retransmissionCount = -1;
+        sdu.inUse = true;
+        sdu.acked = false;
+        sdu.queued = false;
+        sdu.retx.clear();
+
+        if (pending.data.capacity() != 0 && spareBuffers.size() < MAX_SPARE_BUFFERS)
+            spareBuffers.push_back(std::move(pending.data));
+        txPending.pop_front();
     }
 
-    if (si::hasLast(segment->si))
-        txNext = (txNext + 1) % snModulus;
+    // Perform segmentation if it is needed
+    int so = txOffset;
+    int size = std::min(sdu.size - so, maxSize - headerSize);
+    ESegmentInfo si = so + size == sdu.size ? ESegmentInfo::FULL : ESegmentInfo::FIRST;
+    if (so != 0)
+        si = si::asNotFirst(si);
 
-    insertToList(waitBuffer, segment);
+    txPendingBytes -= size;
+    txOffset += size;
+    if (txOffset == sdu.size)
+    {
+        txOffset = 0;
+        txNext = (txNext + 1) % snModulus;
+    }
 
     // 5.3.3.2	Transmission of a AMD PDU
     //  Upon notification of a transmission opportunity by lower layer, for each AMD PDU submitted for
@@ -729,7 +732,7 @@ int AmEntity::createTxPdu(uint8_t *buffer, int maxSize)
 
     // increment BYTE_WITHOUT_POLL by every new byte of Data field element
     //  that it maps to the Data field of the AMD PDU;
-    byteWithoutPoll += segment->size;
+    byteWithoutPoll += size;
 
     bool includePoll = false;
 
@@ -746,10 +749,10 @@ int AmEntity::createTxPdu(uint8_t *buffer, int maxSize)
         forcePoll = false;
     }
 
-    return generateAmdForSdu(*segment, includePoll, buffer);
+    return generateAmd(sdu, si, so, size, includePoll, buffer);
 }
 
-int AmEntity::generateAmdForSdu(const RlcSduSegment &segment, bool includePoll, uint8_t *buffer)
+int AmEntity::generateAmd(TxSdu &sdu, ESegmentInfo si, int so, int size, bool includePoll, uint8_t *buffer)
 {
     bool p = false;
 
@@ -772,8 +775,7 @@ int AmEntity::generateAmdForSdu(const RlcSduSegment &segment, bool includePoll,
         pollRetransmitTimer.start(tCurrent);
     }
 
-    return RlcEncoder::EncodeAmd(buffer, snLength == 12, segment.si, segment.so, segment.sdu->sn,
-                                 segment.sdu->data + segment.so, segment.size, p);
+    return RlcEncoder::EncodeAmd(buffer, snLength == 12, si, so, sdu.sn, sdu.data.data() + so, size, p);
 }
 
 //======================================================================================================
@@ -797,7 +799,7 @@ void AmEntity::actionsOnReassemblyTimerExpired()
     // update RX_Highest_Status to the SN of the first RLC SDU with
     //  SN >= RX_Next_Status_Trigger for which not all bytes have been received;
     int sn = rxNextStatusTrigger;
-    while (func::IsDelivered(rxBuffer, sn))
+    while (isDelivered(sn))
         sn = (sn + 1) % snModulus;
     rxHighestStatus = sn;
 
@@ -808,7 +810,7 @@ void AmEntity::actionsOnReassemblyTimerExpired()
     {
         condition = true;
     }
-    else if (rxNextHighest == (rxHighestStatus + 1) % snModulus && func::HasMissingSegment(rxBuffer, rxHighestStatus))
+    else if (rxNextHighest == (rxHighestStatus + 1) % snModulus && hasMissingSegment(rxHighestStatus))
     {
         // or if RX_Next_Highest = RX_Highest_Status + 1 and there is at least one missing byte
         //  segment of the SDU associated with SN = RX_Highest_Status before the last byte
@@ -829,40 +831,28 @@ void AmEntity::actionsOnPollRetransmitTimerExpired()
 {
     if (pollControlForTransmissionOrRetransmission())
     {
+        // An SDU is a candidate if some of its bytes are neither acknowledged nor waiting for retransmission
+        auto isCandidate = [this](int sn) {
+            auto &sdu = txWindow[sn];
+            return sdu.inUse && sdu.sn == sn && !sdu.acked && !sdu.retx.covers(0, sdu.size);
+        };
+
         // 5.3.3.4: Consider the RLC SDU with the highest SN among the RLC SDUs submitted to lower layer for
         // retransmission
-        auto item = func::FirstItemWithSn(waitBuffer, (txNext - 1 + snModulus) % snModulus);
+        int sn = (txNext - 1 + snModulus) % snModulus;
 
         // 5.3.3.4: ... or consider any RLC SDU which has not been positively acknowledged for retransmission.
-        if (item == nullptr)
+        if (txNextAck == txNext || !isCandidate(sn))
         {
             // The spec says 'any', here we take first one.
-            item = waitBuffer.getFirst();
+            sn = txNextAck;
+            while (sn != txNext && !isCandidate(sn))
+                sn = (sn + 1) % snModulus;
         }
 
-        if (item != nullptr)
-        {
-            auto sn = item->value->sdu->sn;
-            bool alreadyRetIncremented = false;
-            auto cursor = waitBuffer.getFirst();
-
-            // Spec says SDU, not segment. Therefore take all segments.
-            while (cursor != nullptr)
-            {
-                if (snCompareTx(cursor->value->sdu->sn, sn) > 0)
-                    break;
-                if (snCompareTx(cursor->value->sdu->sn, sn) == 0)
-                {
-                    considerRetransmission(cursor->value, !alreadyRetIncremented);
-                    alreadyRetIncremented = true;
-                    waitBuffer.removeAndIncrement(cursor);
-                }
-                else
-                {
-                    cursor = cursor->getNext();
-                }
-            }
-        }
+        // Spec says SDU, not segment. Therefore take all segments.
+        if (sn != txNext)
+            considerRetransmission(txWindow[sn], 0, txWindow[sn].size, true);
     }
 
     forcePoll = true;
@@ -874,16 +864,30 @@ void AmEntity::actionsOnPollRetransmitTimerExpired()
 
 void AmEntity::calculateDataVolume(RlcDataVolume &volume)
 {
-    auto txCalc = [this](const RlcSduSegment *v) { return v->size + func::AmdPduHeaderSize(snLength, v->si); };
-
     // Calculate TX
-    volume.transmissionSize = func::ListSum<RlcSduSegment>(txBuffer, txCalc);
+    volume.transmissionSize = txPendingBytes + static_cast<int>(txPending.size()) *
+                                                   func::AmdPduHeaderSize(snLength, ESegmentInfo::FULL);
+    if (txOffset != 0)
+        volume.transmissionSize += func::AmdPduHeaderSize(snLength, ESegmentInfo::LAST);
 
     // Calculate RX
     volume.receptionSize = rxCurrentSize; // An estimation.
 
     // Calculate RETX
-    volume.retransmissionSize = func::ListSum<RlcSduSegment>(retBuffer, txCalc);
+    volume.retransmissionSize = 0;
+    for (int sn : retQueue)
+    {
+        auto &sdu = txWindow[sn];
+        if (!sdu.inUse || sdu.sn != sn || sdu.acked)
+            continue;
+        for (int i = 0; i < sdu.retx.count; i++)
+        {
+            volume.retransmissionSize += sdu.retx.ends[i] - sdu.retx.starts[i] +
+                                         func::AmdPduHeaderSize(snLength, sdu.retx.starts[i] == 0
+                                                                              ? ESegmentInfo::FULL
+                                                                              : ESegmentInfo::LAST);
+        }
+    }
 
     // Calculate STATUS
     volume.statusSize = estimateStatusSize();
@@ -891,13 +895,8 @@ void AmEntity::calculateDataVolume(RlcDataVolume &volume)
 
 int AmEntity::estimateStatusSize()
 {
-    // TODO: May be optimized
     if (statusTriggered && statusProhibitTimer.stoppedOrExpired(tCurrent))
-    {
-        // just create a STATUS PDU but don't invoke side effects of the function.
-        uint8_t buffer[32768];
-        return createStatusPdu(buffer, 32768, true);
-    }
+        return buildStatusPdu(std::numeric_limits<int>::max());
     return 0;
 }
 
@@ -907,26 +906,36 @@ int AmEntity::estimateStatusSize()
 
 void AmEntity::receiveSdu(uint8_t *data, int size, int sduId)
 {
-    txCurrentSize += func::InsertSduToTransmissionBuffer(data, size, sduId, txBuffer, txCurrentSize, txMaxSize);
+    if (size <= 0 || size > MAX_SDU_SIZE || txCurrentSize + size > txMaxSize)
+        return;
+
+    PendingSdu sdu{{}, sduId};
+    if (!spareBuffers.empty())
+    {
+        sdu.data = std::move(spareBuffers.back());
+        spareBuffers.pop_back();
+    }
+    sdu.data.assign(data, data + size);
+
+    txPending.push_back(std::move(sdu));
+    txCurrentSize += size;
+    txPendingBytes += size;
 }
 
 void AmEntity::discardSdu(int sduId)
 {
-    auto segment = func::FindFirstSduSegmentWithId(txBuffer, sduId);
+    // Only SDUs not submitted to lower layer yet can be discarded, a segmented one is already in the window
+    auto it = std::find_if(txPending.begin(), txPending.end(), [sduId](auto &sdu) { return sdu.sduId == sduId; });
 
     // SDU not found, do nothing.
-    if (segment == nullptr)
+    if (it == txPending.end())
         return;
 
-    // The SDU is already segmented, do nothing.
-    if (segment->value->si != ESegmentInfo::FULL)
-        return;
-
-    // Remove the segment
-    delete txBuffer.remove(segment);
-
     // TODO, WARNING: not really sure here because this is not included in the a.i
-    txCurrentSize -= segment->value->size;
+    int size = static_cast<int>(it->data.size());
+    txCurrentSize -= size;
+    txPendingBytes -= size;
+    txPending.erase(it);
 }
 
 void AmEntity::reestablishment()
@@ -11,16 +11,45 @@
 #include "rlc.hpp"
 #include "utils.hpp"
 
-#include <bitset>
-
-#include <utils/linked_list.hpp>
+#include <deque>
+#include <vector>
 
 namespace rlc
 {
 
 class AmEntity : public IRlcEntity
 {
-    using Snset = std::bitset<262144>;
+    // An RLC SDU of the transmitting side, from its first transmission until it is acknowledged
+    struct TxSdu
+    {
+        std::vector<uint8_t> data;
+        int size{};
+        int sduId{};
+        int sn{};
+        int retransmissionCount{};
+        bool inUse{};
+        bool acked{};
+        bool queued{};    // in the retransmission queue
+        ByteRanges retx{}; // byte ranges waiting for retransmission
+    };
+
+    // An RLC SDU of the receiving side, from its first byte segment until RX_Next passes it
+    struct RxSdu
+    {
+        std::vector<uint8_t> data; // reassembly buffer, its capacity is kept for later SDUs of the slot
+        ByteRanges received{};
+        int size{}; // -1 until the last byte segment is received
+        int sn{};
+        int buffered{}; // bytes counted in rxCurrentSize
+        bool inUse{};
+        bool delivered{};
+    };
+
+    struct PendingSdu
+    {
+        std::vector<uint8_t> data;
+        int sduId;
+    };
 
     // Configurations
     int snLength;
@@ -39,18 +68,21 @@ class AmEntity : public IRlcEntity
     int pduWithoutPoll;
     int byteWithoutPoll;
 
-    // TX buffer
+    // TX buffer, SDUs waiting for their first transmission and SDUs from TX_Next_Ack on by SN
     int txCurrentSize;
-    LinkedList<RlcSduSegment> txBuffer;
+    int txPendingBytes; // bytes not transmitted yet
+    int txOffset;       // bytes of the SDU with SN = TX_Next transmitted so far
+    std::deque<PendingSdu> txPending;
+    SnRing<TxSdu> txWindow;
+    std::deque<int> retQueue; // SNs with byte ranges waiting for retransmission
+    std::vector<std::vector<uint8_t>> spareBuffers;
 
-    // RX buffer
-    int rxCurrentSize;
-    LinkedList<AmdPdu> rxBuffer;
+    // SNs NACKed by the STATUS PDU being processed, one bit per SN of the window
+    std::vector<uint64_t> nackBitmap;
 
-    // Other Buffers
-    LinkedList<RlcSduSegment> retBuffer;
-    LinkedList<RlcSduSegment> waitBuffer;
-    LinkedList<RlcSduSegment> ackBuffer;
+    // RX buffer, SDUs from RX_Next on by SN
+    int rxCurrentSize;
+    SnRing<RxSdu> rxWindow;
 
     // RX state variables
     int rxNext;
@@ -61,6 +93,7 @@ class AmEntity : public IRlcEntity
     // Custom state variables
     bool statusTriggered;
     bool forcePoll;
+    StatusPdu status;
 
     // Timers
     int64_t tCurrent;
@@ -87,24 +120,29 @@ class AmEntity : public IRlcEntity
     bool pollControlForTransmissionOrRetransmission();
 
     /* Internal */
-    bool areAllSegmentsInAck(int sn);
-    int sduListCompare(const RlcSduSegment &a, const RlcSduSegment &b);
-    void insertToList(LinkedList<RlcSduSegment> &list, RlcSduSegment *segment);
+    bool isDelivered(int sn);
+    bool hasMissingSegment(int sn);
+    bool isNacked(int sn);
+    bool testAndSetNacked(int sn);
+    void clearNacked(int sn);
 
     /* PDU receive related */
-    void receiveAmdPdu(AmdPdu *pdu);
-    void actionsOnReception(AmdPdu &pdu);
-    void receiveStatusPdu(StatusPdu *pdu);
+    void receiveAmdPdu(const AmdHeader &header, const uint8_t *data, int size);
+    void actionsOnReception(int x);
+    void receiveStatusPdu(const StatusPdu &pdu);
     void ackReceived(int ackSn);
-    void nackReceived(int nackSn, int soStart, int soEnd, Snset &alreadyRetIncremented);
-    void considerRetransmission(RlcSduSegment *segment, bool updateRetX);
+    void nackReceived(int nackSn, int soStart, int soEnd);
+    void considerRetransmission(TxSdu &sdu, int start, int end, bool updateRetX);
     void checkForSuccessIndication();
 
     /* PDU construct related */
+    int buildStatusPdu(int maxSize);
+    bool addNackBlock(const NackBlock &block, int maxSize, int &size);
+    bool addNackRange(int nackSn, int count, int maxSize, int &size);
     int createStatusPdu(uint8_t *buffer, int maxSize, bool noSideEffect);
     int createRetPdu(uint8_t *buffer, int maxSize);
     int createTxPdu(uint8_t *buffer, int maxSize);
-    int generateAmdForSdu(const RlcSduSegment &segment, bool includePoll, uint8_t *buffer);
+    int generateAmd(TxSdu &sdu, ESegmentInfo si, int so, int size, bool includePoll, uint8_t *buffer);
 
     /* Timer related */
     void actionsOnReassemblyTimerExpired();
@@ -269,7 +269,6 @@ int rlc::UmEntity::createPdu(uint8_t *buffer, int maxSize)
         return 0;
 
     segment->sdu->sn = txNext;
-    txBuffer.removeFirst();
 
     // Perform segmentation if it is needed
     if (headerSize + segment->size > maxSize)
@@ -277,16 +276,24 @@ int rlc::UmEntity::createPdu(uint8_t *buffer, int maxSize)
         auto next = func::UmPerformSegmentation(segment, maxSize, snLength);
         if (next == nullptr)
             return 0;
+        txBuffer.removeFirst();
         txBuffer.addFirst(next);
     }
+    else
+    {
+        txBuffer.removeFirst();
+    }
 
     if (segment->si == ESegmentInfo::LAST)
         txNext = (txNext + 1) % snModulus;
 
     txCurrentSize -= segment->size;
 
-    return RlcEncoder::EncodeUmd(buffer, snLength == 6, segment->si, segment->so, segment->sdu->sn,
-                                 segment->sdu->data + segment->so, segment->size);
+    // Nothing is retransmitted in UM, the segment is done with once it is encoded
+    int size = RlcEncoder::EncodeUmd(buffer, snLength == 6, segment->si, segment->so, segment->sdu->sn,
+                                     segment->sdu->data + segment->so, segment->size);
+    delete segment;
+    return size;
 }
 
 void rlc::UmEntity::timerCycle(int64_t currentTime)
@@ -9,180 +9,162 @@
 #include "test.hpp"
 #include "rlc.hpp"
 
-#include <string>
+#include <chrono>
 #include <cstdio>
-
-#include <utils/nts.hpp>
-
-enum class EntityType
-{
-    TM,
-    UM,
-    AM
-};
-
-static constexpr int SN_LENGTH = 12;
-static constexpr int TX_MAX_SIZE = 1024 * 32;
-static constexpr int RX_MAX_SIZE = 1024 * 32;
-static constexpr int MAX_RET = 8;
-static constexpr int POLL_RETRANSMIT_PERIOD = 400;
-static constexpr int REASSEMBLY_PERIOD = 400;
-static constexpr int STATUS_PROHIBIT_PERIOD = 400;
+#include <deque>
+#include <memory>
+#include <random>
+#include <vector>
+
+// Throughput and loss benchmark of a pair of AM entities over a simulated radio link. The link runs on a virtual
+// clock with a fixed seed, so every run makes the same decisions and only the wall time differs.
+
+static constexpr int SN_LENGTH = 18;
+static constexpr int TX_MAX_SIZE = 1024 * 1024 * 8;
+static constexpr int RX_MAX_SIZE = 1024 * 1024 * 8;
+static constexpr int POLL_PDU = 16;
+static constexpr int POLL_BYTE = 25000;
+static constexpr int MAX_RET = 32;
+static constexpr int POLL_RETRANSMIT_PERIOD = 45;
+static constexpr int REASSEMBLY_PERIOD = 35;
+static constexpr int STATUS_PROHIBIT_PERIOD = 10;
 
 // UPPER LAYER
-static constexpr int TRANSMISSION_SIZE = 2000;
+static constexpr int SDU_SIZE = 1400;
+static constexpr int SDU_COUNT = 100000;
+static constexpr int SDUS_PER_SLOT = 14;
+static constexpr int MAX_UNCONFIRMED = 4096; // SDUs, keeps the offered load within the transmission buffer
 
 // LOWER LAYER
-static constexpr int OPPORTUNITY_SIZE_MIN = 10000;
-static constexpr int OPPORTUNITY_SIZE_MAX = 30000;
+static constexpr int OPPORTUNITIES_PER_SLOT = 16;
+static constexpr int OPPORTUNITY_SIZE = 1200;
+static constexpr int LINK_DELAY = 5;         // slots, in each direction
+static constexpr int64_t MAX_SLOTS = 600000; // 1 ms slots
+static constexpr uint32_t SEED = 42;
+
+static constexpr double LOSS_RATES[] = {0.0, 0.01, 0.05, 0.2};
+
+namespace rlc
+{
 
-// GENERAL
-static constexpr int MAX_PACKET_SEND_COUNT = 60000;
-static constexpr EntityType ENTITY = EntityType::AM;
+struct InFlightPdu
+{
+    int64_t arrival;
+    std::vector<uint8_t> data;
+};
 
-struct NwRadioUplink : NtsMessage
+struct BenchmarkEnd : IRlcConsumer
 {
-    size_t size{};
-    uint8_t *data{};
+    IRlcEntity *entity{};
+    std::deque<InFlightPdu> inbox{};
+    int delivered{};
+    int64_t deliveredBytes{};
+    int confirmed{};
+    int failures{};
+
+    void deliverSdu(IRlcEntity *, uint8_t *, int size) override
+    {
+        delivered++;
+        deliveredBytes += size;
+    }
 
-    NwRadioUplink() : NtsMessage(NtsMessageType::RESERVED_END)
+    void maxRetransmissionReached(IRlcEntity *) override
     {
+        failures++;
     }
 
-    ~NwRadioUplink() override = default;
+    void sduSuccessfulDelivery(IRlcEntity *, int) override
+    {
+        confirmed++;
+    }
 };
 
-static uint64_t currentTimeMs()
+static IRlcEntity *NewBenchmarkEntity(IRlcConsumer *consumer)
 {
-    auto now = std::chrono::high_resolution_clock::now().time_since_epoch();
-    return std::chrono::duration_cast<std::chrono::milliseconds>(now).count();
+    return NewAmEntity(consumer, SN_LENGTH, TX_MAX_SIZE, RX_MAX_SIZE, POLL_PDU, POLL_BYTE, MAX_RET,
+                       POLL_RETRANSMIT_PERIOD, REASSEMBLY_PERIOD, STATUS_PROHIBIT_PERIOD);
 }
 
-namespace rlc
-{
-
-struct RlcTask : NtsTask, IRlcConsumer
+static void Transmit(BenchmarkEnd &from, BenchmarkEnd &to, int64_t now, double loss, std::mt19937 &rng,
+                     std::vector<uint8_t> &buffer, int &outPdus)
 {
-    IRlcEntity *m_pEntity;
-    std::string tag;
-    RlcTask *pair;
+    std::uniform_real_distribution<double> distribution{};
 
-    int packetId;
-    int receivedCounter;
-
-    bool continueTesting = true;
-
-    RlcTask()
+    for (int i = 0; i < OPPORTUNITIES_PER_SLOT; i++)
     {
-        switch (ENTITY)
-        {
-        case EntityType::TM:
-            m_pEntity = NewTmEntity(this, TX_MAX_SIZE);
+        int size = from.entity->createPdu(buffer.data(), OPPORTUNITY_SIZE);
+        if (size <= 0)
             break;
-        case EntityType::UM:
-            m_pEntity = NewUmEntity(this, SN_LENGTH, REASSEMBLY_PERIOD, TX_MAX_SIZE, RX_MAX_SIZE);
-            break;
-        case EntityType::AM:
-            m_pEntity = NewAmEntity(this, SN_LENGTH, TX_MAX_SIZE, RX_MAX_SIZE, -1, -1, MAX_RET, POLL_RETRANSMIT_PERIOD,
-                                    REASSEMBLY_PERIOD, STATUS_PROHIBIT_PERIOD);
-            break;
-        }
+        outPdus++;
+        if (distribution(rng) < loss)
+            continue;
+        to.inbox.push_back(InFlightPdu{now + LINK_DELAY, std::vector<uint8_t>{buffer.data(), buffer.data() + size}});
     }
+}
 
-    void onStart() override
+static void Receive(BenchmarkEnd &end, int64_t now)
+{
+    while (!end.inbox.empty() && end.inbox.front().arrival <= now)
     {
+        auto &pdu = end.inbox.front();
+        end.entity->receivePdu(pdu.data.data(), static_cast<int>(pdu.data.size()));
+        end.inbox.pop_front();
     }
+}
 
-    void onLoop() override
-    {
-        auto msg = poll();
-        if (msg)
-        {
-            if (msg->msgType == NtsMessageType::RESERVED_END)
-            {
-                auto w = ((NwRadioUplink &)*msg);
-                m_pEntity->receivePdu(w.data, w.size);
-            }
-        }
-
-        m_pEntity->timerCycle(currentTimeMs());
+static void RunScenario(double loss)
+{
+    BenchmarkEnd sender{}, receiver{};
+    std::unique_ptr<IRlcEntity> senderEntity{NewBenchmarkEntity(&sender)};
+    std::unique_ptr<IRlcEntity> receiverEntity{NewBenchmarkEntity(&receiver)};
+    sender.entity = senderEntity.get();
+    receiver.entity = receiverEntity.get();
 
-        auto opSize = (OPPORTUNITY_SIZE_MAX + OPPORTUNITY_SIZE_MIN) / 2;
-        static uint8_t buffer[OPPORTUNITY_SIZE_MAX];
+    std::mt19937 rng{SEED};
+    std::vector<uint8_t> sdu(SDU_SIZE, 0x5A);
+    std::vector<uint8_t> buffer(OPPORTUNITY_SIZE);
 
-        auto written = m_pEntity->createPdu(buffer, opSize);
-        if (written)
-        {
-            auto uplink = std::make_unique<NwRadioUplink>();
-            uplink->size = written;
-            uplink->data = buffer;
-            pair->push(std::move(uplink));
-        }
+    int submitted = 0, dataPdus = 0, statusPdus = 0;
+    int64_t now = 1;
 
-        if (continueTesting)
-            upperTransmission();
-    }
-
-    void onQuit() override
-    {
-    }
+    auto start = std::chrono::steady_clock::now();
 
-    void upperTransmission()
+    for (; now < MAX_SLOTS && sender.confirmed < SDU_COUNT; now++)
     {
-        packetId++;
-
-        if (packetId >= MAX_PACKET_SEND_COUNT)
+        for (int i = 0; i < SDUS_PER_SLOT && submitted < SDU_COUNT; i++)
         {
-            puts("ENOUGH TESTING TODAY");
-            tag = tag + "XX"; // it means transmission is done
-            continueTesting = false;
-            return;
+            if (submitted - sender.confirmed >= MAX_UNCONFIRMED)
+                break;
+            sender.entity->receiveSdu(sdu.data(), SDU_SIZE, ++submitted);
         }
 
-        static uint8_t packet[TRANSMISSION_SIZE];
-
-        m_pEntity->receiveSdu(packet, TRANSMISSION_SIZE, packetId);
-    }
+        sender.entity->timerCycle(now);
+        receiver.entity->timerCycle(now);
 
-    void deliverSdu(IRlcEntity *e, uint8_t *data, int size) override
-    {
-        receivedCounter++;
-        printf("[%s] PDU RECEIVED, TOTAL COUNT %d B\n", tag.c_str(), receivedCounter * TRANSMISSION_SIZE);
-        if (receivedCounter * TRANSMISSION_SIZE == 119998000)
-        {
-            printf("%ld\n", currentTimeMs());
-            exit(1);
-        }
+        Transmit(sender, receiver, now, loss, rng, buffer, dataPdus);
+        Transmit(receiver, sender, now, loss, rng, buffer, statusPdus);
 
-        fflush(stdout);
+        Receive(receiver, now);
+        Receive(sender, now);
     }
 
-    void maxRetransmissionReached(IRlcEntity *e) override
-    {
-        printf("[%s] RADIO LINK FAILURE\n", tag.c_str());
-        fflush(stdout);
-    }
+    double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    double goodput = static_cast<double>(receiver.deliveredBytes) * 8.0 / static_cast<double>(now) / 1000.0;
 
-    void sduSuccessfulDelivery(IRlcEntity *e, int sduId) override
-    {
-        printf("[%s] SDU %d DELIVERED\n", tag.c_str(), sduId);
-        fflush(stdout);
-    }
-};
+    printf("loss %5.1f%%  delivered %6d/%d  confirmed %6d  failures %3d  slots %7ld  goodput %7.1f Mbit/s  "
+           "pdus %7d/%6d  wall %7.3f s  %8.0f pdu/s\n",
+           loss * 100.0, receiver.delivered, SDU_COUNT, sender.confirmed, sender.failures, static_cast<long>(now),
+           goodput, dataPdus, statusPdus, wall, (dataPdus + statusPdus) / wall);
+    fflush(stdout);
+}
 
 void rlcTestMain()
 {
-    auto ueRlc = new RlcTask();
-    auto gnbRlc = new RlcTask();
+    printf("RLC AM benchmark: %d SDUs of %d bytes, %d x %d byte opportunities per slot, %d slot delay\n", SDU_COUNT,
+           SDU_SIZE, OPPORTUNITIES_PER_SLOT, OPPORTUNITY_SIZE, LINK_DELAY);
 
-    ueRlc->pair = gnbRlc;
-    gnbRlc->pair = ueRlc;
-
-    ueRlc->tag = "UE";
-    gnbRlc->tag = "GNB";
-
-    printf("%ld\n", currentTimeMs());
-    ueRlc->start();
-    gnbRlc->start();
+    for (double loss : LOSS_RATES)
+        RunScenario(loss);
 }
+
 } // namespace rlc
@@ -8,6 +8,7 @@
 
 #pragma once
 
+#include <algorithm>
 #include <cstring>
 #include <memory>
 #include <vector>
@@ -97,6 +98,15 @@ struct AmdPdu : RxPdu
     bool p;
 };
 
+struct AmdHeader
+{
+    bool p;
+    ESegmentInfo si;
+    int sn;
+    int so;
+    int size; // header size in octets
+};
+
 struct UmdPdu : RxPdu
 {
 };
@@ -204,6 +214,153 @@ class RlcTimer
     }
 };
 
+/*
+ * Byte ranges [start, end) of an RLC SDU, kept sorted, disjoint and non-adjacent in a fixed inline array so that
+ * the segment bookkeeping of an SDU needs no allocation.
+ */
+struct ByteRanges
+{
+    static constexpr const int CAPACITY = 8;
+
+    int count = 0;
+    int starts[CAPACITY]{};
+    int ends[CAPACITY]{};
+
+    [[nodiscard]] inline bool empty() const
+    {
+        return count == 0;
+    }
+
+    inline void clear()
+    {
+        count = 0;
+    }
+
+    [[nodiscard]] inline bool covers(int start, int end) const
+    {
+        for (int i = 0; i < count && starts[i] <= start; i++)
+            if (end <= ends[i])
+                return true;
+        return false;
+    }
+
+    [[nodiscard]] inline bool isSingle(int start, int end) const
+    {
+        return count == 1 && starts[0] == start && ends[0] == end;
+    }
+
+    // Adds the range, merging the ranges it overlaps or touches. Fails if a new range is needed but none is free.
+    inline bool add(int start, int end)
+    {
+        int i = 0;
+        while (i < count && ends[i] < start)
+            i++;
+        int j = i;
+        while (j < count && starts[j] <= end)
+            j++;
+
+        if (i == j)
+        {
+            if (count == CAPACITY)
+                return false;
+            for (int k = count; k > i; k--)
+            {
+                starts[k] = starts[k - 1];
+                ends[k] = ends[k - 1];
+            }
+            starts[i] = start;
+            ends[i] = end;
+            count++;
+            return true;
+        }
+
+        starts[i] = std::min(start, starts[i]);
+        ends[i] = std::max(end, ends[j - 1]);
+        for (int k = j; k < count; k++)
+        {
+            starts[i + 1 + k - j] = starts[k];
+            ends[i + 1 + k - j] = ends[k];
+        }
+        count -= j - i - 1;
+        return true;
+    }
+
+    // Like add, but if no range is free the new one is merged into its nearest neighbour, covering the gap too.
+    inline void addCoalescing(int start, int end)
+    {
+        if (add(start, end))
+            return;
+
+        int i = 0;
+        while (i < count && ends[i] < start)
+            i++;
+
+        if (i == count || (i > 0 && start - ends[i - 1] <= starts[i] - end))
+            ends[i - 1] = end;
+        else
+            starts[i] = start;
+    }
+
+    // Removes the given number of bytes from the front of the first range.
+    inline void consumeFront(int length)
+    {
+        starts[0] += length;
+        if (starts[0] < ends[0])
+            return;
+        for (int k = 1; k < count; k++)
+        {
+            starts[k - 1] = starts[k];
+            ends[k - 1] = ends[k];
+        }
+        count--;
+    }
+};
+
+/*
+ * Entries indexed by SN modulo a power of two capacity. The capacity grows as the span of SNs in use does, up to the
+ * window size, so that small bearers stay small while a full window of a long SN still has a slot per SN.
+ */
+template <typename T>
+class SnRing
+{
+    std::vector<T> entries;
+
+  public:
+    explicit SnRing(int capacity) : entries(static_cast<size_t>(capacity))
+    {
+    }
+
+    inline T &operator[](int sn)
+    {
+        return entries[static_cast<size_t>(sn) & (entries.size() - 1)];
+    }
+
+    // Makes room for the SNs from base to base + span - 1, keeping the entries of the SNs in use from base on.
+    void reserve(int base, int span, int snModulus)
+    {
+        int capacity = static_cast<int>(entries.size());
+        if (span <= capacity)
+            return;
+
+        int grownCapacity = capacity;
+        while (grownCapacity < span)
+            grownCapacity *= 2;
+
+        std::vector<T> grown(static_cast<size_t>(grownCapacity));
+        for (int i = 0; i < capacity; i++)
+        {
+            int sn = (base + i) % snModulus;
+            grown[sn & (grownCapacity - 1)] = std::move(entries[sn & (capacity - 1)]);
+        }
+        entries.swap(grown);
+    }
+
+    void reset(int capacity)
+    {
+        entries = std::vector<T>(static_cast<size_t>(capacity));
+    }
+};
+
 template <typename T>
 struct IComparator
 {
@@ -0,0 +1,270 @@
+//
+// This file is a part of UERANSIM project.
+// Copyright (c) 2023 ALİ GÜNGÖR.
+//
+// https://github.com/aligungr/UERANSIM/
+// See README, LICENSE, and CONTRIBUTING files for licensing details.
+//
+
+#include "rls_ack.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+
+#include <utils/common.hpp>
+
+// Retransmission timeout bounds in ms, RFC 6298 style with bounds suited to a simulated radio link
+static constexpr const int64_t ARQ_INITIAL_RTO = 200;
+static constexpr const int64_t ARQ_MIN_RTO = 20;
+static constexpr const int64_t ARQ_MAX_RTO = 1000;
+static constexpr const int64_t ARQ_CLOCK_GRANULARITY = 10;
+
+namespace rls
+{
+
+AckTracker::AckTracker() : m_mutex{}, m_received{}, m_sent{}, m_unackedCount{}
+{
+}
+
+uint32_t AckTracker::track(int peer, PduInfo &&info)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto &state = m_sent[peer];
+    if (state.lastSeq + 1 - state.base >= ARQ_WINDOW_SIZE)
+        return 0;
+
+    uint32_t seq = ++state.lastSeq;
+
+    auto &slot = state.ring[seq & (ARQ_WINDOW_SIZE - 1)];
+    slot.used = true;
+    slot.lastSent = info.sentTime;
+    slot.retransmissions = 0;
+    slot.info = std::move(info);
+
+    state.count++;
+    m_unackedCount++;
+    return seq;
+}
+
+void AckTracker::acknowledge(int peer, const RlsAckBlock &ack)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto it = m_sent.find(peer);
+    if (it == m_sent.end())
+        return;
+
+    auto &state = it->second;
+    int64_t now = utils::CurrentTimeMillis();
+
+    uint32_t cumulative = std::min(ack.cumulative, state.lastSeq);
+    for (uint32_t seq = state.base; seq <= cumulative; seq++)
+        release(state, seq, now);
+
+    for (int i = 0; i < ACK_BITMAP_SIZE; i++)
+    {
+        uint32_t seq = ack.cumulative + 2 + static_cast<uint32_t>(i);
+        if ((ack.bitmap >> i & 1) != 0 && seq >= state.base && seq <= state.lastSeq)
+            release(state, seq, now);
+    }
+
+    while (state.base <= state.lastSeq && !state.ring[state.base & (ARQ_WINDOW_SIZE - 1)].used)
+        state.base++;
+}
+
+void AckTracker::acknowledge(int peer, uint32_t seq)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto it = m_sent.find(peer);
+    if (it == m_sent.end())
+        return;
+
+    auto &state = it->second;
+    if (seq < state.base || seq > state.lastSeq)
+        return;
+
+    release(state, seq, utils::CurrentTimeMillis());
+
+    while (state.base <= state.lastSeq && !state.ring[state.base & (ARQ_WINDOW_SIZE - 1)].used)
+        state.base++;
+}
+
+void AckTracker::poll(int64_t now, int64_t ttl, std::vector<RlsRetransmission> &retransmissions,
+                      std::vector<PduInfo> &failures)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    for (auto &peer : m_sent)
+    {
+        auto &state = peer.second;
+        for (uint32_t seq = state.base; seq <= state.lastSeq; seq++)
+        {
+            auto &slot = state.ring[seq & (ARQ_WINDOW_SIZE - 1)];
+            if (!slot.used)
+                continue;
+
+            if (now - slot.info.sentTime > ttl)
+            {
+                failures.push_back(std::move(slot.info));
+                slot.used = false;
+                state.count--;
+                m_unackedCount--;
+                continue;
+            }
+
+            // Exponential backoff for each retransmission of the same PDU
+            int64_t rto = state.hasRtt ? state.rto : ARQ_INITIAL_RTO;
+            rto = std::min(rto << std::min(slot.retransmissions, 16), ARQ_MAX_RTO);
+            if (now - slot.lastSent < rto)
+                continue;
+
+            slot.lastSent = now;
+            slot.retransmissions++;
+
+            RlsRetransmission r{};
+            r.peer = peer.first;
+            r.seq = seq;
+            r.rrcChannel = slot.info.rrcChannel;
+            r.pdu = slot.info.pdu.copy();
+            retransmissions.push_back(std::move(r));
+        }
+
+        while (state.base <= state.lastSeq && !state.ring[state.base & (ARQ_WINDOW_SIZE - 1)].used)
+            state.base++;
+    }
+}
+
+size_t AckTracker::unackedCount() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_unackedCount;
+}
+
+bool AckTracker::receive(int peer, uint32_t seq)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto &window = m_received[peer];
+
+    // Acknowledged even if it is a duplicate, the previous ack may have been lost
+    window.owed = true;
+
+    if (seq <= window.cumulative)
+        return false;
+
+    if (seq == window.cumulative + 1)
+    {
+        window.cumulative++;
+        while ((window.bitmap & 1) != 0)
+        {
+            window.bitmap >>= 1;
+            window.cumulative++;
+        }
+        window.bitmap >>= 1;
+        return true;
+    }
+
+    uint32_t offset = seq - window.cumulative - 2;
+    if (offset >= static_cast<uint32_t>(ACK_BITMAP_SIZE))
+        return false; // beyond the window, it could not be told from a duplicate later so the sender has to retransmit
+
+    if ((window.bitmap >> offset & 1) != 0)
+        return false;
+    window.bitmap |= 1u << offset;
+    return true;
+}
+
+std::optional<RlsAckBlock> AckTracker::takeAck(int peer)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto it = m_received.find(peer);
+    if (it == m_received.end() || !it->second.owed)
+        return std::nullopt;
+
+    it->second.owed = false;
+    return RlsAckBlock{it->second.cumulative, it->second.bitmap};
+}
+
+bool AckTracker::isOwed(int peer) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto it = m_received.find(peer);
+    return it != m_received.end() && it->second.owed;
+}
+
+std::vector<int> AckTracker::owingPeers() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    std::vector<int> res{};
+    for (auto &item : m_received)
+        if (item.second.owed)
+            res.push_back(item.first);
+    return res;
+}
+
+void AckTracker::removePeer(int peer)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    m_received.erase(peer);
+
+    auto it = m_sent.find(peer);
+    if (it != m_sent.end())
+    {
+        m_unackedCount -= it->second.count;
+        m_sent.erase(it);
+    }
+}
+
+void AckTracker::clearUnacked(int peer)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto it = m_sent.find(peer);
+    if (it == m_sent.end())
+        return;
+
+    auto &state = it->second;
+    for (auto &slot : state.ring)
+        slot.used = false;
+    m_unackedCount -= state.count;
+    state.count = 0;
+    state.base = state.lastSeq + 1;
+}
+
+void AckTracker::release(SendState &state, uint32_t seq, int64_t now)
+{
+    auto &slot = state.ring[seq & (ARQ_WINDOW_SIZE - 1)];
+    if (!slot.used)
+        return;
+
+    // Karn's algorithm, the ack of a retransmitted PDU cannot tell which copy it acknowledges
+    if (slot.retransmissions == 0)
+    {
+        int64_t rtt = std::max(now - slot.info.sentTime, int64_t{0});
+        if (!state.hasRtt)
+        {
+            state.hasRtt = true;
+            state.srtt = rtt;
+            state.rttvar = rtt / 2;
+        }
+        else
+        {
+            state.rttvar = (3 * state.rttvar + std::abs(state.srtt - rtt)) / 4;
+            state.srtt = (7 * state.srtt + rtt) / 8;
+        }
+        state.rto = std::clamp(state.srtt + std::max(ARQ_CLOCK_GRANULARITY, 4 * state.rttvar), ARQ_MIN_RTO, ARQ_MAX_RTO);
+    }
+
+    slot.used = false;
+    slot.info = PduInfo{};
+    state.count--;
+    m_unackedCount--;
+}
+
+} // namespace rls
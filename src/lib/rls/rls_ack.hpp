@@ -0,0 +1,111 @@
+//
+// This file is a part of UERANSIM project.
+// Copyright (c) 2023 ALİ GÜNGÖR.
+//
+// https://github.com/aligungr/UERANSIM/
+// See README, LICENSE, and CONTRIBUTING files for licensing details.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+#include "rls_base.hpp"
+#include "rls_pdu.hpp"
+
+namespace rls
+{
+
+// Number of PDUs after the cumulative one that can be acknowledged selectively
+static constexpr const int ACK_BITMAP_SIZE = 32;
+// Number of reliable PDUs that can be awaiting an ack per peer, must be a power of two
+static constexpr const uint32_t ARQ_WINDOW_SIZE = 256;
+
+/* Reliable PDU whose retransmission timer has expired */
+struct RlsRetransmission
+{
+    int peer{};
+    uint32_t seq{};
+    rrc::RrcChannel rrcChannel{};
+    OctetString pdu{};
+};
+
+/*
+ * Acknowledgement and retransmission state of the reliable PDUs exchanged with each peer of an RLS end-point.
+ *
+ * Reliable PDUs are numbered per peer starting from 1, the number is carried in the pduId field. The receiver
+ * acknowledges them with a cumulative number and a bitmap of the ones received after a gap, and the block is
+ * piggybacked on whatever is sent to the peer next. The sender keeps the unacknowledged PDUs in a ring indexed by
+ * the sequence number, and retransmits them on an RTO derived from the measured round-trip time of the peer.
+ * Shared by the control and the radio link task of the end-point.
+ */
+class AckTracker
+{
+  private:
+    struct ReceiveWindow
+    {
+        uint32_t cumulative{};
+        uint32_t bitmap{};
+        bool owed{};
+    };
+
+    struct PendingPdu
+    {
+        bool used{};
+        PduInfo info{};
+        int64_t lastSent{};
+        int retransmissions{};
+    };
+
+    struct SendState
+    {
+        uint32_t lastSeq{};
+        uint32_t base = 1; // oldest sequence number that may still be unacknowledged
+        std::vector<PendingPdu> ring = std::vector<PendingPdu>(ARQ_WINDOW_SIZE);
+        size_t count{};
+        bool hasRtt{};
+        int64_t srtt{};
+        int64_t rttvar{};
+        int64_t rto{};
+    };
+
+  private:
+    mutable std::mutex m_mutex;
+    std::unordered_map<int, ReceiveWindow> m_received; // by peer
+    std::unordered_map<int, SendState> m_sent;          // by peer
+    size_t m_unackedCount;
+
+  public:
+    AckTracker();
+
+  public:
+    /* Stores the PDU until it is acknowledged, returns the sequence number assigned to it or 0 if the window of the
+     * peer is full */
+    uint32_t track(int peer, PduInfo &&info);
+    void acknowledge(int peer, const RlsAckBlock &ack);
+    void acknowledge(int peer, uint32_t seq);
+    /* Collects the PDUs to be retransmitted, and removes the ones not acknowledged within the given time */
+    void poll(int64_t now, int64_t ttl, std::vector<RlsRetransmission> &retransmissions,
+              std::vector<PduInfo> &failures);
+    [[nodiscard]] size_t unackedCount() const;
+
+    /* Records a received PDU and owes the peer an ack, returns false if it is a duplicate or beyond the bitmap of
+     * the ack, in which case it is dropped and left to the retransmission of the sender */
+    bool receive(int peer, uint32_t seq);
+    /* Returns the ack owed to the peer, if any */
+    std::optional<RlsAckBlock> takeAck(int peer);
+    [[nodiscard]] bool isOwed(int peer) const;
+    [[nodiscard]] std::vector<int> owingPeers() const;
+
+    void removePeer(int peer);
+    void clearUnacked(int peer);
+
+  private:
+    void release(SendState &state, uint32_t seq, int64_t now);
+};
+
+} // namespace rls
@@ -0,0 +1,95 @@
+//
+// This file is a part of UERANSIM project.
+// Copyright (c) 2023 ALİ GÜNGÖR.
+//
+// https://github.com/aligungr/UERANSIM/
+// See README, LICENSE, and CONTRIBUTING files for licensing details.
+//
+
+#include "rls_aggregator.hpp"
+
+// Encoded size of the aggregate without its PDUs: compatibility octet, version, message type, STI, PDU count
+static constexpr const int AGGREGATE_HEADER_SIZE = 15;
+// Encoded size of a PDU entry without the PDU itself: PDU type, PDU ID, payload, length
+static constexpr const int AGGREGATE_ENTRY_SIZE = 11;
+
+namespace rls
+{
+
+PduAggregator::PduAggregator(uint64_t sti, int mtu) : m_sti{sti}, m_mtu{mtu}, m_batches{}
+{
+}
+
+std::vector<std::unique_ptr<RlsMessage>> PduAggregator::add(int peer, RlsPduTransmission &&pdu)
+{
+    std::vector<std::unique_ptr<RlsMessage>> ready{};
+
+    int size = AGGREGATE_ENTRY_SIZE + pdu.pdu.length();
+
+    auto &batch = m_batches[peer];
+    if (!batch.pdus.empty() && (batch.size + size > m_mtu || batch.pdus.size() >= static_cast<size_t>(MAX_AGGREGATE_PDUS)))
+        ready.push_back(release(batch));
+
+    if (batch.pdus.empty())
+        batch.size = AGGREGATE_HEADER_SIZE;
+
+    batch.pdus.push_back(std::move(pdu));
+    batch.size += size;
+
+    // PDUs too large to share a datagram are not held back
+    if (batch.size >= m_mtu)
+        ready.push_back(release(batch));
+
+    return ready;
+}
+
+std::unique_ptr<RlsMessage> PduAggregator::take(int peer)
+{
+    auto it = m_batches.find(peer);
+    if (it == m_batches.end() || it->second.pdus.empty())
+        return nullptr;
+    return release(it->second);
+}
+
+std::vector<std::pair<int, std::unique_ptr<RlsMessage>>> PduAggregator::takeAll()
+{
+    std::vector<std::pair<int, std::unique_ptr<RlsMessage>>> res{};
+    for (auto &item : m_batches)
+        if (!item.second.pdus.empty())
+            res.emplace_back(item.first, release(item.second));
+    return res;
+}
+
+void PduAggregator::remove(int peer)
+{
+    m_batches.erase(peer);
+}
+
+bool PduAggregator::empty() const
+{
+    for (auto &item : m_batches)
+        if (!item.second.pdus.empty())
+            return false;
+    return true;
+}
+
+std::unique_ptr<RlsMessage> PduAggregator::release(Batch &batch)
+{
+    std::unique_ptr<RlsMessage> res;
+    if (batch.pdus.size() == 1)
+    {
+        res = std::make_unique<RlsPduTransmission>(std::move(batch.pdus[0]));
+    }
+    else
+    {
+        auto aggregate = std::make_unique<RlsPduAggregate>(m_sti);
+        aggregate->pdus = std::move(batch.pdus);
+        res = std::move(aggregate);
+    }
+
+    batch.pdus.clear();
+    batch.size = 0;
+    return res;
+}
+
+} // namespace rls
@@ -0,0 +1,58 @@
+//
+// This file is a part of UERANSIM project.
+// Copyright (c) 2023 ALİ GÜNGÖR.
+//
+// https://github.com/aligungr/UERANSIM/
+// See README, LICENSE, and CONTRIBUTING files for licensing details.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "rls_pdu.hpp"
+
+namespace rls
+{
+
+/*
+ * Coalesces the PDU transmissions towards each peer into PDU_AGGREGATE messages of at most the given MTU, so that
+ * small packets share the RLS header and a single datagram. A batch holding a single PDU is sent as a plain
+ * PDU_TRANSMISSION. Batches are released when they are full, or by the owner when its aggregation window ends.
+ */
+class PduAggregator
+{
+  private:
+    struct Batch
+    {
+        std::vector<RlsPduTransmission> pdus{};
+        int size{};
+    };
+
+  private:
+    uint64_t m_sti;
+    int m_mtu;
+    std::unordered_map<int, Batch> m_batches; // by peer
+
+  public:
+    PduAggregator(uint64_t sti, int mtu);
+
+  public:
+    /* Queues the PDU, returns the messages that are ready to be sent to the peer */
+    std::vector<std::unique_ptr<RlsMessage>> add(int peer, RlsPduTransmission &&pdu);
+    /* Returns the pending batch of the peer, nullptr if there is none */
+    std::unique_ptr<RlsMessage> take(int peer);
+    /* Returns the pending batches of all peers */
+    std::vector<std::pair<int, std::unique_ptr<RlsMessage>>> takeAll();
+    void remove(int peer);
+    [[nodiscard]] bool empty() const;
+
+  private:
+    std::unique_ptr<RlsMessage> release(Batch &batch);
+};
+
+} // namespace rls
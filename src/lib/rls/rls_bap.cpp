@@ -0,0 +1,54 @@
+//
+// This file is a part of UERANSIM project.
+// Copyright (c) 2023 ALİ GÜNGÖR.
+//
+// https://github.com/aligungr/UERANSIM/
+// See README, LICENSE, and CONTRIBUTING files for licensing details.
+//
+
+#include "rls_bap.hpp"
+
+namespace rls
+{
+
+void EncodeBapHeader(const BapHeader &header, OctetString &stream)
+{
+    int destination = header.destination & 0x3FF;
+    int pathId = header.pathId & 0x3FF;
+
+    // D/C | R | R | R | DESTINATION (4 MSB)
+    stream.appendOctet(static_cast<uint8_t>((header.isData ? 0x80 : 0x00) | (destination >> 6)));
+    // DESTINATION (6 LSB) | PATH (2 MSB)
+    stream.appendOctet(static_cast<uint8_t>(((destination & 0x3F) << 2) | (pathId >> 8)));
+    // PATH (8 LSB)
+    stream.appendOctet(static_cast<uint8_t>(pathId & 0xFF));
+}
+
+bool DecodeBapHeader(const OctetString &pdu, BapHeader &header)
+{
+    if (pdu.length() < BAP_HEADER_SIZE)
+        return false;
+
+    const uint8_t *data = pdu.data();
+    header.isData = (data[0] & 0x80) != 0;
+    header.destination = ((data[0] & 0x0F) << 6) | (data[1] >> 2);
+    header.pathId = ((data[1] & 0x03) << 8) | data[2];
+    return true;
+}
+
+uint32_t EncodeBapContext(const BapContext &ctx)
+{
+    return (static_cast<uint32_t>(ctx.source & 0x3FF) << 22) | (static_cast<uint32_t>(ctx.ueId & 0x3FFFF) << 4) |
+           static_cast<uint32_t>(ctx.psi & 0xF);
+}
+
+BapContext DecodeBapContext(uint32_t payload)
+{
+    BapContext ctx{};
+    ctx.source = static_cast<int>(payload >> 22);
+    ctx.ueId = static_cast<int>((payload >> 4) & 0x3FFFF);
+    ctx.psi = static_cast<int>(payload & 0xF);
+    return ctx;
+}
+
+} // namespace rls
@@ -0,0 +1,44 @@
+//
+// This file is a part of UERANSIM project.
+// Copyright (c) 2023 ALİ GÜNGÖR.
+//
+// https://github.com/aligungr/UERANSIM/
+// See README, LICENSE, and CONTRIBUTING files for licensing details.
+//
+
+#pragma once
+
+#include <cstdint>
+
+#include <utils/octet_string.hpp>
+
+namespace rls
+{
+
+// BAP addresses and path identities are 10-bit values (38.340)
+static constexpr const int BAP_ADDRESS_COUNT = 1024;
+static constexpr const int BAP_HEADER_SIZE = 3;
+
+/* Backhaul adaptation header, carried in front of the inner packet of RELAY PDUs */
+struct BapHeader
+{
+    bool isData{};    // D/C bit, control PDUs are hop-local and never forwarded
+    int destination{}; // BAP address of the node that terminates the PDU
+    int pathId{};
+};
+
+/* End-point context, carried in the payload field of RELAY PDUs. Forwarding nodes never look into it. */
+struct BapContext
+{
+    int source{}; // BAP address of the access relay (10-bit)
+    int ueId{};   // UE identity at the access relay (18-bit)
+    int psi{};    // PDU session identity (4-bit)
+};
+
+void EncodeBapHeader(const BapHeader &header, OctetString &stream);
+bool DecodeBapHeader(const OctetString &pdu, BapHeader &header);
+
+uint32_t EncodeBapContext(const BapContext &ctx);
+BapContext DecodeBapContext(uint32_t payload);
+
+} // namespace rls
@@ -6,6 +6,8 @@
 // See README, LICENSE, and CONTRIBUTING files for licensing details.
 //
 
+#pragma once
+
 #include "rls_pdu.hpp"
 
 #include <lib/rrc/rrc.hpp>
@@ -26,7 +28,8 @@ enum class ERlfCause
 {
     PDU_ID_EXISTS,
     PDU_ID_FULL,
-    SIGNAL_LOST_TO_CONNECTED_CELL
+    SIGNAL_LOST_TO_CONNECTED_CELL,
+    RLC_MAX_RETRANSMISSION
 };
 
 } // namespace rls
\ No newline at end of file
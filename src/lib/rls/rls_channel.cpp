@@ -0,0 +1,185 @@
+//
+// This file is a part of UERANSIM project.
+// Copyright (c) 2023 ALİ GÜNGÖR.
+//
+// https://github.com/aligungr/UERANSIM/
+// See README, LICENSE, and CONTRIBUTING files for licensing details.
+//
+
+#include "rls_channel.hpp"
+#include "rls_pdu.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+static int64_t CurrentTimeMicros()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+static std::string AddressKey(const InetAddress &address)
+{
+    return std::string{reinterpret_cast<const char *>(address.getSockAddr()), address.getSockLen()};
+}
+
+namespace rls
+{
+
+ChannelTransport::ChannelTransport(std::unique_ptr<RlsTransport> inner, ChannelConfig config, uint64_t stream)
+    : m_inner{std::move(inner)}, m_config{std::move(config)},
+      m_random{m_config.seed ^ (stream * 0x9E3779B97F4A7C15ull)}, m_links{}, m_anonymous{}, m_pending{}, m_order{}
+{
+    if (m_config.bands.empty())
+        m_config.bands.emplace_back();
+}
+
+int ChannelTransport::receive(uint8_t *buffer, size_t bufferSize, int timeoutMs, InetAddress &outPeerAddress)
+{
+    int64_t deadline = CurrentTimeMicros() + static_cast<int64_t>(timeoutMs) * 1000;
+    bool polled = false;
+
+    while (true)
+    {
+        int64_t now = CurrentTimeMicros();
+        if (!m_pending.empty() && m_pending.front().release <= now)
+            return deliver(buffer, bufferSize, outPeerAddress);
+        if (polled && now >= deadline)
+            return 0;
+
+        int64_t wait = deadline - now;
+        if (!m_pending.empty())
+            wait = std::min(wait, m_pending.front().release - now);
+        polled = true;
+
+        // Transports take a zero timeout as no timeout at all
+        int waitMs = static_cast<int>(std::max<int64_t>((wait + 999) / 1000, 1));
+        int size = m_inner->receive(buffer, bufferSize, waitMs, outPeerAddress);
+        if (size <= 0)
+            continue;
+
+        now = CurrentTimeMicros();
+        int64_t release{};
+        if (!admit(outPeerAddress, buffer, static_cast<size_t>(size), now, release))
+            continue;
+
+        // Datagrams of an unimpaired link are delivered without being copied
+        if (release <= now && (m_pending.empty() || m_pending.front().release > now))
+            return size;
+
+        m_pending.push_back(Datagram{release, m_order++, outPeerAddress, {buffer, buffer + size}});
+        std::push_heap(m_pending.begin(), m_pending.end(), IsLater);
+    }
+}
+
+void ChannelTransport::send(const InetAddress &address, const uint8_t *buffer, size_t bufferSize)
+{
+    m_inner->send(address, buffer, bufferSize);
+}
+
+void ChannelTransport::sendBatch(const std::vector<InetAddress> &addresses, const uint8_t *buffer, size_t bufferSize)
+{
+    m_inner->sendBatch(addresses, buffer, bufferSize);
+}
+
+uint16_t ChannelTransport::localPort(int ipVersion) const
+{
+    return m_inner->localPort(ipVersion);
+}
+
+void ChannelTransport::setLinkQuality(uint64_t sti, int dbm)
+{
+    auto &bands = m_config.bands;
+
+    size_t profile = bands.size() - 1;
+    for (size_t i = 0; i < bands.size(); i++)
+    {
+        if (dbm >= bands[i].minDbm)
+        {
+            profile = i;
+            break;
+        }
+    }
+
+    findLink(sti, {}).profile = profile;
+}
+
+bool ChannelTransport::admit(const InetAddress &source, const uint8_t *data, size_t size, int64_t now,
+                             int64_t &outRelease)
+{
+    auto &link = findLink(PeekRlsSti(data, size), source);
+    auto &profile = m_config.bands[link.profile];
+
+    if (profile.burstEnter > 0)
+    {
+        if (link.burst ? chance(profile.burstExit) : chance(profile.burstEnter))
+            link.burst = !link.burst;
+        if (chance(link.burst ? profile.burstLoss : profile.loss))
+            return false;
+    }
+    else if (chance(profile.loss))
+    {
+        return false;
+    }
+
+    int64_t departure = now;
+    if (profile.rate > 0)
+    {
+        // Virtual finishing time of the link, lagging behind the clock by at most the bucket depth
+        int64_t bucket = static_cast<int64_t>(profile.burst) * 8000 / profile.rate;
+        int64_t start = std::max(link.busyUntil, now - bucket);
+        if (start - now > static_cast<int64_t>(profile.queue) * 1000)
+            return false;
+
+        link.busyUntil = start + static_cast<int64_t>(size) * 8000 / profile.rate;
+        departure = std::max(now, link.busyUntil);
+    }
+
+    int64_t delay = static_cast<int64_t>(profile.delay) * 1000;
+    if (profile.jitter > 0)
+    {
+        std::uniform_int_distribution<int64_t> jitter{-profile.jitter * 1000LL, profile.jitter * 1000LL};
+        delay = std::max<int64_t>(0, delay + jitter(m_random));
+    }
+    if (chance(profile.reorder))
+        delay += static_cast<int64_t>(profile.reorderDelay) * 1000;
+
+    outRelease = departure + delay;
+    return true;
+}
+
+int ChannelTransport::deliver(uint8_t *buffer, size_t bufferSize, InetAddress &outPeerAddress)
+{
+    std::pop_heap(m_pending.begin(), m_pending.end(), IsLater);
+    auto &datagram = m_pending.back();
+
+    size_t size = std::min(bufferSize, datagram.data.size());
+    std::memcpy(buffer, datagram.data.data(), size);
+    outPeerAddress = datagram.source;
+
+    m_pending.pop_back();
+    return static_cast<int>(size);
+}
+
+bool ChannelTransport::chance(double probability)
+{
+    if (probability <= 0)
+        return false;
+    return std::uniform_real_distribution<double>{0.0, 1.0}(m_random) < probability;
+}
+
+bool ChannelTransport::IsLater(const Datagram &a, const Datagram &b)
+{
+    return a.release != b.release ? a.release > b.release : a.order > b.order;
+}
+
+ChannelTransport::Link &ChannelTransport::findLink(uint64_t sti, const InetAddress &address)
+{
+    if (sti != 0)
+        return m_links.try_emplace(sti, Link{m_config.bands.size() - 1}).first->second;
+    return m_anonymous.try_emplace(AddressKey(address), Link{m_config.bands.size() - 1}).first->second;
+}
+
+} // namespace rls
@@ -0,0 +1,107 @@
+//
+// This file is a part of UERANSIM project.
+// Copyright (c) 2023 ALİ GÜNGÖR.
+//
+// https://github.com/aligungr/UERANSIM/
+// See README, LICENSE, and CONTRIBUTING files for licensing details.
+//
+
+#pragma once
+
+#include "rls_transport.hpp"
+
+#include <climits>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <utils/network.hpp>
+
+namespace rls
+{
+
+/* Impairments of the radio links whose simulated signal strength falls into a band */
+struct ChannelProfile
+{
+    int minDbm = INT_MIN;  // the profile applies to links at least this strong
+    double loss{};         // probability of losing a datagram, in the good state if bursts are enabled
+    double burstEnter{};   // Gilbert-Elliott good to bad state transition probability, 0 for Bernoulli loss
+    double burstExit = 1;  // bad to good state transition probability
+    double burstLoss = 1;  // probability of losing a datagram in the bad state
+    int delay{};           // ms
+    int jitter{};          // ms, the delay varies uniformly in [delay - jitter, delay + jitter]
+    double reorder{};      // probability of holding a datagram back so that later ones overtake it
+    int reorderDelay = 10; // ms
+    int rate{};            // link capacity in kbit/s, 0 if not limited
+    int burst = 15000;     // bytes, token bucket depth of the link capacity
+    int queue = 100;       // ms of backlog the link buffers before it drops datagrams
+};
+
+struct ChannelConfig
+{
+    uint64_t seed{};
+    std::vector<ChannelProfile> bands{}; // by decreasing minDbm
+};
+
+/*
+ * Emulates an imperfect radio channel on top of another transport.
+ *
+ * Impairments are applied to received datagrams, so every direction of a link is emulated by its receiving end and
+ * delayed datagrams are released by the receiving thread itself. The profile of a link is selected by the signal
+ * strength reported with setLinkQuality, links of unknown strength use the last (weakest) band. Links are identified
+ * by the STI of the sender, datagrams without one (such as the heartbeat aggregates of a UE process) by their source
+ * address. Random decisions are
+ * taken from a generator seeded by the configuration, so runs with the same traffic are reproducible. Sending is left
+ * to the inner transport untouched, so it is as thread-safe as the inner one.
+ */
+class ChannelTransport : public RlsTransport
+{
+  private:
+    struct Link
+    {
+        size_t profile{};
+        bool burst{};         // in the bad state of the Gilbert-Elliott model
+        int64_t busyUntil{};  // us, when the link has transmitted everything admitted so far
+    };
+
+    struct Datagram
+    {
+        int64_t release{}; // us
+        uint64_t order{};
+        InetAddress source{};
+        std::vector<uint8_t> data{};
+    };
+
+  private:
+    std::unique_ptr<RlsTransport> m_inner;
+    ChannelConfig m_config;
+    std::mt19937_64 m_random;
+    std::unordered_map<uint64_t, Link> m_links;        // by peer STI
+    std::unordered_map<std::string, Link> m_anonymous; // by peer address, of the datagrams without an STI
+    std::vector<Datagram> m_pending;                   // heap by release time
+    uint64_t m_order;
+
+  public:
+    /* Transports of the same configuration take a different stream of random numbers each */
+    ChannelTransport(std::unique_ptr<RlsTransport> inner, ChannelConfig config, uint64_t stream);
+
+    int receive(uint8_t *buffer, size_t bufferSize, int timeoutMs, InetAddress &outPeerAddress) override;
+    void send(const InetAddress &address, const uint8_t *buffer, size_t bufferSize) override;
+    void sendBatch(const std::vector<InetAddress> &addresses, const uint8_t *buffer, size_t bufferSize) override;
+    void setLinkQuality(uint64_t sti, int dbm) override;
+    [[nodiscard]] uint16_t localPort(int ipVersion) const override;
+
+  private:
+    /* Returns false if the datagram is lost, otherwise the time it is to be delivered at */
+    bool admit(const InetAddress &source, const uint8_t *data, size_t size, int64_t now, int64_t &outRelease);
+    int deliver(uint8_t *buffer, size_t bufferSize, InetAddress &outPeerAddress);
+    bool chance(double probability);
+    Link &findLink(uint64_t sti, const InetAddress &address);
+
+    static bool IsLater(const Datagram &a, const Datagram &b);
+};
+
+} // namespace rls
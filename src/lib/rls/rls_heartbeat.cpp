@@ -0,0 +1,62 @@
+//
+// This file is a part of UERANSIM project.
+// Copyright (c) 2023 ALİ GÜNGÖR.
+//
+// https://github.com/aligungr/UERANSIM/
+// See README, LICENSE, and CONTRIBUTING files for licensing details.
+//
+
+#include "rls_heartbeat.hpp"
+
+#include <algorithm>
+
+// Lower bound of the heartbeat timeout, the value used before the interval was announced
+static constexpr const int MIN_HEARTBEAT_TIMEOUT = 2000;
+
+namespace rls
+{
+
+int HeartbeatTimeout(int interval)
+{
+    return std::max(MIN_HEARTBEAT_TIMEOUT, 2 * interval);
+}
+
+HeartbeatPacer::HeartbeatPacer() : m_interval{HEARTBEAT_SEARCH_INTERVAL}, m_nextRound{}, m_changed{}
+{
+}
+
+bool HeartbeatPacer::isDue(int64_t now) const
+{
+    return now >= m_nextRound;
+}
+
+int HeartbeatPacer::startRound(int64_t now, bool searching)
+{
+    if (searching)
+        m_interval = HEARTBEAT_SEARCH_INTERVAL;
+    else if (m_changed || m_interval < HEARTBEAT_BASE_INTERVAL)
+        m_interval = HEARTBEAT_BASE_INTERVAL;
+    else
+        m_interval = std::min(m_interval * 2, HEARTBEAT_MAX_INTERVAL);
+
+    m_changed = false;
+    m_nextRound = now + m_interval;
+    return m_interval;
+}
+
+void HeartbeatPacer::notifyChange()
+{
+    m_changed = true;
+}
+
+int HeartbeatPacer::interval() const
+{
+    return m_interval;
+}
+
+bool HeartbeatPacer::isSuppressed(int64_t lastSent, int64_t lastReceived, int64_t now) const
+{
+    return now - lastSent < m_interval && now - lastReceived < m_interval;
+}
+
+} // namespace rls
@@ -0,0 +1,54 @@
+//
+// This file is a part of UERANSIM project.
+// Copyright (c) 2023 ALİ GÜNGÖR.
+//
+// https://github.com/aligungr/UERANSIM/
+// See README, LICENSE, and CONTRIBUTING files for licensing details.
+//
+
+#pragma once
+
+#include <cstdint>
+
+namespace rls
+{
+
+// Heartbeat intervals of a UE in ms
+static constexpr const int HEARTBEAT_SEARCH_INTERVAL = 500;
+static constexpr const int HEARTBEAT_BASE_INTERVAL = 1000;
+static constexpr const int HEARTBEAT_MAX_INTERVAL = 8000;
+
+/* Time after which a peer that announced the given heartbeat interval is considered lost */
+int HeartbeatTimeout(int interval);
+
+/*
+ * Decides when a UE sends its next round of heartbeats.
+ *
+ * Cells are probed quickly while none is known. Once they are, the interval doubles after each round in which nothing
+ * changed (cells found or lost, signal strengths, the position of the UE) up to HEARTBEAT_MAX_INTERVAL, and falls back
+ * to HEARTBEAT_BASE_INTERVAL on any change. The interval is announced in the heartbeats, so that the cells scale their
+ * timeout of the UE accordingly.
+ */
+class HeartbeatPacer
+{
+  private:
+    int m_interval;
+    int64_t m_nextRound;
+    bool m_changed;
+
+  public:
+    HeartbeatPacer();
+
+  public:
+    [[nodiscard]] bool isDue(int64_t now) const;
+    /* Starts a round of heartbeats, returns the interval to announce in them */
+    int startRound(int64_t now, bool searching);
+    /* Marks a change to be reflected by the next round */
+    void notifyChange();
+    [[nodiscard]] int interval() const;
+
+    /* A cell receiving and sending traffic within the interval needs no heartbeat, the traffic keeps both ends alive */
+    [[nodiscard]] bool isSuppressed(int64_t lastSent, int64_t lastReceived, int64_t now) const;
+};
+
+} // namespace rls
@@ -0,0 +1,130 @@
+//
+// This file is a part of UERANSIM project.
+// Copyright (c) 2023 ALİ GÜNGÖR.
+//
+// https://github.com/aligungr/UERANSIM/
+// See README, LICENSE, and CONTRIBUTING files for licensing details.
+//
+
+#include "rls_liveness.hpp"
+
+#include <algorithm>
+
+namespace rls
+{
+
+LivenessWheel::LivenessWheel(int64_t tick, int64_t maxTimeout)
+    : m_tick{tick}, m_maxTimeout{maxTimeout}, m_currentTick{-1}, m_slots{}, m_nodes{}, m_freeNodes{}
+{
+    // A deadline is at most maxTimeout / tick + 1 ticks ahead, so it never wraps onto a slot that is not drained yet
+    m_slots.resize(static_cast<size_t>(maxTimeout / tick + 2), NO_HANDLE);
+}
+
+size_t LivenessWheel::add(int id, int64_t now, int64_t timeout)
+{
+    size_t handle;
+    if (m_freeNodes.empty())
+    {
+        handle = m_nodes.size();
+        m_nodes.emplace_back();
+    }
+    else
+    {
+        handle = m_freeNodes.back();
+        m_freeNodes.pop_back();
+    }
+
+    m_nodes[handle].id = id;
+    link(handle, deadlineOf(now, timeout));
+    return handle;
+}
+
+void LivenessWheel::refresh(size_t handle, int64_t now, int64_t timeout)
+{
+    unlink(handle);
+    link(handle, deadlineOf(now, timeout));
+}
+
+void LivenessWheel::remove(size_t handle)
+{
+    unlink(handle);
+    m_freeNodes.push_back(handle);
+}
+
+void LivenessWheel::expire(int64_t now, std::vector<int> &expired)
+{
+    int64_t nowTick = now / m_tick;
+    if (m_currentTick < 0)
+        m_currentTick = nowTick;
+
+    // After a stall longer than the wheel, every slot is due once
+    if (nowTick - m_currentTick >= static_cast<int64_t>(m_slots.size()))
+        m_currentTick = nowTick - static_cast<int64_t>(m_slots.size()) + 1;
+
+    for (; m_currentTick <= nowTick; m_currentTick++)
+    {
+        auto &head = m_slots[static_cast<size_t>(m_currentTick) % m_slots.size()];
+        size_t handle = head;
+        head = NO_HANDLE;
+
+        while (handle != NO_HANDLE)
+        {
+            auto &node = m_nodes[handle];
+            size_t next = node.next;
+            node.slot = NO_HANDLE;
+
+            // Nodes linked while the wheel was lagging behind may share the slot with a later deadline
+            if (node.deadline > nowTick)
+            {
+                link(handle, node.deadline);
+            }
+            else
+            {
+                expired.push_back(node.id);
+                m_freeNodes.push_back(handle);
+            }
+            handle = next;
+        }
+    }
+}
+
+int64_t LivenessWheel::deadlineOf(int64_t now, int64_t timeout) const
+{
+    // Rounded up so that a peer lives at least for the timeout
+    return (now + std::min(timeout, m_maxTimeout) + m_tick - 1) / m_tick;
+}
+
+void LivenessWheel::link(size_t handle, int64_t deadline)
+{
+    size_t slot = static_cast<size_t>(deadline) % m_slots.size();
+
+    auto &node = m_nodes[handle];
+    node.deadline = deadline;
+    node.slot = slot;
+    node.prev = NO_HANDLE;
+    node.next = m_slots[slot];
+    if (node.next != NO_HANDLE)
+        m_nodes[node.next].prev = handle;
+    m_slots[slot] = handle;
+}
+
+void LivenessWheel::unlink(size_t handle)
+{
+    auto &node = m_nodes[handle];
+    if (node.slot == NO_HANDLE)
+        return;
+
+    if (node.prev != NO_HANDLE)
+        m_nodes[node.prev].next = node.next;
+    else
+        m_slots[node.slot] = node.next;
+
+    if (node.next != NO_HANDLE)
+        m_nodes[node.next].prev = node.prev;
+
+    node.prev = NO_HANDLE;
+    node.next = NO_HANDLE;
+    node.slot = NO_HANDLE;
+}
+
+} // namespace rls
@@ -0,0 +1,66 @@
+//
+// This file is a part of UERANSIM project.
+// Copyright (c) 2023 ALİ GÜNGÖR.
+//
+// https://github.com/aligungr/UERANSIM/
+// See README, LICENSE, and CONTRIBUTING files for licensing details.
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace rls
+{
+
+/*
+ * Timing wheel of the peers of an RLS end-point that are considered alive.
+ *
+ * Each peer sits in the slot of the tick its liveness expires at, slots are intrusive doubly linked lists so that
+ * re-arming a peer on a heartbeat or any other message is O(1). Peers may have different timeouts, up to the maximum
+ * the wheel is created with. Advancing the wheel only visits the slots of the elapsed ticks, so the cost of expiry is
+ * proportional to the number of peers lost.
+ */
+class LivenessWheel
+{
+  public:
+    static constexpr const size_t NO_HANDLE = SIZE_MAX;
+
+  private:
+    struct Node
+    {
+        int id{};
+        int64_t deadline{}; // in ticks
+        size_t prev = NO_HANDLE;
+        size_t next = NO_HANDLE;
+        size_t slot = NO_HANDLE;
+    };
+
+  private:
+    int64_t m_tick;
+    int64_t m_maxTimeout;
+    int64_t m_currentTick; // next tick to be expired
+    std::vector<size_t> m_slots;
+    std::vector<Node> m_nodes;
+    std::vector<size_t> m_freeNodes;
+
+  public:
+    LivenessWheel(int64_t tick, int64_t maxTimeout);
+
+  public:
+    /* Starts tracking the peer, returns the handle to refresh or remove it with */
+    size_t add(int id, int64_t now, int64_t timeout);
+    void refresh(size_t handle, int64_t now, int64_t timeout);
+    void remove(size_t handle);
+    /* Appends the peers not refreshed within the timeout to the list, and stops tracking them */
+    void expire(int64_t now, std::vector<int> &expired);
+
+  private:
+    [[nodiscard]] int64_t deadlineOf(int64_t now, int64_t timeout) const;
+    void link(size_t handle, int64_t deadline);
+    void unlink(size_t handle);
+};
+
+} // namespace rls
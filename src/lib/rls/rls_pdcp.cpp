@@ -0,0 +1,326 @@
+//
+// This file is a part of UERANSIM project.
+// Copyright (c) 2023 ALİ GÜNGÖR.
+//
+// https://github.com/aligungr/UERANSIM/
+// See README, LICENSE, and CONTRIBUTING files for licensing details.
+//
+
+#include "rls_pdcp.hpp"
+
+#include <algorithm>
+#include <iterator>
+
+#include <lib/crypt/crypt.hpp>
+
+static constexpr const int MAC_I_SIZE = 4;
+// Bearers without integrity protection accept COUNTs within this fraction of the SN window around their state
+static constexpr const uint32_t PLAUSIBLE_WINDOW_FRACTION = 4;
+
+// Algorithm type distinguishers of TS 33.501 Table A.8-1
+static constexpr const int N_UP_ENC_ALG = 0x05;
+static constexpr const int N_UP_INT_ALG = 0x06;
+
+// Mode of a bearer in the RLS payload, the PSI is in the low octet
+static constexpr const uint32_t MODE_SN18 = 1u << 8;
+static constexpr const int MODE_CIPHERING_SHIFT = 12;
+static constexpr const int MODE_INTEGRITY_SHIFT = 16;
+static constexpr const uint32_t MODE_MASK = MODE_SN18 | 3u << MODE_CIPHERING_SHIFT | 3u << MODE_INTEGRITY_SHIFT;
+
+namespace rls
+{
+
+static int64_t BearerKey(int peer, int psi)
+{
+    return static_cast<int64_t>(peer) << 8 | (psi & 0xFF);
+}
+
+static int SnLength(uint32_t mode)
+{
+    return (mode & MODE_SN18) ? 18 : 12;
+}
+
+static int Ciphering(uint32_t mode)
+{
+    return static_cast<int>(mode >> MODE_CIPHERING_SHIFT & 3);
+}
+
+static int Integrity(uint32_t mode)
+{
+    return static_cast<int>(mode >> MODE_INTEGRITY_SHIFT & 3);
+}
+
+static int Bearer(int psi)
+{
+    // DRB identities start from 1 and are the PSI of the bearer
+    return (psi - 1) & 0x1F;
+}
+
+static OctetString DeriveUpKey(const OctetString &kGnb, int distinguisher, int algorithm)
+{
+    OctetString s[2];
+    s[0] = OctetString::FromOctet(distinguisher);
+    s[1] = OctetString::FromOctet(algorithm);
+    return crypto::CalculateKdfKey(kGnb, 0x69, s, 2).subCopy(16, 16);
+}
+
+static void Cipher(int algorithm, bool decrypt, uint32_t count, int bearer, int direction, OctetString &data,
+                   const OctetString &key)
+{
+    switch (algorithm)
+    {
+    case 1:
+        decrypt ? crypto::DecryptEea1(count, bearer, direction, data, key)
+                : crypto::EncryptEea1(count, bearer, direction, data, key);
+        break;
+    case 2:
+        decrypt ? crypto::DecryptEea2(count, bearer, direction, data, key)
+                : crypto::EncryptEea2(count, bearer, direction, data, key);
+        break;
+    case 3:
+        decrypt ? crypto::DecryptEea3(count, bearer, direction, data, key)
+                : crypto::EncryptEea3(count, bearer, direction, data, key);
+        break;
+    default:
+        break;
+    }
+}
+
+static uint32_t ComputeMac(int algorithm, uint32_t count, int bearer, int direction, const OctetString &message,
+                           const OctetString &key)
+{
+    switch (algorithm)
+    {
+    case 1:
+        return crypto::ComputeMacEia1(count, bearer, direction, message, key);
+    case 2:
+        return crypto::ComputeMacEia2(count, bearer, direction, message, key);
+    case 3:
+        return crypto::ComputeMacEia3(count, bearer, direction, message, key);
+    default:
+        return 0;
+    }
+}
+
+PdcpEntities::PdcpEntities(bool uplink, const PdcpConfig &config)
+    : m_uplink{uplink},
+      m_config{config.snLength, config.ciphering, config.integrity, config.reordering, config.key.copy()},
+      m_mode{(config.snLength == 18 ? MODE_SN18 : 0) |
+             static_cast<uint32_t>(config.ciphering) << MODE_CIPHERING_SHIFT |
+             static_cast<uint32_t>(config.integrity) << MODE_INTEGRITY_SHIFT},
+      m_tx{}, m_rx{}, m_integrityFailures{}
+{
+}
+
+uint32_t PdcpEntities::protect(int peer, int psi, OctetString &data)
+{
+    auto it = m_tx.find(BearerKey(peer, psi));
+    if (it == m_tx.end())
+    {
+        TxEntity entity{};
+        entity.encKey = DeriveUpKey(m_config.key, N_UP_ENC_ALG, m_config.ciphering);
+        entity.intKey = DeriveUpKey(m_config.key, N_UP_INT_ALG, m_config.integrity);
+        it = m_tx.emplace(BearerKey(peer, psi), std::move(entity)).first;
+    }
+
+    auto &entity = it->second;
+    uint32_t count = entity.txNext++;
+    int bearer = Bearer(psi);
+    int direction = m_uplink ? 0 : 1;
+
+    // PDCP Data PDU header of TS 38.323 6.2.2, D/C bit set
+    OctetString pdu;
+    if (m_config.snLength == 18)
+    {
+        pdu.appendOctet(static_cast<int>(0x80 | (count >> 16 & 0x03)));
+        pdu.appendOctet2(static_cast<int>(count & 0xFFFF));
+    }
+    else
+    {
+        pdu.appendOctet(static_cast<int>(0x80 | (count >> 8 & 0x0F)));
+        pdu.appendOctet(static_cast<int>(count & 0xFF));
+    }
+    int headerSize = pdu.length();
+    pdu.append(data);
+
+    // MAC-I covers the header and the data, the data and MAC-I are ciphered
+    if (m_config.integrity != 0)
+        pdu.appendOctet4(ComputeMac(m_config.integrity, count, bearer, direction, pdu, entity.intKey));
+
+    if (m_config.ciphering != 0)
+    {
+        auto body = pdu.subCopy(headerSize);
+        Cipher(m_config.ciphering, false, count, bearer, direction, body, entity.encKey);
+        data = pdu.subCopy(0, headerSize);
+        data.append(body);
+    }
+    else
+    {
+        data = std::move(pdu);
+    }
+
+    return m_mode | static_cast<uint32_t>(psi & 0xFF);
+}
+
+void PdcpEntities::receive(int64_t now, int peer, uint32_t payload, const OctetString &pdu,
+                           std::vector<PdcpSdu> &outDelivered)
+{
+    int psi = static_cast<int>(payload & 0xFF);
+    uint32_t mode = payload & ~0xFFu;
+    if ((mode & ~MODE_MASK) != 0)
+        return;
+
+    int snLength = SnLength(mode);
+    int headerSize = snLength == 18 ? 3 : 2;
+    int integrity = Integrity(mode);
+    int macSize = integrity != 0 ? MAC_I_SIZE : 0;
+    if (pdu.length() < headerSize + macSize || (pdu.data()[0] & 0x80) == 0)
+        return;
+
+    // The peer re-established its bearer with another mode, the state of the old one is useless
+    auto &entity = m_rx[BearerKey(peer, psi)];
+    if (entity.encKey.length() == 0 || entity.mode != mode)
+    {
+        entity = RxEntity{};
+        entity.mode = mode;
+        entity.encKey = DeriveUpKey(m_config.key, N_UP_ENC_ALG, Ciphering(mode));
+        entity.intKey = DeriveUpKey(m_config.key, N_UP_INT_ALG, integrity);
+    }
+
+    uint32_t sn = snLength == 18 ? static_cast<uint32_t>(pdu.get3I(0)) & 0x3FFFF
+                                 : static_cast<uint32_t>(pdu.get2I(0)) & 0xFFF;
+
+    // COUNT of the PDU from the HFN of RX_DELIV, TS 38.323 5.2.2.1
+    uint32_t window = 1u << (snLength - 1);
+    uint32_t snMask = (1u << snLength) - 1;
+    uint32_t delivSn = entity.rxDeliv & snMask;
+    uint32_t hfn = entity.rxDeliv >> snLength;
+    if (static_cast<int64_t>(sn) < static_cast<int64_t>(delivSn) - window)
+        hfn++;
+    else if (sn >= delivSn + window && hfn > 0)
+        hfn--;
+    uint32_t count = hfn << snLength | sn;
+
+    // Without MAC-I a wrong HFN goes unnoticed and deciphers into garbage, so PDUs far off the state of the bearer
+    // are taken for those of a peer whose bearer restarted, and dropped along with the integrity failures
+    uint32_t plausible = window / PLAUSIBLE_WINDOW_FRACTION;
+    if (integrity == 0 && (count + plausible < entity.rxDeliv || count >= entity.rxNext + plausible))
+    {
+        m_integrityFailures++;
+        return;
+    }
+
+    int bearer = Bearer(psi);
+    int direction = m_uplink ? 1 : 0;
+
+    auto body = pdu.subCopy(headerSize);
+    Cipher(Ciphering(mode), true, count, bearer, direction, body, entity.encKey);
+
+    int dataSize = body.length() - macSize;
+    if (integrity != 0)
+    {
+        auto message = pdu.subCopy(0, headerSize);
+        message.append(body.data(), static_cast<size_t>(dataSize));
+        if (ComputeMac(integrity, count, bearer, direction, message, entity.intKey) != body.get4UI(dataSize))
+        {
+            m_integrityFailures++;
+            return;
+        }
+    }
+
+    auto sdu = macSize != 0 ? body.subCopy(0, dataSize) : std::move(body);
+
+    if (m_config.reordering == 0)
+    {
+        if (count >= entity.rxNext)
+            entity.rxNext = count + 1;
+        entity.rxDeliv = entity.rxNext;
+        outDelivered.push_back(PdcpSdu{peer, psi, std::move(sdu)});
+        return;
+    }
+
+    if (count < entity.rxDeliv || entity.buffer.count(count) != 0)
+        return;
+
+    entity.buffer.emplace(count, std::move(sdu));
+    if (count >= entity.rxNext)
+        entity.rxNext = count + 1;
+
+    if (count == entity.rxDeliv)
+        deliverInOrder(entity, peer, psi, outDelivered);
+
+    updateReordering(now, entity);
+}
+
+void PdcpEntities::runTimers(int64_t now, std::vector<PdcpSdu> &outDelivered)
+{
+    for (auto &item : m_rx)
+    {
+        auto &entity = item.second;
+        if (entity.reorderingExpiry == 0 || entity.reorderingExpiry > now)
+            continue;
+
+        int peer = static_cast<int>(item.first >> 8);
+        int psi = static_cast<int>(item.first & 0xFF);
+
+        // The missing PDUs are given up on, everything before RX_REORD is delivered
+        entity.reorderingExpiry = 0;
+        while (!entity.buffer.empty() && entity.buffer.begin()->first < entity.rxReord)
+        {
+            outDelivered.push_back(PdcpSdu{peer, psi, std::move(entity.buffer.begin()->second)});
+            entity.buffer.erase(entity.buffer.begin());
+        }
+        entity.rxDeliv = std::max(entity.rxDeliv, entity.rxReord);
+        deliverInOrder(entity, peer, psi, outDelivered);
+
+        updateReordering(now, entity);
+    }
+}
+
+void PdcpEntities::remove(int peer)
+{
+    for (auto it = m_tx.begin(); it != m_tx.end();)
+        it = (it->first >> 8) == peer ? m_tx.erase(it) : std::next(it);
+    for (auto it = m_rx.begin(); it != m_rx.end();)
+        it = (it->first >> 8) == peer ? m_rx.erase(it) : std::next(it);
+}
+
+int64_t PdcpEntities::nextExpiry() const
+{
+    int64_t expiry = 0;
+    for (auto &item : m_rx)
+    {
+        if (item.second.reorderingExpiry != 0 && (expiry == 0 || item.second.reorderingExpiry < expiry))
+            expiry = item.second.reorderingExpiry;
+    }
+    return expiry;
+}
+
+int64_t PdcpEntities::integrityFailures() const
+{
+    return m_integrityFailures;
+}
+
+void PdcpEntities::deliverInOrder(RxEntity &entity, int peer, int psi, std::vector<PdcpSdu> &outDelivered)
+{
+    while (!entity.buffer.empty() && entity.buffer.begin()->first == entity.rxDeliv)
+    {
+        outDelivered.push_back(PdcpSdu{peer, psi, std::move(entity.buffer.begin()->second)});
+        entity.buffer.erase(entity.buffer.begin());
+        entity.rxDeliv++;
+    }
+}
+
+void PdcpEntities::updateReordering(int64_t now, RxEntity &entity)
+{
+    if (entity.reorderingExpiry != 0 && entity.rxDeliv >= entity.rxReord)
+        entity.reorderingExpiry = 0;
+
+    if (entity.reorderingExpiry == 0 && entity.rxDeliv < entity.rxNext)
+    {
+        entity.rxReord = entity.rxNext;
+        entity.reorderingExpiry = now + m_config.reordering;
+    }
+}
+
+} // namespace rls
@@ -0,0 +1,100 @@
+//
+// This file is a part of UERANSIM project.
+// Copyright (c) 2023 ALİ GÜNGÖR.
+//
+// https://github.com/aligungr/UERANSIM/
+// See README, LICENSE, and CONTRIBUTING files for licensing details.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+#include <utils/octet_string.hpp>
+
+namespace rls
+{
+
+struct PdcpConfig
+{
+    int snLength = 12;  // 12 or 18 bits
+    int ciphering = 2;  // NEA0 to NEA3
+    int integrity = 0;  // NIA0 to NIA3, 0 for DRBs without integrity protection
+    int reordering = 0; // t-Reordering in ms, 0 delivers PDUs as they arrive
+    OctetString key{};  // K_gNB of the AS security context, the same at both ends, unused with NEA0 and NIA0
+};
+
+/* User PDU delivered by a PDCP entity */
+struct PdcpSdu
+{
+    int peer{};
+    int psi{};
+    OctetString data{};
+};
+
+/*
+ * PDCP entities of the data radio bearers of a node, one per peer and PDU session. User PDUs get a PDCP SN and are
+ * ciphered and integrity protected with the UP keys derived from the AS security context (TS 33.501 A.8), using the
+ * NEA/NIA algorithms of the configuration, so that the per-packet crypto load of a real UE and gNB is exercised.
+ *
+ * The receiving end creates the entity of a bearer on its first PDU, with the SN length and algorithms the peer
+ * announces in the payload, its own keys and its own t-Reordering. Without reordering PDUs are delivered as they
+ * arrive and duplicates are not detected. Both ends of a bearer must be removed together, see the link session of
+ * RlsHeartBeat; without integrity protection the PDUs of a peer that restarted its COUNT are mostly caught by their
+ * implausible COUNT and discarded.
+ */
+class PdcpEntities
+{
+  private:
+    struct TxEntity
+    {
+        uint32_t txNext{};
+        OctetString encKey{};
+        OctetString intKey{};
+    };
+
+    struct RxEntity
+    {
+        uint32_t mode{}; // announced by the peer
+        uint32_t rxNext{};
+        uint32_t rxDeliv{};
+        uint32_t rxReord{};
+        int64_t reorderingExpiry{}; // 0 if t-Reordering is not running
+        std::map<uint32_t, OctetString> buffer{}; // SDUs waiting for reordering, by COUNT
+        OctetString encKey{};
+        OctetString intKey{};
+    };
+
+  private:
+    bool m_uplink; // direction of the PDUs sent by this node
+    PdcpConfig m_config;
+    uint32_t m_mode;
+    std::unordered_map<int64_t, TxEntity> m_tx; // by peer and PSI
+    std::unordered_map<int64_t, RxEntity> m_rx; // by peer and PSI
+    int64_t m_integrityFailures;
+
+  public:
+    PdcpEntities(bool uplink, const PdcpConfig &config);
+
+  public:
+    /* Turns the user PDU into a PDCP PDU, returns the RLS payload announcing the PSI and the mode of the bearer */
+    uint32_t protect(int peer, int psi, OctetString &data);
+    /* Handles a PDCP PDU from the peer, the user PDUs it releases are appended to outDelivered in order */
+    void receive(int64_t now, int peer, uint32_t payload, const OctetString &pdu, std::vector<PdcpSdu> &outDelivered);
+    /* Runs the expired t-Reordering timers, the user PDUs they release are appended to outDelivered */
+    void runTimers(int64_t now, std::vector<PdcpSdu> &outDelivered);
+    void remove(int peer);
+
+    /* Earliest t-Reordering expiry, 0 if none is running */
+    [[nodiscard]] int64_t nextExpiry() const;
+    [[nodiscard]] int64_t integrityFailures() const;
+
+  private:
+    void deliverInOrder(RxEntity &entity, int peer, int psi, std::vector<PdcpSdu> &outDelivered);
+    void updateReordering(int64_t now, RxEntity &entity);
+};
+
+} // namespace rls
@@ -8,13 +8,361 @@
 
 #include "rls_pdu.hpp"
 
+#include <cstring>
+#include <endian.h>
+
 #include <utils/constants.hpp>
 
+// Marks the optional ack block that follows the message body
+static constexpr const uint8_t ACK_BLOCK_TAG = 0xA5;
+// Marks the optional destination block that follows the ack block, if any
+static constexpr const uint8_t DESTINATION_BLOCK_TAG = 0xA6;
+// Marks the optional session block that directly follows the body of a HEARTBEAT
+static constexpr const uint8_t SESSION_BLOCK_TAG = 0xA7;
+// Upper bound of the PDU carried by a PDU_TRANSMISSION
+static constexpr const uint32_t MAX_PDU_LENGTH = 16384;
+
 namespace rls
 {
 
+// Wire layout of the fixed-size parts of the messages, in network byte order
+#pragma pack(push, 1)
+struct WireHeader
+{
+    uint8_t compatibility; // (Just for old RLS compatibility)
+    uint8_t major;
+    uint8_t minor;
+    uint8_t patch;
+    uint8_t msgType;
+    uint64_t sti;
+};
+
+struct WirePduTransmission
+{
+    WireHeader header;
+    uint8_t pduType;
+    uint32_t pduId;
+    uint32_t payload;
+    uint32_t pduLength;
+};
+
+struct WireHeartBeat
+{
+    WireHeader header;
+    uint32_t x;
+    uint32_t y;
+    uint32_t z;
+    uint16_t interval;
+};
+
+struct WireAckBlock
+{
+    uint8_t tag;
+    uint32_t cumulative;
+    uint32_t bitmap;
+};
+
+struct WireDestinationBlock
+{
+    uint8_t tag;
+    uint64_t sti;
+};
+
+struct WireSessionBlock
+{
+    uint8_t tag;
+    uint32_t session;
+};
+#pragma pack(pop)
+
+static_assert(sizeof(WireHeader) == 13 && sizeof(WirePduTransmission) == PDU_TRANSMISSION_HEADER_SIZE &&
+              sizeof(WireHeartBeat) == 27 && sizeof(WireAckBlock) == 9 && sizeof(WireDestinationBlock) == 9 &&
+              sizeof(WireSessionBlock) == 5);
+
+static WireHeader MakeHeader(EMessageType msgType, uint64_t sti)
+{
+    WireHeader header{};
+    header.compatibility = 0x03;
+    header.major = static_cast<uint8_t>(cons::Major);
+    header.minor = static_cast<uint8_t>(cons::Minor);
+    header.patch = static_cast<uint8_t>(cons::Patch);
+    header.msgType = static_cast<uint8_t>(msgType);
+    header.sti = htobe64(sti);
+    return header;
+}
+
+static bool IsValidHeader(const WireHeader &header)
+{
+    return header.compatibility == 0x03 && header.major == cons::Major && header.minor == cons::Minor &&
+           header.patch == cons::Patch;
+}
+
+/* Decodes the ack and destination blocks that may follow a message body, returns false if one is truncated */
+static bool DecodeTrailer(const uint8_t *data, size_t size, std::optional<RlsAckBlock> &ack,
+                          std::optional<uint64_t> &destination)
+{
+    if (size != 0 && data[0] == ACK_BLOCK_TAG)
+    {
+        if (size < sizeof(WireAckBlock))
+            return false;
+
+        WireAckBlock block;
+        std::memcpy(&block, data, sizeof(block));
+        ack = RlsAckBlock{be32toh(block.cumulative), be32toh(block.bitmap)};
+        data += sizeof(block);
+        size -= sizeof(block);
+    }
+
+    if (size != 0 && data[0] == DESTINATION_BLOCK_TAG)
+    {
+        if (size < sizeof(WireDestinationBlock))
+            return false;
+
+        WireDestinationBlock block;
+        std::memcpy(&block, data, sizeof(block));
+        destination = be64toh(block.sti);
+    }
+    return true;
+}
+
+void EncodeRlsPduTransmissionHeader(uint64_t sti, EPduType pduType, uint32_t pduId, uint32_t payload, size_t pduLength,
+                                    uint8_t *out)
+{
+    WirePduTransmission wire{};
+    wire.header = MakeHeader(EMessageType::PDU_TRANSMISSION, sti);
+    wire.pduType = static_cast<uint8_t>(pduType);
+    wire.pduId = htobe32(pduId);
+    wire.payload = htobe32(payload);
+    wire.pduLength = htobe32(static_cast<uint32_t>(pduLength));
+    std::memcpy(out, &wire, sizeof(wire));
+}
+
+static void EncodePduTransmission(const RlsPduTransmission &msg, OctetString &stream)
+{
+    uint8_t header[PDU_TRANSMISSION_HEADER_SIZE];
+    EncodeRlsPduTransmissionHeader(msg.sti, msg.pduType, msg.pduId, msg.payload, msg.pdu.length(), header);
+
+    // Room for the blocks the sender may append
+    stream.reserve(stream.length() + sizeof(header) + msg.pdu.length() + sizeof(WireAckBlock) +
+                   sizeof(WireDestinationBlock));
+    stream.append(header, sizeof(header));
+    stream.append(msg.pdu);
+}
+
+static void EncodeHeartBeat(const RlsHeartBeat &msg, OctetString &stream)
+{
+    WireHeartBeat wire{};
+    wire.header = MakeHeader(msg.msgType, msg.sti);
+    wire.x = htobe32(static_cast<uint32_t>(msg.simPos.x));
+    wire.y = htobe32(static_cast<uint32_t>(msg.simPos.y));
+    wire.z = htobe32(static_cast<uint32_t>(msg.simPos.z));
+    wire.interval = htobe16(static_cast<uint16_t>(msg.interval));
+
+    stream.append(reinterpret_cast<const uint8_t *>(&wire), sizeof(wire));
+
+    if (msg.session != 0)
+    {
+        WireSessionBlock block{};
+        block.tag = SESSION_BLOCK_TAG;
+        block.session = htobe32(msg.session);
+        stream.append(reinterpret_cast<const uint8_t *>(&block), sizeof(block));
+    }
+}
+
+RlsPduTransmission RlsPduTransmissionView::toMessage() const
+{
+    RlsPduTransmission msg{sti};
+    msg.ack = ack;
+    msg.destination = destination;
+    msg.pduType = pduType;
+    msg.pduId = pduId;
+    msg.payload = payload;
+    msg.pdu = OctetString{std::vector<uint8_t>{pdu, pdu + pduLength}};
+    return msg;
+}
+
+EMessageType PeekRlsMessageType(const uint8_t *data, size_t size)
+{
+    if (size < sizeof(WireHeader))
+        return EMessageType::RESERVED;
+
+    WireHeader header;
+    std::memcpy(&header, data, sizeof(header));
+    return IsValidHeader(header) ? static_cast<EMessageType>(header.msgType) : EMessageType::RESERVED;
+}
+
+uint64_t PeekRlsSti(const uint8_t *data, size_t size)
+{
+    if (size < sizeof(WireHeader))
+        return 0;
+
+    WireHeader header;
+    std::memcpy(&header, data, sizeof(header));
+    return IsValidHeader(header) ? be64toh(header.sti) : 0;
+}
+
+bool DecodeRlsPduTransmission(const uint8_t *data, size_t size, RlsPduTransmissionView &out)
+{
+    if (size < sizeof(WirePduTransmission))
+        return false;
+
+    WirePduTransmission wire;
+    std::memcpy(&wire, data, sizeof(wire));
+    if (!IsValidHeader(wire.header) || wire.header.msgType != static_cast<uint8_t>(EMessageType::PDU_TRANSMISSION))
+        return false;
+
+    uint32_t pduLength = be32toh(wire.pduLength);
+    if (pduLength > MAX_PDU_LENGTH || pduLength > size - sizeof(wire))
+        return false;
+
+    out.sti = be64toh(wire.header.sti);
+    out.pduType = static_cast<EPduType>(wire.pduType);
+    out.pduId = be32toh(wire.pduId);
+    out.payload = be32toh(wire.payload);
+    out.pdu = data + sizeof(wire);
+    out.pduLength = pduLength;
+    out.ack = std::nullopt;
+    out.destination = std::nullopt;
+
+    size_t consumed = sizeof(wire) + pduLength;
+    return DecodeTrailer(data + consumed, size - consumed, out.ack, out.destination);
+}
+
+bool DecodeRlsHeartBeat(const uint8_t *data, size_t size, RlsHeartBeatView &out)
+{
+    if (size < sizeof(WireHeartBeat))
+        return false;
+
+    WireHeartBeat wire;
+    std::memcpy(&wire, data, sizeof(wire));
+    if (!IsValidHeader(wire.header) || wire.header.msgType != static_cast<uint8_t>(EMessageType::HEARTBEAT))
+        return false;
+
+    out.sti = be64toh(wire.header.sti);
+    out.simPos.x = static_cast<int>(be32toh(wire.x));
+    out.simPos.y = static_cast<int>(be32toh(wire.y));
+    out.simPos.z = static_cast<int>(be32toh(wire.z));
+    out.interval = be16toh(wire.interval);
+    out.session = 0;
+    out.ack = std::nullopt;
+
+    data += sizeof(wire);
+    size -= sizeof(wire);
+
+    if (size != 0 && data[0] == SESSION_BLOCK_TAG)
+    {
+        if (size < sizeof(WireSessionBlock))
+            return false;
+
+        WireSessionBlock block;
+        std::memcpy(&block, data, sizeof(block));
+        out.session = be32toh(block.session);
+        data += sizeof(block);
+        size -= sizeof(block);
+    }
+
+    std::optional<uint64_t> destination{}; // heartbeats only go from the UE to the cells
+    return DecodeTrailer(data, size, out.ack, destination);
+}
+
+/* Size of the body of a message of the generic layout, 0 if it is truncated */
+static size_t RlsMessageBodySize(const OctetView &stream, EMessageType msgType)
+{
+    size_t start = stream.remaining();
+    auto skip = [&stream](size_t count) {
+        if (stream.remaining() < count)
+            return false;
+        stream.skip(count);
+        return true;
+    };
+
+    switch (msgType)
+    {
+    case EMessageType::HEARTBEAT_ACK:
+        if (!skip(4))
+            return 0;
+        if (stream.remaining() != 0 && stream.peekI() == SESSION_BLOCK_TAG && !skip(sizeof(WireSessionBlock)))
+            return 0;
+        break;
+    case EMessageType::PDU_AGGREGATE: {
+        if (stream.remaining() < 2)
+            return 0;
+        int count = stream.read2I();
+        for (int i = 0; i < count; i++)
+        {
+            if (stream.remaining() < 11)
+                return 0;
+            stream.skip(9);
+            if (!skip(static_cast<size_t>(stream.read2I())))
+                return 0;
+        }
+        break;
+    }
+    case EMessageType::HEARTBEAT_AGGREGATE:
+    case EMessageType::HEARTBEAT_ACK_AGGREGATE:
+        if (stream.remaining() < 2 ||
+            !skip(static_cast<size_t>(stream.read2I()) * (msgType == EMessageType::HEARTBEAT_AGGREGATE ? 24 : 12)))
+            return 0;
+        break;
+    case EMessageType::PDU_TRANSMISSION_ACK: {
+        if (stream.remaining() < 4)
+            return 0;
+        auto count = stream.read4UI();
+        if (stream.remaining() / 4 < count)
+            return 0;
+        stream.skip(static_cast<size_t>(count) * 4);
+        break;
+    }
+    case EMessageType::CREDIT_GRANT:
+    case EMessageType::CREDIT_STATUS:
+        if (!skip(8))
+            return 0;
+        break;
+    default:
+        return 0;
+    }
+    return start - stream.remaining();
+}
+
+std::optional<uint64_t> PeekRlsDestination(const uint8_t *data, size_t size)
+{
+    auto msgType = PeekRlsMessageType(data, size);
+    if (msgType == EMessageType::PDU_TRANSMISSION)
+    {
+        RlsPduTransmissionView view{};
+        if (!DecodeRlsPduTransmission(data, size, view))
+            return std::nullopt;
+        return view.destination;
+    }
+    if (msgType == EMessageType::RESERVED || msgType == EMessageType::HEARTBEAT)
+        return std::nullopt;
+
+    OctetView stream{data + sizeof(WireHeader), size - sizeof(WireHeader)};
+    size_t body = RlsMessageBodySize(stream, msgType);
+    if (body == 0)
+        return std::nullopt;
+
+    std::optional<RlsAckBlock> ack{};
+    std::optional<uint64_t> destination{};
+    size_t offset = sizeof(WireHeader) + body;
+    if (!DecodeTrailer(data + offset, size - offset, ack, destination))
+        return std::nullopt;
+    return destination;
+}
+
 void EncodeRlsMessage(const RlsMessage &msg, OctetString &stream)
 {
+    if (msg.msgType == EMessageType::PDU_TRANSMISSION)
+    {
+        EncodePduTransmission((const RlsPduTransmission &)msg, stream);
+        return;
+    }
+    if (msg.msgType == EMessageType::HEARTBEAT)
+    {
+        EncodeHeartBeat((const RlsHeartBeat &)msg, stream);
+        return;
+    }
+
     stream.appendOctet(0x03); // (Just for old RLS compatibility)
 
     stream.appendOctet(cons::Major);
@@ -22,26 +370,52 @@ void EncodeRlsMessage(const RlsMessage &msg, OctetString &stream)
     stream.appendOctet(cons::Patch);
     stream.appendOctet(static_cast<uint8_t>(msg.msgType));
     stream.appendOctet8(msg.sti);
-    if (msg.msgType == EMessageType::HEARTBEAT)
-    {
-        auto &m = (const RlsHeartBeat &)msg;
-        stream.appendOctet4(m.simPos.x);
-        stream.appendOctet4(m.simPos.y);
-        stream.appendOctet4(m.simPos.z);
-    }
-    else if (msg.msgType == EMessageType::HEARTBEAT_ACK)
+    if (msg.msgType == EMessageType::HEARTBEAT_ACK)
     {
         auto &m = (const RlsHeartBeatAck &)msg;
         stream.appendOctet4(m.dbm);
+        if (m.session != 0)
+        {
+            stream.appendOctet(SESSION_BLOCK_TAG);
+            stream.appendOctet4(m.session);
+        }
+    }
+    else if (msg.msgType == EMessageType::PDU_AGGREGATE)
+    {
+        auto &m = (const RlsPduAggregate &)msg;
+        stream.appendOctet2(static_cast<int>(m.pdus.size()));
+        for (auto &pdu : m.pdus)
+        {
+            stream.appendOctet(static_cast<uint8_t>(pdu.pduType));
+            stream.appendOctet4(pdu.pduId);
+            stream.appendOctet4(pdu.payload);
+            stream.appendOctet2(pdu.pdu.length());
+            stream.append(pdu.pdu);
+        }
     }
-    else if (msg.msgType == EMessageType::PDU_TRANSMISSION)
+    else if (msg.msgType == EMessageType::HEARTBEAT_AGGREGATE)
     {
-        auto &m = (const RlsPduTransmission &)msg;
-        stream.appendOctet(static_cast<uint8_t>(m.pduType));
-        stream.appendOctet4(m.pduId);
-        stream.appendOctet4(m.payload);
-        stream.appendOctet4(m.pdu.length());
-        stream.append(m.pdu);
+        auto &m = (const RlsHeartBeatAggregate &)msg;
+        stream.appendOctet2(static_cast<int>(m.entries.size()));
+        for (auto &entry : m.entries)
+        {
+            stream.appendOctet8(entry.sti);
+            stream.appendOctet4(entry.simPos.x);
+            stream.appendOctet4(entry.simPos.y);
+            stream.appendOctet4(entry.simPos.z);
+            stream.appendOctet2(entry.interval);
+            stream.appendOctet2(entry.port);
+        }
+    }
+    else if (msg.msgType == EMessageType::HEARTBEAT_ACK_AGGREGATE)
+    {
+        auto &m = (const RlsHeartBeatAckAggregate &)msg;
+        stream.appendOctet2(static_cast<int>(m.entries.size()));
+        for (auto &entry : m.entries)
+        {
+            stream.appendOctet8(entry.sti);
+            stream.appendOctet4(entry.dbm);
+        }
     }
     else if (msg.msgType == EMessageType::PDU_TRANSMISSION_ACK)
     {
@@ -50,63 +424,199 @@ void EncodeRlsMessage(const RlsMessage &msg, OctetString &stream)
         for (auto pduId : m.pduIds)
             stream.appendOctet4(pduId);
     }
+    else if (msg.msgType == EMessageType::CREDIT_GRANT)
+    {
+        auto &m = (const RlsCreditGrant &)msg;
+        stream.appendOctet8(m.creditLimit);
+    }
+    else if (msg.msgType == EMessageType::CREDIT_STATUS)
+    {
+        auto &m = (const RlsCreditStatus &)msg;
+        stream.appendOctet8(m.sentBytes);
+    }
 }
 
-std::unique_ptr<RlsMessage> DecodeRlsMessage(const OctetView &stream)
+static std::unique_ptr<RlsMessage> DecodeRlsMessageBody(const OctetView &stream, EMessageType msgType, uint64_t sti)
 {
-    auto first = stream.readI(); // (Just for old RLS compatibility)
-    if (first != 3)
-        return nullptr;
+    if (msgType == EMessageType::HEARTBEAT_ACK)
+    {
+        if (stream.remaining() < 4)
+            return nullptr;
 
-    if (stream.read() != cons::Major)
-        return nullptr;
-    if (stream.read() != cons::Minor)
-        return nullptr;
-    if (stream.read() != cons::Patch)
-        return nullptr;
+        auto res = std::make_unique<RlsHeartBeatAck>(sti);
+        res->dbm = stream.read4I();
+        if (stream.remaining() != 0 && stream.peekI() == SESSION_BLOCK_TAG)
+        {
+            if (stream.remaining() < sizeof(WireSessionBlock))
+                return nullptr;
+            stream.read();
+            res->session = stream.read4UI();
+        }
+        return res;
+    }
+    else if (msgType == EMessageType::PDU_AGGREGATE)
+    {
+        if (stream.remaining() < 2)
+            return nullptr;
 
-    auto msgType = static_cast<EMessageType>(stream.readI());
-    uint64_t sti = stream.read8UL();
+        auto res = std::make_unique<RlsPduAggregate>(sti);
+        int count = stream.read2I();
+        if (count > MAX_AGGREGATE_PDUS)
+            return nullptr;
 
-    if (msgType == EMessageType::HEARTBEAT)
-    {
-        auto res = std::make_unique<RlsHeartBeat>(sti);
-        res->simPos.x = stream.read4I();
-        res->simPos.y = stream.read4I();
-        res->simPos.z = stream.read4I();
+        res->pdus.reserve(count);
+        for (int i = 0; i < count; i++)
+        {
+            if (stream.remaining() < 11)
+                return nullptr;
+
+            auto &pdu = res->pdus.emplace_back(sti);
+            pdu.pduType = static_cast<EPduType>((uint8_t)stream.read());
+            pdu.pduId = stream.read4UI();
+            pdu.payload = stream.read4UI();
+
+            int pduLength = stream.read2I();
+            if (stream.remaining() < static_cast<size_t>(pduLength))
+                return nullptr;
+            pdu.pdu = stream.readOctetString(pduLength);
+        }
         return res;
     }
-    else if (msgType == EMessageType::HEARTBEAT_ACK)
+    else if (msgType == EMessageType::HEARTBEAT_AGGREGATE)
     {
-        auto res = std::make_unique<RlsHeartBeatAck>(sti);
-        res->dbm = stream.read4I();
+        if (stream.remaining() < 2)
+            return nullptr;
+
+        auto res = std::make_unique<RlsHeartBeatAggregate>(sti);
+        int count = stream.read2I();
+        if (count > MAX_AGGREGATE_HEARTBEATS || stream.remaining() < static_cast<size_t>(count) * 24)
+            return nullptr;
+
+        res->entries.reserve(count);
+        for (int i = 0; i < count; i++)
+        {
+            auto &entry = res->entries.emplace_back();
+            entry.sti = stream.read8UL();
+            entry.simPos.x = stream.read4I();
+            entry.simPos.y = stream.read4I();
+            entry.simPos.z = stream.read4I();
+            entry.interval = stream.read2I();
+            entry.port = static_cast<uint16_t>(stream.read2I());
+        }
         return res;
     }
-    else if (msgType == EMessageType::PDU_TRANSMISSION)
+    else if (msgType == EMessageType::HEARTBEAT_ACK_AGGREGATE)
     {
-        auto res = std::make_unique<RlsPduTransmission>(sti);
-        res->pduType = static_cast<EPduType>((uint8_t)stream.read());
-        res->pduId = stream.read4UI();
-        res->payload = stream.read4UI();
+        if (stream.remaining() < 2)
+            return nullptr;
 
-        int pduLength = stream.read4I();
-        if (pduLength > 16384)
+        auto res = std::make_unique<RlsHeartBeatAckAggregate>(sti);
+        int count = stream.read2I();
+        if (count > MAX_AGGREGATE_HEARTBEATS || stream.remaining() < static_cast<size_t>(count) * 12)
             return nullptr;
-        
-        res->pdu = stream.readOctetString(pduLength);
+
+        res->entries.reserve(count);
+        for (int i = 0; i < count; i++)
+        {
+            auto &entry = res->entries.emplace_back();
+            entry.sti = stream.read8UL();
+            entry.dbm = stream.read4I();
+        }
         return res;
     }
     else if (msgType == EMessageType::PDU_TRANSMISSION_ACK)
     {
+        if (stream.remaining() < 4)
+            return nullptr;
+
         auto res = std::make_unique<RlsPduTransmissionAck>(sti);
         auto count = stream.read4UI();
+        if (stream.remaining() / 4 < count)
+            return nullptr;
+
         res->pduIds.reserve(count);
         for (uint32_t i = 0; i < count; i++)
             res->pduIds.push_back(stream.read4UI());
         return res;
     }
+    else if (msgType == EMessageType::CREDIT_GRANT)
+    {
+        if (stream.remaining() < 8)
+            return nullptr;
+
+        auto res = std::make_unique<RlsCreditGrant>(sti);
+        res->creditLimit = stream.read8UL();
+        return res;
+    }
+    else if (msgType == EMessageType::CREDIT_STATUS)
+    {
+        if (stream.remaining() < 8)
+            return nullptr;
+
+        auto res = std::make_unique<RlsCreditStatus>(sti);
+        res->sentBytes = stream.read8UL();
+        return res;
+    }
 
     return nullptr;
 }
 
+void EncodeRlsAckBlock(const RlsAckBlock &ack, OctetString &stream)
+{
+    stream.appendOctet(ACK_BLOCK_TAG);
+    stream.appendOctet4(ack.cumulative);
+    stream.appendOctet4(ack.bitmap);
+}
+
+void EncodeRlsDestinationBlock(uint64_t sti, OctetString &stream)
+{
+    stream.appendOctet(DESTINATION_BLOCK_TAG);
+    stream.appendOctet8(sti);
+}
+
+std::unique_ptr<RlsMessage> DecodeRlsMessage(const OctetView &stream)
+{
+    return DecodeRlsMessage(stream.current(), stream.remaining());
+}
+
+std::unique_ptr<RlsMessage> DecodeRlsMessage(const uint8_t *data, size_t size)
+{
+    auto msgType = PeekRlsMessageType(data, size);
+    if (msgType == EMessageType::RESERVED)
+        return nullptr;
+
+    if (msgType == EMessageType::PDU_TRANSMISSION)
+    {
+        RlsPduTransmissionView view{};
+        if (!DecodeRlsPduTransmission(data, size, view))
+            return nullptr;
+        return std::make_unique<RlsPduTransmission>(view.toMessage());
+    }
+    if (msgType == EMessageType::HEARTBEAT)
+    {
+        RlsHeartBeatView view{};
+        if (!DecodeRlsHeartBeat(data, size, view))
+            return nullptr;
+
+        auto res = std::make_unique<RlsHeartBeat>(view.sti);
+        res->simPos = view.simPos;
+        res->interval = view.interval;
+        res->session = view.session;
+        res->ack = view.ack;
+        return res;
+    }
+
+    OctetView stream{data, size};
+    stream.skip(sizeof(WireHeader) - sizeof(uint64_t));
+    uint64_t sti = stream.read8UL();
+
+    auto res = DecodeRlsMessageBody(stream, msgType, sti);
+    if (res == nullptr)
+        return nullptr;
+
+    if (!DecodeTrailer(stream.current(), stream.remaining(), res->ack, res->destination))
+        return nullptr;
+    return res;
+}
+
 } // namespace rls
@@ -10,6 +10,8 @@
 
 #include <cstdint>
 #include <memory>
+#include <optional>
+#include <vector>
 
 #include <utils/common_types.hpp>
 #include <utils/octet_string.hpp>
@@ -18,6 +20,13 @@
 namespace rls
 {
 
+// Upper bound of the PDUs carried by a single PDU_AGGREGATE message
+static constexpr const int MAX_AGGREGATE_PDUS = 1024;
+// Upper bound of the UEs carried by a single HEARTBEAT_AGGREGATE or HEARTBEAT_ACK_AGGREGATE message
+static constexpr const int MAX_AGGREGATE_HEARTBEATS = 512;
+// Size of the fixed header of a PDU_TRANSMISSION, which the PDU follows
+static constexpr const size_t PDU_TRANSMISSION_HEADER_SIZE = 26;
+
 enum class EMessageType : uint8_t
 {
     RESERVED = 0,
@@ -30,28 +39,50 @@ enum class EMessageType : uint8_t
     HEARTBEAT_ACK = 5,
     PDU_TRANSMISSION = 6,
     PDU_TRANSMISSION_ACK = 7,
+    CREDIT_GRANT = 8,
+    CREDIT_STATUS = 9,
+    PDU_AGGREGATE = 10,
+    HEARTBEAT_AGGREGATE = 11,
+    HEARTBEAT_ACK_AGGREGATE = 12,
 };
 
 enum class EPduType : uint8_t
 {
     RESERVED = 0,
     RRC,
-    DATA
+    DATA,
+    RELAY, // BAP header + inner packet, see rls_bap.hpp
+    RELAY_COMPRESSED, // RELAY with the inner IP headers compressed, see rls_rohc.hpp
+    RLC, // RLC PDU of the radio bearer carrying the user PDUs, the payload is its mode, see rls_rlc.hpp
+    DATA_PDCP, // DATA protected by the PDCP entity of its bearer, the payload is its PSI and mode, see rls_pdcp.hpp
+};
+
+/* Acknowledgement of the reliable PDUs (non-zero pduId) received from a peer, see rls_ack.hpp */
+struct RlsAckBlock
+{
+    uint32_t cumulative{}; // every PDU up to and including this one is received
+    uint32_t bitmap{};     // bit i: PDU cumulative + 2 + i is received
 };
 
 struct RlsMessage
 {
     const EMessageType msgType;
     const uint64_t sti{};
+    std::optional<RlsAckBlock> ack{}; // piggybacked on any message type
+    std::optional<uint64_t> destination{}; // STI of the UE a unicast message of a cell is meant for
 
     explicit RlsMessage(EMessageType msgType, uint64_t sti) : msgType(msgType), sti(sti)
     {
     }
+
+    virtual ~RlsMessage() = default;
 };
 
 struct RlsHeartBeat : RlsMessage
 {
     Vector3 simPos;
+    int interval{}; // ms until the next heartbeat of the UE, 0 if not known
+    uint32_t session{}; // epoch of the link state the UE keeps for the cell, 0 if it keeps none
 
     explicit RlsHeartBeat(uint64_t sti) : RlsMessage(EMessageType::HEARTBEAT, sti)
     {
@@ -61,12 +92,46 @@ struct RlsHeartBeat : RlsMessage
 struct RlsHeartBeatAck : RlsMessage
 {
     int dbm{};
+    uint32_t session{}; // of the heartbeat acknowledged
 
     explicit RlsHeartBeatAck(uint64_t sti) : RlsMessage(EMessageType::HEARTBEAT_ACK, sti)
     {
     }
 };
 
+/* Heartbeat of a UE sent on its behalf by its process, together with the other UEs of the process */
+struct RlsHeartBeatEntry
+{
+    uint64_t sti{};
+    Vector3 simPos;
+    int interval{};
+    uint16_t port{}; // of the UE, at the address the aggregate is sent from
+};
+
+struct RlsHeartBeatAggregate : RlsMessage
+{
+    std::vector<RlsHeartBeatEntry> entries;
+
+    explicit RlsHeartBeatAggregate(uint64_t sti) : RlsMessage(EMessageType::HEARTBEAT_AGGREGATE, sti)
+    {
+    }
+};
+
+struct RlsHeartBeatAckEntry
+{
+    uint64_t sti{}; // of the UE
+    int dbm{};
+};
+
+struct RlsHeartBeatAckAggregate : RlsMessage
+{
+    std::vector<RlsHeartBeatAckEntry> entries;
+
+    explicit RlsHeartBeatAckAggregate(uint64_t sti) : RlsMessage(EMessageType::HEARTBEAT_ACK_AGGREGATE, sti)
+    {
+    }
+};
+
 struct RlsPduTransmission : RlsMessage
 {
     EPduType pduType{};
@@ -79,6 +144,15 @@ struct RlsPduTransmission : RlsMessage
     }
 };
 
+struct RlsPduAggregate : RlsMessage
+{
+    std::vector<RlsPduTransmission> pdus; // carry the STI of the aggregate
+
+    explicit RlsPduAggregate(uint64_t sti) : RlsMessage(EMessageType::PDU_AGGREGATE, sti)
+    {
+    }
+};
+
 struct RlsPduTransmissionAck : RlsMessage
 {
     std::vector<uint32_t> pduIds;
@@ -88,7 +162,70 @@ struct RlsPduTransmissionAck : RlsMessage
     }
 };
 
+struct RlsCreditGrant : RlsMessage
+{
+    uint64_t creditLimit{}; // total number of RELAY bytes the child may have sent
+
+    explicit RlsCreditGrant(uint64_t sti) : RlsMessage(EMessageType::CREDIT_GRANT, sti)
+    {
+    }
+};
+
+struct RlsCreditStatus : RlsMessage
+{
+    uint64_t sentBytes{}; // total number of RELAY bytes sent to the parent
+
+    explicit RlsCreditStatus(uint64_t sti) : RlsMessage(EMessageType::CREDIT_STATUS, sti)
+    {
+    }
+};
+
+/* PDU_TRANSMISSION decoded in place, the PDU points into the decoded buffer and lives as long as it */
+struct RlsPduTransmissionView
+{
+    uint64_t sti{};
+    EPduType pduType{};
+    uint32_t pduId{};
+    uint32_t payload{};
+    const uint8_t *pdu{};
+    size_t pduLength{};
+    std::optional<RlsAckBlock> ack{};
+    std::optional<uint64_t> destination{};
+
+    [[nodiscard]] RlsPduTransmission toMessage() const;
+};
+
+/* HEARTBEAT decoded in place */
+struct RlsHeartBeatView
+{
+    uint64_t sti{};
+    Vector3 simPos;
+    int interval{};
+    uint32_t session{};
+    std::optional<RlsAckBlock> ack{};
+};
+
 void EncodeRlsMessage(const RlsMessage &msg, OctetString &stream);
+/* Appends the ack block to an encoded message, older decoders ignore it */
+void EncodeRlsAckBlock(const RlsAckBlock &ack, OctetString &stream);
+/* Appends the STI of the destination UE to an encoded message, after the ack block if any */
+void EncodeRlsDestinationBlock(uint64_t sti, OctetString &stream);
+/* Writes the header of a PDU_TRANSMISSION to the PDU_TRANSMISSION_HEADER_SIZE bytes in front of its PDU */
+void EncodeRlsPduTransmissionHeader(uint64_t sti, EPduType pduType, uint32_t pduId, uint32_t payload, size_t pduLength,
+                                    uint8_t *out);
 std::unique_ptr<RlsMessage> DecodeRlsMessage(const OctetView &stream);
+std::unique_ptr<RlsMessage> DecodeRlsMessage(const uint8_t *data, size_t size);
+
+/*
+ * Fast path of the decoder for the hottest messages, reading their fixed-size header at once without any allocation.
+ * The type is RESERVED if the common header is not valid, and the decoders return false on malformed input.
+ */
+EMessageType PeekRlsMessageType(const uint8_t *data, size_t size);
+/* STI of the sender, 0 if the common header is not valid */
+uint64_t PeekRlsSti(const uint8_t *data, size_t size);
+bool DecodeRlsPduTransmission(const uint8_t *data, size_t size, RlsPduTransmissionView &out);
+bool DecodeRlsHeartBeat(const uint8_t *data, size_t size, RlsHeartBeatView &out);
+/* STI of the destination block, found by skipping over the message body without decoding it */
+std::optional<uint64_t> PeekRlsDestination(const uint8_t *data, size_t size);
 
 } // namespace rls
\ No newline at end of file
@@ -0,0 +1,201 @@
+//
+// This file is a part of UERANSIM project.
+// Copyright (c) 2023 ALİ GÜNGÖR.
+//
+// https://github.com/aligungr/UERANSIM/
+// See README, LICENSE, and CONTRIBUTING files for licensing details.
+//
+
+#include "rls_rlc.hpp"
+
+#include <algorithm>
+
+static constexpr const int SDU_HEADER_SIZE = 5; // PDU type and payload of the user PDU
+static constexpr const int MAX_SDU_SIZE = 32768; // reassembly buffer of the RLC entities
+
+static constexpr const uint32_t MODE_AM = 1;
+
+namespace rls
+{
+
+static uint32_t EncodeMode(const RlcConfig &config)
+{
+    return (config.acknowledged ? MODE_AM : 0) | static_cast<uint32_t>(config.snLength) << 8;
+}
+
+static bool IsValidMode(uint32_t mode)
+{
+    uint32_t snLength = mode >> 8;
+    if (mode & MODE_AM)
+        return snLength == 12 || snLength == 18;
+    return snLength == 6 || snLength == 12;
+}
+
+RlcBearers::RlcBearers(uint64_t sti, const RlcConfig &config)
+    : m_sti{sti}, m_config{config}, m_entities{}, m_peers{},
+      m_buffer(static_cast<size_t>(std::max(config.opportunitySize, SDU_HEADER_SIZE))), m_delivered{}, m_failures{},
+      m_sduId{}
+{
+}
+
+RlcBearers::~RlcBearers() = default;
+
+void RlcBearers::submit(int peer, const RlsPduTransmission &pdu)
+{
+    if (SDU_HEADER_SIZE + pdu.pdu.length() > MAX_SDU_SIZE)
+        return;
+
+    // An existing bearer keeps the mode it was created with, it may have been set up by the peer
+    auto it = m_entities.find(peer);
+    auto *entity = it != m_entities.end() ? it->second.get() : findOrCreate(peer, EncodeMode(m_config));
+
+    size_t size = SDU_HEADER_SIZE + static_cast<size_t>(pdu.pdu.length());
+    if (m_buffer.size() < size)
+        m_buffer.resize(size);
+
+    m_buffer[0] = static_cast<uint8_t>(pdu.pduType);
+    m_buffer[1] = static_cast<uint8_t>(pdu.payload >> 24);
+    m_buffer[2] = static_cast<uint8_t>(pdu.payload >> 16);
+    m_buffer[3] = static_cast<uint8_t>(pdu.payload >> 8);
+    m_buffer[4] = static_cast<uint8_t>(pdu.payload);
+    std::copy(pdu.pdu.data(), pdu.pdu.data() + pdu.pdu.length(), m_buffer.data() + SDU_HEADER_SIZE);
+
+    // SDUs that do not fit in the transmission buffer are dropped by the entity, like a full radio bearer would
+    m_sduId = (m_sduId + 1) & 0x7FFFFFFF;
+    entity->receiveSdu(m_buffer.data(), static_cast<int>(size), m_sduId);
+}
+
+void RlcBearers::receive(int64_t now, int peer, const RlsPduTransmission &pdu,
+                         std::vector<RlsPduTransmission> &outDelivered)
+{
+    if (!IsValidMode(pdu.payload) || pdu.pdu.length() == 0)
+        return;
+
+    auto *entity = findOrCreate(peer, pdu.payload);
+
+    // The entity only reads the PDU, the copy is needed because the interface takes a mutable buffer
+    std::vector<uint8_t> data{pdu.pdu.data(), pdu.pdu.data() + pdu.pdu.length()};
+
+    // Timers started by the PDU must count from now, not from the last slot
+    entity->timerCycle(now);
+
+    m_delivered = &outDelivered;
+    entity->receivePdu(data.data(), static_cast<int>(data.size()));
+    m_delivered = nullptr;
+}
+
+bool RlcBearers::runSlot(int64_t now, std::vector<std::pair<int, RlsPduTransmission>> &outPdus)
+{
+    bool backlogged = false;
+
+    if (m_buffer.size() < static_cast<size_t>(m_config.opportunitySize))
+        m_buffer.resize(static_cast<size_t>(m_config.opportunitySize));
+
+    for (auto &item : m_entities)
+    {
+        auto &entity = item.second;
+        entity->timerCycle(now);
+
+        uint32_t mode = m_peers[entity.get()].second;
+        int used = 0;
+        for (; used < m_config.opportunities; used++)
+        {
+            int size = entity->createPdu(m_buffer.data(), m_config.opportunitySize);
+            if (size <= 0)
+                break;
+
+            RlsPduTransmission pdu{m_sti};
+            pdu.pduType = EPduType::RLC;
+            pdu.payload = mode;
+            pdu.pduId = 0;
+            pdu.pdu = OctetString{std::vector<uint8_t>{m_buffer.data(), m_buffer.data() + size}};
+            outPdus.emplace_back(item.first, std::move(pdu));
+        }
+
+        if (used == m_config.opportunities)
+            backlogged = true;
+    }
+
+    return backlogged;
+}
+
+void RlcBearers::remove(int peer)
+{
+    auto it = m_entities.find(peer);
+    if (it == m_entities.end())
+        return;
+
+    m_peers.erase(it->second.get());
+    m_entities.erase(it);
+}
+
+std::vector<int> RlcBearers::takeFailures()
+{
+    std::vector<int> res;
+    res.swap(m_failures);
+    return res;
+}
+
+bool RlcBearers::empty() const
+{
+    return m_entities.empty();
+}
+
+int RlcBearers::slot() const
+{
+    return m_config.slot;
+}
+
+void RlcBearers::deliverSdu(rlc::IRlcEntity *, uint8_t *data, int size)
+{
+    if (m_delivered == nullptr || size < SDU_HEADER_SIZE || data[0] == static_cast<uint8_t>(EPduType::RLC))
+        return;
+
+    RlsPduTransmission pdu{m_sti};
+    pdu.pduType = static_cast<EPduType>(data[0]);
+    pdu.payload = static_cast<uint32_t>(data[1]) << 24 | static_cast<uint32_t>(data[2]) << 16 |
+                  static_cast<uint32_t>(data[3]) << 8 | static_cast<uint32_t>(data[4]);
+    pdu.pduId = 0;
+    pdu.pdu = OctetString{std::vector<uint8_t>{data + SDU_HEADER_SIZE, data + size}};
+    m_delivered->push_back(std::move(pdu));
+}
+
+void RlcBearers::maxRetransmissionReached(rlc::IRlcEntity *entity)
+{
+    auto it = m_peers.find(entity);
+    if (it != m_peers.end() && std::find(m_failures.begin(), m_failures.end(), it->second.first) == m_failures.end())
+        m_failures.push_back(it->second.first);
+}
+
+void RlcBearers::sduSuccessfulDelivery(rlc::IRlcEntity *, int)
+{
+}
+
+rlc::IRlcEntity *RlcBearers::findOrCreate(int peer, uint32_t mode)
+{
+    auto &entity = m_entities[peer];
+    if (entity)
+    {
+        // The peer re-established its bearer with another mode, the state of the old one is useless
+        if (m_peers[entity.get()].second == mode)
+            return entity.get();
+        m_peers.erase(entity.get());
+    }
+
+    int snLength = static_cast<int>(mode >> 8);
+    if (mode & MODE_AM)
+    {
+        entity.reset(rlc::NewAmEntity(this, snLength, m_config.bufferSize, m_config.bufferSize, m_config.pollPdu,
+                                      m_config.pollByte, m_config.maxRetx, m_config.pollRetransmit,
+                                      m_config.reassembly, m_config.statusProhibit));
+    }
+    else
+    {
+        entity.reset(rlc::NewUmEntity(this, snLength, m_config.reassembly, m_config.bufferSize, m_config.bufferSize));
+    }
+
+    m_peers[entity.get()] = {peer, mode};
+    return entity.get();
+}
+
+} // namespace rls
@@ -0,0 +1,90 @@
+//
+// This file is a part of UERANSIM project.
+// Copyright (c) 2023 ALİ GÜNGÖR.
+//
+// https://github.com/aligungr/UERANSIM/
+// See README, LICENSE, and CONTRIBUTING files for licensing details.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "rls_pdu.hpp"
+
+#include <lib/rlc/rlc.hpp>
+
+namespace rls
+{
+
+struct RlcConfig
+{
+    bool acknowledged = true;    // AM, otherwise UM
+    int snLength = 12;           // 12 or 18 bits for AM, 6 or 12 bits for UM
+    int slot = 1;                // ms between transmission opportunities
+    int opportunities = 1;       // transmission opportunities per slot and link
+    int opportunitySize = 1500;  // bytes per transmission opportunity
+    int bufferSize = 1024 * 1024; // bytes buffered per direction and link
+    int maxRetx = 8;
+    int pollPdu = 16;      // -1 for infinity
+    int pollByte = 25000;  // -1 for infinity
+    int pollRetransmit = 45; // ms
+    int reassembly = 35;     // ms
+    int statusProhibit = 10; // ms
+};
+
+/*
+ * RLC bearers of the radio links of a node, one entity per peer. User PDUs are queued as RLC SDUs and leave as RLC
+ * PDUs in the transmission opportunities of each slot, so the link gets the segmentation, ARQ and window behaviour
+ * of a real radio bearer. The type and payload of the user PDU travel in a small header in front of the SDU.
+ *
+ * The receiving end creates the bearer of a peer on its first RLC PDU, with the mode and SN length the peer announces
+ * in the payload and its own timers.
+ */
+class RlcBearers : public rlc::IRlcConsumer
+{
+  private:
+    uint64_t m_sti;
+    RlcConfig m_config;
+    std::unordered_map<int, std::unique_ptr<rlc::IRlcEntity>> m_entities; // by peer
+    std::unordered_map<rlc::IRlcEntity *, std::pair<int, uint32_t>> m_peers; // peer and mode of each entity
+    std::vector<uint8_t> m_buffer;
+    std::vector<RlsPduTransmission> *m_delivered;
+    std::vector<int> m_failures;
+    int m_sduId;
+
+  public:
+    RlcBearers(uint64_t sti, const RlcConfig &config);
+    ~RlcBearers();
+
+  public:
+    /* Queues the user PDU for the peer, sent in the next transmission opportunities. PDUs over 32 KiB are dropped */
+    void submit(int peer, const RlsPduTransmission &pdu);
+    /* Handles an RLC PDU from the peer, the user PDUs it completes are appended to outDelivered in order */
+    void receive(int64_t now, int peer, const RlsPduTransmission &pdu, std::vector<RlsPduTransmission> &outDelivered);
+    /*
+     * Runs the RLC timers and the transmission opportunities of a slot, the RLC PDUs to send are appended to outPdus.
+     * Returns whether a bearer used all its opportunities, so that it may still have something to send.
+     */
+    bool runSlot(int64_t now, std::vector<std::pair<int, RlsPduTransmission>> &outPdus);
+    void remove(int peer);
+    /* Peers whose bearer reached the maximum number of retransmissions since the last call */
+    std::vector<int> takeFailures();
+
+    [[nodiscard]] bool empty() const;
+    [[nodiscard]] int slot() const;
+
+  public:
+    void deliverSdu(rlc::IRlcEntity *entity, uint8_t *data, int size) override;
+    void maxRetransmissionReached(rlc::IRlcEntity *entity) override;
+    void sduSuccessfulDelivery(rlc::IRlcEntity *entity, int sduId) override;
+
+  private:
+    rlc::IRlcEntity *findOrCreate(int peer, uint32_t mode);
+};
+
+} // namespace rls
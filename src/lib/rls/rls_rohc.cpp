@@ -0,0 +1,278 @@
+//
+// This file is a part of UERANSIM project.
+// Copyright (c) 2023 ALİ GÜNGÖR.
+//
+// https://github.com/aligungr/UERANSIM/
+// See README, LICENSE, and CONTRIBUTING files for licensing details.
+//
+
+#include "rls_rohc.hpp"
+
+#include <cstring>
+
+#include <netinet/in.h>
+
+static constexpr const int IPV4_HEADER_SIZE = 20;
+static constexpr const int UDP_HEADER_SIZE = 8;
+static constexpr const int TCP_HEADER_SIZE = 20;
+
+// Packets sent with a context before it is refreshed with an IR
+static constexpr const int REFRESH_PERIOD = 32;
+
+// Changing fields carried by the compressed packets
+static constexpr const int UDP_FIELDS_SIZE = 4; // IP ID, UDP checksum
+static constexpr const int TCP_FIELDS_SIZE = 15; // IP ID, sequence, ack, flags, window, TCP checksum
+
+enum PacketType : uint8_t
+{
+    PACKET_IR = 1,  // full packet, (re)establishes the context
+    PACKET_UDP = 2, // compressed IPv4/UDP
+    PACKET_TCP = 3, // compressed IPv4/TCP
+};
+
+/* Length of the compressible headers, 0 if the packet is not an unfragmented IPv4 UDP or TCP packet without IP options */
+static int HeaderLength(const uint8_t *ip, int length)
+{
+    if (length < IPV4_HEADER_SIZE || ip[0] != 0x45)
+        return 0;
+    if (((ip[2] << 8) | ip[3]) != length)
+        return 0;
+    if ((ip[6] & 0x3F) != 0 || ip[7] != 0) // MF flag or fragment offset
+        return 0;
+
+    if (ip[9] == IPPROTO_UDP)
+    {
+        if (length < IPV4_HEADER_SIZE + UDP_HEADER_SIZE)
+            return 0;
+        // The decompressor rebuilds the UDP length from the IP total length
+        if (((ip[24] << 8) | ip[25]) != length - IPV4_HEADER_SIZE)
+            return 0;
+        return IPV4_HEADER_SIZE + UDP_HEADER_SIZE;
+    }
+
+    if (ip[9] == IPPROTO_TCP)
+    {
+        if (length < IPV4_HEADER_SIZE + TCP_HEADER_SIZE)
+            return 0;
+        int dataOffset = (ip[32] >> 4) * 4;
+        if (dataOffset < TCP_HEADER_SIZE || length < IPV4_HEADER_SIZE + dataOffset)
+            return 0;
+        return IPV4_HEADER_SIZE + dataOffset;
+    }
+
+    return 0;
+}
+
+/* Header fields that identify a flow and are not expected to change during its lifetime */
+static std::string StaticFields(const uint8_t *ip)
+{
+    auto *chars = reinterpret_cast<const char *>(ip);
+
+    std::string fields{};
+    fields.append(chars, 2);      // version, IHL, TOS
+    fields.push_back(chars[6]);   // DF flag
+    fields.append(chars + 8, 2);  // TTL, protocol
+    fields.append(chars + 12, 8); // addresses
+    fields.append(chars + 20, 4); // ports
+    if (ip[9] == IPPROTO_TCP)
+        fields.push_back(chars[32]); // data offset
+    return fields;
+}
+
+static void SetIpv4Checksum(uint8_t *ip)
+{
+    ip[10] = 0;
+    ip[11] = 0;
+
+    uint32_t sum = 0;
+    for (int i = 0; i < IPV4_HEADER_SIZE; i += 2)
+        sum += (ip[i] << 8) | ip[i + 1];
+    while (sum >> 16)
+        sum = (sum & 0xFFFF) + (sum >> 16);
+
+    ip[10] = static_cast<uint8_t>(~sum >> 8 & 0xFF);
+    ip[11] = static_cast<uint8_t>(~sum & 0xFF);
+}
+
+namespace rls
+{
+
+HeaderCompressor::HeaderCompressor()
+    : m_contexts{}, m_owners(ROHC_MAX_CONTEXTS), m_generations(ROHC_MAX_CONTEXTS), m_nextCid{}
+{
+}
+
+bool HeaderCompressor::compress(const OctetString &packet, int offset, OctetString &output)
+{
+    if (packet.length() < offset)
+        return false;
+
+    const uint8_t *ip = packet.data() + offset;
+    int length = packet.length() - offset;
+
+    int headerLength = HeaderLength(ip, length);
+    if (headerLength == 0)
+        return false;
+
+    bool isTcp = ip[9] == IPPROTO_TCP;
+
+    // The urgent pointer is left to uncompressed packets
+    if (isTcp && (ip[38] != 0 || ip[39] != 0))
+        return false;
+
+    bool refresh = false;
+
+    auto fields = StaticFields(ip);
+    auto it = m_contexts.find(fields);
+    if (it == m_contexts.end())
+    {
+        // Context ids are reused in a round, the flow that got its id the longest time ago loses it
+        int cid = m_nextCid;
+        m_nextCid = (m_nextCid + 1) % ROHC_MAX_CONTEXTS;
+
+        if (!m_owners[cid].empty())
+            m_contexts.erase(m_owners[cid]);
+        m_owners[cid] = fields;
+        m_generations[cid]++;
+
+        it = m_contexts.emplace(std::move(fields), Context{cid, 0}).first;
+        refresh = true;
+    }
+    else if (++it->second.sinceRefresh >= REFRESH_PERIOD)
+    {
+        refresh = true;
+    }
+
+    auto &ctx = it->second;
+
+    output.append(packet.data(), static_cast<size_t>(offset));
+
+    if (refresh)
+    {
+        ctx.sinceRefresh = 0;
+        output.appendOctet(PACKET_IR);
+        output.appendOctet(ctx.cid);
+        output.appendOctet(m_generations[ctx.cid]);
+        output.append(ip, static_cast<size_t>(length));
+        return true;
+    }
+
+    output.appendOctet(isTcp ? PACKET_TCP : PACKET_UDP);
+    output.appendOctet(ctx.cid);
+    output.appendOctet(m_generations[ctx.cid]);
+    output.append(ip + 4, 2); // IP ID
+
+    if (isTcp)
+    {
+        output.append(ip + 24, 8); // sequence and ack numbers
+        output.appendOctet(ip[33]); // flags
+        output.append(ip + 34, 4); // window, checksum
+        output.append(ip + 40, static_cast<size_t>(headerLength - IPV4_HEADER_SIZE - TCP_HEADER_SIZE)); // options
+    }
+    else
+    {
+        output.append(ip + 26, 2); // checksum
+    }
+
+    output.append(ip + headerLength, static_cast<size_t>(length - headerLength));
+    return true;
+}
+
+void HeaderCompressor::reset()
+{
+    m_contexts.clear();
+    for (auto &owner : m_owners)
+        owner.clear();
+    m_nextCid = 0;
+}
+
+HeaderDecompressor::HeaderDecompressor() : m_headers(ROHC_MAX_CONTEXTS), m_generations(ROHC_MAX_CONTEXTS)
+{
+}
+
+bool HeaderDecompressor::decompress(const OctetString &packet, int offset, OctetString &output)
+{
+    if (packet.length() < offset + 3)
+        return false;
+
+    const uint8_t *data = packet.data() + offset;
+    int length = packet.length() - offset - 3;
+    int type = data[0];
+    int cid = data[1];
+    uint8_t generation = data[2];
+    data += 3;
+
+    if (type == PACKET_IR)
+    {
+        int headerLength = HeaderLength(data, length);
+        if (headerLength == 0)
+            return false;
+
+        m_headers[cid] = OctetString::FromArray(data, static_cast<size_t>(headerLength));
+        m_generations[cid] = generation;
+
+        output.append(packet.data(), static_cast<size_t>(offset));
+        output.append(data, static_cast<size_t>(length));
+        return true;
+    }
+
+    if (type != PACKET_UDP && type != PACKET_TCP)
+        return false;
+
+    auto &header = m_headers[cid];
+    if (header.length() == 0 || m_generations[cid] != generation)
+        return false; // IR of the flow not received yet, the next refresh recovers it
+
+    bool isTcp = header.data()[9] == IPPROTO_TCP;
+    if (isTcp != (type == PACKET_TCP))
+        return false;
+
+    int headerLength = header.length();
+    int fieldsLength = isTcp ? TCP_FIELDS_SIZE + headerLength - IPV4_HEADER_SIZE - TCP_HEADER_SIZE : UDP_FIELDS_SIZE;
+    if (length < fieldsLength)
+        return false;
+
+    int payloadLength = length - fieldsLength;
+    int totalLength = headerLength + payloadLength;
+    if (totalLength > 0xFFFF)
+        return false;
+
+    int start = output.length();
+    output.append(packet.data(), static_cast<size_t>(offset));
+    output.append(header.data(), static_cast<size_t>(headerLength));
+
+    uint8_t *ip = output.data() + start + offset;
+    ip[2] = static_cast<uint8_t>(totalLength >> 8);
+    ip[3] = static_cast<uint8_t>(totalLength & 0xFF);
+    std::memcpy(ip + 4, data, 2);
+
+    if (isTcp)
+    {
+        std::memcpy(ip + 24, data + 2, 8);
+        ip[33] = data[10];
+        std::memcpy(ip + 34, data + 11, 4);
+        ip[38] = 0;
+        ip[39] = 0;
+        std::memcpy(ip + 40, data + TCP_FIELDS_SIZE, static_cast<size_t>(headerLength - IPV4_HEADER_SIZE - TCP_HEADER_SIZE));
+    }
+    else
+    {
+        int udpLength = UDP_HEADER_SIZE + payloadLength;
+        ip[24] = static_cast<uint8_t>(udpLength >> 8);
+        ip[25] = static_cast<uint8_t>(udpLength & 0xFF);
+        std::memcpy(ip + 26, data + 2, 2);
+    }
+
+    SetIpv4Checksum(ip);
+
+    output.append(data + fieldsLength, static_cast<size_t>(payloadLength));
+    return true;
+}
+
+void HeaderDecompressor::reset()
+{
+    for (auto &header : m_headers)
+        header = OctetString{};
+}
+
+} // namespace rls
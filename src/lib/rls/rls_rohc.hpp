@@ -0,0 +1,73 @@
+//
+// This file is a part of UERANSIM project.
+// Copyright (c) 2023 ALİ GÜNGÖR.
+//
+// https://github.com/aligungr/UERANSIM/
+// See README, LICENSE, and CONTRIBUTING files for licensing details.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <utils/octet_string.hpp>
+
+namespace rls
+{
+
+// Number of flows a single link keeps a compression context for
+static constexpr const int ROHC_MAX_CONTEXTS = 256;
+
+/*
+ * ROHC-like header compression for IPv4/UDP and IPv4/TCP packets of a single link.
+ *
+ * The static part of the headers (addresses, ports, TOS, TTL...) is sent once in an IR packet and then referred to by
+ * a context id, compressed packets only carry the fields that change per packet. Contexts are refreshed with an IR
+ * periodically, so that a lost IR or a decompressor that has lost its state recovers without a feedback channel.
+ * Every packet also carries the generation of its context id, which changes whenever the id is given to another flow,
+ * so that packets whose IR was lost are dropped instead of being rebuilt with the headers of the previous flow.
+ * Bytes before the given offset (e.g. the BAP header) are carried unchanged.
+ */
+class HeaderCompressor
+{
+  private:
+    struct Context
+    {
+        int cid{};
+        int sinceRefresh{};
+    };
+
+  private:
+    std::unordered_map<std::string, Context> m_contexts; // by static header fields
+    std::vector<std::string> m_owners;                   // static header fields by cid
+    std::vector<uint8_t> m_generations;                  // by cid, kept over resets
+    int m_nextCid;
+
+  public:
+    HeaderCompressor();
+
+  public:
+    /* Returns false if the packet has to be sent uncompressed */
+    bool compress(const OctetString &packet, int offset, OctetString &output);
+    void reset();
+};
+
+class HeaderDecompressor
+{
+  private:
+    std::vector<OctetString> m_headers; // uncompressed IP and transport headers by cid
+    std::vector<uint8_t> m_generations; // of the headers, by cid
+
+  public:
+    HeaderDecompressor();
+
+  public:
+    /* Returns false if the packet is malformed or refers to an unknown or outdated context */
+    bool decompress(const OctetString &packet, int offset, OctetString &output);
+    void reset();
+};
+
+} // namespace rls
@@ -0,0 +1,707 @@
+//
+// This file is a part of UERANSIM project.
+// Copyright (c) 2023 ALİ GÜNGÖR.
+//
+// https://github.com/aligungr/UERANSIM/
+// See README, LICENSE, and CONTRIBUTING files for licensing details.
+//
+
+#include "rls_shm.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <new>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <utils/common.hpp>
+#include <utils/libc_error.hpp>
+
+static constexpr const size_t RING_SIZE = 256 * 1024; // bytes per direction of a channel
+static constexpr const uint32_t WRAP_MARKER = 0xFFFFFFFF;
+static constexpr const uint32_t HANDSHAKE_MAGIC = 0x524C5331;
+static constexpr const int HANDSHAKE_TIMEOUT = 100;   // ms
+static constexpr const int64_t CONNECT_RETRY_PERIOD = 5000; // ms between attempts to reach the same address
+static constexpr const int CHANNEL_BURST = 32; // datagrams taken from a channel before moving on to the next
+static constexpr const uint32_t UDP_TURN = 16; // UDP is looked at first once in this many receptions
+static constexpr const int MAX_EVENTS = 16;
+
+// Synthetic addresses of unbound end-points, fd00:5253::/32 with the pid and a per-process counter
+static constexpr const uint8_t SYNTHETIC_PREFIX[] = {0xFD, 0x00, 0x52, 0x53};
+static std::atomic<uint32_t> g_unboundCounter{};
+
+namespace rls
+{
+
+struct ShmRing
+{
+    alignas(64) std::atomic<uint64_t> head; // written by the producer only
+    alignas(64) std::atomic<uint64_t> tail; // written by the consumer only
+    alignas(64) uint8_t data[RING_SIZE];
+};
+
+} // namespace rls
+
+using rls::ShmRing;
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "ring indices are shared between processes");
+
+struct Hello
+{
+    uint32_t magic;
+    uint32_t addressLength;
+    sockaddr_storage address;
+};
+
+static size_t RecordSize(size_t size)
+{
+    return (sizeof(uint32_t) + size + 7) & ~static_cast<size_t>(7);
+}
+
+/* Returns false if the ring is full, outNotify is set if the consumer may have found the ring empty */
+static bool PushRing(ShmRing &ring, const uint8_t *buffer, size_t size, bool &outNotify)
+{
+    uint64_t head = ring.head.load(std::memory_order_relaxed);
+    uint64_t tail = ring.tail.load(std::memory_order_acquire);
+
+    size_t record = RecordSize(size);
+    size_t offset = head % RING_SIZE;
+    size_t contiguous = RING_SIZE - offset;
+    size_t skip = contiguous < record ? contiguous : 0;
+
+    if (RING_SIZE - (head - tail) < skip + record)
+        return false;
+
+    uint64_t position = head;
+    if (skip != 0)
+    {
+        std::memcpy(ring.data + offset, &WRAP_MARKER, sizeof(uint32_t));
+        position += skip;
+        offset = 0;
+    }
+
+    auto length = static_cast<uint32_t>(size);
+    std::memcpy(ring.data + offset, &length, sizeof(uint32_t));
+    std::memcpy(ring.data + offset + sizeof(uint32_t), buffer, size);
+
+    // Pairs with the consumer storing its tail before it loads the head, one of the two sees the other
+    ring.head.store(position + record, std::memory_order_seq_cst);
+    outNotify = ring.tail.load(std::memory_order_seq_cst) == head;
+    return true;
+}
+
+/* Returns 0 if the ring is empty, -1 if it is corrupted, otherwise the size of the datagram */
+static int PopRing(ShmRing &ring, uint8_t *buffer, size_t bufferSize)
+{
+    uint64_t tail = ring.tail.load(std::memory_order_relaxed);
+    uint64_t head = ring.head.load(std::memory_order_seq_cst);
+    if (tail == head)
+        return 0;
+
+    size_t offset = tail % RING_SIZE;
+    uint32_t length{};
+    std::memcpy(&length, ring.data + offset, sizeof(uint32_t));
+
+    if (length == WRAP_MARKER)
+    {
+        tail += RING_SIZE - offset;
+        offset = 0;
+        if (tail == head)
+        {
+            ring.tail.store(tail, std::memory_order_seq_cst);
+            return 0;
+        }
+        std::memcpy(&length, ring.data, sizeof(uint32_t));
+    }
+
+    if (RecordSize(length) > RING_SIZE - offset || tail + RecordSize(length) > head)
+        return -1;
+
+    size_t size = std::min(bufferSize, static_cast<size_t>(length));
+    std::memcpy(buffer, ring.data + offset + sizeof(uint32_t), size);
+
+    ring.tail.store(tail + RecordSize(length), std::memory_order_seq_cst);
+    return static_cast<int>(size);
+}
+
+static std::pair<sockaddr_un, socklen_t> SocketName(const InetAddress &address)
+{
+    char ip[INET6_ADDRSTRLEN] = {0};
+    auto *sa = address.getSockAddr();
+    if (sa->sa_family == AF_INET)
+        inet_ntop(AF_INET, &reinterpret_cast<const sockaddr_in *>(sa)->sin_addr, ip, sizeof(ip));
+    else if (sa->sa_family == AF_INET6)
+        inet_ntop(AF_INET6, &reinterpret_cast<const sockaddr_in6 *>(sa)->sin6_addr, ip, sizeof(ip));
+
+    std::string name = "ueransim-rls/" + std::string{ip} + "/" + std::to_string(address.getPort());
+
+    // Abstract namespace, the name starts after a null byte and the socket goes away with its process
+    sockaddr_un sun{};
+    sun.sun_family = AF_UNIX;
+    size_t length = std::min(name.size(), sizeof(sun.sun_path) - 1);
+    std::memcpy(sun.sun_path + 1, name.data(), length);
+    return {sun, static_cast<socklen_t>(offsetof(sockaddr_un, sun_path) + 1 + length)};
+}
+
+static bool IsSynthetic(const InetAddress &address)
+{
+    auto *sa = address.getSockAddr();
+    if (sa->sa_family != AF_INET6)
+        return false;
+    return std::memcmp(&reinterpret_cast<const sockaddr_in6 *>(sa)->sin6_addr, SYNTHETIC_PREFIX,
+                       sizeof(SYNTHETIC_PREFIX)) == 0;
+}
+
+static InetAddress SyntheticAddress()
+{
+    auto pid = static_cast<uint32_t>(getpid());
+    uint32_t counter = g_unboundCounter++;
+
+    sockaddr_storage storage{};
+    auto &sin6 = reinterpret_cast<sockaddr_in6 &>(storage);
+    sin6.sin6_family = AF_INET6;
+    sin6.sin6_port = htons(1);
+    std::memcpy(sin6.sin6_addr.s6_addr, SYNTHETIC_PREFIX, sizeof(SYNTHETIC_PREFIX));
+    for (int i = 0; i < 4; i++)
+    {
+        sin6.sin6_addr.s6_addr[8 + i] = static_cast<uint8_t>(pid >> (24 - 8 * i));
+        sin6.sin6_addr.s6_addr[12 + i] = static_cast<uint8_t>(counter >> (24 - 8 * i));
+    }
+    return InetAddress{storage, sizeof(sockaddr_in6)};
+}
+
+static std::string AddressKey(const InetAddress &address)
+{
+    return std::string{reinterpret_cast<const char *>(address.getSockAddr()), address.getSockLen()};
+}
+
+static bool SendWithFds(int socket, const void *data, size_t size, const int *fds, int fdCount)
+{
+    iovec iov{const_cast<void *>(data), size};
+
+    alignas(cmsghdr) char control[CMSG_SPACE(2 * sizeof(int))] = {0};
+    msghdr msg{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = CMSG_SPACE(fdCount * sizeof(int));
+
+    cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(fdCount * sizeof(int));
+    std::memcpy(CMSG_DATA(cmsg), fds, fdCount * sizeof(int));
+
+    return sendmsg(socket, &msg, MSG_NOSIGNAL) == static_cast<ssize_t>(size);
+}
+
+/* Received descriptors beyond the expected count are closed, missing ones are set to -1 */
+static bool ReceiveWithFds(int socket, void *data, size_t size, int *fds, int fdCount)
+{
+    for (int i = 0; i < fdCount; i++)
+        fds[i] = -1;
+
+    iovec iov{data, size};
+
+    alignas(cmsghdr) char control[CMSG_SPACE(4 * sizeof(int))] = {0};
+    msghdr msg{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    ssize_t received = recvmsg(socket, &msg, MSG_CMSG_CLOEXEC);
+
+    for (cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr; cmsg = CMSG_NXTHDR(&msg, cmsg))
+    {
+        if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS)
+            continue;
+
+        int count = static_cast<int>((cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int));
+        for (int i = 0; i < count; i++)
+        {
+            int fd{};
+            std::memcpy(&fd, CMSG_DATA(cmsg) + i * sizeof(int), sizeof(int));
+            if (i < fdCount)
+                fds[i] = fd;
+            else
+                close(fd);
+        }
+    }
+
+    bool complete = received == static_cast<ssize_t>(size);
+    for (int i = 0; i < fdCount; i++)
+        complete = complete && fds[i] >= 0;
+    return complete;
+}
+
+static void CloseAll(const int *fds, int count)
+{
+    for (int i = 0; i < count; i++)
+        if (fds[i] >= 0)
+            close(fds[i]);
+}
+
+static void SetReceiveTimeout(int socket, int timeoutMs)
+{
+    timeval tv{};
+    tv.tv_sec = timeoutMs / 1000;
+    tv.tv_usec = (timeoutMs % 1000) * 1000;
+    setsockopt(socket, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+}
+
+namespace rls
+{
+
+ShmTransport::ShmTransport()
+    : m_udp{}, m_udpFds{}, m_address{SyntheticAddress()}, m_bound{}, m_listener{-1}, m_event{-1}, m_epoll{-1},
+      m_channels{}, m_channelByPeer{}, m_lastAttempt{}, m_cursor{}, m_burst{}, m_turn{}, m_handshakes{}, m_mutex{}
+{
+    setup();
+}
+
+ShmTransport::ShmTransport(const std::string &address, uint16_t port)
+    : m_udp{address, port}, m_udpFds{}, m_address{address, port}, m_bound{true}, m_listener{-1}, m_event{-1},
+      m_epoll{-1}, m_channels{}, m_channelByPeer{}, m_lastAttempt{}, m_cursor{}, m_burst{}, m_turn{}, m_handshakes{},
+      m_mutex{}
+{
+    setup();
+
+    m_listener = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (m_listener < 0)
+        throw LibError("Shared memory link socket could not be created:", errno);
+
+    auto name = SocketName(m_address);
+    if (bind(m_listener, reinterpret_cast<sockaddr *>(&name.first), name.second) != 0 ||
+        listen(m_listener, SOMAXCONN) != 0)
+    {
+        int err = errno;
+        close(m_listener);
+        close(m_epoll);
+        close(m_event);
+        throw LibError("Shared memory link socket could not be bound:", err);
+    }
+
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.fd = m_listener;
+    epoll_ctl(m_epoll, EPOLL_CTL_ADD, m_listener, &ev);
+}
+
+ShmTransport::~ShmTransport()
+{
+    while (!m_channels.empty())
+        closeChannel(m_channels.back().get());
+    for (auto &item : m_handshakes)
+        close(item.first);
+
+    if (m_listener >= 0)
+        close(m_listener);
+    close(m_epoll);
+    close(m_event);
+}
+
+void ShmTransport::setup()
+{
+    m_event = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    m_epoll = epoll_create1(EPOLL_CLOEXEC);
+    if (m_event < 0 || m_epoll < 0)
+        throw LibError("Shared memory link could not be set up:", errno);
+
+    m_udpFds = m_udp.GetFileDescriptors();
+    std::vector<int> fds = m_udpFds;
+    fds.push_back(m_event);
+
+    for (int fd : fds)
+    {
+        epoll_event ev{};
+        ev.events = EPOLLIN;
+        ev.data.fd = fd;
+        epoll_ctl(m_epoll, EPOLL_CTL_ADD, fd, &ev);
+    }
+}
+
+int ShmTransport::receive(uint8_t *buffer, size_t bufferSize, int timeoutMs, InetAddress &outPeerAddress)
+{
+    int size{};
+
+    // Busy channels are not allowed to starve the UDP peers
+    if (++m_turn % UDP_TURN == 0 && receiveUdp(buffer, bufferSize, outPeerAddress, size))
+        return size;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (pop(buffer, bufferSize, outPeerAddress, size))
+            return size;
+    }
+
+    epoll_event events[MAX_EVENTS];
+    int count = epoll_wait(m_epoll, events, MAX_EVENTS, timeoutMs);
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    bool udpReadable = false;
+    for (int i = 0; i < count; i++)
+    {
+        int fd = events[i].data.fd;
+        if (fd == m_event)
+        {
+            uint64_t value{};
+            (void)!read(m_event, &value, sizeof(value));
+        }
+        else if (fd == m_listener)
+        {
+            accept();
+        }
+        else if (std::find(m_udpFds.begin(), m_udpFds.end(), fd) != m_udpFds.end())
+        {
+            udpReadable = true;
+        }
+        else if (m_handshakes.count(fd))
+        {
+            completeHandshake(fd);
+        }
+        else
+        {
+            // The peer of the channel is gone
+            auto it = std::find_if(m_channels.begin(), m_channels.end(),
+                                   [fd](auto &channel) { return channel->socket == fd; });
+            if (it != m_channels.end())
+                closeChannel(it->get());
+        }
+    }
+
+    if (!m_handshakes.empty())
+        expireHandshakes(utils::CurrentTimeMillis());
+
+    if (pop(buffer, bufferSize, outPeerAddress, size))
+        return size;
+    lock.unlock();
+
+    if (udpReadable && receiveUdp(buffer, bufferSize, outPeerAddress, size))
+        return size;
+    return 0;
+}
+
+void ShmTransport::send(const InetAddress &address, const uint8_t *buffer, size_t bufferSize)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    auto *channel = channelFor(address, lock);
+    if (channel != nullptr)
+        transmit(*channel, buffer, bufferSize);
+    else if (!IsSynthetic(address))
+        m_udp.Send(address, buffer, bufferSize);
+}
+
+void ShmTransport::sendBatch(const std::vector<InetAddress> &addresses, const uint8_t *buffer, size_t bufferSize)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    std::vector<InetAddress> remote{};
+    for (auto &address : addresses)
+    {
+        auto *channel = channelFor(address, lock);
+        if (channel != nullptr)
+            transmit(*channel, buffer, bufferSize);
+        else if (!IsSynthetic(address))
+            remote.push_back(address);
+    }
+
+    if (!remote.empty())
+        m_udp.SendBatch(remote, buffer, bufferSize);
+}
+
+uint16_t ShmTransport::localPort(int ipVersion) const
+{
+    return m_udp.GetLocalPort(ipVersion);
+}
+
+bool ShmTransport::receiveUdp(uint8_t *buffer, size_t bufferSize, InetAddress &outPeerAddress, int &outSize)
+{
+    for (int fd : m_udpFds)
+    {
+        sockaddr_storage peer{};
+        socklen_t peerLength = sizeof(peer);
+        ssize_t size = recvfrom(fd, buffer, bufferSize, MSG_DONTWAIT, reinterpret_cast<sockaddr *>(&peer), &peerLength);
+        if (size > 0)
+        {
+            outPeerAddress = InetAddress{peer, peerLength};
+            outSize = static_cast<int>(size);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ShmTransport::pop(uint8_t *buffer, size_t bufferSize, InetAddress &outPeerAddress, int &outSize)
+{
+    for (size_t i = 0; i < m_channels.size(); i++)
+    {
+        size_t index = (m_cursor + i) % m_channels.size();
+        auto *channel = m_channels[index].get();
+
+        int size = PopRing(*channel->rx, buffer, bufferSize);
+        if (size == 0)
+            continue;
+
+        if (size < 0)
+        {
+            closeChannel(channel);
+            return false;
+        }
+
+        // Stay on the channel for a burst, so that idle channels are looked at once per burst rather than per datagram
+        if (index != m_cursor)
+        {
+            m_cursor = index;
+            m_burst = 0;
+        }
+        if (++m_burst >= CHANNEL_BURST)
+        {
+            m_cursor = index + 1;
+            m_burst = 0;
+        }
+
+        outPeerAddress = channel->peer;
+        outSize = size;
+        return true;
+    }
+    return false;
+}
+
+void ShmTransport::transmit(Channel &channel, const uint8_t *buffer, size_t bufferSize)
+{
+    // A full ring drops the datagram, as the socket buffer of a congested UDP peer would
+    bool notify = false;
+    if (bufferSize > RING_SIZE / 4 || !PushRing(*channel.tx, buffer, bufferSize, notify))
+        return;
+
+    if (notify)
+    {
+        uint64_t one = 1;
+        (void)!write(channel.peerEvent, &one, sizeof(one));
+    }
+}
+
+ShmTransport::Channel *ShmTransport::channelFor(const InetAddress &address, std::unique_lock<std::mutex> &lock)
+{
+    auto key = AddressKey(address);
+
+    auto it = m_channelByPeer.find(key);
+    if (it != m_channelByPeer.end())
+        return it->second;
+
+    // Channels are set up by unbound end-points, bound ones only accept them
+    if (m_bound || IsSynthetic(address))
+        return nullptr;
+
+    // The attempt is recorded first, so that the other senders use UDP meanwhile instead of setting up another one
+    int64_t now = utils::CurrentTimeMillis();
+    auto &lastAttempt = m_lastAttempt[key];
+    if (lastAttempt != 0 && now - lastAttempt < CONNECT_RETRY_PERIOD)
+        return nullptr;
+    lastAttempt = now;
+
+    // The handshake may take up to HANDSHAKE_TIMEOUT, the other senders and the receiver are not held up by it
+    lock.unlock();
+    auto channel = connect(address);
+    lock.lock();
+
+    return channel != nullptr ? addChannel(std::move(channel)) : nullptr;
+}
+
+std::unique_ptr<ShmTransport::Channel> ShmTransport::connect(const InetAddress &address)
+{
+    int sock = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (sock < 0)
+        return nullptr;
+
+    // Refused if there is no bound end-point of this address on the host, UDP is used then
+    auto name = SocketName(address);
+    if (::connect(sock, reinterpret_cast<sockaddr *>(&name.first), name.second) != 0)
+    {
+        close(sock);
+        return nullptr;
+    }
+    SetReceiveTimeout(sock, HANDSHAKE_TIMEOUT);
+
+    int memfd = memfd_create("ueransim-rls", MFD_CLOEXEC);
+    if (memfd < 0 || ftruncate(memfd, 2 * sizeof(ShmRing)) != 0)
+    {
+        if (memfd >= 0)
+            close(memfd);
+        close(sock);
+        return nullptr;
+    }
+
+    void *memory = mmap(nullptr, 2 * sizeof(ShmRing), PROT_READ | PROT_WRITE, MAP_SHARED, memfd, 0);
+    if (memory == MAP_FAILED)
+    {
+        close(memfd);
+        close(sock);
+        return nullptr;
+    }
+    // The memfd is zero-filled, only the indices are set explicitly
+    for (int i = 0; i < 2; i++)
+    {
+        auto *ring = new (static_cast<ShmRing *>(memory) + i) ShmRing;
+        ring->head.store(0);
+        ring->tail.store(0);
+    }
+
+    Hello hello{};
+    hello.magic = HANDSHAKE_MAGIC;
+    hello.addressLength = m_address.getSockLen();
+    std::memcpy(&hello.address, m_address.getSockAddr(), m_address.getSockLen());
+
+    int fds[2] = {memfd, m_event};
+    bool sent = SendWithFds(sock, &hello, sizeof(hello), fds, 2);
+    close(memfd);
+
+    uint32_t reply{};
+    int peerEvent = -1;
+    if (!sent || !ReceiveWithFds(sock, &reply, sizeof(reply), &peerEvent, 1) || reply != HANDSHAKE_MAGIC)
+    {
+        CloseAll(&peerEvent, 1);
+        munmap(memory, 2 * sizeof(ShmRing));
+        close(sock);
+        return nullptr;
+    }
+
+    return makeChannel(sock, peerEvent, memory, true, address);
+}
+
+void ShmTransport::accept()
+{
+    // The hello is waited for by the receive loop, a peer that is slow to send it holds nothing up
+    int64_t deadline = utils::CurrentTimeMillis() + HANDSHAKE_TIMEOUT;
+    while (true)
+    {
+        int sock = accept4(m_listener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (sock < 0)
+            return;
+
+        epoll_event ev{};
+        ev.events = EPOLLIN | EPOLLRDHUP;
+        ev.data.fd = sock;
+        epoll_ctl(m_epoll, EPOLL_CTL_ADD, sock, &ev);
+        m_handshakes[sock] = deadline;
+    }
+}
+
+void ShmTransport::completeHandshake(int sock)
+{
+    m_handshakes.erase(sock);
+    epoll_ctl(m_epoll, EPOLL_CTL_DEL, sock, nullptr);
+
+    Hello hello{};
+    int fds[2];
+    struct stat info{};
+    if (!ReceiveWithFds(sock, &hello, sizeof(hello), fds, 2) || hello.magic != HANDSHAKE_MAGIC ||
+        hello.addressLength > sizeof(sockaddr_storage) || fstat(fds[0], &info) != 0 ||
+        info.st_size < static_cast<off_t>(2 * sizeof(ShmRing)))
+    {
+        CloseAll(fds, 2);
+        close(sock);
+        return;
+    }
+
+    void *memory = mmap(nullptr, 2 * sizeof(ShmRing), PROT_READ | PROT_WRITE, MAP_SHARED, fds[0], 0);
+    close(fds[0]);
+
+    uint32_t reply = HANDSHAKE_MAGIC;
+    if (memory == MAP_FAILED || !SendWithFds(sock, &reply, sizeof(reply), &m_event, 1))
+    {
+        if (memory != MAP_FAILED)
+            munmap(memory, 2 * sizeof(ShmRing));
+        close(fds[1]);
+        close(sock);
+        return;
+    }
+
+    InetAddress peer{hello.address, static_cast<socklen_t>(hello.addressLength)};
+
+    // A peer that set up its channel again has lost the previous one
+    auto it = m_channelByPeer.find(AddressKey(peer));
+    if (it != m_channelByPeer.end())
+        closeChannel(it->second);
+
+    addChannel(makeChannel(sock, fds[1], memory, false, peer));
+}
+
+void ShmTransport::expireHandshakes(int64_t now)
+{
+    for (auto it = m_handshakes.begin(); it != m_handshakes.end();)
+    {
+        if (it->second > now)
+        {
+            ++it;
+            continue;
+        }
+
+        epoll_ctl(m_epoll, EPOLL_CTL_DEL, it->first, nullptr);
+        close(it->first);
+        it = m_handshakes.erase(it);
+    }
+}
+
+std::unique_ptr<ShmTransport::Channel> ShmTransport::makeChannel(int socket, int peerEvent, void *memory,
+                                                                 bool initiator, const InetAddress &peer)
+{
+    auto *rings = static_cast<ShmRing *>(memory);
+
+    auto channel = std::make_unique<Channel>();
+    channel->socket = socket;
+    channel->peerEvent = peerEvent;
+    channel->memory = memory;
+    channel->tx = initiator ? &rings[0] : &rings[1];
+    channel->rx = initiator ? &rings[1] : &rings[0];
+    channel->peer = peer;
+    return channel;
+}
+
+ShmTransport::Channel *ShmTransport::addChannel(std::unique_ptr<Channel> &&channel)
+{
+    epoll_event ev{};
+    ev.events = EPOLLRDHUP;
+    ev.data.fd = channel->socket;
+    epoll_ctl(m_epoll, EPOLL_CTL_ADD, channel->socket, &ev);
+
+    auto *result = channel.get();
+    m_channelByPeer[AddressKey(channel->peer)] = result;
+    m_channels.push_back(std::move(channel));
+    return result;
+}
+
+void ShmTransport::closeChannel(Channel *channel)
+{
+    epoll_ctl(m_epoll, EPOLL_CTL_DEL, channel->socket, nullptr);
+    close(channel->socket);
+    close(channel->peerEvent);
+    munmap(channel->memory, 2 * sizeof(ShmRing));
+
+    auto key = AddressKey(channel->peer);
+    auto it = m_channelByPeer.find(key);
+    if (it != m_channelByPeer.end() && it->second == channel)
+        m_channelByPeer.erase(it);
+
+    // An unbound end-point may set the channel up again right away if the peer comes back
+    m_lastAttempt.erase(key);
+
+    m_channels.erase(std::find_if(m_channels.begin(), m_channels.end(),
+                                  [channel](auto &item) { return item.get() == channel; }));
+    m_cursor = 0;
+    m_burst = 0;
+}
+
+} // namespace rls
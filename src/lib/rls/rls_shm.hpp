@@ -0,0 +1,98 @@
+//
+// This file is a part of UERANSIM project.
+// Copyright (c) 2023 ALİ GÜNGÖR.
+//
+// https://github.com/aligungr/UERANSIM/
+// See README, LICENSE, and CONTRIBUTING files for licensing details.
+//
+
+#pragma once
+
+#include "rls_transport.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <lib/udp/server.hpp>
+#include <utils/network.hpp>
+
+namespace rls
+{
+
+struct ShmRing;
+
+/*
+ * Transport to processes of the same host through shared memory, peers elsewhere are reached with UDP.
+ *
+ * An end-point bound to an address also listens on an abstract unix socket named after that address. The first
+ * datagram sent to such an address sets up a channel: the sender passes a memfd holding one SPSC ring per direction
+ * and its eventfd over the unix socket, and gets the eventfd of the bound end-point back. Datagrams are then copied
+ * into the ring of the channel, and the eventfd of the receiver is only signalled when it may have found the ring
+ * empty. The unix socket is kept open so that the channel is torn down when the peer process is gone.
+ *
+ * Sending is thread-safe. The sender setting up a channel waits for the handshake without holding the lock, and the
+ * bound end-point completes the handshakes of the accepted sockets as their hello arrives, within its receive loop.
+ *
+ * The unbound side is known to the bound side by a synthetic address, replies to it never leave the channel.
+ */
+class ShmTransport : public RlsTransport
+{
+  private:
+    struct Channel
+    {
+        int socket{};
+        int peerEvent{};
+        void *memory{};
+        ShmRing *tx{};
+        ShmRing *rx{};
+        InetAddress peer{};
+    };
+
+  private:
+    udp::UdpServer m_udp;
+    std::vector<int> m_udpFds;
+    InetAddress m_address; // bound address, or the synthetic address of an unbound end-point
+    bool m_bound;
+    int m_listener;
+    int m_event;
+    int m_epoll;
+    std::vector<std::unique_ptr<Channel>> m_channels;
+    std::unordered_map<std::string, Channel *> m_channelByPeer;
+    std::unordered_map<std::string, int64_t> m_lastAttempt; // by peer address
+    size_t m_cursor;
+    int m_burst;
+    uint32_t m_turn;
+    std::unordered_map<int, int64_t> m_handshakes; // accepted sockets waiting for their hello, with their deadline
+    std::mutex m_mutex; // senders of several threads against each other and the receiver, which waits without it
+
+  public:
+    ShmTransport();
+    ShmTransport(const std::string &address, uint16_t port);
+    ~ShmTransport() override;
+
+    int receive(uint8_t *buffer, size_t bufferSize, int timeoutMs, InetAddress &outPeerAddress) override;
+    void send(const InetAddress &address, const uint8_t *buffer, size_t bufferSize) override;
+    void sendBatch(const std::vector<InetAddress> &addresses, const uint8_t *buffer, size_t bufferSize) override;
+    [[nodiscard]] uint16_t localPort(int ipVersion) const override;
+
+  private:
+    void setup();
+    bool receiveUdp(uint8_t *buffer, size_t bufferSize, InetAddress &outPeerAddress, int &outSize);
+    bool pop(uint8_t *buffer, size_t bufferSize, InetAddress &outPeerAddress, int &outSize);
+    void transmit(Channel &channel, const uint8_t *buffer, size_t bufferSize);
+    Channel *channelFor(const InetAddress &address, std::unique_lock<std::mutex> &lock);
+    std::unique_ptr<Channel> connect(const InetAddress &address);
+    void accept();
+    void completeHandshake(int socket);
+    void expireHandshakes(int64_t now);
+    static std::unique_ptr<Channel> makeChannel(int socket, int peerEvent, void *memory, bool initiator,
+                                                const InetAddress &peer);
+    Channel *addChannel(std::unique_ptr<Channel> &&channel);
+    void closeChannel(Channel *channel);
+};
+
+} // namespace rls
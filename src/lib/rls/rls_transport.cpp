@@ -0,0 +1,340 @@
+//
+// This file is a part of UERANSIM project.
+// Copyright (c) 2023 ALİ GÜNGÖR.
+//
+// https://github.com/aligungr/UERANSIM/
+// See README, LICENSE, and CONTRIBUTING files for licensing details.
+//
+
+#include "rls_transport.hpp"
+#include "rls_pdu.hpp"
+#include "rls_shm.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
+
+#include <utils/libc_error.hpp>
+
+static constexpr const size_t RING_CAPACITY = 1024; // must be a power of two
+static constexpr const size_t SHARED_INBOX_CAPACITY = 64; // per UE of a shared end-point, a power of two as well
+static constexpr const size_t SHARED_BUFFER_SIZE = 16384;
+static constexpr const uint16_t EPHEMERAL_PORT_BASE = 49152;
+
+static std::string AddressKey(const InetAddress &address)
+{
+    return std::string{reinterpret_cast<const char *>(address.getSockAddr()), address.getSockLen()};
+}
+
+namespace rls
+{
+
+/* Bounded multi-producer single-consumer ring, every cell and UE sending to the end-point is a producer */
+class MemoryEndpoint
+{
+  private:
+    struct Slot
+    {
+        std::atomic<size_t> sequence{};
+        InetAddress source{};
+        std::vector<uint8_t> data{};
+    };
+
+  private:
+    size_t m_capacity;
+    std::unique_ptr<Slot[]> m_slots;
+    alignas(64) std::atomic<size_t> m_head;
+    alignas(64) size_t m_tail;
+
+    // Only used to put the consumer to sleep when the ring is empty
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::atomic<bool> m_waiting;
+
+  public:
+    explicit MemoryEndpoint(size_t capacity)
+        : m_capacity{capacity}, m_slots{new Slot[capacity]}, m_head{}, m_tail{}, m_mutex{}, m_cv{}, m_waiting{}
+    {
+        for (size_t i = 0; i < m_capacity; i++)
+            m_slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    bool push(const InetAddress &source, const uint8_t *buffer, size_t size)
+    {
+        Slot *slot;
+        size_t pos = m_head.load(std::memory_order_relaxed);
+        while (true)
+        {
+            slot = &m_slots[pos & (m_capacity - 1)];
+            size_t seq = slot->sequence.load(std::memory_order_acquire);
+            auto diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (diff == 0)
+            {
+                if (m_head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            }
+            else if (diff < 0)
+            {
+                // Full, dropped like a datagram overflowing a socket buffer
+                return false;
+            }
+            else
+            {
+                pos = m_head.load(std::memory_order_relaxed);
+            }
+        }
+
+        slot->source = source;
+        slot->data.assign(buffer, buffer + size);
+        slot->sequence.store(pos + 1, std::memory_order_release);
+
+        if (m_waiting.load())
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_cv.notify_one();
+        }
+        return true;
+    }
+
+    int pop(uint8_t *buffer, size_t bufferSize, int timeoutMs, InetAddress &outSource)
+    {
+        if (!isReadable())
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_waiting.store(true);
+            m_cv.wait_for(lock, std::chrono::milliseconds(timeoutMs), [this]() { return isReadable(); });
+            m_waiting.store(false);
+
+            if (!isReadable())
+                return 0;
+        }
+
+        auto &slot = m_slots[m_tail & (m_capacity - 1)];
+        size_t size = std::min(bufferSize, slot.data.size());
+        std::memcpy(buffer, slot.data.data(), size);
+        outSource = slot.source;
+
+        slot.sequence.store(m_tail + m_capacity, std::memory_order_release);
+        m_tail++;
+        return static_cast<int>(size);
+    }
+
+  private:
+    bool isReadable() const
+    {
+        return m_slots[m_tail & (m_capacity - 1)].sequence.load(std::memory_order_acquire) == m_tail + 1;
+    }
+};
+
+/* Registered in-memory end-points of this process, by address */
+static std::shared_mutex g_endpointsMutex{};
+static std::unordered_map<std::string, std::shared_ptr<MemoryEndpoint>> g_endpoints{};
+static std::atomic<uint16_t> g_ephemeralPort{EPHEMERAL_PORT_BASE};
+
+std::unique_ptr<RlsTransport> RlsTransport::Create(ELinkTransport type)
+{
+    switch (type)
+    {
+    case ELinkTransport::MEMORY:
+        return std::make_unique<MemoryTransport>();
+    case ELinkTransport::SHARED_MEMORY:
+        return std::make_unique<ShmTransport>();
+    default:
+        return std::make_unique<UdpTransport>();
+    }
+}
+
+std::unique_ptr<RlsTransport> RlsTransport::Create(ELinkTransport type, const std::string &address, uint16_t port)
+{
+    switch (type)
+    {
+    case ELinkTransport::MEMORY:
+        return std::make_unique<MemoryTransport>(address, port);
+    case ELinkTransport::SHARED_MEMORY:
+        return std::make_unique<ShmTransport>(address, port);
+    default:
+        return std::make_unique<UdpTransport>(address, port);
+    }
+}
+
+void RlsTransport::setLinkQuality(uint64_t, int)
+{
+}
+
+UdpTransport::UdpTransport() : m_server{}
+{
+}
+
+UdpTransport::UdpTransport(const std::string &address, uint16_t port) : m_server{address, port}
+{
+}
+
+int UdpTransport::receive(uint8_t *buffer, size_t bufferSize, int timeoutMs, InetAddress &outPeerAddress)
+{
+    return m_server.Receive(buffer, bufferSize, timeoutMs, outPeerAddress);
+}
+
+void UdpTransport::send(const InetAddress &address, const uint8_t *buffer, size_t bufferSize)
+{
+    m_server.Send(address, buffer, bufferSize);
+}
+
+void UdpTransport::sendBatch(const std::vector<InetAddress> &addresses, const uint8_t *buffer, size_t bufferSize)
+{
+    m_server.SendBatch(addresses, buffer, bufferSize);
+}
+
+uint16_t UdpTransport::localPort(int ipVersion) const
+{
+    return m_server.GetLocalPort(ipVersion);
+}
+
+MemoryTransport::MemoryTransport() : MemoryTransport("127.0.0.1", g_ephemeralPort++)
+{
+}
+
+MemoryTransport::MemoryTransport(const std::string &address, uint16_t port)
+    : m_address{address, port}, m_endpoint{std::make_shared<MemoryEndpoint>(RING_CAPACITY)}
+{
+    std::unique_lock<std::shared_mutex> lock(g_endpointsMutex);
+
+    auto key = AddressKey(m_address);
+    if (g_endpoints.count(key))
+        throw LibError("In-memory link address already in use: " + address + ":" + std::to_string(port));
+    g_endpoints[key] = m_endpoint;
+}
+
+MemoryTransport::~MemoryTransport()
+{
+    std::unique_lock<std::shared_mutex> lock(g_endpointsMutex);
+    g_endpoints.erase(AddressKey(m_address));
+}
+
+int MemoryTransport::receive(uint8_t *buffer, size_t bufferSize, int timeoutMs, InetAddress &outPeerAddress)
+{
+    return m_endpoint->pop(buffer, bufferSize, timeoutMs, outPeerAddress);
+}
+
+void MemoryTransport::send(const InetAddress &address, const uint8_t *buffer, size_t bufferSize)
+{
+    std::shared_ptr<MemoryEndpoint> target;
+    {
+        std::shared_lock<std::shared_mutex> lock(g_endpointsMutex);
+        auto it = g_endpoints.find(AddressKey(address));
+        if (it == g_endpoints.end())
+            return; // nobody listening, the datagram is lost as it would be over UDP
+        target = it->second;
+    }
+
+    target->push(m_address, buffer, bufferSize);
+}
+
+void MemoryTransport::sendBatch(const std::vector<InetAddress> &addresses, const uint8_t *buffer, size_t bufferSize)
+{
+    std::vector<std::shared_ptr<MemoryEndpoint>> targets{};
+    targets.reserve(addresses.size());
+    {
+        std::shared_lock<std::shared_mutex> lock(g_endpointsMutex);
+        for (auto &address : addresses)
+        {
+            auto it = g_endpoints.find(AddressKey(address));
+            if (it != g_endpoints.end())
+                targets.push_back(it->second);
+        }
+    }
+
+    for (auto &target : targets)
+        target->push(m_address, buffer, bufferSize);
+}
+
+uint16_t MemoryTransport::localPort(int ipVersion) const
+{
+    return ipVersion == m_address.getIpVersion() ? m_address.getPort() : 0;
+}
+
+SharedUdpEndpoint::SharedUdpEndpoint() : m_server{}, m_mutex{}, m_inboxes{}, m_buffer(SHARED_BUFFER_SIZE)
+{
+}
+
+std::unique_ptr<RlsTransport> SharedUdpEndpoint::attach(uint64_t sti)
+{
+    auto inbox = std::make_shared<MemoryEndpoint>(SHARED_INBOX_CAPACITY);
+    {
+        std::unique_lock<std::shared_mutex> lock(m_mutex);
+        m_inboxes[sti] = inbox;
+    }
+    return std::make_unique<SharedUdpTransport>(this, sti, std::move(inbox));
+}
+
+void SharedUdpEndpoint::detach(uint64_t sti)
+{
+    std::unique_lock<std::shared_mutex> lock(m_mutex);
+    m_inboxes.erase(sti);
+}
+
+void SharedUdpEndpoint::serve(int timeoutMs)
+{
+    InetAddress peerAddress;
+    int size = m_server.Receive(m_buffer.data(), m_buffer.size(), timeoutMs, peerAddress);
+    if (size <= 0)
+        return;
+
+    // Broadcasts and datagrams that cannot be decoded have no destination block
+    auto destination = PeekRlsDestination(m_buffer.data(), static_cast<size_t>(size));
+
+    std::shared_lock<std::shared_mutex> lock(m_mutex);
+    if (destination)
+    {
+        auto it = m_inboxes.find(*destination);
+        if (it != m_inboxes.end())
+            it->second->push(peerAddress, m_buffer.data(), static_cast<size_t>(size));
+        return;
+    }
+
+    for (auto &item : m_inboxes)
+        item.second->push(peerAddress, m_buffer.data(), static_cast<size_t>(size));
+}
+
+const udp::UdpServer &SharedUdpEndpoint::server() const
+{
+    return m_server;
+}
+
+SharedUdpTransport::SharedUdpTransport(SharedUdpEndpoint *owner, uint64_t sti, std::shared_ptr<MemoryEndpoint> inbox)
+    : m_owner{owner}, m_sti{sti}, m_inbox{std::move(inbox)}
+{
+}
+
+SharedUdpTransport::~SharedUdpTransport()
+{
+    m_owner->detach(m_sti);
+}
+
+int SharedUdpTransport::receive(uint8_t *buffer, size_t bufferSize, int timeoutMs, InetAddress &outPeerAddress)
+{
+    return m_inbox->pop(buffer, bufferSize, timeoutMs, outPeerAddress);
+}
+
+void SharedUdpTransport::send(const InetAddress &address, const uint8_t *buffer, size_t bufferSize)
+{
+    m_owner->server().Send(address, buffer, bufferSize);
+}
+
+void SharedUdpTransport::sendBatch(const std::vector<InetAddress> &addresses, const uint8_t *buffer,
+                                   size_t bufferSize)
+{
+    m_owner->server().SendBatch(addresses, buffer, bufferSize);
+}
+
+uint16_t SharedUdpTransport::localPort(int ipVersion) const
+{
+    return m_owner->server().GetLocalPort(ipVersion);
+}
+
+} // namespace rls
@@ -0,0 +1,141 @@
+//
+// This file is a part of UERANSIM project.
+// Copyright (c) 2023 ALİ GÜNGÖR.
+//
+// https://github.com/aligungr/UERANSIM/
+// See README, LICENSE, and CONTRIBUTING files for licensing details.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <lib/udp/server.hpp>
+#include <utils/network.hpp>
+
+namespace rls
+{
+
+enum class ELinkTransport
+{
+    UDP,
+    MEMORY,        // process-local rings, every node of the link runs in this process
+    SHARED_MEMORY, // shared memory rings to processes of the same host, UDP to the others
+};
+
+/*
+ * Datagram transport carrying encoded RLS messages between a UE and its cells.
+ *
+ * An end-point is received from by a single thread, but send and sendBatch must be safe to call from any number of
+ * threads at the same time as each other and as receive, since the user plane fast path of the UE sends from the TUN
+ * threads concurrently with the RLS task.
+ */
+class RlsTransport
+{
+  public:
+    virtual ~RlsTransport() = default;
+
+    virtual int receive(uint8_t *buffer, size_t bufferSize, int timeoutMs, InetAddress &outPeerAddress) = 0;
+    virtual void send(const InetAddress &address, const uint8_t *buffer, size_t bufferSize) = 0;
+    /* Sends the same datagram to all the given addresses */
+    virtual void sendBatch(const std::vector<InetAddress> &addresses, const uint8_t *buffer, size_t bufferSize) = 0;
+    /*
+     * Simulated signal strength of the link to the peer of the given STI, used by transports that emulate the radio
+     * channel. Links are told apart by STI since the UEs of a process may share a single address.
+     */
+    virtual void setLinkQuality(uint64_t sti, int dbm);
+    /* Local port of the end-point for the IP version, 0 if it is not bound yet */
+    [[nodiscard]] virtual uint16_t localPort(int ipVersion) const = 0;
+
+  public:
+    /* Unbound end-point, used by the UE side */
+    static std::unique_ptr<RlsTransport> Create(ELinkTransport type);
+    /* End-point bound to the given address, used by the cell side */
+    static std::unique_ptr<RlsTransport> Create(ELinkTransport type, const std::string &address, uint16_t port);
+};
+
+class UdpTransport : public RlsTransport
+{
+  private:
+    udp::UdpServer m_server;
+
+  public:
+    UdpTransport();
+    UdpTransport(const std::string &address, uint16_t port);
+
+    int receive(uint8_t *buffer, size_t bufferSize, int timeoutMs, InetAddress &outPeerAddress) override;
+    void send(const InetAddress &address, const uint8_t *buffer, size_t bufferSize) override;
+    void sendBatch(const std::vector<InetAddress> &addresses, const uint8_t *buffer, size_t bufferSize) override;
+    [[nodiscard]] uint16_t localPort(int ipVersion) const override;
+};
+
+class MemoryEndpoint;
+
+/* Process-local transport, datagrams are handed over through a lock-free ring per end-point */
+class MemoryTransport : public RlsTransport
+{
+  private:
+    InetAddress m_address;
+    std::shared_ptr<MemoryEndpoint> m_endpoint;
+
+  public:
+    MemoryTransport();
+    MemoryTransport(const std::string &address, uint16_t port);
+    ~MemoryTransport() override;
+
+    int receive(uint8_t *buffer, size_t bufferSize, int timeoutMs, InetAddress &outPeerAddress) override;
+    void send(const InetAddress &address, const uint8_t *buffer, size_t bufferSize) override;
+    void sendBatch(const std::vector<InetAddress> &addresses, const uint8_t *buffer, size_t bufferSize) override;
+    [[nodiscard]] uint16_t localPort(int ipVersion) const override;
+};
+
+class SharedUdpEndpoint;
+
+/* Transport of a UE over the socket it shares with the other UEs of the process */
+class SharedUdpTransport : public RlsTransport
+{
+  private:
+    SharedUdpEndpoint *m_owner;
+    uint64_t m_sti;
+    std::shared_ptr<MemoryEndpoint> m_inbox; // datagrams of the cells meant for the UE
+
+  public:
+    SharedUdpTransport(SharedUdpEndpoint *owner, uint64_t sti, std::shared_ptr<MemoryEndpoint> inbox);
+    ~SharedUdpTransport() override;
+
+    int receive(uint8_t *buffer, size_t bufferSize, int timeoutMs, InetAddress &outPeerAddress) override;
+    void send(const InetAddress &address, const uint8_t *buffer, size_t bufferSize) override;
+    void sendBatch(const std::vector<InetAddress> &addresses, const uint8_t *buffer, size_t bufferSize) override;
+    [[nodiscard]] uint16_t localPort(int ipVersion) const override;
+};
+
+/*
+ * UDP socket shared by all UEs of a process, so that neither the sockets nor their kernel buffers grow with the number
+ * of UEs. The cells append the STI of the destination UE to unicast messages, and the datagrams are handed to the
+ * inbox of that UE in O(1). Broadcasts and messages of older cells, which carry no destination, go to every UE.
+ */
+class SharedUdpEndpoint
+{
+  private:
+    udp::UdpServer m_server;
+    std::shared_mutex m_mutex;
+    std::unordered_map<uint64_t, std::shared_ptr<MemoryEndpoint>> m_inboxes; // by STI of the UE
+    std::vector<uint8_t> m_buffer;
+
+  public:
+    SharedUdpEndpoint();
+
+    /* Transport of the UE with the given STI, the UE is detached when it is destroyed */
+    std::unique_ptr<RlsTransport> attach(uint64_t sti);
+    void detach(uint64_t sti);
+    /* Receives a datagram and hands it to its UEs, called by the single thread serving the end-point */
+    void serve(int timeoutMs);
+    [[nodiscard]] const udp::UdpServer &server() const;
+};
+
+} // namespace rls
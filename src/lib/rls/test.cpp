@@ -0,0 +1,177 @@
+//
+// This file is a part of UERANSIM project.
+// Copyright (c) 2023 ALİ GÜNGÖR.
+//
+// https://github.com/aligungr/UERANSIM/
+// See README, LICENSE, and CONTRIBUTING files for licensing details.
+//
+
+#include "test.hpp"
+#include "rls_ack.hpp"
+#include "rls_channel.hpp"
+#include "rls_pdu.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+#include <utils/common.hpp>
+
+// Checks of the reliable delivery of RLS PDUs between a pair of ack trackers over a simulated link. Lost PDUs are
+// chosen up front and retransmissions go through, so every run makes the same decisions.
+
+static constexpr int PEER = 1;
+static constexpr int TTL = 60000;     // ms, long enough that nothing is given up on
+static constexpr int ROUND = 1001;    // ms of each retransmission round, beyond the maximum RTO
+static constexpr int MAX_ROUNDS = 64;
+
+// Checks of the downlink channel emulation of a UE, a cell sends user PDUs over in-memory links to a UE whose
+// transport is wrapped as nr-ue wraps it. Links weaker than CHANNEL_STRONG_DBM lose and delay datagrams.
+
+static constexpr uint64_t CELL_STI = 0x1234;
+static constexpr uint16_t CELL_PORT = 4997;
+static constexpr int CHANNEL_STRONG_DBM = -80;
+static constexpr double CHANNEL_LOSS = 0.3;
+static constexpr int CHANNEL_DELAY = 20; // ms
+static constexpr int CHANNEL_PDU_SIZE = 100;
+static constexpr int CHANNEL_SETTLE = 500; // ms waited for late datagrams
+
+namespace rls
+{
+
+struct ArqEnd
+{
+    AckTracker tracker{};
+    std::vector<int> deliveries{}; // by sequence number
+};
+
+static void Deliver(ArqEnd &sender, ArqEnd &receiver, uint32_t seq)
+{
+    if (receiver.tracker.receive(PEER, seq))
+        receiver.deliveries[seq]++;
+
+    // The receiver acks right away, as it does for RRC
+    auto ack = receiver.tracker.takeAck(PEER);
+    if (ack)
+        sender.tracker.acknowledge(PEER, *ack);
+}
+
+static void RunScenario(const char *name, int count, const std::vector<uint32_t> &lost)
+{
+    ArqEnd sender{}, receiver{};
+    receiver.deliveries.resize(static_cast<size_t>(count) + 1);
+
+    int64_t now = utils::CurrentTimeMillis();
+    for (int i = 0; i < count; i++)
+    {
+        PduInfo info{};
+        info.sentTime = now;
+        uint32_t seq = sender.tracker.track(PEER, std::move(info));
+
+        bool isLost = false;
+        for (auto item : lost)
+            isLost |= item == seq;
+        if (!isLost)
+            Deliver(sender, receiver, seq);
+    }
+
+    int rounds = 0, retransmitted = 0;
+    for (; rounds < MAX_ROUNDS && sender.tracker.unackedCount() > 0; rounds++)
+    {
+        now += ROUND;
+
+        std::vector<RlsRetransmission> retransmissions;
+        std::vector<PduInfo> failures;
+        sender.tracker.poll(now, TTL, retransmissions, failures);
+        for (auto &item : retransmissions)
+        {
+            retransmitted++;
+            Deliver(sender, receiver, item.seq);
+        }
+    }
+
+    int delivered = 0, duplicates = 0;
+    for (int seq = 1; seq <= count; seq++)
+    {
+        delivered += receiver.deliveries[seq] != 0 ? 1 : 0;
+        duplicates += receiver.deliveries[seq] > 1 ? receiver.deliveries[seq] - 1 : 0;
+    }
+
+    bool passed = delivered == count && duplicates == 0 && sender.tracker.unackedCount() == 0;
+    printf("%-40s  delivered %4d/%d  duplicates %3d  retransmitted %4d  rounds %3d  %s\n", name, delivered, count,
+           duplicates, retransmitted, rounds, passed ? "OK" : "FAILED");
+    fflush(stdout);
+}
+
+static void RunChannelScenario(const char *name, int dbm, int count)
+{
+    ChannelProfile strong{};
+    strong.minDbm = CHANNEL_STRONG_DBM;
+    ChannelProfile weak{};
+    weak.minDbm = -120;
+    weak.loss = CHANNEL_LOSS;
+    weak.delay = CHANNEL_DELAY;
+
+    ChannelConfig config{};
+    config.seed = 1;
+    config.bands = {strong, weak};
+
+    MemoryTransport cell{"127.0.0.1", CELL_PORT};
+    ChannelTransport ue{std::make_unique<MemoryTransport>(), config, 0};
+    ue.setLinkQuality(CELL_STI, dbm);
+    InetAddress ueAddress{"127.0.0.1", ue.localPort(4)};
+
+    std::vector<uint8_t> frame(PDU_TRANSMISSION_HEADER_SIZE + CHANNEL_PDU_SIZE);
+    int64_t start = utils::CurrentTimeMillis();
+    for (int i = 0; i < count; i++)
+    {
+        EncodeRlsPduTransmissionHeader(CELL_STI, EPduType::DATA, 0, static_cast<uint32_t>(i), CHANNEL_PDU_SIZE,
+                                       frame.data());
+        cell.send(ueAddress, frame.data(), frame.size());
+    }
+
+    int received = 0;
+    int64_t minLatency = INT64_MAX, maxLatency = 0;
+    std::vector<uint8_t> buffer(frame.size());
+    while (received < count && utils::CurrentTimeMillis() - start < CHANNEL_DELAY + CHANNEL_SETTLE)
+    {
+        InetAddress source{};
+        if (ue.receive(buffer.data(), buffer.size(), 10, source) <= 0)
+            continue;
+
+        int64_t latency = utils::CurrentTimeMillis() - start;
+        minLatency = std::min(minLatency, latency);
+        maxLatency = std::max(maxLatency, latency);
+        received++;
+    }
+
+    bool impaired = dbm < CHANNEL_STRONG_DBM;
+    bool passed = impaired ? received < count && received >= count * (1 - 2 * CHANNEL_LOSS) &&
+                                 minLatency >= CHANNEL_DELAY
+                           : received == count && maxLatency < CHANNEL_DELAY;
+    printf("%-40s  received %4d/%d  latency %3lld..%3lld ms  %s\n", name, received, count,
+           static_cast<long long>(received != 0 ? minLatency : 0), static_cast<long long>(maxLatency),
+           passed ? "OK" : "FAILED");
+    fflush(stdout);
+}
+
+void rlsTestMain()
+{
+    printf("RLS ARQ checks: SACK bitmap of %d PDUs, send window of %u PDUs\n", ACK_BITMAP_SIZE, ARQ_WINDOW_SIZE);
+
+    // The PDUs after the gap beyond the bitmap come back as retransmissions and must not be delivered twice
+    RunScenario("no loss", 100, {});
+    RunScenario("first PDU lost, 40 after it", 41, {1});
+    RunScenario("first PDU lost, full window after it", static_cast<int>(ARQ_WINDOW_SIZE), {1});
+    RunScenario("gaps inside and beyond the bitmap", 200, {5, 6, 20, 90, 91, 150});
+
+    printf("RLS downlink channel checks: %.0f%% loss and %d ms delay below %d dBm\n", CHANNEL_LOSS * 100,
+           CHANNEL_DELAY, CHANNEL_STRONG_DBM);
+
+    RunChannelScenario("strong downlink", -60, 200);
+    RunChannelScenario("weak downlink", -100, 200);
+}
+
+} // namespace rls
@@ -8,12 +8,25 @@
 
 #include "server.hpp"
 
+#include <algorithm>
 #include <cstring>
 #include <utils/common.hpp>
 
 namespace udp
 {
 
+static bool CompareAddress(const InetAddress *a, const InetAddress *b)
+{
+    if (a->getSockLen() != b->getSockLen())
+        return a->getSockLen() < b->getSockLen();
+    return std::memcmp(a->getSockAddr(), b->getSockAddr(), a->getSockLen()) < 0;
+}
+
+static bool IsSameAddress(const InetAddress *a, const InetAddress *b)
+{
+    return a->getSockLen() == b->getSockLen() && std::memcmp(a->getSockAddr(), b->getSockAddr(), a->getSockLen()) == 0;
+}
+
 UdpServer::UdpServer() : sockets{Socket::CreateUdp4(), Socket::CreateUdp6()}
 {
 }
@@ -48,6 +61,45 @@ void UdpServer::Send(const InetAddress &address, const uint8_t *buffer, size_t b
     throw std::runtime_error{"UdpServer::Send failure: No IP socket found"};
 }
 
+void UdpServer::SendBatch(const std::vector<InetAddress> &addresses, const uint8_t *buffer, size_t bufferSize) const
+{
+    for (const Socket &s : sockets)
+    {
+        if (!s.hasFd())
+            continue;
+
+        std::vector<const InetAddress *> targets{};
+        targets.reserve(addresses.size());
+        for (auto &address : addresses)
+            if (address.getIpVersion() == s.getIpVersion())
+                targets.push_back(&address);
+
+        // End-points shared by several UEs get a single copy
+        std::sort(targets.begin(), targets.end(), CompareAddress);
+        targets.erase(std::unique(targets.begin(), targets.end(), IsSameAddress), targets.end());
+
+        if (!targets.empty())
+            s.sendBatch(targets, buffer, bufferSize);
+    }
+}
+
+uint16_t UdpServer::GetLocalPort(int ipVersion) const
+{
+    for (const Socket &s : sockets)
+        if (s.hasFd() && s.getIpVersion() == ipVersion)
+            return s.getAddress().getPort();
+    return 0;
+}
+
+std::vector<int> UdpServer::GetFileDescriptors() const
+{
+    std::vector<int> fds{};
+    for (const Socket &s : sockets)
+        if (s.hasFd())
+            fds.push_back(s.getFd());
+    return fds;
+}
+
 UdpServer::~UdpServer()
 {
     for (auto &s : sockets)
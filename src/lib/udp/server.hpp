@@ -26,6 +26,10 @@ class UdpServer
 
     int Receive(uint8_t *buffer, size_t bufferSize, int timeoutMs, InetAddress &outPeerAddress) const;
     void Send(const InetAddress &address, const uint8_t *buffer, size_t bufferSize) const;
+    void SendBatch(const std::vector<InetAddress> &addresses, const uint8_t *buffer, size_t bufferSize) const;
+    /* Port of the socket of the IP version, 0 if there is none or it is not bound yet */
+    uint16_t GetLocalPort(int ipVersion) const;
+    std::vector<int> GetFileDescriptors() const;
 };
 
 } // namespace udp
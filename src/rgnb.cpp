@@ -6,12 +6,16 @@
 // See README, LICENSE, and CONTRIBUTING files for licensing details.
 //
 
+#include <algorithm>
 #include <chrono>
 #include <iostream>
 #include <stdexcept>
 #include <unordered_map>
 #include <thread>
+#include <utility>
+#include <vector>
 
+#include <arpa/inet.h>
 #include <unistd.h>
 
 #include <rgnb/rgnb.hpp>
@@ -32,6 +36,7 @@
 // use two config files, one for the GNB part, one for the UE part
 static nr::rgnb::RGnbGnbConfig *gnb_refConfig = nullptr;
 static nr::rgnb::RGnbUeConfig *ue_refConfig = nullptr;
+static std::vector<std::pair<nr::rgnb::RGnbGnbConfig *, nr::rgnb::RGnbUeConfig *>> g_nodeConfigs{};
 static ConcurrentMap<std::string, nr::rgnb::RGNodeB *> g_rgnbMap{}; // TODO: The gnb uses an unordered map while the ue file uses a concurrent map
 //static app::CliResponseTask *g_cliRespTask = nullptr;
 
@@ -39,6 +44,7 @@ static struct Options
 {
     std::string ueConfigFile{};
     std::string gnbConfigFile{};
+    std::string topologyFile{};
     bool noRoutingConfigs{}; // copied from ue.cpp
     bool disableCmd{};
     std::string imsi{}; // copied from ue.cpp
@@ -108,10 +114,146 @@ class UeControllerTask : public NtsTask // copied from ue.cp
 
 static UeControllerTask *g_controllerTask; // copied from ue.cp
 
-static nr::rgnb::RGnbGnbConfig *ReadGnbConfigYaml()
+static rls::ELinkTransport ReadLinkTransport(const YAML::Node &config, const std::string &name, bool allowMemory)
+{
+    std::string transport = yaml::GetString(config, name);
+    if (transport == "udp")
+        return rls::ELinkTransport::UDP;
+    if (transport == "shm")
+        return rls::ELinkTransport::SHARED_MEMORY;
+    if (transport == "memory" && allowMemory)
+        return rls::ELinkTransport::MEMORY;
+    throw std::runtime_error("Invalid " + name + ": " + transport);
+}
+
+static rls::ChannelProfile ReadChannelProfile(const YAML::Node &band)
+{
+    rls::ChannelProfile p{};
+    if (yaml::HasField(band, "minDbm"))
+        p.minDbm = yaml::GetInt32(band, "minDbm", -120, 0);
+    if (yaml::HasField(band, "loss"))
+        p.loss = yaml::GetDouble(band, "loss", 0.0, 1.0);
+    if (yaml::HasField(band, "burst"))
+    {
+        auto burst = band["burst"];
+        p.burstEnter = yaml::GetDouble(burst, "enter", 0.0, 1.0);
+        p.burstExit = yaml::GetDouble(burst, "exit", 0.0, 1.0);
+        if (yaml::HasField(burst, "loss"))
+            p.burstLoss = yaml::GetDouble(burst, "loss", 0.0, 1.0);
+    }
+    if (yaml::HasField(band, "delay"))
+        p.delay = yaml::GetInt32(band, "delay", 0, 10000);
+    if (yaml::HasField(band, "jitter"))
+        p.jitter = yaml::GetInt32(band, "jitter", 0, 10000);
+    if (yaml::HasField(band, "reorder"))
+        p.reorder = yaml::GetDouble(band, "reorder", 0.0, 1.0);
+    if (yaml::HasField(band, "reorderDelay"))
+        p.reorderDelay = yaml::GetInt32(band, "reorderDelay", 1, 10000);
+    if (yaml::HasField(band, "rate"))
+        p.rate = yaml::GetInt32(band, "rate", 0, std::nullopt);
+    if (yaml::HasField(band, "bucket"))
+        p.burst = yaml::GetInt32(band, "bucket", 0, std::nullopt);
+    if (yaml::HasField(band, "queue"))
+        p.queue = yaml::GetInt32(band, "queue", 0, 10000);
+    return p;
+}
+
+static rls::RlcConfig ReadRlcConfig(const YAML::Node &rlc)
+{
+    rls::RlcConfig c{};
+    if (yaml::HasField(rlc, "mode"))
+    {
+        auto mode = yaml::GetString(rlc, "mode");
+        if (mode != "am" && mode != "um")
+            throw std::runtime_error("Invalid RLC mode: " + mode);
+        c.acknowledged = mode == "am";
+    }
+    if (yaml::HasField(rlc, "snLength"))
+        c.snLength = yaml::GetInt32(rlc, "snLength", 6, 18);
+    if (c.acknowledged ? c.snLength != 12 && c.snLength != 18 : c.snLength != 6 && c.snLength != 12)
+        throw std::runtime_error("Invalid RLC SN length: " + std::to_string(c.snLength));
+    if (yaml::HasField(rlc, "slot"))
+        c.slot = yaml::GetInt32(rlc, "slot", 1, 100);
+    if (yaml::HasField(rlc, "opportunities"))
+        c.opportunities = yaml::GetInt32(rlc, "opportunities", 1, 1024);
+    if (yaml::HasField(rlc, "opportunitySize"))
+        c.opportunitySize = yaml::GetInt32(rlc, "opportunitySize", 16, 65000);
+    if (yaml::HasField(rlc, "bufferSize"))
+        c.bufferSize = yaml::GetInt32(rlc, "bufferSize", 1024, std::nullopt);
+    if (yaml::HasField(rlc, "maxRetx"))
+        c.maxRetx = yaml::GetInt32(rlc, "maxRetx", 1, 32);
+    if (yaml::HasField(rlc, "pollPdu"))
+        c.pollPdu = yaml::GetInt32(rlc, "pollPdu", -1, std::nullopt);
+    if (yaml::HasField(rlc, "pollByte"))
+        c.pollByte = yaml::GetInt32(rlc, "pollByte", -1, std::nullopt);
+    if (yaml::HasField(rlc, "pollRetransmit"))
+        c.pollRetransmit = yaml::GetInt32(rlc, "pollRetransmit", 1, 10000);
+    if (yaml::HasField(rlc, "reassembly"))
+        c.reassembly = yaml::GetInt32(rlc, "reassembly", 1, 10000);
+    if (yaml::HasField(rlc, "statusProhibit"))
+        c.statusProhibit = yaml::GetInt32(rlc, "statusProhibit", 0, 10000);
+    return c;
+}
+
+static rls::PdcpConfig ReadPdcpConfig(const YAML::Node &pdcp)
+{
+    rls::PdcpConfig c{};
+    if (yaml::HasField(pdcp, "snLength"))
+        c.snLength = yaml::GetInt32(pdcp, "snLength", 12, 18);
+    if (c.snLength != 12 && c.snLength != 18)
+        throw std::runtime_error("Invalid PDCP SN length: " + std::to_string(c.snLength));
+    if (yaml::HasField(pdcp, "ciphering"))
+        c.ciphering = yaml::GetInt32(pdcp, "ciphering", 0, 3);
+    if (yaml::HasField(pdcp, "integrity"))
+        c.integrity = yaml::GetInt32(pdcp, "integrity", 0, 3);
+    if (yaml::HasField(pdcp, "reordering"))
+        c.reordering = yaml::GetInt32(pdcp, "reordering", 0, 10000);
+    // A default key would protect the PDUs with a key anyone knows, while the algorithms look enabled
+    if (c.ciphering != 0 || c.integrity != 0)
+        c.key = OctetString::FromHex(yaml::GetString(pdcp, "key", 64, 64));
+    return c;
+}
+
+static nr::rgnb::MacConfig ReadMacConfig(const YAML::Node &mac)
+{
+    nr::rgnb::MacConfig c{};
+    if (yaml::HasField(mac, "policy"))
+    {
+        auto policy = yaml::GetString(mac, "policy");
+        if (policy == "roundRobin")
+            c.policy = nr::rgnb::EMacPolicy::ROUND_ROBIN;
+        else if (policy == "proportionalFair")
+            c.policy = nr::rgnb::EMacPolicy::PROPORTIONAL_FAIR;
+        else if (policy == "maxCi")
+            c.policy = nr::rgnb::EMacPolicy::MAX_CI;
+        else
+            throw std::runtime_error("Invalid MAC scheduling policy: " + policy);
+    }
+    if (yaml::HasField(mac, "numerology"))
+        c.numerology = yaml::GetInt32(mac, "numerology", 0, 4);
+    if (yaml::HasField(mac, "slotDuration"))
+        c.slotDuration = yaml::GetInt32(mac, "slotDuration", 1, 100000);
+    if (yaml::HasField(mac, "prbs"))
+        c.prbs = yaml::GetInt32(mac, "prbs", 1, 275);
+    if (yaml::HasField(mac, "bler"))
+        c.bler = yaml::GetDouble(mac, "bler", 0.0, 0.99);
+    if (yaml::HasField(mac, "harqRtt"))
+        c.harqRtt = yaml::GetInt32(mac, "harqRtt", 1, 100);
+    if (yaml::HasField(mac, "harqMaxTx"))
+        c.harqMaxTx = yaml::GetInt32(mac, "harqMaxTx", 1, 32);
+    if (yaml::HasField(mac, "queueSize"))
+        c.queueSize = yaml::GetInt32(mac, "queueSize", 1024, std::nullopt);
+    if (yaml::HasField(mac, "pfWindow"))
+        c.pfWindow = yaml::GetInt32(mac, "pfWindow", 1, 100000);
+    if (yaml::HasField(mac, "seed"))
+        c.seed = static_cast<uint64_t>(yaml::GetInt64(mac, "seed", 0, std::nullopt));
+    return c;
+}
+
+static nr::rgnb::RGnbGnbConfig *ReadGnbConfigYaml(const std::string &file)
 {
     auto *result = new nr::rgnb::RGnbGnbConfig();
-    auto config = YAML::LoadFile(g_options.gnbConfigFile);
+    auto config = YAML::LoadFile(file);
 
     result->plmn.mcc = yaml::GetInt32(config, "mcc", 1, 999);
     yaml::GetString(config, "mcc", 3, 3);
@@ -130,6 +272,113 @@ static nr::rgnb::RGnbGnbConfig *ReadGnbConfigYaml()
         result->gtpAdvertiseIp = yaml::GetIpAddress(config, "gtpAdvertiseIp");
 
     result->ignoreStreamIds = yaml::GetBool(config, "ignoreStreamIds");
+
+    if (yaml::HasField(config, "bap"))
+    {
+        auto bap = config["bap"];
+        result->bapAddress = yaml::GetInt32(bap, "address", 0, 1023);
+        if (yaml::HasField(bap, "donor"))
+            result->bapDonor = yaml::GetInt32(bap, "donor", 0, 1023);
+        if (yaml::HasField(bap, "routes"))
+        {
+            for (auto &route : yaml::GetSequence(bap, "routes"))
+            {
+                nr::rgnb::BapRouteConfig r{};
+                r.destination = yaml::GetInt32(route, "destination", 0, 1023);
+                r.nextHop = yaml::GetInt32(route, "nextHop", 0, 1023);
+                result->bapRoutes.push_back(r);
+            }
+        }
+    }
+
+    if (yaml::HasField(config, "fusedRls"))
+        result->fusedRls = yaml::GetBool(config, "fusedRls");
+    if (yaml::HasField(config, "linkTransport"))
+        result->linkTransport = ReadLinkTransport(config, "linkTransport", false);
+
+    if (yaml::HasField(config, "localSwitching"))
+    {
+        for (auto &item : yaml::GetSequence(config, "localSwitching"))
+        {
+            auto subnet = item.as<std::string>();
+
+            auto separator = subnet.find('/');
+            in_addr address{};
+            if (separator == std::string::npos || inet_pton(AF_INET, subnet.substr(0, separator).c_str(), &address) != 1)
+                throw std::runtime_error("Invalid local switching subnet: " + subnet);
+
+            // The prefix length is taken as it is written, "/", "/8x" or "/abc" are not read as a prefix of 0
+            auto prefixText = subnet.substr(separator + 1);
+            if (!utils::IsNumeric(prefixText) || prefixText.length() > 2)
+                throw std::runtime_error("Invalid local switching subnet: " + subnet);
+
+            int prefix = utils::ParseInt(prefixText);
+            if (prefix > 32)
+                throw std::runtime_error("Invalid local switching subnet: " + subnet);
+
+            nr::rgnb::Ipv4Subnet s{};
+            s.mask = prefix == 0 ? 0 : ~uint32_t{0} << (32 - prefix);
+            s.address = ntohl(address.s_addr) & s.mask;
+            result->localSwitching.push_back(s);
+        }
+    }
+
+    if (yaml::HasField(config, "backhaul"))
+    {
+        auto backhaul = config["backhaul"];
+        if (yaml::HasField(backhaul, "capacity"))
+            result->backhaul.capacity = yaml::GetInt32(backhaul, "capacity", 1, std::nullopt);
+        if (yaml::HasField(backhaul, "creditBuffer"))
+            result->backhaul.creditBuffer = yaml::GetInt32(backhaul, "creditBuffer", 16384, std::nullopt);
+        if (yaml::HasField(backhaul, "outageBuffer"))
+            result->backhaul.outageBuffer = yaml::GetInt32(backhaul, "outageBuffer", 0, std::nullopt);
+        if (yaml::HasField(backhaul, "outageMaxAge"))
+            result->backhaul.outageMaxAge = yaml::GetInt32(backhaul, "outageMaxAge", 10, 60000);
+        if (yaml::HasField(backhaul, "drainRate"))
+            result->backhaul.drainRate = yaml::GetInt32(backhaul, "drainRate", 1, std::nullopt);
+        if (yaml::HasField(backhaul, "headerCompression"))
+            result->backhaul.headerCompression = yaml::GetBool(backhaul, "headerCompression");
+        if (yaml::HasField(backhaul, "quantum"))
+            result->backhaul.quantum = yaml::GetInt32(backhaul, "quantum", 64, 65535);
+        if (yaml::HasField(backhaul, "weights"))
+        {
+            for (auto &weight : yaml::GetSequence(backhaul, "weights"))
+            {
+                nr::rgnb::BackhaulWeightConfig w{};
+                w.ueId = yaml::GetInt32(weight, "ueId", 1, std::nullopt);
+                w.weight = yaml::GetInt32(weight, "weight", 1, 1000);
+                result->backhaul.weights.push_back(w);
+            }
+        }
+    }
+    if (yaml::HasField(config, "aggregation"))
+    {
+        auto aggregation = config["aggregation"];
+        result->aggregation.mtu = yaml::GetInt32(aggregation, "mtu", 128, 65000);
+        if (yaml::HasField(aggregation, "window"))
+            result->aggregation.window = yaml::GetInt32(aggregation, "window", 1, 100);
+    }
+    if (yaml::HasField(config, "channel"))
+    {
+        auto channel = config["channel"];
+        rls::ChannelConfig c{};
+        if (yaml::HasField(channel, "seed"))
+            c.seed = static_cast<uint64_t>(yaml::GetInt64(channel, "seed", 0, std::nullopt));
+        for (auto &band : yaml::GetSequence(channel, "bands"))
+            c.bands.push_back(ReadChannelProfile(band));
+        if (c.bands.empty())
+            throw std::runtime_error("Channel emulation needs at least one band");
+
+        std::stable_sort(c.bands.begin(), c.bands.end(), [](auto &a, auto &b) { return a.minDbm > b.minDbm; });
+        result->channel = std::move(c);
+    }
+    if (yaml::HasField(config, "rlc"))
+        result->rlc = ReadRlcConfig(config["rlc"]);
+    if (yaml::HasField(config, "pdcp"))
+        result->pdcp = ReadPdcpConfig(config["pdcp"]);
+    if (yaml::HasField(config, "mac"))
+        result->mac = ReadMacConfig(config["mac"]);
+
     result->pagingDrx = EPagingDrx::V128;
     result->name = "UERANSIM-gnb-" + std::to_string(result->plmn.mcc) + "-" + std::to_string(result->plmn.mnc) + "-" +
                    std::to_string(result->getGnbId()); // NOTE: Avoid using "/" dir separator character.
@@ -154,10 +403,10 @@ static nr::rgnb::RGnbGnbConfig *ReadGnbConfigYaml()
     return result;
 }
 
-static nr::rgnb::RGnbUeConfig *ReadUeConfigYaml()
+static nr::rgnb::RGnbUeConfig *ReadUeConfigYaml(const std::string &file)
 {
     auto *result = new nr::rgnb::RGnbUeConfig();
-    auto config = YAML::LoadFile(g_options.ueConfigFile);
+    auto config = YAML::LoadFile(file);
 
     result->hplmn.mcc = yaml::GetInt32(config, "mcc", 1, 999);
     yaml::GetString(config, "mcc", 3, 3);
@@ -216,6 +465,8 @@ static nr::rgnb::RGnbUeConfig *ReadUeConfigYaml()
         result->imeiSv = yaml::GetString(config, "imeiSv", 16, 16);
     if (yaml::HasField(config, "tunName"))
         result->tunName = yaml::GetString(config, "tunName", 1, 12);
+    if (yaml::HasField(config, "linkTransport"))
+        result->linkTransport = ReadLinkTransport(config, "linkTransport", false);
 
     yaml::AssertHasField(config, "integrity");
     yaml::AssertHasField(config, "ciphering");
@@ -303,6 +554,39 @@ static nr::rgnb::RGnbUeConfig *ReadUeConfigYaml()
     return result;
 }
 
+static void ReadTopologyYaml()
+{
+    auto config = YAML::LoadFile(g_options.topologyFile);
+
+    // Node config files are looked up relative to the topology file
+    std::string directory{};
+    auto separator = g_options.topologyFile.find_last_of('/');
+    if (separator != std::string::npos)
+        directory = g_options.topologyFile.substr(0, separator + 1);
+    auto resolve = [&directory](const std::string &path) { return path[0] == '/' ? path : directory + path; };
+
+    auto linkTransport = rls::ELinkTransport::MEMORY;
+    if (yaml::HasField(config, "transport"))
+        linkTransport = ReadLinkTransport(config, "transport", true);
+
+    for (auto &node : yaml::GetSequence(config, "nodes"))
+    {
+        auto *gnbConfig = ReadGnbConfigYaml(resolve(yaml::GetString(node, "gnb", 1, std::nullopt)));
+        auto *ueConfig = ReadUeConfigYaml(resolve(yaml::GetString(node, "ue", 1, std::nullopt)));
+        gnbConfig->linkTransport = linkTransport;
+        ueConfig->linkTransport = linkTransport;
+
+        for (auto &item : g_nodeConfigs)
+            if (item.first->name == gnbConfig->name)
+                throw std::runtime_error("Duplicate node in topology: " + gnbConfig->name);
+
+        g_nodeConfigs.emplace_back(gnbConfig, ueConfig);
+    }
+
+    if (g_nodeConfigs.empty())
+        throw std::runtime_error("Topology has no nodes");
+}
+
 static void ReadOptions(int argc, char **argv)
 {
     opt::OptionsDescription desc{cons::Project,
@@ -310,17 +594,19 @@ static void ReadOptions(int argc, char **argv)
                                  "5G-SA relay gNB implementation",
                                  cons::Owner,
                                  "nr-rgnb",
-                                 {"-gnb <gnb-config-file> -u <ue-config-file> [option...]"},
+                                 {"-g <gnb-config-file> -u <ue-config-file> [option...]", "-t <topology-file>"},
                                  {},
                                  true,
                                  false};
 
     opt::OptionItem itemGnbConfigFile = {'g', "config", "Use specified gNodeB configuration file for relay gNB", "gnb-config-file"};
     opt::OptionItem itemUeConfigFile = {'u', "config", "Use specified UE configuration file for relay gNB", "ue-config-file"};
+    opt::OptionItem itemTopologyFile = {'t', "topology", "Run all relay nodes listed in the topology file in this process", "topology-file"};
 //    opt::OptionItem itemDisableCmd = {'l', "disable-cmd", "Disable command line functionality for this instance", std::nullopt};
 
     desc.items.push_back(itemGnbConfigFile);
     desc.items.push_back(itemUeConfigFile);
+    desc.items.push_back(itemTopologyFile);
 //    desc.items.push_back(itemDisableCmd);
 
     opt::OptionsResult opt{argc, argv, desc, false, nullptr};
@@ -329,11 +615,20 @@ static void ReadOptions(int argc, char **argv)
 //        g_options.disableCmd = true;
     g_options.gnbConfigFile = opt.getOption(itemGnbConfigFile);
     g_options.ueConfigFile = opt.getOption(itemUeConfigFile);
+    g_options.topologyFile = opt.getOption(itemTopologyFile);
 
     try
     {
-        gnb_refConfig = ReadGnbConfigYaml();
-        ue_refConfig = ReadUeConfigYaml();
+        if (!g_options.topologyFile.empty())
+        {
+            ReadTopologyYaml();
+        }
+        else
+        {
+            gnb_refConfig = ReadGnbConfigYaml(g_options.gnbConfigFile);
+            ue_refConfig = ReadUeConfigYaml(g_options.ueConfigFile);
+            g_nodeConfigs.emplace_back(gnb_refConfig, ue_refConfig);
+        }
     }
     catch (const std::runtime_error &e)
     {
@@ -525,9 +820,12 @@ int main(int argc, char **argv)
 //        g_cliRespTask = new app::CliResponseTask(g_cliServer);
 //    }
 
-    auto *rgnb = new nr::rgnb::RGNodeB(gnb_refConfig, ue_refConfig, &g_ueController, nullptr);
-    g_rgnbMap.put(gnb_refConfig->name, rgnb);
-//    g_rgnbMap[gnb_refConfig->name] = rgnb;
+    for (auto &item : g_nodeConfigs)
+    {
+        auto *rgnb = new nr::rgnb::RGNodeB(item.first, item.second, &g_ueController, nullptr);
+        g_rgnbMap.put(item.first->name, rgnb);
+//        g_rgnbMap[gnb_refConfig->name] = rgnb;
+    }
 
 //    if (!g_options.disableCmd)
 //    {
@@ -535,7 +833,7 @@ int main(int argc, char **argv)
 //        g_cliRespTask->start();
 //    }
 
-    rgnb->start();
+    g_rgnbMap.invokeForeach([](const auto &item) { item.second->start(); });
 
     while (true)
         Loop();
@@ -0,0 +1,56 @@
+//
+// This file is a part of UERANSIM project.
+// Copyright (c) 2023 ALİ GÜNGÖR.
+//
+// https://github.com/aligungr/UERANSIM/
+// See README, LICENSE, and CONTRIBUTING files for licensing details.
+//
+
+#include "fused.hpp"
+
+namespace nr::rgnb
+{
+
+void FusableTask::startFused()
+{
+    m_fused = true;
+    onStart();
+}
+
+void FusableTask::quitFused()
+{
+    onQuit();
+}
+
+void FusableTask::deliver(std::unique_ptr<NtsMessage> &&msg)
+{
+    if (m_fused)
+        handleMessage(*msg);
+    else
+        push(std::move(msg));
+}
+
+void FusableTask::runPending()
+{
+    while (auto msg = poll())
+        handleMessage(*msg);
+}
+
+bool FusableTask::isFused() const
+{
+    return m_fused;
+}
+
+void FusableTask::setFused()
+{
+    m_fused = true;
+}
+
+void FusableTask::onLoop()
+{
+    auto msg = take();
+    if (msg)
+        handleMessage(*msg);
+}
+
+} // namespace nr::rgnb
@@ -0,0 +1,48 @@
+//
+// This file is a part of UERANSIM project.
+// Copyright (c) 2023 ALİ GÜNGÖR.
+//
+// https://github.com/aligungr/UERANSIM/
+// See README, LICENSE, and CONTRIBUTING files for licensing details.
+//
+
+#pragma once
+
+#include <memory>
+
+#include <utils/nts.hpp>
+
+namespace nr::rgnb
+{
+
+/*
+ * NTS task that can share a single thread with the other tasks of its stack (fused mode). Messages delivered to a
+ * fused task are handled in place by a direct call instead of crossing a queue and a thread hand-off. A fused task
+ * that is not the owner of the thread is never started; the owner runs its timers and queued messages instead.
+ */
+class FusableTask : public NtsTask
+{
+  private:
+    bool m_fused{};
+
+  public:
+    /* Starts the task without a thread of its own, used for the tasks driven by the owner of the thread */
+    void startFused();
+    void quitFused();
+
+    /* Hands the message over, by a direct call if the task is fused */
+    void deliver(std::unique_ptr<NtsMessage> &&msg);
+    /* Handles the queued messages and the expired timers without blocking */
+    void runPending();
+
+    [[nodiscard]] bool isFused() const;
+
+  protected:
+    /* Used by the owner of the thread, which is started normally */
+    void setFused();
+
+    void onLoop() override;
+    virtual void handleMessage(NtsMessage &msg) = 0;
+};
+
+} // namespace nr::rgnb
@@ -154,6 +154,13 @@ void GnbCmdHandler::handleCmdImpl(NmGnbCliCommand &msg)
         }
         break;
     }
+    case app::GnbCliCommand::MAC_STATS: {
+        if (!m_base->gnbRlsTask->m_mac)
+            sendError(msg.address, "MAC scheduling is not enabled");
+        else
+            sendResult(msg.address, m_base->gnbRlsTask->m_mac->toJson().dumpYaml());
+        break;
+    }
     }
 }
 
@@ -68,12 +68,13 @@ void PduSessionTree::enumerateByUe(int ue, std::vector<uint64_t> &output)
         output.push_back(item.second);
 }
 
-TokenBucket::TokenBucket(int64_t byteCapacity) : byteCapacity(byteCapacity)
+TokenBucket::TokenBucket(int64_t byteCapacity, uint64_t minBucketSize)
+    : byteCapacity(byteCapacity), minBucketSize(minBucketSize)
 {
     if (byteCapacity > 0)
     {
         this->refillTokensPerOneMillis = (double)byteCapacity / (double)REFILL_PERIOD;
-        this->availableTokens = static_cast<double>(byteCapacity);
+        this->availableTokens = static_cast<double>(bucketSize());
         this->lastRefillTimestamp = utils::CurrentTimeMillis();
     }
 }
@@ -109,11 +110,16 @@ void TokenBucket::refill()
     {
         int64_t millisSinceLastRefill = currentTimeMillis - lastRefillTimestamp;
         double refill = static_cast<double>(millisSinceLastRefill) * refillTokensPerOneMillis;
-        availableTokens = std::min(static_cast<double>(byteCapacity), availableTokens + refill);
+        availableTokens = std::min(static_cast<double>(bucketSize()), availableTokens + refill);
         lastRefillTimestamp = currentTimeMillis;
     }
 }
 
+uint64_t TokenBucket::bucketSize() const
+{
+    return std::max(byteCapacity, minBucketSize);
+}
+
 bool RateLimiter::allowDownlinkPacket(uint64_t pduSession, uint64_t packetSize)
 {
     int ueId = GetUeId(pduSession);
@@ -51,18 +51,21 @@ class TokenBucket
     static constexpr const int64_t REFILL_PERIOD = 1000L;
 
     uint64_t byteCapacity;
+    uint64_t minBucketSize;
     double refillTokensPerOneMillis;
     double availableTokens;
     int64_t lastRefillTimestamp;
 
   public:
-    explicit TokenBucket(int64_t byteCapacity);
+    /* Holds a second of capacity, but never less than minBucketSize so that a packet of that size can pass */
+    explicit TokenBucket(int64_t byteCapacity, uint64_t minBucketSize = 0);
 
     bool tryConsume(uint64_t numberOfTokens);
     void updateCapacity(uint64_t newByteCapacity);
 
   private:
     void refill();
+    [[nodiscard]] uint64_t bucketSize() const;
 };
 
 class IRateLimiter
@@ -8,28 +8,48 @@
 
 #include "ctl_task.hpp"
 
+#include <algorithm>
 #include <stdexcept>
+
+#include <lib/rls/rls_bap.hpp>
 #include <utils/common.hpp>
 
-static constexpr const size_t MAX_PDU_COUNT = 4096;
 static constexpr const int MAX_PDU_TTL = 3000;
 
 static constexpr const int TIMER_ID_ACK_CONTROL = 1;
 static constexpr const int TIMER_ID_ACK_SEND = 2;
+static constexpr const int TIMER_ID_AGGREGATION = 3;
+static constexpr const int TIMER_ID_RLC_SLOT = 4;
+static constexpr const int TIMER_ID_PDCP_REORDERING = 5;
 
-static constexpr const int TIMER_PERIOD_ACK_CONTROL = 1500;
-static constexpr const int TIMER_PERIOD_ACK_SEND = 2250;
+static constexpr const int TIMER_PERIOD_ACK_CONTROL = 10; // granularity of the retransmission timers
+static constexpr const int TIMER_PERIOD_ACK_SEND = 20; // delay of acks not sent immediately
+static constexpr const int TIMER_PERIOD_RLC_IDLE = 10; // slot period while no bearer has anything to send
 
 namespace nr::rgnb
 {
 
-RlsControlTask::RlsControlTask(TaskBase *base, uint64_t sti)
-    : m_sti{sti}, m_mainTask{}, m_udpTask{}, m_pduMap{}, m_pendingAck{}
+static const rls::PdcpConfig &PdcpConfigOf(const RGnbGnbConfig &config)
+{
+    static const rls::PdcpConfig defaultConfig{};
+    return config.pdcp ? *config.pdcp : defaultConfig;
+}
+
+RlsControlTask::RlsControlTask(TaskBase *base, uint64_t sti, rls::AckTracker *acks)
+    : m_sti{sti}, m_mainTask{}, m_udpTask{}, m_acks{acks}, m_ackTimerArmed{}, m_arqTimerArmed{},
+      m_compressRelay{base->gnbConfig->backhaul.headerCompression}, m_compressors{}, m_decompressors{},
+      m_aggregator{}, m_aggregationWindow{base->gnbConfig->aggregation.window}, m_aggregationTimerArmed{},
+      m_rlc{sti, base->gnbConfig->rlc.value_or(rls::RlcConfig{})}, m_rlcEnabled{base->gnbConfig->rlc.has_value()},
+      m_rlcSlotTime{}, m_pdcp{false, PdcpConfigOf(*base->gnbConfig)},
+      m_pdcpEnabled{base->gnbConfig->pdcp.has_value()}, m_pdcpReorderTime{}
 {
     m_logger = base->logBase->makeUniqueLogger("rls-ctl");
+
+    if (base->gnbConfig->aggregation.mtu > 0)
+        m_aggregator = std::make_unique<rls::PduAggregator>(sti, base->gnbConfig->aggregation.mtu);
 }
 
-void RlsControlTask::initialize(NtsTask *mainTask, RlsUdpTask *udpTask)
+void RlsControlTask::initialize(FusableTask *mainTask, RlsUdpTask *udpTask)
 {
     m_mainTask = mainTask;
     m_udpTask = udpTask;
@@ -37,20 +57,14 @@ void RlsControlTask::initialize(NtsTask *mainTask, RlsUdpTask *udpTask)
 
 void RlsControlTask::onStart()
 {
-    setTimer(TIMER_ID_ACK_CONTROL, TIMER_PERIOD_ACK_CONTROL);
-    setTimer(TIMER_ID_ACK_SEND, TIMER_PERIOD_ACK_SEND);
 }
 
-void RlsControlTask::onLoop()
+void RlsControlTask::handleMessage(NtsMessage &msg)
 {
-    auto msg = take();
-    if (!msg)
-        return;
-
-    switch (msg->msgType)
+    switch (msg.msgType)
     {
     case NtsMessageType::GNB_RLS_TO_RLS: {
-        auto &w = dynamic_cast<NmGnbRlsToRls &>(*msg);
+        auto &w = dynamic_cast<NmGnbRlsToRls &>(msg);
         switch (w.present)
         {
         case NmGnbRlsToRls::SIGNAL_DETECTED:
@@ -59,6 +73,13 @@ void RlsControlTask::onLoop()
         case NmGnbRlsToRls::SIGNAL_LOST:
             handleSignalLost(w.ueId);
             break;
+        case NmGnbRlsToRls::SIGNAL_QUALITY: {
+            auto m = std::make_unique<NmGnbRlsToRls>(NmGnbRlsToRls::SIGNAL_QUALITY);
+            m->ueId = w.ueId;
+            m->dbm = w.dbm;
+            m_mainTask->deliver(std::move(m));
+            break;
+        }
         case NmGnbRlsToRls::RECEIVE_RLS_MESSAGE:
             handleRlsMessage(w.ueId, *w.msg);
             break;
@@ -68,28 +89,63 @@ void RlsControlTask::onLoop()
         case NmGnbRlsToRls::DOWNLINK_RRC:
             handleDownlinkRrcDelivery(w.ueId, w.pduId, w.rrcChannel, std::move(w.data));
             break;
+        case NmGnbRlsToRls::DOWNLINK_RELAY:
+            handleDownlinkRelayDelivery(w.ueId, w.bapContext, std::move(w.data));
+            break;
+        case NmGnbRlsToRls::DOWNLINK_CREDIT: {
+            rls::RlsCreditGrant grant{m_sti};
+            grant.creditLimit = w.credit;
+            m_udpTask->send(w.ueId, grant);
+            break;
+        }
         default:
-            m_logger->unhandledNts(*msg);
+            m_logger->unhandledNts(msg);
             break;
         }
         break;
     }
     case NtsMessageType::TIMER_EXPIRED: {
-        auto &w = dynamic_cast<NmTimerExpired &>(*msg);
+        auto &w = dynamic_cast<NmTimerExpired &>(msg);
         if (w.timerId == TIMER_ID_ACK_CONTROL)
         {
-            setTimer(TIMER_ID_ACK_CONTROL, TIMER_PERIOD_ACK_CONTROL);
+            m_arqTimerArmed = false;
             onAckControlTimerExpired();
         }
         else if (w.timerId == TIMER_ID_ACK_SEND)
         {
-            setTimer(TIMER_ID_ACK_SEND, TIMER_PERIOD_ACK_SEND);
+            m_ackTimerArmed = false;
             onAckSendTimerExpired();
         }
+        else if (w.timerId == TIMER_ID_AGGREGATION)
+        {
+            m_aggregationTimerArmed = false;
+            flushAggregates(0);
+        }
+        else if (w.timerId == TIMER_ID_RLC_SLOT)
+        {
+            // Timers of superseded slots are left running, they are recognized by their early expiry
+            if (m_rlcSlotTime != 0 && utils::CurrentTimeMillis() >= m_rlcSlotTime)
+            {
+                m_rlcSlotTime = 0;
+                onRlcSlotTimerExpired();
+            }
+        }
+        else if (w.timerId == TIMER_ID_PDCP_REORDERING)
+        {
+            if (m_pdcpReorderTime != 0 && utils::CurrentTimeMillis() >= m_pdcpReorderTime)
+            {
+                m_pdcpReorderTime = 0;
+
+                std::vector<rls::PdcpSdu> sdus;
+                m_pdcp.runTimers(utils::CurrentTimeMillis(), sdus);
+                deliverPdcpSdus(sdus);
+                armPdcpTimer();
+            }
+        }
         break;
     }
     default:
-        m_logger->unhandledNts(*msg);
+        m_logger->unhandledNts(msg);
         break;
     }
 }
@@ -102,14 +158,22 @@ void RlsControlTask::handleSignalDetected(int ueId)
 {
     auto w = std::make_unique<NmGnbRlsToRls>(NmGnbRlsToRls::SIGNAL_DETECTED);
     w->ueId = ueId;
-    m_mainTask->push(std::move(w));
+    m_mainTask->deliver(std::move(w));
 }
 
 void RlsControlTask::handleSignalLost(int ueId)
 {
+    m_compressors.erase(ueId);
+    m_decompressors.erase(ueId);
+    m_acks->removePeer(ueId);
+    m_rlc.remove(ueId);
+    m_pdcp.remove(ueId);
+    if (m_aggregator)
+        m_aggregator->remove(ueId);
+
     auto w = std::make_unique<NmGnbRlsToRls>(NmGnbRlsToRls::SIGNAL_LOST);
     w->ueId = ueId;
-    m_mainTask->push(std::move(w));
+    m_mainTask->deliver(std::move(w));
 }
 
 void RlsControlTask::handleRlsMessage(int ueId, rls::RlsMessage &msg)
@@ -119,14 +183,20 @@ void RlsControlTask::handleRlsMessage(int ueId, rls::RlsMessage &msg)
     {
         auto &m = (rls::RlsPduTransmissionAck &)msg;
         for (auto pduId : m.pduIds)
-            m_pduMap.erase(pduId);
+            m_acks->acknowledge(ueId, pduId);
     }
     // otherwise it should be an actual PDU transmission
     else if (msg.msgType == rls::EMessageType::PDU_TRANSMISSION)
     {
         auto &m = (rls::RlsPduTransmission &)msg; //cast to RlsPduTransmission
-        if (m.pduId != 0)   // if pduId not zero, add to the list of pendings Acks
-            m_pendingAck[ueId].push_back(m.pduId);
+        if (m.pduId != 0)
+        {
+            // RRC is acknowledged right away so that procedures do not wait for the ack delay
+            bool isNew = m_acks->receive(ueId, m.pduId);
+            scheduleAck(ueId, m.pduType == rls::EPduType::RRC);
+            if (!isNew)
+                return;
+        }
         // Two possible PDU Types: DATA or RRC
         if (m.pduType == rls::EPduType::DATA)
         {
@@ -134,7 +204,14 @@ void RlsControlTask::handleRlsMessage(int ueId, rls::RlsMessage &msg)
             w->ueId = ueId;
             w->psi = static_cast<int>(m.payload); // PDU session identity
             w->data = std::move(m.pdu);
-            m_mainTask->push(std::move(w));
+            m_mainTask->deliver(std::move(w));
+        }
+        else if (m.pduType == rls::EPduType::DATA_PDCP)
+        {
+            std::vector<rls::PdcpSdu> sdus;
+            m_pdcp.receive(utils::CurrentTimeMillis(), ueId, m.payload, m.pdu, sdus);
+            deliverPdcpSdus(sdus);
+            armPdcpTimer();
         }
         else if (m.pduType == rls::EPduType::RRC)
         {
@@ -142,13 +219,54 @@ void RlsControlTask::handleRlsMessage(int ueId, rls::RlsMessage &msg)
             w->ueId = ueId;
             w->rrcChannel = static_cast<rrc::RrcChannel>(m.payload);
             w->data = std::move(m.pdu);
-            m_mainTask->push(std::move(w));
+            m_mainTask->deliver(std::move(w));
+        }
+        else if (m.pduType == rls::EPduType::RELAY || m.pduType == rls::EPduType::RELAY_COMPRESSED)
+        {
+            if (m.pduType == rls::EPduType::RELAY_COMPRESSED)
+            {
+                OctetString pdu;
+                if (!m_decompressors[ueId].decompress(m.pdu, rls::BAP_HEADER_SIZE, pdu))
+                {
+                    m_logger->debug("Compressed RELAY PDU from UE[%d] could not be decompressed", ueId);
+                    return;
+                }
+                m.pdu = std::move(pdu);
+            }
+
+            auto w = std::make_unique<NmGnbRlsToRls>(NmGnbRlsToRls::UPLINK_RELAY);
+            w->ueId = ueId;
+            w->bapContext = m.payload;
+            w->data = std::move(m.pdu);
+            m_mainTask->deliver(std::move(w));
+        }
+        else if (m.pduType == rls::EPduType::RLC)
+        {
+            std::vector<rls::RlsPduTransmission> sdus;
+            m_rlc.receive(utils::CurrentTimeMillis(), ueId, m, sdus);
+            for (auto &sdu : sdus)
+                handleRlsMessage(ueId, sdu);
+
+            // Status reports triggered by the PDU go out in the next slot
+            armRlcSlotTimer(true);
         }
         else
         {
             m_logger->err("Unhandled RLS PDU type");
         }
     }
+    else if (msg.msgType == rls::EMessageType::PDU_AGGREGATE)
+    {
+        for (auto &pdu : ((rls::RlsPduAggregate &)msg).pdus)
+            handleRlsMessage(ueId, pdu);
+    }
+    else if (msg.msgType == rls::EMessageType::CREDIT_STATUS)
+    {
+        auto w = std::make_unique<NmGnbRlsToRls>(NmGnbRlsToRls::CREDIT_STATUS);
+        w->ueId = ueId;
+        w->credit = ((const rls::RlsCreditStatus &)msg).sentBytes;
+        m_mainTask->deliver(std::move(w));
+    }
     else
     {
         m_logger->err("Unhandled RLS message type");
@@ -163,41 +281,38 @@ void RlsControlTask::handleDownlinkRrcDelivery(int ueId, uint32_t pduId, rrc::Rr
         throw std::runtime_error("");
     }
 
-    if (pduId != 0)
+    // Unicast RRC is sent reliably, pduId of the upper layer is only kept to report transmission failures
+    uint32_t seq = 0;
+    if (ueId != 0)
     {
-        if (m_pduMap.count(pduId))
-        {
-            m_pduMap.clear();
-
-            auto w = std::make_unique<NmGnbRlsToRls>(NmGnbRlsToRls::RADIO_LINK_FAILURE);
-            w->rlfCause = rls::ERlfCause::PDU_ID_EXISTS;
-            m_mainTask->push(std::move(w));
-            return;
-        }
-
-        if (m_pduMap.size() > MAX_PDU_COUNT)
+        rls::PduInfo info{};
+        info.endPointId = ueId;
+        info.id = pduId;
+        info.pdu = data.copy();
+        info.rrcChannel = channel;
+        info.sentTime = utils::CurrentTimeMillis();
+        seq = m_acks->track(ueId, std::move(info));
+        if (seq == 0)
         {
-            m_pduMap.clear();
+            m_acks->clearUnacked(ueId);
 
             auto w = std::make_unique<NmGnbRlsToRls>(NmGnbRlsToRls::RADIO_LINK_FAILURE);
             w->rlfCause = rls::ERlfCause::PDU_ID_FULL;
-            m_mainTask->push(std::move(w));
+            m_mainTask->deliver(std::move(w));
             return;
         }
 
-        m_pduMap[pduId].endPointId = ueId;
-        m_pduMap[pduId].id = pduId;
-        m_pduMap[pduId].pdu = data.copy();
-        m_pduMap[pduId].rrcChannel = channel;
-        m_pduMap[pduId].sentTime = utils::CurrentTimeMillis();
+        armRetransmissionTimer();
     }
 
     rls::RlsPduTransmission msg{m_sti};
     msg.pduType = rls::EPduType::RRC;
     msg.pdu = std::move(data);
     msg.payload = static_cast<uint32_t>(channel);
-    msg.pduId = pduId;
+    msg.pduId = seq;
 
+    // Keep the order of the user PDUs already queued for the UE
+    flushAggregates(ueId);
     m_udpTask->send(ueId, msg);
 }
 
@@ -205,56 +320,211 @@ void RlsControlTask::handleDownlinkDataDelivery(int ueId, int psi, OctetString &
 {
     rls::RlsPduTransmission msg{m_sti};
     msg.pduType = rls::EPduType::DATA;
-    msg.pdu = std::move(data);
     msg.payload = static_cast<uint32_t>(psi);
     msg.pduId = 0;
 
-    m_udpTask->send(ueId, msg);
+    if (m_pdcpEnabled)
+    {
+        msg.pduType = rls::EPduType::DATA_PDCP;
+        msg.payload = m_pdcp.protect(ueId, psi, data);
+    }
+
+    msg.pdu = std::move(data);
+
+    sendUserPdu(ueId, std::move(msg));
+}
+
+void RlsControlTask::handleDownlinkRelayDelivery(int ueId, uint32_t bapContext, OctetString &&pdu)
+{
+    rls::RlsPduTransmission msg{m_sti};
+    msg.pduType = rls::EPduType::RELAY;
+
+    OctetString compressed;
+    if (m_compressRelay && m_compressors[ueId].compress(pdu, rls::BAP_HEADER_SIZE, compressed))
+    {
+        msg.pduType = rls::EPduType::RELAY_COMPRESSED;
+        pdu = std::move(compressed);
+    }
+
+    msg.pdu = std::move(pdu);
+    msg.payload = bapContext;
+    msg.pduId = 0;
+
+    sendUserPdu(ueId, std::move(msg));
+}
+
+void RlsControlTask::sendUserPdu(int ueId, rls::RlsPduTransmission &&msg)
+{
+    if (!m_rlcEnabled)
+    {
+        sendPdu(ueId, std::move(msg));
+        return;
+    }
+
+    m_rlc.submit(ueId, msg);
+    armRlcSlotTimer(true);
+}
+
+void RlsControlTask::sendPdu(int ueId, rls::RlsPduTransmission &&msg)
+{
+    if (!m_aggregator)
+    {
+        m_udpTask->send(ueId, msg);
+        return;
+    }
+
+    for (auto &ready : m_aggregator->add(ueId, std::move(msg)))
+        m_udpTask->send(ueId, *ready);
+
+    if (!m_aggregationTimerArmed && !m_aggregator->empty())
+    {
+        m_aggregationTimerArmed = true;
+        setTimer(TIMER_ID_AGGREGATION, m_aggregationWindow);
+    }
+}
+
+void RlsControlTask::flushAggregates(int ueId)
+{
+    if (!m_aggregator)
+        return;
+
+    if (ueId != 0)
+    {
+        auto msg = m_aggregator->take(ueId);
+        if (msg)
+            m_udpTask->send(ueId, *msg);
+        return;
+    }
+
+    for (auto &item : m_aggregator->takeAll())
+        m_udpTask->send(item.first, *item.second);
+}
+
+void RlsControlTask::deliverPdcpSdus(std::vector<rls::PdcpSdu> &sdus)
+{
+    for (auto &sdu : sdus)
+    {
+        auto w = std::make_unique<NmGnbRlsToRls>(NmGnbRlsToRls::UPLINK_DATA);
+        w->ueId = sdu.peer;
+        w->psi = sdu.psi;
+        w->data = std::move(sdu.data);
+        m_mainTask->deliver(std::move(w));
+    }
+}
+
+void RlsControlTask::armPdcpTimer()
+{
+    int64_t expiry = m_pdcp.nextExpiry();
+    if (expiry == 0 || (m_pdcpReorderTime != 0 && m_pdcpReorderTime <= expiry))
+        return;
+
+    m_pdcpReorderTime = expiry;
+    setTimerAbsolute(TIMER_ID_PDCP_REORDERING, expiry);
+}
+
+void RlsControlTask::onRlcSlotTimerExpired()
+{
+    std::vector<std::pair<int, rls::RlsPduTransmission>> pdus;
+    bool backlogged = m_rlc.runSlot(utils::CurrentTimeMillis(), pdus);
+    for (auto &item : pdus)
+        sendPdu(item.first, std::move(item.second));
+
+    for (int ueId : m_rlc.takeFailures())
+    {
+        m_logger->warn("RLC maximum retransmissions reached for UE[%d]", ueId);
+        m_rlc.remove(ueId);
+        m_udpTask->resetUe(ueId);
+
+        auto w = std::make_unique<NmGnbRlsToRls>(NmGnbRlsToRls::RADIO_LINK_FAILURE);
+        w->ueId = ueId;
+        w->rlfCause = rls::ERlfCause::RLC_MAX_RETRANSMISSION;
+        m_mainTask->deliver(std::move(w));
+    }
+
+    armRlcSlotTimer(backlogged);
+}
+
+void RlsControlTask::armRlcSlotTimer(bool busy)
+{
+    if (m_rlc.empty())
+        return;
+
+    // Bearers keep ticking while idle, their poll and reassembly timers run on the slot clock
+    int period = busy ? m_rlc.slot() : std::max(m_rlc.slot(), TIMER_PERIOD_RLC_IDLE);
+    int64_t time = utils::CurrentTimeMillis() + period;
+    if (m_rlcSlotTime != 0 && m_rlcSlotTime <= time)
+        return;
+
+    m_rlcSlotTime = time;
+    setTimerAbsolute(TIMER_ID_RLC_SLOT, time);
 }
 
 void RlsControlTask::onAckControlTimerExpired()
 {
     int64_t current = utils::CurrentTimeMillis();
 
-    std::vector<uint32_t> transmissionFailureIds;
+    std::vector<rls::RlsRetransmission> retransmissions;
     std::vector<rls::PduInfo> transmissionFailures;
+    m_acks->poll(current, MAX_PDU_TTL, retransmissions, transmissionFailures);
 
-    for (auto &pdu : m_pduMap)
+    for (auto &item : retransmissions)
     {
-        auto delta = current - pdu.second.sentTime;
-        if (delta > MAX_PDU_TTL)
-        {
-            transmissionFailureIds.push_back(pdu.first);
-            transmissionFailures.push_back(std::move(pdu.second));
-        }
+        rls::RlsPduTransmission msg{m_sti};
+        msg.pduType = rls::EPduType::RRC;
+        msg.pdu = std::move(item.pdu);
+        msg.payload = static_cast<uint32_t>(item.rrcChannel);
+        msg.pduId = item.seq;
+        m_udpTask->send(item.peer, msg);
     }
 
-    for (auto id : transmissionFailureIds)
-        m_pduMap.erase(id);
-
     if (!transmissionFailures.empty())
     {
         auto w = std::make_unique<NmGnbRlsToRls>(NmGnbRlsToRls::TRANSMISSION_FAILURE);
         w->pduList = std::move(transmissionFailures);
-        m_mainTask->push(std::move(w));
+        m_mainTask->deliver(std::move(w));
+    }
+
+    armRetransmissionTimer();
+}
+
+void RlsControlTask::armRetransmissionTimer()
+{
+    if (!m_arqTimerArmed && m_acks->unackedCount() > 0)
+    {
+        m_arqTimerArmed = true;
+        setTimer(TIMER_ID_ACK_CONTROL, TIMER_PERIOD_ACK_CONTROL);
     }
 }
 
 void RlsControlTask::onAckSendTimerExpired()
 {
-    auto copy = m_pendingAck;
-    m_pendingAck.clear();
+    for (int peer : m_acks->owingPeers())
+        sendAck(peer);
+}
 
-    for (auto &item : copy)
+void RlsControlTask::scheduleAck(int ueId, bool immediate)
+{
+    if (immediate)
     {
-        if (!item.second.empty())
-            continue;
-
-        rls::RlsPduTransmissionAck msg{m_sti};
-        msg.pduIds = std::move(item.second);
+        sendAck(ueId);
+        return;
+    }
 
-        m_udpTask->send(item.first, msg);
+    if (!m_ackTimerArmed)
+    {
+        m_ackTimerArmed = true;
+        setTimer(TIMER_ID_ACK_SEND, TIMER_PERIOD_ACK_SEND);
     }
 }
 
+void RlsControlTask::sendAck(int ueId)
+{
+    // The radio link task attaches the owed ack block to whatever is sent, so nothing to do if it already left
+    if (!m_acks->isOwed(ueId))
+        return;
+
+    rls::RlsPduTransmissionAck msg{m_sti};
+    m_udpTask->send(ueId, msg);
+}
+
 } // namespace nr::rgnb
@@ -10,34 +10,53 @@
 
 #include "udp_task.hpp"
 
+#include <lib/rls/rls_ack.hpp>
+#include <lib/rls/rls_aggregator.hpp>
+#include <lib/rls/rls_pdcp.hpp>
+#include <lib/rls/rls_rlc.hpp>
+#include <lib/rls/rls_rohc.hpp>
 #include <rgnb/nts.hpp>
+#include <rgnb/fused.hpp>
 #include <rgnb/types.hpp>
 #include <utils/nts.hpp>
 
 namespace nr::rgnb
 {
 
-class RlsControlTask : public NtsTask
+class RlsControlTask : public FusableTask
 {
   private:
     std::unique_ptr<Logger> m_logger;
     uint64_t m_sti;
-    NtsTask *m_mainTask;
+    FusableTask *m_mainTask;
     RlsUdpTask *m_udpTask;
-    std::unordered_map<uint32_t, rls::PduInfo> m_pduMap;
-    std::unordered_map<int, std::vector<uint32_t>> m_pendingAck;
+    rls::AckTracker *m_acks;
+    bool m_ackTimerArmed;
+    bool m_arqTimerArmed;
+    bool m_compressRelay;
+    std::unordered_map<int, rls::HeaderCompressor> m_compressors;     // downlink, by child relay
+    std::unordered_map<int, rls::HeaderDecompressor> m_decompressors; // uplink, by child relay
+    std::unique_ptr<rls::PduAggregator> m_aggregator;
+    int m_aggregationWindow;
+    bool m_aggregationTimerArmed;
+    rls::RlcBearers m_rlc;
+    bool m_rlcEnabled;     // user PDUs sent by this node go through RLC, received RLC PDUs are always handled
+    int64_t m_rlcSlotTime; // time of the next slot, 0 if the slot timer is not armed
+    rls::PdcpEntities m_pdcp;
+    bool m_pdcpEnabled;        // user PDUs sent by this node are protected, received PDCP PDUs are always handled
+    int64_t m_pdcpReorderTime; // expiry of the t-Reordering timer, 0 if it is not armed
 
   public:
-    explicit RlsControlTask(TaskBase *base, uint64_t sti);
+    explicit RlsControlTask(TaskBase *base, uint64_t sti, rls::AckTracker *acks);
     ~RlsControlTask() override = default;
 
   protected:
     void onStart() override;
-    void onLoop() override;
+    void handleMessage(NtsMessage &msg) override;
     void onQuit() override;
 
   public:
-    void initialize(NtsTask *mainTask, RlsUdpTask *udpTask);
+    void initialize(FusableTask *mainTask, RlsUdpTask *udpTask);
 
   private:
     void handleSignalDetected(int ueId);
@@ -45,8 +64,19 @@ class RlsControlTask : public NtsTask
     void handleRlsMessage(int ueId, rls::RlsMessage &msg);
     void handleDownlinkRrcDelivery(int ueId, uint32_t pduId, rrc::RrcChannel channel, OctetString &&data);
     void handleDownlinkDataDelivery(int ueId, int psi, OctetString &&data);
+    void handleDownlinkRelayDelivery(int ueId, uint32_t bapContext, OctetString &&pdu);
+    void sendUserPdu(int ueId, rls::RlsPduTransmission &&msg);
+    void sendPdu(int ueId, rls::RlsPduTransmission &&msg);
+    void flushAggregates(int ueId);
+    void deliverPdcpSdus(std::vector<rls::PdcpSdu> &sdus);
+    void armPdcpTimer();
+    void onRlcSlotTimerExpired();
+    void armRlcSlotTimer(bool busy);
     void onAckControlTimerExpired();
+    void armRetransmissionTimer();
     void onAckSendTimerExpired();
+    void scheduleAck(int ueId, bool immediate);
+    void sendAck(int ueId);
 };
 
 } // namespace nr::rgnb
\ No newline at end of file
@@ -0,0 +1,344 @@
+//
+// This file is a part of UERANSIM project.
+// Copyright (c) 2023 ALİ GÜNGÖR.
+//
+// https://github.com/aligungr/UERANSIM/
+// See README, LICENSE, and CONTRIBUTING files for licensing details.
+//
+
+#include "mac.hpp"
+
+#include <algorithm>
+
+// Resource elements of a PRB per slot available for data, 12 subcarriers x 14 symbols less one DMRS symbol
+static constexpr const int DATA_RE_PER_PRB = 156;
+
+// Spectral efficiency in bits per resource element of CQI 1 to 15, TS 38.214 Table 5.2.2.1-2
+static constexpr const double CQI_EFFICIENCY[] = {0.1523, 0.2344, 0.3770, 0.6016, 0.8770, 1.1758, 1.4766, 1.9141,
+                                                  2.4063, 2.7305, 3.3223, 3.9023, 4.5234, 5.1152, 5.5547};
+
+// Simulated signal strengths mapped to CQI 1 and CQI 15, linear in between
+static constexpr const int CQI_MIN_DBM = -120;
+static constexpr const int CQI_MAX_DBM = -50;
+static constexpr const int DEFAULT_CQI = 7; // UEs without a heartbeat yet
+
+// Slots further behind than this are skipped instead of being caught up with
+static constexpr const int64_t MAX_SLOTS_PER_RUN = 1000;
+
+namespace nr::rgnb
+{
+
+MacScheduler::MacScheduler(const MacConfig &config, int64_t now)
+    : m_config{config},
+      m_slotDuration{config.slotDuration != 0 ? config.slotDuration : 1000 >> config.numerology}, m_startTime{now},
+      m_slot{}, m_slotsRun{}, m_rng{config.seed}, m_uniform{}, m_dbm{}, m_lastPduId{}, m_directions{}, m_candidates{}
+{
+}
+
+void MacScheduler::setSignalQuality(int ueId, int dbm)
+{
+    m_dbm[ueId] = dbm;
+}
+
+void MacScheduler::removeUe(int ueId)
+{
+    m_dbm.erase(ueId);
+    for (auto &direction : m_directions)
+    {
+        direction.ues.erase(ueId);
+        direction.order.erase(std::remove(direction.order.begin(), direction.order.end(), ueId),
+                              direction.order.end());
+    }
+}
+
+bool MacScheduler::enqueue(EMacDirection direction, MacPdu &&pdu, int64_t now)
+{
+    // An idle scheduler does not run, its clock restarts with the first slot after the PDU
+    if (!isBusy())
+        m_slot = (now - m_startTime) / m_slotDuration + 1;
+
+    auto &dir = m_directions[static_cast<int>(direction)];
+    auto it = dir.ues.find(pdu.ueId);
+    if (it == dir.ues.end())
+    {
+        it = dir.ues.emplace(pdu.ueId, UeQueue{}).first;
+        dir.order.push_back(pdu.ueId);
+    }
+
+    auto &ue = it->second;
+    if (ue.bytes + static_cast<int64_t>(pdu.pdu.length()) > m_config.queueSize)
+    {
+        ue.droppedPdus++;
+        return false;
+    }
+
+    pdu.arrival = now;
+    ue.bytes += pdu.pdu.length();
+    ue.queue.push_back(std::move(pdu));
+    return true;
+}
+
+void MacScheduler::run(int64_t now, std::vector<MacPdu> &outUplink, std::vector<MacPdu> &outDownlink)
+{
+    int64_t current = (now - m_startTime) / m_slotDuration;
+    if (current - m_slot >= MAX_SLOTS_PER_RUN)
+        m_slot = current - MAX_SLOTS_PER_RUN + 1;
+
+    for (; m_slot <= current; m_slot++)
+    {
+        runSlot(m_directions[static_cast<int>(EMacDirection::UPLINK)], now, outUplink);
+        runSlot(m_directions[static_cast<int>(EMacDirection::DOWNLINK)], now, outDownlink);
+        m_slotsRun++;
+    }
+}
+
+void MacScheduler::runSlot(Direction &direction, int64_t now, std::vector<MacPdu> &output)
+{
+    int prbs = m_config.prbs;
+
+    // HARQ retransmissions go first, with the PRBs of their original allocation
+    while (!direction.harq.empty() && direction.harq.front().dueSlot <= m_slot && direction.harq.front().prbs <= prbs)
+    {
+        auto block = std::move(direction.harq.front());
+        direction.harq.pop_front();
+
+        prbs -= block.prbs;
+        direction.retransmissions++;
+        transmit(direction, std::move(block), now, output);
+    }
+
+    m_candidates.clear();
+    for (int ueId : direction.order)
+    {
+        auto &ue = direction.ues[ueId];
+        if (ue.bytes > ue.headSent)
+        {
+            double rate = bytesPerPrb(ueId);
+            double metric = rate;
+            if (m_config.policy == EMacPolicy::PROPORTIONAL_FAIR)
+                metric = rate / std::max(ue.averageRate, 1.0);
+            m_candidates.emplace_back(ueId, metric);
+        }
+    }
+
+    if (m_config.policy == EMacPolicy::ROUND_ROBIN)
+    {
+        // Each slot starts from the next UE of the previous one
+        if (!m_candidates.empty())
+        {
+            std::rotate(m_candidates.begin(), m_candidates.begin() + direction.roundRobin % m_candidates.size(),
+                        m_candidates.end());
+            direction.roundRobin++;
+        }
+    }
+    else
+    {
+        std::stable_sort(m_candidates.begin(), m_candidates.end(),
+                         [](auto &a, auto &b) { return a.second > b.second; });
+    }
+
+    for (auto &candidate : m_candidates)
+    {
+        if (prbs == 0)
+            break;
+        auto &ue = direction.ues[candidate.first];
+        int bytesPerPrb = this->bytesPerPrb(candidate.first);
+        int64_t needed = (ue.bytes - ue.headSent + bytesPerPrb - 1) / bytesPerPrb;
+        int allocated = static_cast<int>(std::min(needed, static_cast<int64_t>(prbs)));
+
+        prbs -= allocated;
+        allocate(direction, candidate.first, allocated, now, output);
+    }
+
+    direction.usedPrbs += m_config.prbs - prbs;
+
+    for (auto &item : direction.ues)
+    {
+        auto &ue = item.second;
+        ue.averageRate += (ue.slotBytes - ue.averageRate) / m_config.pfWindow;
+        ue.slotBytes = 0;
+    }
+}
+
+void MacScheduler::allocate(Direction &direction, int ueId, int prbs, int64_t now, std::vector<MacPdu> &output)
+{
+    auto &ue = direction.ues[ueId];
+
+    int64_t carried = std::min(static_cast<int64_t>(prbs) * bytesPerPrb(ueId), ue.bytes - ue.headSent);
+    ue.slotBytes += static_cast<int>(carried);
+
+    TransportBlock block{};
+    block.ueId = ueId;
+    block.prbs = prbs;
+
+    while (carried > 0)
+    {
+        // The PDU waits outside the queue from its first carried byte until all of its blocks are received
+        if (ue.head == 0)
+        {
+            ue.head = ++m_lastPduId;
+            ue.carried.emplace(ue.head, CarriedPdu{std::move(ue.queue.front())});
+            ue.queue.pop_front();
+        }
+
+        auto &head = ue.carried[ue.head];
+        head.blocks++;
+        block.pdus.push_back(ue.head);
+
+        int remaining = head.pdu.pdu.length() - ue.headSent;
+        if (carried < remaining)
+        {
+            ue.headSent += static_cast<int>(carried);
+            break;
+        }
+
+        carried -= remaining;
+        ue.bytes -= head.pdu.pdu.length();
+        ue.headSent = 0;
+        ue.head = 0;
+        head.complete = true;
+    }
+
+    transmit(direction, std::move(block), now, output);
+}
+
+void MacScheduler::transmit(Direction &direction, TransportBlock &&block, int64_t now, std::vector<MacPdu> &output)
+{
+    direction.transmissions++;
+    block.transmissions++;
+
+    auto ue = direction.ues.find(block.ueId);
+    if (ue == direction.ues.end())
+        return;
+
+    auto &queue = ue->second;
+
+    if (m_uniform(m_rng) >= m_config.bler)
+    {
+        for (uint64_t id : block.pdus)
+        {
+            // PDUs another block of which failed for good are gone already
+            auto it = queue.carried.find(id);
+            if (it == queue.carried.end() || --it->second.blocks > 0 || !it->second.complete)
+                continue;
+
+            auto &pdu = it->second.pdu;
+            int64_t delay = now - pdu.arrival;
+            queue.deliveredBytes += pdu.pdu.length();
+            queue.deliveredPdus++;
+            queue.delaySum += delay;
+            queue.delayMax = std::max(queue.delayMax, delay);
+            output.push_back(std::move(pdu));
+            queue.carried.erase(it);
+        }
+        return;
+    }
+
+    if (block.transmissions >= m_config.harqMaxTx)
+    {
+        // Recovery is left to the upper layers, as with a real HARQ failure. The PDUs the block carries bytes of are
+        // lost, including the rest of a PDU that is still being carried.
+        direction.harqFailures++;
+        for (uint64_t id : block.pdus)
+        {
+            auto it = queue.carried.find(id);
+            if (it == queue.carried.end())
+                continue;
+
+            if (id == queue.head)
+            {
+                queue.bytes -= it->second.pdu.pdu.length();
+                queue.headSent = 0;
+                queue.head = 0;
+            }
+            queue.droppedPdus++;
+            queue.carried.erase(it);
+        }
+        return;
+    }
+
+    block.dueSlot = m_slot + m_config.harqRtt;
+    direction.harq.push_back(std::move(block));
+}
+
+int MacScheduler::cqi(int ueId) const
+{
+    auto it = m_dbm.find(ueId);
+    if (it == m_dbm.end())
+        return DEFAULT_CQI;
+
+    int dbm = std::clamp(it->second, CQI_MIN_DBM, CQI_MAX_DBM);
+    return 1 + (dbm - CQI_MIN_DBM) * 14 / (CQI_MAX_DBM - CQI_MIN_DBM);
+}
+
+int MacScheduler::bytesPerPrb(int ueId) const
+{
+    return std::max(1, static_cast<int>(DATA_RE_PER_PRB * CQI_EFFICIENCY[cqi(ueId) - 1] / 8));
+}
+
+bool MacScheduler::isBusy() const
+{
+    for (auto &direction : m_directions)
+    {
+        if (!direction.harq.empty())
+            return true;
+        for (auto &ue : direction.ues)
+            if (ue.second.bytes > 0)
+                return true;
+    }
+    return false;
+}
+
+int MacScheduler::slotDuration() const
+{
+    return m_slotDuration;
+}
+
+Json MacScheduler::toJson() const
+{
+    std::string policy = m_config.policy == EMacPolicy::ROUND_ROBIN         ? "round-robin"
+                         : m_config.policy == EMacPolicy::PROPORTIONAL_FAIR ? "proportional-fair"
+                                                                            : "max-ci";
+
+    return Json::Obj({
+        {"policy", policy},
+        {"slot-duration-us", m_slotDuration},
+        {"prbs", m_config.prbs},
+        {"slots", m_slotsRun},
+        {"uplink", toJson(m_directions[static_cast<int>(EMacDirection::UPLINK)])},
+        {"downlink", toJson(m_directions[static_cast<int>(EMacDirection::DOWNLINK)])},
+    });
+}
+
+Json MacScheduler::toJson(const Direction &direction) const
+{
+    Json ues = Json::Arr({});
+    for (int ueId : direction.order)
+    {
+        auto &ue = direction.ues.at(ueId);
+        auto dbm = m_dbm.find(ueId);
+        ues.push(Json::Obj({
+            {"ue-id", ueId},
+            {"dbm", dbm == m_dbm.end() ? Json{nullptr} : Json{dbm->second}},
+            {"cqi", cqi(ueId)},
+            {"queued-bytes", ue.bytes},
+            {"delivered-bytes", ue.deliveredBytes},
+            {"delivered-pdus", ue.deliveredPdus},
+            {"dropped-pdus", ue.droppedPdus},
+            {"throughput-kbps", static_cast<int64_t>(ue.averageRate * 8000 / m_slotDuration)},
+            {"avg-delay-us", ue.deliveredPdus == 0 ? 0 : ue.delaySum / ue.deliveredPdus},
+            {"max-delay-us", ue.delayMax},
+        }));
+    }
+
+    int64_t available = m_slotsRun * m_config.prbs;
+    return Json::Obj({
+        {"prb-utilization", available == 0 ? 0 : direction.usedPrbs * 100 / available},
+        {"transmissions", direction.transmissions},
+        {"retransmissions", direction.retransmissions},
+        {"harq-failures", direction.harqFailures},
+        {"ues", ues},
+    });
+}
+
+} // namespace nr::rgnb
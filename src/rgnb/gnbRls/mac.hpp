@@ -0,0 +1,135 @@
+//
+// This file is a part of UERANSIM project.
+// Copyright (c) 2023 ALİ GÜNGÖR.
+//
+// https://github.com/aligungr/UERANSIM/
+// See README, LICENSE, and CONTRIBUTING files for licensing details.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <random>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <rgnb/types.hpp>
+#include <utils/json.hpp>
+#include <utils/octet_string.hpp>
+
+namespace nr::rgnb
+{
+
+enum class EMacDirection
+{
+    UPLINK = 0,
+    DOWNLINK = 1,
+};
+
+struct MacPdu
+{
+    int ueId{};
+    bool relay{};       // RELAY PDU, otherwise DATA
+    uint32_t context{}; // PSI of a DATA PDU, BAP context of a RELAY PDU
+    OctetString pdu{};
+    int64_t arrival{}; // us
+};
+
+/*
+ * Slot-based MAC scheduler emulation of the cell. Each slot has a number of PRBs per direction, and the bytes a PRB
+ * carries for a UE follow the CQI of its simulated signal strength. The PRBs of a slot are allocated to the backlogged
+ * UEs of the direction by round robin, proportional fair or max-C/I. The transport block of each allocation fails
+ * with the configured BLER, failed blocks are retransmitted by HARQ ahead of new data and dropped after the last
+ * attempt. A PDU leaves the scheduler once every transport block carrying its bytes has been received, and is dropped
+ * as soon as one of them is.
+ *
+ * Slots follow the wall clock, the ones elapsed since the last run are scheduled together.
+ */
+class MacScheduler
+{
+  private:
+    struct CarriedPdu
+    {
+        MacPdu pdu{};
+        int blocks{};    // transport blocks carrying bytes of the PDU that are not received yet
+        bool complete{}; // all bytes of the PDU are in transport blocks
+    };
+
+    struct UeQueue
+    {
+        std::deque<MacPdu> queue{};                         // PDUs none of whose bytes are carried yet
+        std::unordered_map<uint64_t, CarriedPdu> carried{}; // by PDU id
+        uint64_t head{};      // id of the PDU whose bytes are being carried, 0 if none
+        int64_t bytes{};      // queued, including the part of the head PDU already carried
+        int headSent{};       // bytes of the head PDU carried by transport blocks
+        int slotBytes{};      // carried in the current slot
+        double averageRate{}; // bytes per slot
+
+        int64_t deliveredBytes{};
+        int64_t deliveredPdus{};
+        int64_t droppedPdus{};
+        int64_t delaySum{}; // us
+        int64_t delayMax{}; // us
+    };
+
+    struct TransportBlock
+    {
+        int ueId{};
+        int prbs{};
+        int transmissions{};
+        int64_t dueSlot{};          // of the next HARQ retransmission
+        std::vector<uint64_t> pdus{}; // ids of the PDUs whose bytes are carried by the block
+    };
+
+    struct Direction
+    {
+        std::unordered_map<int, UeQueue> ues{};
+        std::vector<int> order{};           // UEs in arrival order, for round robin
+        std::deque<TransportBlock> harq{}; // by due slot
+        size_t roundRobin{};
+        int64_t usedPrbs{};
+        int64_t transmissions{};
+        int64_t retransmissions{};
+        int64_t harqFailures{};
+    };
+
+  private:
+    MacConfig m_config;
+    int m_slotDuration;  // us
+    int64_t m_startTime; // us
+    int64_t m_slot;      // next slot to be scheduled
+    int64_t m_slotsRun;
+    std::mt19937_64 m_rng;
+    std::uniform_real_distribution<double> m_uniform;
+    std::unordered_map<int, int> m_dbm;
+    uint64_t m_lastPduId;
+    Direction m_directions[2];
+    std::vector<std::pair<int, double>> m_candidates; // reused by each slot
+
+  public:
+    MacScheduler(const MacConfig &config, int64_t now);
+
+  public:
+    void setSignalQuality(int ueId, int dbm);
+    void removeUe(int ueId);
+    /* Queues the PDU for the next slots, returns false if the queue of the UE is full and the PDU is dropped */
+    bool enqueue(EMacDirection direction, MacPdu &&pdu, int64_t now);
+    /* Schedules the slots elapsed until now, the PDUs delivered by them are appended to the outputs */
+    void run(int64_t now, std::vector<MacPdu> &outUplink, std::vector<MacPdu> &outDownlink);
+
+    [[nodiscard]] bool isBusy() const;
+    [[nodiscard]] int slotDuration() const;
+    [[nodiscard]] Json toJson() const;
+
+  private:
+    void runSlot(Direction &direction, int64_t now, std::vector<MacPdu> &output);
+    void allocate(Direction &direction, int ueId, int prbs, int64_t now, std::vector<MacPdu> &output);
+    void transmit(Direction &direction, TransportBlock &&block, int64_t now, std::vector<MacPdu> &output);
+    [[nodiscard]] int cqi(int ueId) const;
+    [[nodiscard]] int bytesPerPrb(int ueId) const;
+    [[nodiscard]] Json toJson(const Direction &direction) const;
+};
+
+} // namespace nr::rgnb
@@ -0,0 +1,133 @@
+//
+// This file is a part of UERANSIM project.
+// Copyright (c) 2023 ALİ GÜNGÖR.
+//
+// https://github.com/aligungr/UERANSIM/
+// See README, LICENSE, and CONTRIBUTING files for licensing details.
+//
+
+#include "outage.hpp"
+
+#include <algorithm>
+
+namespace nr::rgnb
+{
+
+OutageBuffer::OutageBuffer(size_t capacity, int64_t maxAge)
+    : m_capacity{capacity}, m_maxAge{maxAge}, m_queues{}, m_order{}, m_next{}, m_size{}
+{
+}
+
+size_t OutageBuffer::store(BackhaulPdu &&pdu, int64_t now)
+{
+    auto length = static_cast<size_t>(pdu.pdu.length());
+    if (length > m_capacity)
+        return 1;
+
+    size_t evicted = 0;
+    if (m_size + length > m_capacity)
+        evicted += evictExpired(now);
+
+    // Still full, drop from the head of the longest queue so that a single UE cannot take the whole buffer
+    while (m_size + length > m_capacity)
+    {
+        auto longest = std::max_element(m_queues.begin(), m_queues.end(), [](auto &a, auto &b) {
+            return a.second.bytes < b.second.bytes;
+        });
+        popFront(longest->first, longest->second);
+        evicted++;
+    }
+
+    int ueId = pdu.ueId;
+    auto &queue = m_queues[ueId];
+    if (queue.entries.empty())
+        m_order.push_back(ueId);
+
+    queue.bytes += length;
+    queue.entries.push_back(Entry{now, std::move(pdu)});
+    m_size += length;
+    return evicted;
+}
+
+void OutageBuffer::drain(int64_t now, size_t byteBudget, std::vector<BackhaulPdu> &output)
+{
+    evictExpired(now);
+
+    // One PDU per UE and turn, so that every UE behind the relay recovers at the same pace
+    while (!m_order.empty())
+    {
+        if (m_next >= m_order.size())
+            m_next = 0;
+
+        int ueId = m_order[m_next];
+        auto &queue = m_queues[ueId];
+
+        auto length = static_cast<size_t>(queue.entries.front().pdu.pdu.length());
+        if (length > byteBudget)
+            return;
+        byteBudget -= length;
+
+        bool last = queue.entries.size() == 1;
+        output.push_back(std::move(queue.entries.front().pdu));
+        popFront(ueId, queue);
+
+        if (!last)
+            m_next++;
+    }
+}
+
+bool OutageBuffer::empty() const
+{
+    return m_size == 0;
+}
+
+size_t OutageBuffer::size() const
+{
+    return m_size;
+}
+
+size_t OutageBuffer::evictExpired(int64_t now)
+{
+    size_t evicted = 0;
+
+    auto order = m_order;
+    for (int ueId : order)
+    {
+        auto &queue = m_queues[ueId];
+        while (true)
+        {
+            bool last = queue.entries.size() == 1;
+            if (now - queue.entries.front().time <= m_maxAge)
+                break;
+
+            popFront(ueId, queue);
+            evicted++;
+
+            if (last)
+                break;
+        }
+    }
+
+    return evicted;
+}
+
+void OutageBuffer::popFront(int ueId, Queue &queue)
+{
+    auto length = static_cast<size_t>(queue.entries.front().pdu.pdu.length());
+    queue.entries.pop_front();
+    queue.bytes -= length;
+    m_size -= length;
+
+    if (!queue.entries.empty())
+        return;
+
+    m_queues.erase(ueId);
+
+    auto it = std::find(m_order.begin(), m_order.end(), ueId);
+    auto index = static_cast<size_t>(it - m_order.begin());
+    m_order.erase(it);
+    if (index < m_next)
+        m_next--;
+}
+
+} // namespace nr::rgnb
@@ -0,0 +1,61 @@
+//
+// This file is a part of UERANSIM project.
+// Copyright (c) 2023 ALİ GÜNGÖR.
+//
+// https://github.com/aligungr/UERANSIM/
+// See README, LICENSE, and CONTRIBUTING files for licensing details.
+//
+
+#pragma once
+
+#include "scheduler.hpp"
+
+#include <cstdint>
+#include <deque>
+#include <unordered_map>
+#include <vector>
+
+namespace nr::rgnb
+{
+
+/* Per-downstream-UE store-and-forward buffer used while the upstream link is down */
+class OutageBuffer
+{
+  private:
+    struct Entry
+    {
+        int64_t time{};
+        BackhaulPdu pdu{};
+    };
+
+    struct Queue
+    {
+        std::deque<Entry> entries{};
+        size_t bytes{};
+    };
+
+  private:
+    size_t m_capacity;
+    int64_t m_maxAge;
+    std::unordered_map<int, Queue> m_queues;
+    std::vector<int> m_order; // round robin order of non-empty queues
+    size_t m_next;
+    size_t m_size;
+
+  public:
+    OutageBuffer(size_t capacity, int64_t maxAge);
+
+  public:
+    /* Returns the number of PDUs evicted to make room */
+    size_t store(BackhaulPdu &&pdu, int64_t now);
+    void drain(int64_t now, size_t byteBudget, std::vector<BackhaulPdu> &output);
+
+    [[nodiscard]] bool empty() const;
+    [[nodiscard]] size_t size() const;
+
+  private:
+    size_t evictExpired(int64_t now);
+    void popFront(int ueId, Queue &queue);
+};
+
+} // namespace nr::rgnb
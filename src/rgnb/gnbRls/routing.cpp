@@ -0,0 +1,101 @@
+//
+// This file is a part of UERANSIM project.
+// Copyright (c) 2023 ALİ GÜNGÖR.
+//
+// https://github.com/aligungr/UERANSIM/
+// See README, LICENSE, and CONTRIBUTING files for licensing details.
+//
+
+#include "routing.hpp"
+
+// Remote UE ids are kept apart from the ids assigned by the RLS layer
+static constexpr const int REMOTE_UE_ID_BASE = 1 << 24;
+
+static bool IsValidAddress(int address)
+{
+    return address >= 0 && address < rls::BAP_ADDRESS_COUNT;
+}
+
+namespace nr::rgnb
+{
+
+BapRoutingTable::BapRoutingTable() : m_nextHop{}, m_neighbours{}, m_learned{}
+{
+    m_nextHop.fill(-1);
+}
+
+void BapRoutingTable::addRoute(int destination, int nextHop)
+{
+    if (IsValidAddress(destination) && IsValidAddress(nextHop))
+        m_nextHop[destination] = nextHop;
+}
+
+void BapRoutingTable::addNeighbour(int address, int ueId)
+{
+    if (IsValidAddress(address))
+    {
+        m_neighbours[address] = ueId;
+        m_learned[address] = ueId;
+    }
+}
+
+void BapRoutingTable::learn(int source, int ueId)
+{
+    if (IsValidAddress(source))
+        m_learned[source] = ueId;
+}
+
+void BapRoutingTable::removeLink(int ueId)
+{
+    for (auto &item : m_neighbours)
+        if (item == ueId)
+            item = 0;
+    for (auto &item : m_learned)
+        if (item == ueId)
+            item = 0;
+}
+
+int BapRoutingTable::lookup(int destination) const
+{
+    if (!IsValidAddress(destination))
+        return 0;
+
+    // Configured routes take precedence over the ones learned from uplink traffic
+    int nextHop = m_nextHop[destination];
+    if (nextHop != -1 && m_neighbours[nextHop] != 0)
+        return m_neighbours[nextHop];
+
+    return m_learned[destination];
+}
+
+RemoteUeTable::RemoteUeTable() : m_idByContext{}, m_contextById{}, m_idCounter{REMOTE_UE_ID_BASE}
+{
+}
+
+int RemoteUeTable::getOrAssign(const rls::BapContext &ctx)
+{
+    uint32_t key = (static_cast<uint32_t>(ctx.source) << 18) | static_cast<uint32_t>(ctx.ueId);
+
+    auto it = m_idByContext.find(key);
+    if (it != m_idByContext.end())
+        return it->second;
+
+    int ueId = ++m_idCounter;
+    m_idByContext[key] = ueId;
+    m_contextById[ueId] = rls::BapContext{ctx.source, ctx.ueId, 0};
+    return ueId;
+}
+
+bool RemoteUeTable::isRemote(int ueId) const
+{
+    return ueId > REMOTE_UE_ID_BASE && m_contextById.count(ueId) != 0;
+}
+
+rls::BapContext RemoteUeTable::getContext(int ueId, int psi) const
+{
+    auto ctx = m_contextById.at(ueId);
+    ctx.psi = psi;
+    return ctx;
+}
+
+} // namespace nr::rgnb
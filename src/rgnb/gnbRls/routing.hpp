@@ -0,0 +1,58 @@
+//
+// This file is a part of UERANSIM project.
+// Copyright (c) 2023 ALİ GÜNGÖR.
+//
+// https://github.com/aligungr/UERANSIM/
+// See README, LICENSE, and CONTRIBUTING files for licensing details.
+//
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <unordered_map>
+
+#include <lib/rls/rls_bap.hpp>
+
+namespace nr::rgnb
+{
+
+/* Maps BAP destinations to the downstream link (UE id of a directly attached child) to forward on */
+class BapRoutingTable
+{
+  private:
+    std::array<int, rls::BAP_ADDRESS_COUNT> m_nextHop;    // destination -> configured next hop address, or -1
+    std::array<int, rls::BAP_ADDRESS_COUNT> m_neighbours; // neighbour address -> ueId, or 0
+    std::array<int, rls::BAP_ADDRESS_COUNT> m_learned;    // destination -> ueId learned from uplink, or 0
+
+  public:
+    BapRoutingTable();
+
+  public:
+    void addRoute(int destination, int nextHop);
+    void addNeighbour(int address, int ueId);
+    void learn(int source, int ueId);
+    void removeLink(int ueId);
+
+    /* Returns the UE id of the next hop, or 0 if the destination is not downstream of this node */
+    [[nodiscard]] int lookup(int destination) const;
+};
+
+/* Assigns local UE ids to UEs served by descendant relays, so that they can be addressed like local UEs */
+class RemoteUeTable
+{
+  private:
+    std::unordered_map<uint32_t, int> m_idByContext;
+    std::unordered_map<int, rls::BapContext> m_contextById;
+    int m_idCounter;
+
+  public:
+    RemoteUeTable();
+
+  public:
+    int getOrAssign(const rls::BapContext &ctx);
+    [[nodiscard]] bool isRemote(int ueId) const;
+    [[nodiscard]] rls::BapContext getContext(int ueId, int psi) const;
+};
+
+} // namespace nr::rgnb
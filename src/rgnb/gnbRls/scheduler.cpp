@@ -0,0 +1,102 @@
+//
+// This file is a part of UERANSIM project.
+// Copyright (c) 2023 ALİ GÜNGÖR.
+//
+// https://github.com/aligungr/UERANSIM/
+// See README, LICENSE, and CONTRIBUTING files for licensing details.
+//
+
+#include "scheduler.hpp"
+
+#include <algorithm>
+
+// Largest PDU the RLS tasks receive, a slow link still has to hold one in its token bucket to ever send it
+static constexpr const int64_t MAX_PDU_SIZE = 16384;
+
+namespace nr::rgnb
+{
+
+BackhaulScheduler::BackhaulScheduler(int64_t bytesPerSecond, int quantum)
+    : m_capacity{bytesPerSecond, static_cast<uint64_t>(std::max<int64_t>(quantum, MAX_PDU_SIZE))},
+      m_quantum{quantum}, m_weights{}, m_flows{}, m_activeList{}
+{
+}
+
+void BackhaulScheduler::setWeight(int ueId, int weight)
+{
+    m_weights[ueId] = weight;
+}
+
+void BackhaulScheduler::enqueue(BackhaulPdu &&pdu)
+{
+    int ueId = pdu.ueId;
+
+    auto it = m_flows.find(ueId);
+    if (it == m_flows.end())
+    {
+        // A new flow joins the round with an empty deficit
+        it = m_flows.emplace(ueId, Flow{}).first;
+        it->second.weight = m_weights.count(ueId) ? m_weights[ueId] : 1;
+        m_activeList.push_back(ueId);
+    }
+
+    it->second.bytes += static_cast<size_t>(pdu.pdu.length());
+    it->second.queue.push_back(std::move(pdu));
+}
+
+void BackhaulScheduler::schedule(std::vector<BackhaulPdu> &output, int64_t byteBudget)
+{
+    while (!m_activeList.empty())
+    {
+        int ueId = m_activeList.front();
+        auto &flow = m_flows[ueId];
+
+        if (!flow.visited)
+        {
+            flow.deficit += static_cast<int64_t>(m_quantum) * flow.weight;
+            flow.visited = true;
+        }
+
+        while (!flow.queue.empty())
+        {
+            auto size = flow.queue.front().pdu.length();
+            if (size > flow.deficit)
+                break;
+
+            // Out of capacity or credit, the round continues from this flow the next time
+            if (size > byteBudget || !m_capacity.tryConsume(static_cast<uint64_t>(size)))
+                return;
+
+            byteBudget -= size;
+            flow.deficit -= size;
+            flow.bytes -= static_cast<size_t>(size);
+            output.push_back(std::move(flow.queue.front()));
+            flow.queue.pop_front();
+        }
+
+        m_activeList.pop_front();
+
+        if (flow.queue.empty())
+        {
+            m_flows.erase(ueId);
+        }
+        else
+        {
+            flow.visited = false;
+            m_activeList.push_back(ueId);
+        }
+    }
+}
+
+bool BackhaulScheduler::hasBacklog() const
+{
+    return !m_activeList.empty();
+}
+
+size_t BackhaulScheduler::queuedBytes(int ueId) const
+{
+    auto it = m_flows.find(ueId);
+    return it == m_flows.end() ? 0 : it->second.bytes;
+}
+
+} // namespace nr::rgnb
@@ -0,0 +1,61 @@
+//
+// This file is a part of UERANSIM project.
+// Copyright (c) 2023 ALİ GÜNGÖR.
+//
+// https://github.com/aligungr/UERANSIM/
+// See README, LICENSE, and CONTRIBUTING files for licensing details.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <unordered_map>
+#include <vector>
+
+#include <rgnb/gnbGtp/utils.hpp>
+#include <utils/octet_string.hpp>
+
+namespace nr::rgnb
+{
+
+struct BackhaulPdu
+{
+    int ueId{}; // downstream UE the PDU was received from
+    uint32_t bapContext{};
+    OctetString pdu{};
+};
+
+/* Deficit round robin over per-downstream-UE queues, paced by the upstream link capacity */
+class BackhaulScheduler
+{
+  private:
+    struct Flow
+    {
+        std::deque<BackhaulPdu> queue{};
+        size_t bytes{};
+        int64_t deficit{};
+        int weight{};
+        bool visited{};
+    };
+
+  private:
+    TokenBucket m_capacity;
+    int m_quantum;
+    std::unordered_map<int, int> m_weights;
+    std::unordered_map<int, Flow> m_flows;
+    std::deque<int> m_activeList;
+
+  public:
+    BackhaulScheduler(int64_t bytesPerSecond, int quantum);
+
+  public:
+    void setWeight(int ueId, int weight);
+    void enqueue(BackhaulPdu &&pdu);
+    void schedule(std::vector<BackhaulPdu> &output, int64_t byteBudget);
+
+    [[nodiscard]] bool hasBacklog() const;
+    [[nodiscard]] size_t queuedBytes(int ueId) const;
+};
+
+} // namespace nr::rgnb
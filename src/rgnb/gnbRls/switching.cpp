@@ -0,0 +1,78 @@
+//
+// This file is a part of UERANSIM project.
+// Copyright (c) 2023 ALİ GÜNGÖR.
+//
+// https://github.com/aligungr/UERANSIM/
+// See README, LICENSE, and CONTRIBUTING files for licensing details.
+//
+
+#include "switching.hpp"
+
+// Learned addresses not refreshed by uplink traffic within this time (ms) are forgotten
+static constexpr const int64_t ENTRY_LIFETIME = 30000;
+
+static uint32_t ReadAddress(const uint8_t *data)
+{
+    return static_cast<uint32_t>(data[0]) << 24 | static_cast<uint32_t>(data[1]) << 16 |
+           static_cast<uint32_t>(data[2]) << 8 | static_cast<uint32_t>(data[3]);
+}
+
+namespace nr::rgnb
+{
+
+LocalSwitch::LocalSwitch(std::vector<Ipv4Subnet> subnets) : m_subnets{std::move(subnets)}, m_entries{}
+{
+}
+
+std::optional<SwitchTarget> LocalSwitch::process(int ueId, int psi, const OctetString &packet, int64_t now)
+{
+    const uint8_t *data = packet.data();
+    if (packet.length() < 20 || (data[0] >> 4 & 0xF) != 4)
+        return std::nullopt;
+
+    uint32_t source = ReadAddress(data + 12);
+    uint32_t destination = ReadAddress(data + 16);
+
+    if (!isAllowed(source))
+        return std::nullopt;
+
+    // An address held by another live session is never taken over, so that a UE cannot attract someone else's traffic
+    auto it = m_entries.find(source);
+    if (it == m_entries.end() || (it->second.ueId == ueId && it->second.psi == psi) ||
+        now - it->second.lastSeen > ENTRY_LIFETIME)
+    {
+        m_entries[source] = Entry{ueId, psi, now};
+    }
+
+    if (!isAllowed(destination))
+        return std::nullopt;
+
+    it = m_entries.find(destination);
+    if (it == m_entries.end() || now - it->second.lastSeen > ENTRY_LIFETIME)
+        return std::nullopt;
+    if (it->second.ueId == ueId && it->second.psi == psi)
+        return std::nullopt;
+
+    return SwitchTarget{it->second.ueId, it->second.psi};
+}
+
+void LocalSwitch::removeUe(int ueId)
+{
+    for (auto it = m_entries.begin(); it != m_entries.end();)
+    {
+        if (it->second.ueId == ueId)
+            it = m_entries.erase(it);
+        else
+            ++it;
+    }
+}
+
+bool LocalSwitch::isAllowed(uint32_t address) const
+{
+    for (auto &subnet : m_subnets)
+        if (subnet.contains(address))
+            return true;
+    return false;
+}
+
+} // namespace nr::rgnb
@@ -0,0 +1,55 @@
+//
+// This file is a part of UERANSIM project.
+// Copyright (c) 2023 ALİ GÜNGÖR.
+//
+// https://github.com/aligungr/UERANSIM/
+// See README, LICENSE, and CONTRIBUTING files for licensing details.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+#include <rgnb/types.hpp>
+#include <utils/octet_string.hpp>
+
+namespace nr::rgnb
+{
+
+struct SwitchTarget
+{
+    int ueId{};
+    int psi{};
+};
+
+/* Hair-pins uplink packets between PDU sessions served by this node. UE addresses are learned from uplink traffic. */
+class LocalSwitch
+{
+  private:
+    struct Entry
+    {
+        int ueId{};
+        int psi{};
+        int64_t lastSeen{};
+    };
+
+  private:
+    std::vector<Ipv4Subnet> m_subnets;
+    std::unordered_map<uint32_t, Entry> m_entries; // by UE address
+
+  public:
+    explicit LocalSwitch(std::vector<Ipv4Subnet> subnets);
+
+  public:
+    /* Learns the source of the uplink packet, returns the local session the destination belongs to */
+    std::optional<SwitchTarget> process(int ueId, int psi, const OctetString &packet, int64_t now);
+    void removeUe(int ueId);
+
+  private:
+    [[nodiscard]] bool isAllowed(uint32_t address) const;
+};
+
+} // namespace nr::rgnb
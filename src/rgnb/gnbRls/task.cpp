@@ -8,42 +8,110 @@
 
 #include "task.hpp"
 
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+
 #include <rgnb/gnbGtp/task.hpp>
 #include <rgnb/gnbRrc/task.hpp>
+#include <rgnb/ueRls/task.hpp>
 #include <utils/common.hpp>
 #include <utils/random.hpp>
 
+static constexpr const int TIMER_ID_BACKHAUL_SCHEDULE = 1;
+static constexpr const int TIMER_PERIOD_BACKHAUL_SCHEDULE = 2;
+static constexpr const int TIMER_ID_OUTAGE_DRAIN = 2;
+static constexpr const int TIMER_PERIOD_OUTAGE_DRAIN = 10;
+static constexpr const int TIMER_ID_MAC_SLOT = 3;
+
+// Longest time the radio link is waited for in fused mode before queued messages are looked at again
+static constexpr const int FUSED_RECEIVE_TIMEOUT = 1;
+
+static constexpr const int CREDIT_STATUS_PERIOD = 100;
+static constexpr const int OUTAGE_DRAIN_BURST = 100;
+
+static int64_t CurrentTimeMicros()
+{
+    auto now = std::chrono::steady_clock::now().time_since_epoch();
+    return std::chrono::duration_cast<std::chrono::microseconds>(now).count();
+}
+
 namespace nr::rgnb
 {
 
-GnbRlsTask::GnbRlsTask(TaskBase *base) : m_base{base}
+GnbRlsTask::GnbRlsTask(TaskBase *base)
+    : m_base{base}, m_backhaulTimerArmed{}, m_childCredits{}, m_upstreamLimit{}, m_upstreamSent{},
+      m_lastCreditStatus{}, m_upstreamUp{}, m_drainTimerArmed{}, m_drainAllowance{}, m_lastDrain{},
+      m_macTimerArmed{}
 {
     m_logger = m_base->logBase->makeUniqueLogger("gnbRls");
     m_sti = Random::Mixed(base->gnbConfig->name).nextUL();
 
-    m_udpTask = new RlsUdpTask(base, m_sti, base->gnbConfig->phyLocation);
-    m_ctlTask = new RlsControlTask(base, m_sti);
+    m_acks = std::make_unique<rls::AckTracker>();
+    m_udpTask = new RlsUdpTask(base, m_sti, base->gnbConfig->phyLocation, m_acks.get());
+    m_ctlTask = new RlsControlTask(base, m_sti, m_acks.get());
 
     m_udpTask->initialize(m_ctlTask);
     m_ctlTask->initialize(this, m_udpTask);
+
+    if (base->gnbConfig->fusedRls)
+        setFused();
+
+    for (auto &route : base->gnbConfig->bapRoutes)
+        m_routing.addRoute(route.destination, route.nextHop);
+
+    // Every relay that sends upstream is scheduled, so that parent credit can hold traffic back
+    auto &backhaul = base->gnbConfig->backhaul;
+    if (backhaul.capacity > 0 || base->gnbConfig->bapDonor.has_value())
+    {
+        m_scheduler = std::make_unique<BackhaulScheduler>(static_cast<int64_t>(backhaul.capacity) * 1000 / 8,
+                                                          backhaul.quantum);
+        for (auto &weight : backhaul.weights)
+            m_scheduler->setWeight(weight.ueId, weight.weight);
+    }
+
+    if (!base->gnbConfig->localSwitching.empty())
+        m_localSwitch = std::make_unique<LocalSwitch>(base->gnbConfig->localSwitching);
+
+    if (backhaul.outageBuffer > 0 && base->gnbConfig->bapDonor.has_value())
+        m_outage = std::make_unique<OutageBuffer>(static_cast<size_t>(backhaul.outageBuffer), backhaul.outageMaxAge);
+
+    if (base->gnbConfig->mac.has_value())
+        m_mac = std::make_unique<MacScheduler>(*base->gnbConfig->mac, CurrentTimeMicros());
 }
 
 void GnbRlsTask::onStart()
 {
+    if (isFused())
+    {
+        m_ctlTask->startFused();
+        return;
+    }
+
     m_udpTask->start();
     m_ctlTask->start();
 }
 
 void GnbRlsTask::onLoop()
 {
-    auto msg = take();
-    if (!msg)
+    if (!isFused())
+    {
+        FusableTask::onLoop();
         return;
+    }
+
+    // The whole RLS stack runs on this thread, the radio link is polled in between messages and timers
+    runPending();
+    m_ctlTask->runPending();
+    m_udpTask->serve(FUSED_RECEIVE_TIMEOUT);
+}
 
-    switch (msg->msgType)
+void GnbRlsTask::handleMessage(NtsMessage &msg)
+{
+    switch (msg.msgType)
     {
     case NtsMessageType::GNB_RLS_TO_RLS: {
-        auto &w = dynamic_cast<NmGnbRlsToRls &>(*msg);
+        auto &w = dynamic_cast<NmGnbRlsToRls &>(msg);
         switch (w.present)
         {
         case NmGnbRlsToRls::SIGNAL_DETECTED: {
@@ -54,15 +122,37 @@ void GnbRlsTask::onLoop()
         }
         case NmGnbRlsToRls::SIGNAL_LOST: {
             m_logger->debug("UE[%d] signal lost", w.ueId);
+            m_routing.removeLink(w.ueId);
+            m_childCredits.erase(w.ueId);
+            if (m_localSwitch)
+                m_localSwitch->removeUe(w.ueId);
+            if (m_mac)
+                m_mac->removeUe(w.ueId);
+            break;
+        }
+        case NmGnbRlsToRls::SIGNAL_QUALITY: {
+            if (m_mac)
+                m_mac->setSignalQuality(w.ueId, w.dbm);
             break;
         }
         case NmGnbRlsToRls::UPLINK_DATA: {
-            // TODO: Decide whether to forward on RLS layer or through GTP tunnel
-            auto m = std::make_unique<NmGnbRlsToGtp>(NmGnbRlsToGtp::DATA_PDU_DELIVERY);
-            m->ueId = w.ueId;
-            m->psi = w.psi; //PDU Session identity
-            m->pdu = std::move(w.data);
-            m_base->gnbGtpTask->push(std::move(m));
+            // Uplink grants are emulated at the receiving side, the PDU is released once its slots are scheduled
+            if (m_mac)
+                scheduleMac(EMacDirection::UPLINK,
+                            MacPdu{w.ueId, false, static_cast<uint32_t>(w.psi), std::move(w.data)});
+            else
+                handleUplinkData(w.ueId, w.psi, std::move(w.data));
+            break;
+        }
+        case NmGnbRlsToRls::UPLINK_RELAY: {
+            if (m_mac)
+                scheduleMac(EMacDirection::UPLINK, MacPdu{w.ueId, true, w.bapContext, std::move(w.data)});
+            else
+                handleRelayPdu(w.ueId, w.bapContext, std::move(w.data));
+            break;
+        }
+        case NmGnbRlsToRls::CREDIT_STATUS: {
+            handleCreditStatus(w.ueId, w.credit);
             break;
         }
         case NmGnbRlsToRls::UPLINK_RRC: {
@@ -82,14 +172,14 @@ void GnbRlsTask::onLoop()
             break;
         }
         default: {
-            m_logger->unhandledNts(*msg);
+            m_logger->unhandledNts(msg);
             break;
         }
         }
         break;
     }
     case NtsMessageType::GNB_RRC_TO_RLS: {
-        auto &w = dynamic_cast<NmGnbRrcToRls &>(*msg);
+        auto &w = dynamic_cast<NmGnbRrcToRls &>(msg);
         switch (w.present)
         {
         case NmGnbRrcToRls::RRC_PDU_DELIVERY: {
@@ -98,39 +188,475 @@ void GnbRlsTask::onLoop()
             m->rrcChannel = w.channel;
             m->pduId = 0;
             m->data = std::move(w.pdu);
-            m_ctlTask->push(std::move(m));
+            m_ctlTask->deliver(std::move(m));
             break;
         }
         }
         break;
     }
     case NtsMessageType::GNB_GTP_TO_RLS: {
-        auto &w = dynamic_cast<NmGnbGtpToRls &>(*msg);
+        auto &w = dynamic_cast<NmGnbGtpToRls &>(msg);
         switch (w.present)
         {
         case NmGnbGtpToRls::DATA_PDU_DELIVERY: {
-            auto m = std::make_unique<NmGnbRlsToRls>(NmGnbRlsToRls::DOWNLINK_DATA);
-            m->ueId = w.ueId;
-            m->psi = w.psi;
-            m->data = std::move(w.pdu);
-            m_ctlTask->push(std::move(m));
+            handleDownlinkData(w.ueId, w.psi, std::move(w.pdu));
+            break;
+        }
+        }
+        break;
+    }
+    case NtsMessageType::TIMER_EXPIRED: {
+        auto &w = dynamic_cast<NmTimerExpired &>(msg);
+        if (w.timerId == TIMER_ID_BACKHAUL_SCHEDULE)
+        {
+            m_backhaulTimerArmed = false;
+            serviceBackhaul();
+        }
+        else if (w.timerId == TIMER_ID_OUTAGE_DRAIN)
+        {
+            m_drainTimerArmed = false;
+            drainOutage();
+        }
+        else if (w.timerId == TIMER_ID_MAC_SLOT)
+        {
+            m_macTimerArmed = false;
+            runMac();
+        }
+        break;
+    }
+    case NtsMessageType::RGNB_RLS_TO_RLS: {
+        auto &w = dynamic_cast<NmRgnbRlsToRls &>(msg);
+        switch (w.present)
+        {
+        case NmRgnbRlsToRls::DOWNLINK_RELAY: {
+            rls::BapHeader header{};
+            if (!rls::DecodeBapHeader(w.pdu, header) || !header.isData)
+            {
+                m_logger->err("Invalid BAP PDU received from upstream");
+                break;
+            }
+            routeRelayPdu(header.destination, w.bapContext, std::move(w.pdu), 0);
+            break;
+        }
+        case NmRgnbRlsToRls::UPSTREAM_CREDIT: {
+            handleUpstreamCredit(w.credit);
+            break;
+        }
+        case NmRgnbRlsToRls::UPSTREAM_CHANGED: {
+            handleUpstreamChange();
+            break;
+        }
+        case NmRgnbRlsToRls::UPSTREAM_LOST: {
+            handleUpstreamLoss();
+            break;
+        }
+        default: {
+            m_logger->unhandledNts(msg);
             break;
         }
         }
         break;
     }
     default:
-        m_logger->unhandledNts(*msg);
+        m_logger->unhandledNts(msg);
         break;
     }
 }
 
 void GnbRlsTask::onQuit()
 {
-    m_udpTask->quit();
-    m_ctlTask->quit();
+    if (isFused())
+    {
+        m_ctlTask->quitFused();
+    }
+    else
+    {
+        m_udpTask->quit();
+        m_ctlTask->quit();
+    }
     delete m_udpTask;
     delete m_ctlTask;
 }
 
+void GnbRlsTask::handleUplinkData(int ueId, int psi, OctetString &&data)
+{
+    if (switchLocally(ueId, psi, data))
+        return;
+
+    auto &config = *m_base->gnbConfig;
+    if (!config.bapAddress.has_value() || !config.bapDonor.has_value())
+    {
+        // This node terminates the user plane
+        auto m = std::make_unique<NmGnbRlsToGtp>(NmGnbRlsToGtp::DATA_PDU_DELIVERY);
+        m->ueId = ueId;
+        m->psi = psi; //PDU Session identity
+        m->pdu = std::move(data);
+        m_base->gnbGtpTask->push(std::move(m));
+        return;
+    }
+
+    // Access relay, the packet is routed towards the donor
+    OctetString pdu;
+    rls::EncodeBapHeader(rls::BapHeader{true, *config.bapDonor, 0}, pdu);
+    pdu.append(data);
+
+    sendUpstream(ueId, rls::EncodeBapContext(rls::BapContext{*config.bapAddress, ueId, psi}), std::move(pdu));
+}
+
+void GnbRlsTask::handleDownlinkData(int ueId, int psi, OctetString &&data)
+{
+    if (m_remoteUes.isRemote(ueId))
+    {
+        auto ctx = m_remoteUes.getContext(ueId, psi);
+
+        OctetString pdu;
+        rls::EncodeBapHeader(rls::BapHeader{true, ctx.source, 0}, pdu);
+        pdu.append(data);
+
+        routeRelayPdu(ctx.source, rls::EncodeBapContext(ctx), std::move(pdu), 0);
+        return;
+    }
+
+    sendDownlink(ueId, false, static_cast<uint32_t>(psi), std::move(data));
+}
+
+bool GnbRlsTask::switchLocally(int ueId, int psi, OctetString &data)
+{
+    if (!m_localSwitch)
+        return false;
+
+    auto target = m_localSwitch->process(ueId, psi, data, utils::CurrentTimeMillis());
+    if (!target.has_value())
+        return false;
+
+    handleDownlinkData(target->ueId, target->psi, std::move(data));
+    return true;
+}
+
+void GnbRlsTask::handleRelayPdu(int ueId, uint32_t bapContext, OctetString &&pdu)
+{
+    rls::BapHeader header{};
+    if (!rls::DecodeBapHeader(pdu, header))
+    {
+        m_logger->err("Invalid BAP PDU received from UE[%d]", ueId);
+        return;
+    }
+
+    auto ctx = rls::DecodeBapContext(bapContext);
+    if (!header.isData)
+    {
+        // Control PDUs are hop-local, the only one used is the announcement of a directly attached relay
+        m_logger->debug("BAP neighbour[%d] attached as UE[%d]", ctx.source, ueId);
+        m_routing.addNeighbour(ctx.source, ueId);
+
+        if (m_base->gnbConfig->backhaul.creditBuffer > 0)
+        {
+            m_childCredits[ueId] = {};
+            grantCredit(ueId, true);
+        }
+        return;
+    }
+
+    auto credit = m_childCredits.find(ueId);
+    if (credit != m_childCredits.end())
+        credit->second.received += static_cast<uint64_t>(pdu.length());
+
+    m_routing.learn(ctx.source, ueId);
+    routeRelayPdu(header.destination, bapContext, std::move(pdu), ueId);
+
+    if (credit != m_childCredits.end())
+        grantCredit(ueId, false);
+}
+
+void GnbRlsTask::routeRelayPdu(int destination, uint32_t bapContext, OctetString &&pdu, int fromUeId)
+{
+    auto &config = *m_base->gnbConfig;
+    if (config.bapAddress.has_value() && destination == *config.bapAddress)
+    {
+        deliverRelayPdu(rls::DecodeBapContext(bapContext), std::move(pdu));
+        return;
+    }
+
+    int nextHop = m_routing.lookup(destination);
+    if (nextHop != 0)
+    {
+        // Forwarded as is, only the adaptation header is inspected
+        sendDownlink(nextHop, true, bapContext, std::move(pdu));
+        return;
+    }
+
+    // fromUeId is 0 for PDUs coming from upstream or originated by this node
+    if (fromUeId != 0 && config.bapDonor.has_value())
+    {
+        sendUpstream(fromUeId, bapContext, std::move(pdu));
+        return;
+    }
+
+    m_logger->err("No route to BAP address[%d]", destination);
+}
+
+void GnbRlsTask::deliverRelayPdu(const rls::BapContext &ctx, OctetString &&pdu)
+{
+    auto data = pdu.subCopy(rls::BAP_HEADER_SIZE);
+
+    if (ctx.source == *m_base->gnbConfig->bapAddress)
+    {
+        // Downlink packet for a UE attached to this relay
+        sendDownlink(ctx.ueId, false, static_cast<uint32_t>(ctx.psi), std::move(data));
+    }
+    else
+    {
+        // Uplink packet of a UE served by a descendant relay
+        int ueId = m_remoteUes.getOrAssign(ctx);
+        if (switchLocally(ueId, ctx.psi, data))
+            return;
+
+        auto m = std::make_unique<NmGnbRlsToGtp>(NmGnbRlsToGtp::DATA_PDU_DELIVERY);
+        m->ueId = ueId;
+        m->psi = ctx.psi;
+        m->pdu = std::move(data);
+        m_base->gnbGtpTask->push(std::move(m));
+    }
+}
+
+void GnbRlsTask::sendUpstream(int ueId, uint32_t bapContext, OctetString &&pdu)
+{
+    // Held traffic goes out first, new packets queue up behind it until the buffer is drained
+    if (m_outage && (!m_upstreamUp || !m_outage->empty()))
+    {
+        size_t evicted = m_outage->store(BackhaulPdu{ueId, bapContext, std::move(pdu)}, utils::CurrentTimeMillis());
+        if (evicted > 0)
+            m_logger->debug("Outage buffer full, %d PDUs dropped", static_cast<int>(evicted));
+        return;
+    }
+
+    if (m_scheduler)
+    {
+        m_scheduler->enqueue(BackhaulPdu{ueId, bapContext, std::move(pdu)});
+        serviceBackhaul();
+        return;
+    }
+
+    auto m = std::make_unique<NmRgnbRlsToRls>(NmRgnbRlsToRls::UPLINK_RELAY);
+    m->bapContext = bapContext;
+    m->pdu = std::move(pdu);
+    m_base->ueRlsTask->push(std::move(m));
+}
+
+void GnbRlsTask::serviceBackhaul()
+{
+    // Without a parent the scheduled traffic would be lost, it stays queued until reattachment
+    if (m_outage && !m_upstreamUp)
+        return;
+
+    int64_t budget = INT64_MAX;
+    if (m_upstreamLimit.has_value())
+        budget = *m_upstreamLimit > m_upstreamSent ? static_cast<int64_t>(*m_upstreamLimit - m_upstreamSent) : 0;
+
+    std::vector<BackhaulPdu> scheduled;
+    m_scheduler->schedule(scheduled, budget);
+
+    for (auto &item : scheduled)
+    {
+        m_upstreamSent += static_cast<uint64_t>(item.pdu.length());
+
+        auto m = std::make_unique<NmRgnbRlsToRls>(NmRgnbRlsToRls::UPLINK_RELAY);
+        m->bapContext = item.bapContext;
+        m->pdu = std::move(item.pdu);
+        m_base->ueRlsTask->push(std::move(m));
+    }
+
+    // Freed buffer space is passed on to the children
+    if (!scheduled.empty())
+    {
+        for (auto &child : m_childCredits)
+            grantCredit(child.first, false);
+    }
+
+    if (!m_scheduler->hasBacklog())
+        return;
+
+    // Out of parent credit, report what has been sent so that the parent can recover lost grants
+    int64_t current = utils::CurrentTimeMillis();
+    if (m_upstreamLimit.has_value() && m_upstreamSent >= *m_upstreamLimit &&
+        current - m_lastCreditStatus > CREDIT_STATUS_PERIOD)
+    {
+        m_lastCreditStatus = current;
+
+        auto m = std::make_unique<NmRgnbRlsToRls>(NmRgnbRlsToRls::CREDIT_STATUS);
+        m->credit = m_upstreamSent;
+        m_base->ueRlsTask->push(std::move(m));
+    }
+
+    // The timer only runs while some downstream UE is waiting for capacity or credit
+    if (!m_backhaulTimerArmed)
+    {
+        m_backhaulTimerArmed = true;
+        setTimer(TIMER_ID_BACKHAUL_SCHEDULE, TIMER_PERIOD_BACKHAUL_SCHEDULE);
+    }
+}
+
+void GnbRlsTask::grantCredit(int ueId, bool force)
+{
+    auto &credit = m_childCredits[ueId];
+
+    auto buffer = static_cast<uint64_t>(m_base->gnbConfig->backhaul.creditBuffer);
+    auto queued = m_scheduler ? std::min(static_cast<uint64_t>(m_scheduler->queuedBytes(ueId)), buffer) : 0;
+    uint64_t limit = credit.received + buffer - queued;
+
+    // Grants are only sent once a meaningful part of the buffer has been freed
+    if (!force && limit < credit.advertised + buffer / 4)
+        return;
+
+    credit.advertised = limit;
+
+    auto m = std::make_unique<NmGnbRlsToRls>(NmGnbRlsToRls::DOWNLINK_CREDIT);
+    m->ueId = ueId;
+    m->credit = limit;
+    m_ctlTask->deliver(std::move(m));
+}
+
+void GnbRlsTask::handleCreditStatus(int ueId, uint64_t sentBytes)
+{
+    auto it = m_childCredits.find(ueId);
+    if (it == m_childCredits.end())
+        return;
+
+    // Bytes lost on the way would otherwise never be given back to the child
+    it->second.received = std::max(it->second.received, sentBytes);
+    grantCredit(ueId, true);
+}
+
+void GnbRlsTask::handleUpstreamCredit(uint64_t creditLimit)
+{
+    m_upstreamLimit = creditLimit;
+    if (m_scheduler)
+        serviceBackhaul();
+}
+
+void GnbRlsTask::handleUpstreamChange()
+{
+    // The new parent may not support flow control, and its counters start from scratch
+    m_upstreamLimit = std::nullopt;
+    m_upstreamSent = 0;
+    m_upstreamUp = true;
+    if (m_scheduler)
+        serviceBackhaul();
+
+    if (m_outage && !m_outage->empty())
+    {
+        m_logger->info("Upstream link re-established, releasing %d held bytes", static_cast<int>(m_outage->size()));
+        m_drainAllowance = 0;
+        m_lastDrain = utils::CurrentTimeMillis();
+        drainOutage();
+    }
+}
+
+void GnbRlsTask::handleUpstreamLoss()
+{
+    if (!m_upstreamUp)
+        return;
+
+    m_upstreamUp = false;
+    if (m_outage)
+        m_logger->warn("Upstream link lost, holding upstream traffic");
+}
+
+void GnbRlsTask::drainOutage()
+{
+    if (!m_upstreamUp || m_outage->empty())
+        return;
+
+    int64_t current = utils::CurrentTimeMillis();
+
+    size_t budget = SIZE_MAX;
+    int rate = m_base->gnbConfig->backhaul.drainRate;
+    if (rate > 0)
+    {
+        // 1 kbit/s is 1 byte per 8 ms, the allowance is capped so that a late timer does not release a burst
+        int64_t burst = std::max(static_cast<int64_t>(rate) * OUTAGE_DRAIN_BURST / 8, int64_t{65535});
+        m_drainAllowance = std::min(m_drainAllowance + (current - m_lastDrain) * rate / 8, burst);
+        budget = static_cast<size_t>(m_drainAllowance);
+    }
+    m_lastDrain = current;
+
+    std::vector<BackhaulPdu> drained;
+    m_outage->drain(current, budget, drained);
+
+    for (auto &item : drained)
+    {
+        m_drainAllowance -= item.pdu.length();
+        m_scheduler->enqueue(std::move(item));
+    }
+    if (!drained.empty())
+        serviceBackhaul();
+
+    if (!m_outage->empty() && !m_drainTimerArmed)
+    {
+        m_drainTimerArmed = true;
+        setTimer(TIMER_ID_OUTAGE_DRAIN, TIMER_PERIOD_OUTAGE_DRAIN);
+    }
+}
+
+void GnbRlsTask::sendDownlink(int ueId, bool relay, uint32_t context, OctetString &&data)
+{
+    if (m_mac)
+    {
+        scheduleMac(EMacDirection::DOWNLINK, MacPdu{ueId, relay, context, std::move(data)});
+        return;
+    }
+
+    deliverDownlink(ueId, relay, context, std::move(data));
+}
+
+void GnbRlsTask::deliverDownlink(int ueId, bool relay, uint32_t context, OctetString &&data)
+{
+    auto m = std::make_unique<NmGnbRlsToRls>(relay ? NmGnbRlsToRls::DOWNLINK_RELAY : NmGnbRlsToRls::DOWNLINK_DATA);
+    m->ueId = ueId;
+    if (relay)
+        m->bapContext = context;
+    else
+        m->psi = static_cast<int>(context);
+    m->data = std::move(data);
+    m_ctlTask->deliver(std::move(m));
+}
+
+void GnbRlsTask::scheduleMac(EMacDirection direction, MacPdu &&pdu)
+{
+    int ueId = pdu.ueId;
+    if (!m_mac->enqueue(direction, std::move(pdu), CurrentTimeMicros()))
+        m_logger->debug("MAC queue of UE[%d] full, PDU dropped", ueId);
+
+    // PDUs wait for the next slot, handled with the ones of the same slot by the timer
+    if (!m_macTimerArmed)
+    {
+        m_macTimerArmed = true;
+        setTimer(TIMER_ID_MAC_SLOT, std::max(1, m_mac->slotDuration() / 1000));
+    }
+}
+
+void GnbRlsTask::runMac()
+{
+    std::vector<MacPdu> uplink, downlink;
+    m_mac->run(CurrentTimeMicros(), uplink, downlink);
+
+    for (auto &item : uplink)
+    {
+        if (item.relay)
+            handleRelayPdu(item.ueId, item.context, std::move(item.pdu));
+        else
+            handleUplinkData(item.ueId, static_cast<int>(item.context), std::move(item.pdu));
+    }
+
+    for (auto &item : downlink)
+        deliverDownlink(item.ueId, item.relay, item.context, std::move(item.pdu));
+
+    // The timer only runs while the cell has something to schedule
+    if (m_mac->isBusy() && !m_macTimerArmed)
+    {
+        m_macTimerArmed = true;
+        setTimer(TIMER_ID_MAC_SLOT, std::max(1, m_mac->slotDuration() / 1000));
+    }
+}
+
 } // namespace nr::rgnb
@@ -9,14 +9,21 @@
 #pragma once
 
 #include "ctl_task.hpp"
+#include "mac.hpp"
+#include "outage.hpp"
+#include "routing.hpp"
+#include "scheduler.hpp"
+#include "switching.hpp"
 #include "udp_task.hpp"
 
 #include <memory>
+#include <optional>
 #include <thread>
 #include <unordered_map>
 #include <vector>
 
 #include <rgnb/nts.hpp>
+#include <rgnb/fused.hpp>
 #include <rgnb/types.hpp>
 #include <lib/rls/rls_pdu.hpp>
 #include <lib/udp/server_task.hpp>
@@ -26,17 +33,44 @@
 namespace nr::rgnb
 {
 
-class GnbRlsTask : public NtsTask
+class GnbRlsTask : public FusableTask
 {
   private:
     TaskBase *m_base;
     std::unique_ptr<Logger> m_logger;
 
+    std::unique_ptr<rls::AckTracker> m_acks; // shared by the control and the radio link task
     RlsUdpTask *m_udpTask;
     RlsControlTask *m_ctlTask;
 
     uint64_t m_sti;
 
+    BapRoutingTable m_routing;
+    RemoteUeTable m_remoteUes;
+    std::unique_ptr<BackhaulScheduler> m_scheduler;
+    bool m_backhaulTimerArmed;
+
+    struct ChildCredit
+    {
+        uint64_t received{};   // RELAY bytes received from the child
+        uint64_t advertised{}; // last credit limit sent to the child
+    };
+    std::unordered_map<int, ChildCredit> m_childCredits; // flow controlled downstream relays
+    std::optional<uint64_t> m_upstreamLimit;             // credit limit granted by the parent, if any
+    uint64_t m_upstreamSent;
+    int64_t m_lastCreditStatus;
+
+    std::unique_ptr<LocalSwitch> m_localSwitch;
+
+    std::unique_ptr<OutageBuffer> m_outage; // holds upstream traffic while the parent is lost
+    bool m_upstreamUp;
+    bool m_drainTimerArmed;
+    int64_t m_drainAllowance;
+    int64_t m_lastDrain;
+
+    std::unique_ptr<MacScheduler> m_mac; // slot scheduling of the user plane of the cell
+    bool m_macTimerArmed;
+
     friend class GnbCmdHandler;
 
   public:
@@ -46,7 +80,28 @@ class GnbRlsTask : public NtsTask
   protected:
     void onStart() override;
     void onLoop() override;
+    void handleMessage(NtsMessage &msg) override;
     void onQuit() override;
+
+  private:
+    void handleUplinkData(int ueId, int psi, OctetString &&data);
+    void handleDownlinkData(int ueId, int psi, OctetString &&data);
+    bool switchLocally(int ueId, int psi, OctetString &data);
+    void handleRelayPdu(int ueId, uint32_t bapContext, OctetString &&pdu);
+    void routeRelayPdu(int destination, uint32_t bapContext, OctetString &&pdu, int fromUeId);
+    void deliverRelayPdu(const rls::BapContext &ctx, OctetString &&pdu);
+    void sendUpstream(int ueId, uint32_t bapContext, OctetString &&pdu);
+    void serviceBackhaul();
+    void grantCredit(int ueId, bool force);
+    void handleCreditStatus(int ueId, uint64_t sentBytes);
+    void handleUpstreamCredit(uint64_t creditLimit);
+    void handleUpstreamChange();
+    void handleUpstreamLoss();
+    void drainOutage();
+    void sendDownlink(int ueId, bool relay, uint32_t context, OctetString &&data);
+    void deliverDownlink(int ueId, bool relay, uint32_t context, OctetString &&data);
+    void scheduleMac(EMacDirection direction, MacPdu &&pdu);
+    void runMac();
 };
 
 } // namespace nr::rgnb
@@ -0,0 +1,105 @@
+//
+// This file is a part of UERANSIM project.
+// Copyright (c) 2023 ALİ GÜNGÖR.
+//
+// https://github.com/aligungr/UERANSIM/
+// See README, LICENSE, and CONTRIBUTING files for licensing details.
+//
+
+#include "test.hpp"
+#include "mac.hpp"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Checks of the HARQ accounting of the MAC scheduler emulation, with PDUs that span several transport blocks. The
+// scheduler runs on a virtual clock with a fixed seed, so every run makes the same decisions.
+
+static constexpr int UE_ID = 1;
+static constexpr int PDU_SIZE = 1000; // bytes, at the default CQI a slot of 10 PRBs carries 280 of them
+static constexpr int PRBS = 10;
+static constexpr int SLOT_DURATION = 1000; // us
+static constexpr int MAX_SLOTS = 100000;
+
+namespace nr::rgnb
+{
+
+static const Json *FindChild(const Json &json, const std::string &key)
+{
+    for (auto &child : json)
+        if (child.first == key)
+            return &child.second;
+    return nullptr;
+}
+
+static int64_t DroppedPdus(const MacScheduler &mac)
+{
+    auto json = mac.toJson();
+    auto *downlink = FindChild(json, "downlink");
+    auto *ues = downlink ? FindChild(*downlink, "ues") : nullptr;
+    if (ues == nullptr || ues->begin() == ues->end())
+        return -1;
+    auto *dropped = FindChild(ues->begin()->second, "dropped-pdus");
+    return dropped ? std::stoll(dropped->str()) : -1;
+}
+
+/* maxDelivered is the most PDUs that may get through when every PDU needs all of its blocks to be received */
+static void RunScenario(const char *name, double bler, int harqMaxTx, int count, int maxDelivered)
+{
+    MacConfig config{};
+    config.slotDuration = SLOT_DURATION;
+    config.prbs = PRBS;
+    config.bler = bler;
+    config.harqRtt = 4;
+    config.harqMaxTx = harqMaxTx;
+    config.seed = 1;
+
+    MacScheduler mac{config, 0};
+    for (int i = 0; i < count; i++)
+    {
+        MacPdu pdu{};
+        pdu.ueId = UE_ID;
+        pdu.context = static_cast<uint32_t>(i);
+        pdu.pdu = OctetString::FromSpare(PDU_SIZE);
+        mac.enqueue(EMacDirection::DOWNLINK, std::move(pdu), 0);
+    }
+
+    std::vector<int> deliveries(static_cast<size_t>(count));
+    int64_t now = 0;
+    for (int slot = 0; slot < MAX_SLOTS && mac.isBusy(); slot++)
+    {
+        now += SLOT_DURATION;
+
+        std::vector<MacPdu> uplink, downlink;
+        mac.run(now, uplink, downlink);
+        for (auto &pdu : downlink)
+            deliveries[pdu.context]++;
+    }
+
+    int delivered = 0, duplicates = 0;
+    for (int item : deliveries)
+    {
+        delivered += item != 0 ? 1 : 0;
+        duplicates += item > 1 ? item - 1 : 0;
+    }
+    int64_t dropped = DroppedPdus(mac);
+
+    bool passed = !mac.isBusy() && duplicates == 0 && delivered + dropped == count && delivered <= maxDelivered;
+    printf("%-40s  delivered %4d/%d  dropped %4lld  duplicates %3d  %s\n", name, delivered, count,
+           static_cast<long long>(dropped), duplicates, passed ? "OK" : "FAILED");
+    fflush(stdout);
+}
+
+void macTestMain()
+{
+    printf("MAC HARQ checks: PDUs of %d bytes over transport blocks of %d PRBs\n", PDU_SIZE, PRBS);
+
+    RunScenario("no loss", 0.0, 4, 200, 200);
+    // Every PDU is delivered or dropped once, whatever block of it fails
+    RunScenario("BLER 0.3, up to 4 transmissions", 0.3, 4, 200, 200);
+    // A PDU spans 4 or 5 blocks, so about one in 20 survives; counting only its last block lets half of them through
+    RunScenario("BLER 0.5, no retransmission", 0.5, 1, 200, 50);
+}
+
+} // namespace nr::rgnb
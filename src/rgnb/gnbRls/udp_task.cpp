@@ -11,7 +11,6 @@
 #include <cmath>
 #include <cstdint>
 #include <cstring>
-#include <set>
 
 #include <rgnb/nts.hpp>
 #include <utils/common.hpp>
@@ -20,9 +19,8 @@
 
 static constexpr const int BUFFER_SIZE = 16384;
 
-static constexpr const int LOOP_PERIOD = 1000;
 static constexpr const int RECEIVE_TIMEOUT = 200;
-static constexpr const int HEARTBEAT_THRESHOLD = 2000; // (LOOP_PERIOD + RECEIVE_TIMEOUT)'dan büyük olmalı
+static constexpr const int LIVENESS_TICK = 100; // granularity of the heartbeat timeouts
 
 static constexpr const int MIN_ALLOWED_DBM = -120;
 
@@ -41,14 +39,20 @@ static int EstimateSimulatedDbm(const Vector3 &myPos, const Vector3 &uePos)
 namespace nr::rgnb
 {
 
-RlsUdpTask::RlsUdpTask(TaskBase *base, uint64_t sti, Vector3 phyLocation)
-    : m_server{}, m_ctlTask{}, m_sti{sti}, m_phyLocation{phyLocation}, m_lastLoop{}, m_stiToUe{}, m_ueMap{}, m_newIdCounter{}
+RlsUdpTask::RlsUdpTask(TaskBase *base, uint64_t sti, Vector3 phyLocation, rls::AckTracker *acks)
+    : m_transport{}, m_ctlTask{}, m_acks{acks}, m_sti{sti}, m_phyLocation{phyLocation}, m_now{}, m_stiToUe{},
+      m_ueMap{}, m_ueAddresses{}, m_ueIds{},
+      m_liveness{LIVENESS_TICK, rls::HeartbeatTimeout(rls::HEARTBEAT_MAX_INTERVAL)}, m_lostUes{}, m_newIdCounter{}
 {
     m_logger = base->logBase->makeUniqueLogger("rls-udp");
 
     try
     {
-        m_server = new udp::UdpServer(base->gnbConfig->linkIp, cons::RadioLinkPort);
+        m_transport = rls::RlsTransport::Create(base->gnbConfig->linkTransport, base->gnbConfig->linkIp,
+                                                cons::RadioLinkPort);
+        if (base->gnbConfig->channel)
+            m_transport = std::make_unique<rls::ChannelTransport>(std::move(m_transport), *base->gnbConfig->channel,
+                                                                  static_cast<uint64_t>(base->gnbConfig->nci) << 1);
     }
     catch (const LibError &e)
     {
@@ -64,122 +68,289 @@ void RlsUdpTask::onStart()
 
 void RlsUdpTask::onLoop()
 {
-    auto current = utils::CurrentTimeMillis();
-    if (current - m_lastLoop > LOOP_PERIOD)
-    {
-        m_lastLoop = current;
-        heartbeatCycle(current);
-    }
+    serve(RECEIVE_TIMEOUT);
+}
 
+void RlsUdpTask::serve(int receiveTimeout)
+{
     uint8_t buffer[BUFFER_SIZE];
     InetAddress peerAddress;
 
-    int size = m_server->Receive(buffer, BUFFER_SIZE, RECEIVE_TIMEOUT, peerAddress);
+    int size = m_transport->receive(buffer, BUFFER_SIZE, receiveTimeout, peerAddress);
+
+    // A single clock read per loop, for the liveness of both the lost UEs and the sender
+    m_now = utils::CurrentTimeMillis();
+    heartbeatCycle(m_now);
+
     if (size > 0)
-    {
-        auto rlsMsg = rls::DecodeRlsMessage(OctetView{buffer, static_cast<size_t>(size)});
-        if (rlsMsg == nullptr)
-            m_logger->err("Unable to decode RLS message");
-        else
-            receiveRlsPdu(peerAddress, std::move(rlsMsg));
-    }
+        receive(peerAddress, buffer, static_cast<size_t>(size));
 }
 
 void RlsUdpTask::onQuit()
 {
-    delete m_server;
+    m_transport.reset();
 }
 
-void RlsUdpTask::receiveRlsPdu(const InetAddress &addr, std::unique_ptr<rls::RlsMessage> &&msg)
+void RlsUdpTask::receive(const InetAddress &addr, const uint8_t *data, size_t size)
 {
-    if (msg->msgType == rls::EMessageType::HEARTBEAT) // Rls Message is a heartbeat message
+    // Heartbeats and user PDUs are decoded in place, the PDU is copied out of the buffer only if its UE is known
+    auto msgType = rls::PeekRlsMessageType(data, size);
+    if (msgType == rls::EMessageType::HEARTBEAT)
     {
-        int dbm = EstimateSimulatedDbm(m_phyLocation, ((const rls::RlsHeartBeat &)*msg).simPos);
-        if (dbm < MIN_ALLOWED_DBM)
-        {
-            // if the simulated signal strength is such low, then ignore this message
-            return;
-        }
+        rls::RlsHeartBeatView heartbeat{};
+        if (rls::DecodeRlsHeartBeat(data, size, heartbeat))
+            receiveHeartbeat(addr, heartbeat);
+        else
+            m_logger->err("Unable to decode RLS message");
+        return;
+    }
 
-        if (m_stiToUe.count(msg->sti)) // sti is already known
+    if (msgType == rls::EMessageType::PDU_TRANSMISSION)
+    {
+        rls::RlsPduTransmissionView pdu{};
+        if (!rls::DecodeRlsPduTransmission(data, size, pdu))
         {
-            int ueId = m_stiToUe[msg->sti];
-            m_ueMap[ueId].address = addr;
-            m_ueMap[ueId].lastSeen = utils::CurrentTimeMillis();
+            m_logger->err("Unable to decode RLS message");
+            return;
         }
-        else    // sti is not known yet, create a new UE in the map, register it by pushing a message up a layer with SIGNAL DETECTED
-        {
-            int ueId = ++m_newIdCounter;
 
-            m_stiToUe[msg->sti] = ueId;
-            m_ueMap[ueId].address = addr;
-            m_ueMap[ueId].lastSeen = utils::CurrentTimeMillis();
+        int ueId = acceptFromUe(pdu.sti, pdu.ack);
+        if (ueId == 0)
+            return;
 
-            auto w = std::make_unique<NmGnbRlsToRls>(NmGnbRlsToRls::SIGNAL_DETECTED);
-            w->ueId = ueId;
-            m_ctlTask->push(std::move(w));
-        }
+        auto w = std::make_unique<NmGnbRlsToRls>(NmGnbRlsToRls::RECEIVE_RLS_MESSAGE);
+        w->ueId = ueId;
+        w->msg = std::make_unique<rls::RlsPduTransmission>(pdu.toMessage());
+        m_ctlTask->deliver(std::move(w));
+        return;
+    }
 
-        // send an acknowledgement back to the sender
-        rls::RlsHeartBeatAck ack{m_sti};
-        ack.dbm = dbm;
+    auto rlsMsg = rls::DecodeRlsMessage(data, size);
+    if (rlsMsg == nullptr)
+        m_logger->err("Unable to decode RLS message");
+    else
+        receiveRlsPdu(addr, std::move(rlsMsg));
+}
 
-        sendRlsPdu(addr, ack);
+void RlsUdpTask::receiveHeartbeat(const InetAddress &addr, const rls::RlsHeartBeatView &heartbeat)
+{
+    int dbm = EstimateSimulatedDbm(m_phyLocation, heartbeat.simPos);
+    if (dbm < MIN_ALLOWED_DBM)
+    {
+        // if the simulated signal strength is such low, then ignore this message
         return;
     }
 
-    // message is not a heartbeat and the sti is not recognized.
-    if (!m_stiToUe.count(msg->sti))
+    m_transport->setLinkQuality(heartbeat.sti, dbm);
+    int ueId = handleHeartbeat(addr, heartbeat.sti, heartbeat.interval, dbm, heartbeat.session);
+    if (ueId == 0)
+        return;
+
+    if (heartbeat.ack)
+        m_acks->acknowledge(ueId, *heartbeat.ack);
+
+    // send an acknowledgement back to the sender
+    rls::RlsHeartBeatAck ack{m_sti};
+    ack.dbm = dbm;
+    ack.session = heartbeat.session;
+
+    sendRlsPdu(addr, ack, ueId);
+}
+
+void RlsUdpTask::receiveRlsPdu(const InetAddress &addr, std::unique_ptr<rls::RlsMessage> &&msg)
+{
+    if (msg->msgType == rls::EMessageType::HEARTBEAT_AGGREGATE)
     {
-        // if no HB received yet, and the message is not HB, then ignore the message
+        // Heartbeats of the UEs of a single process, acknowledged together
+        rls::RlsHeartBeatAckAggregate ack{m_sti};
+        for (auto &entry : ((const rls::RlsHeartBeatAggregate &)*msg).entries)
+        {
+            int dbm = EstimateSimulatedDbm(m_phyLocation, entry.simPos);
+            if (dbm < MIN_ALLOWED_DBM)
+                continue;
+
+            // The UEs of the process share the address of the aggregate, their own traffic comes from their ports
+            m_transport->setLinkQuality(entry.sti, dbm);
+            if (handleHeartbeat(addr.withPort(entry.port), entry.sti, entry.interval, dbm, 0) == 0)
+                continue;
+            ack.entries.push_back(rls::RlsHeartBeatAckEntry{entry.sti, dbm});
+        }
+
+        if (!ack.entries.empty())
+            sendRlsPdu(addr, ack, 0);
         return;
     }
 
-    // RlsPdu is not a heartbeat but the sti is recognized
-    // creates
+    int ueId = acceptFromUe(msg->sti, msg->ack);
+    if (ueId == 0)
+        return;
+
     auto w = std::make_unique<NmGnbRlsToRls>(NmGnbRlsToRls::RECEIVE_RLS_MESSAGE);
-    w->ueId = m_stiToUe[msg->sti];
+    w->ueId = ueId;
     w->msg = std::move(msg);
-    m_ctlTask->push(std::move(w));
+    m_ctlTask->deliver(std::move(w));
 }
 
-void RlsUdpTask::sendRlsPdu(const InetAddress &addr, const rls::RlsMessage &msg)
+int RlsUdpTask::acceptFromUe(uint64_t sti, const std::optional<rls::RlsAckBlock> &ack)
 {
-    OctetString stream;
-    rls::EncodeRlsMessage(msg, stream);
+    auto it = m_stiToUe.find(sti);
+
+    // message is not a heartbeat and the sti is not recognized.
+    if (it == m_stiToUe.end())
+    {
+        // if no HB received yet, and the message is not HB, then ignore the message
+        return 0;
+    }
 
-    m_server->Send(addr, stream.data(), static_cast<size_t>(stream.length()));
+    // RlsPdu is not a heartbeat but the sti is recognized, any traffic of the UE keeps it alive
+    int ueId = it->second;
+    auto &ue = m_ueMap[ueId];
+    if (ue.stale)
+        return 0;
+    m_liveness.refresh(ue.liveness, m_now, ue.timeout);
+
+    if (ack)
+        m_acks->acknowledge(ueId, *ack);
+    return ueId;
 }
 
-void RlsUdpTask::heartbeatCycle(int64_t time)
+int RlsUdpTask::handleHeartbeat(const InetAddress &addr, uint64_t sti, int interval, int dbm, uint32_t session)
 {
-    std::set<int> lostUeId{};
-    std::set<uint64_t> lostSti{};
+    int64_t timeout = rls::HeartbeatTimeout(interval);
 
-    for (auto &item : m_ueMap)
+    auto it = m_stiToUe.find(sti);
+    if (it != m_stiToUe.end() && session != 0 && m_ueMap[it->second].session != 0 &&
+        static_cast<int32_t>(session - m_ueMap[it->second].session) > 0)
     {
-        if (time - item.second.lastSeen > HEARTBEAT_THRESHOLD)
+        // The UE dropped its link state with this cell, ours is dropped as well so that both ends start over
+        int ueId = it->second;
+        m_logger->debug("UE[%d] restarted its link session", ueId);
+        bool isStale = m_ueMap[ueId].stale;
+        m_liveness.remove(m_ueMap[ueId].liveness);
+        removeUe(ueId);
+
+        if (!isStale)
         {
-            lostUeId.insert(item.first);
-            lostSti.insert(item.second.sti);
+            auto w = std::make_unique<NmGnbRlsToRls>(NmGnbRlsToRls::SIGNAL_LOST);
+            w->ueId = ueId;
+            m_ctlTask->deliver(std::move(w));
         }
+        it = m_stiToUe.end();
     }
 
-    for (uint64_t sti : lostSti)
-        m_stiToUe.erase(sti);
+    if (it != m_stiToUe.end()) // sti is already known
+    {
+        int ueId = it->second;
+
+        auto &ue = m_ueMap[ueId];
+        if (ue.stale)
+            return 0; // left to time out, so that the UE drops its end of the link state as well
+        if (ue.session == 0)
+            ue.session = session;
+        ue.address = addr;
+        ue.timeout = timeout;
+        m_ueAddresses[ue.index] = addr;
+        m_liveness.refresh(ue.liveness, m_now, timeout);
+
+        // Only changes are passed on, the position of most UEs is fixed
+        if (ue.dbm != dbm)
+        {
+            ue.dbm = dbm;
+            notifySignalQuality(ueId, dbm);
+        }
+        return ueId;
+    }
+
+    // sti is not known yet, create a new UE in the map, register it by pushing a message up a layer with SIGNAL DETECTED
+    int ueId = ++m_newIdCounter;
+    m_stiToUe.emplace(sti, ueId);
+
+    auto &ue = m_ueMap[ueId];
+    ue.sti = sti;
+    ue.address = addr;
+    ue.timeout = timeout;
+    ue.index = m_ueAddresses.size();
+    ue.liveness = m_liveness.add(ueId, m_now, timeout);
+    ue.dbm = dbm;
+    ue.session = session;
+    m_ueAddresses.push_back(addr);
+    m_ueIds.push_back(ueId);
+
+    auto w = std::make_unique<NmGnbRlsToRls>(NmGnbRlsToRls::SIGNAL_DETECTED);
+    w->ueId = ueId;
+    m_ctlTask->deliver(std::move(w));
+    notifySignalQuality(ueId, dbm);
+    return ueId;
+}
+
+void RlsUdpTask::notifySignalQuality(int ueId, int dbm)
+{
+    auto w = std::make_unique<NmGnbRlsToRls>(NmGnbRlsToRls::SIGNAL_QUALITY);
+    w->ueId = ueId;
+    w->dbm = dbm;
+    m_ctlTask->deliver(std::move(w));
+}
+
+void RlsUdpTask::sendRlsPdu(const InetAddress &addr, const rls::RlsMessage &msg, int ueId)
+{
+    OctetString stream;
+    rls::EncodeRlsMessage(msg, stream);
+
+    // Acks owed to the UE ride on whatever is sent to it
+    auto ack = m_acks->takeAck(ueId);
+    if (ack)
+        rls::EncodeRlsAckBlock(*ack, stream);
+
+    // UEs of an nr-ue process may share a single end-point, which demultiplexes by the destination
+    auto ue = m_ueMap.find(ueId);
+    if (ue != m_ueMap.end())
+        rls::EncodeRlsDestinationBlock(ue->second.sti, stream);
+
+    m_transport->send(addr, stream.data(), static_cast<size_t>(stream.length()));
+}
 
-    for (int ueId : lostUeId)
-        m_ueMap.erase(ueId);
+void RlsUdpTask::heartbeatCycle(int64_t time)
+{
+    m_lostUes.clear();
+    m_liveness.expire(time, m_lostUes);
 
-    for (int ueId : lostUeId)
+    for (int ueId : m_lostUes)
     {
+        bool isStale = m_ueMap[ueId].stale;
+        removeUe(ueId);
+        if (isStale)
+            continue; // already reported
+
         auto w = std::make_unique<NmGnbRlsToRls>(NmGnbRlsToRls::SIGNAL_LOST);
         w->ueId = ueId;
-        m_ctlTask->push(std::move(w));
+        m_ctlTask->deliver(std::move(w));
     }
 }
 
-void RlsUdpTask::initialize(NtsTask *ctlTask)
+void RlsUdpTask::removeUe(int ueId)
+{
+    auto &ue = m_ueMap[ueId];
+    m_stiToUe.erase(ue.sti);
+    if (!ue.stale)
+        detachUe(ue);
+
+    m_ueMap.erase(ueId);
+    m_acks->removePeer(ueId);
+}
+
+void RlsUdpTask::detachUe(UeInfo &ue)
+{
+    // The last entry takes the place of the removed one, so that the address list stays contiguous
+    size_t index = ue.index;
+    m_ueAddresses[index] = m_ueAddresses.back();
+    m_ueIds[index] = m_ueIds.back();
+    m_ueMap[m_ueIds[index]].index = index;
+
+    m_ueAddresses.pop_back();
+    m_ueIds.pop_back();
+}
+
+void RlsUdpTask::initialize(FusableTask *ctlTask)
 {
     m_ctlTask = ctlTask;
 }
@@ -188,18 +359,37 @@ void RlsUdpTask::send(int ueId, const rls::RlsMessage &msg)
 {
     if (ueId == 0)
     {
-        for (auto &ue : m_ueMap)
-            send(ue.first, msg);
+        // Encoded once for all UEs
+        OctetString stream;
+        rls::EncodeRlsMessage(msg, stream);
+
+        m_transport->sendBatch(m_ueAddresses, stream.data(), static_cast<size_t>(stream.length()));
         return;
     }
 
-    if (!m_ueMap.count(ueId))
+    if (!m_ueMap.count(ueId) || m_ueMap[ueId].stale)
     {
         // ignore the message
         return;
     }
 
-    sendRlsPdu(m_ueMap[ueId].address, msg);
+    sendRlsPdu(m_ueMap[ueId].address, msg, ueId);
+}
+
+void RlsUdpTask::resetUe(int ueId)
+{
+    auto it = m_ueMap.find(ueId);
+    if (it == m_ueMap.end() || it->second.stale)
+        return;
+
+    // Nothing reaches the UE any more, it drops its end of the link as lost and comes back with a newer session
+    it->second.stale = true;
+    detachUe(it->second);
+    m_acks->removePeer(ueId);
+
+    auto w = std::make_unique<NmGnbRlsToRls>(NmGnbRlsToRls::SIGNAL_LOST);
+    w->ueId = ueId;
+    m_ctlTask->deliver(std::move(w));
 }
 
 } // namespace nr::rgnb
@@ -9,12 +9,17 @@
 #pragma once
 
 #include <cstdint>
+#include <memory>
 #include <unordered_map>
 #include <vector>
 
+#include <rgnb/fused.hpp>
 #include <rgnb/types.hpp>
+#include <lib/rls/rls_ack.hpp>
+#include <lib/rls/rls_heartbeat.hpp>
+#include <lib/rls/rls_liveness.hpp>
 #include <lib/rls/rls_pdu.hpp>
-#include <lib/udp/server.hpp>
+#include <lib/rls/rls_transport.hpp>
 #include <utils/nts.hpp>
 
 namespace nr::rgnb
@@ -27,22 +32,32 @@ class RlsUdpTask : public NtsTask
     {
         uint64_t sti{};
         InetAddress address;
-        int64_t lastSeen{};
+        size_t index{};    // in m_ueAddresses
+        size_t liveness{}; // handle in m_liveness
+        int64_t timeout{}; // of the liveness, by the heartbeat interval of the UE
+        int dbm{};         // simulated signal strength of the last heartbeat
+        uint32_t session{}; // epoch of the link state of the UE, see RlsHeartBeat
+        bool stale{};       // link state dropped by this cell, ignored until a newer session or the liveness expiry
     };
 
   private:
     std::unique_ptr<Logger> m_logger;
-    udp::UdpServer *m_server;
-    NtsTask *m_ctlTask;
+    std::unique_ptr<rls::RlsTransport> m_transport;
+    FusableTask *m_ctlTask;
+    rls::AckTracker *m_acks;
     uint64_t m_sti;
     Vector3 m_phyLocation;
-    int64_t m_lastLoop;
+    int64_t m_now; // time of the current loop
     std::unordered_map<uint64_t, int> m_stiToUe;
     std::unordered_map<int, UeInfo> m_ueMap;
+    std::vector<InetAddress> m_ueAddresses; // broadcast targets, contiguous for a single batch send
+    std::vector<int> m_ueIds;               // UE of each entry of m_ueAddresses
+    rls::LivenessWheel m_liveness;
+    std::vector<int> m_lostUes; // reused by each heartbeat cycle
     int m_newIdCounter;
 
   public:
-    explicit RlsUdpTask(TaskBase *base, uint64_t sti, Vector3 phyLocation);
+    explicit RlsUdpTask(TaskBase *base, uint64_t sti, Vector3 phyLocation, rls::AckTracker *acks);
     ~RlsUdpTask() override = default;
 
   protected:
@@ -51,13 +66,22 @@ class RlsUdpTask : public NtsTask
     void onQuit() override;
 
   private:
+    void receive(const InetAddress &addr, const uint8_t *data, size_t size);
+    void receiveHeartbeat(const InetAddress &addr, const rls::RlsHeartBeatView &heartbeat);
     void receiveRlsPdu(const InetAddress &addr, std::unique_ptr<rls::RlsMessage> &&msg);
-    void sendRlsPdu(const InetAddress &addr, const rls::RlsMessage &msg);
+    int acceptFromUe(uint64_t sti, const std::optional<rls::RlsAckBlock> &ack);
+    int handleHeartbeat(const InetAddress &addr, uint64_t sti, int interval, int dbm, uint32_t session);
+    void notifySignalQuality(int ueId, int dbm);
+    void sendRlsPdu(const InetAddress &addr, const rls::RlsMessage &msg, int ueId);
     void heartbeatCycle(int64_t time);
+    void removeUe(int ueId);
+    void detachUe(UeInfo &ue);
 
   public:
-    void initialize(NtsTask *ctlTask);
+    void initialize(FusableTask *ctlTask);
+    void serve(int receiveTimeout);
     void send(int ueId, const rls::RlsMessage &msg);
+    void resetUe(int ueId);
 };
 
 } // namespace nr::rgnb
@@ -104,14 +104,24 @@ struct NmGnbRlsToRls : NtsMessage
         UPLINK_DATA,
         RADIO_LINK_FAILURE,
         TRANSMISSION_FAILURE,
+        UPLINK_RELAY,
+        DOWNLINK_RELAY,
+        DOWNLINK_CREDIT,
+        CREDIT_STATUS,
+        SIGNAL_QUALITY,
     } present;
 
     // SIGNAL_DETECTED
     // SIGNAL_LOST
+    // SIGNAL_QUALITY
     // DOWNLINK_RRC
     // DOWNLINK_DATA
     // UPLINK_DATA
     // UPLINK_RRC
+    // UPLINK_RELAY
+    // DOWNLINK_RELAY
+    // DOWNLINK_CREDIT
+    // CREDIT_STATUS
     int ueId{};
 
     // RECEIVE_RLS_MESSAGE
@@ -125,8 +135,21 @@ struct NmGnbRlsToRls : NtsMessage
     // DOWNLINK_RRC
     // UPLINK_DATA
     // UPLINK_RRC
+    // UPLINK_RELAY
+    // DOWNLINK_RELAY
     OctetString data;
 
+    // UPLINK_RELAY
+    // DOWNLINK_RELAY
+    uint32_t bapContext{};
+
+    // DOWNLINK_CREDIT
+    // CREDIT_STATUS
+    uint64_t credit{};
+
+    // SIGNAL_QUALITY
+    int dbm{}; // simulated signal strength
+
     // DOWNLINK_RRC
     uint32_t pduId{};
 
@@ -562,6 +585,10 @@ struct NmUeRlsToRls : NtsMessage
         RADIO_LINK_FAILURE,
         TRANSMISSION_FAILURE,
         ASSIGN_CURRENT_CELL,
+        UPLINK_RELAY,
+        DOWNLINK_RELAY,
+        CREDIT_GRANT,
+        CREDIT_STATUS,
     } present;
 
     // RECEIVE_RLS_MESSAGE
@@ -585,6 +612,8 @@ struct NmUeRlsToRls : NtsMessage
     // DOWNLINK_DATA
     // UPLINK_RRC
     // DOWNLINK_RRC
+    // UPLINK_RELAY
+    // DOWNLINK_RELAY
     OctetString data;
 
     // UPLINK_RRC
@@ -594,6 +623,14 @@ struct NmUeRlsToRls : NtsMessage
     // UPLINK_RRC
     uint32_t pduId{};
 
+    // UPLINK_RELAY
+    // DOWNLINK_RELAY
+    uint32_t bapContext{};
+
+    // CREDIT_GRANT
+    // CREDIT_STATUS
+    uint64_t credit{};
+
     // RADIO_LINK_FAILURE
     rls::ERlfCause rlfCause{};
 
@@ -667,4 +704,30 @@ struct NmRgnbRrcToRrc : NtsMessage // equivalent of NmGnbRrcToNgap
     }
 };
 
+struct NmRgnbRlsToRls : NtsMessage // carries RELAY PDUs between the gNB and the UE part
+{
+    enum PR
+    {
+        UPLINK_RELAY,     // gNB part -> UE part
+        DOWNLINK_RELAY,   // UE part -> gNB part
+        UPSTREAM_CREDIT,  // UE part -> gNB part
+        UPSTREAM_CHANGED, // UE part -> gNB part
+        UPSTREAM_LOST,    // UE part -> gNB part
+        CREDIT_STATUS,    // gNB part -> UE part
+    } present;
+
+    // UPLINK_RELAY
+    // DOWNLINK_RELAY
+    uint32_t bapContext{};
+    OctetString pdu{};
+
+    // UPSTREAM_CREDIT
+    // CREDIT_STATUS
+    uint64_t credit{};
+
+    explicit NmRgnbRlsToRls(PR present) : NtsMessage(NtsMessageType::RGNB_RLS_TO_RLS), present(present)
+    {
+    }
+};
+
 } // namespace nr::rgnb
@@ -20,6 +20,10 @@
 
 #include <lib/app/monitor.hpp>
 #include <lib/asn/utils.hpp>
+#include <lib/rls/rls_ack.hpp>
+#include <lib/rls/rls_channel.hpp>
+#include <lib/rls/rls_pdcp.hpp>
+#include <lib/rls/rls_rlc.hpp>
 #include <utils/common_types.hpp>
 #include <utils/logger.hpp>
 #include <utils/network.hpp>
@@ -324,6 +328,50 @@ struct GnbAmfConfig
     uint16_t port{};
 };
 
+struct BapRouteConfig
+{
+    int destination{};
+    int nextHop{};
+};
+
+struct Ipv4Subnet
+{
+    uint32_t address{}; // host byte order
+    uint32_t mask{};
+
+    [[nodiscard]] inline bool contains(uint32_t ip) const
+    {
+        return (ip & mask) == address;
+    }
+};
+
+struct BackhaulWeightConfig
+{
+    int ueId{};
+    int weight{};
+};
+
+enum class EMacPolicy
+{
+    ROUND_ROBIN,
+    PROPORTIONAL_FAIR,
+    MAX_CI,
+};
+
+struct MacConfig
+{
+    EMacPolicy policy = EMacPolicy::PROPORTIONAL_FAIR;
+    int numerology = 1;      // subcarrier spacing of 15 kHz * 2^numerology, slots of 1 ms / 2^numerology
+    int slotDuration{};      // us, overrides the slot duration of the numerology if not 0
+    int prbs = 51;           // PRBs per slot and direction
+    double bler = 0.1;       // probability of a transport block transmission failing
+    int harqRtt = 8;         // slots from a failed transmission to its retransmission
+    int harqMaxTx = 4;       // transmissions of a transport block before it is dropped
+    int queueSize = 1048576; // bytes buffered per UE and direction
+    int pfWindow = 100;      // slots, averaging window of the proportional fair metric
+    uint64_t seed{};
+};
+
 struct RGnbGnbConfig
 {
     /* Read from config file */
@@ -338,6 +386,35 @@ struct RGnbGnbConfig
     std::string gtpIp{};
     std::optional<std::string> gtpAdvertiseIp{};
     bool ignoreStreamIds{};
+    std::optional<int> bapAddress{};       // enables multi-hop relaying
+    std::optional<int> bapDonor{};         // not present on the donor itself
+    std::vector<BapRouteConfig> bapRoutes{};
+    std::vector<Ipv4Subnet> localSwitching{}; // UE subnets switched locally, empty if disabled
+    bool fusedRls{}; // RLS control and radio link tasks share the thread of the RLS task
+    rls::ELinkTransport linkTransport{}; // overridden by the topology file
+
+    struct
+    {
+        int capacity{};       // kbit/s, 0 if the upstream link is not paced
+        int quantum = 1500;   // bytes per round and unit weight
+        int creditBuffer{};   // bytes buffered per downstream relay, 0 if flow control is disabled
+        int outageBuffer{};   // bytes held while the upstream link is down, 0 if nothing is held
+        int outageMaxAge = 3000; // ms
+        int drainRate{};      // kbit/s at which held bytes are released, 0 if not limited
+        bool headerCompression{}; // compress IP headers of RELAY PDUs sent by this node
+        std::vector<BackhaulWeightConfig> weights{};
+    } backhaul{};
+
+    struct
+    {
+        int mtu{};    // bytes per datagram, 0 if user PDUs are not aggregated
+        int window = 1; // ms
+    } aggregation{};
+
+    std::optional<rls::ChannelConfig> channel{}; // radio channel emulation of the links of both RLS stacks
+    std::optional<rls::RlcConfig> rlc{};         // RLC bearers for the user PDUs of both RLS stacks
+    std::optional<rls::PdcpConfig> pdcp{};       // PDCP protection of the user PDUs of both RLS stacks
+    std::optional<MacConfig> mac{};              // slot-based scheduling of the user PDUs of the cell
 
     /* Assigned by program */
     std::string name{};
@@ -445,6 +522,8 @@ struct UeSharedContext
 struct RlsSharedContext
 {
     std::atomic<uint64_t> sti{};
+    std::atomic<int> servingCell{};
+    rls::AckTracker acks{};
 };
 
 struct RrcTimers
@@ -900,6 +979,7 @@ struct RGnbUeConfig //copied from ue/types.hpp
     NetworkSlice defaultConfiguredNssai{};
     NetworkSlice configuredNssai{};
     std::optional<std::string> tunName{};
+    rls::ELinkTransport linkTransport{}; // overridden by the topology file
 
     struct
     {
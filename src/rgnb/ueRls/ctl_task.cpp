@@ -8,27 +8,48 @@
 
 #include "ctl_task.hpp"
 
+#include <algorithm>
+#include <cstdint>
+
+#include <lib/rls/rls_bap.hpp>
 #include <utils/common.hpp>
 
-static constexpr const size_t MAX_PDU_COUNT = 128;
 static constexpr const int MAX_PDU_TTL = 3000;
 
 static constexpr const int TIMER_ID_ACK_CONTROL = 1;
 static constexpr const int TIMER_ID_ACK_SEND = 2;
+static constexpr const int TIMER_ID_AGGREGATION = 3;
+static constexpr const int TIMER_ID_RLC_SLOT = 4;
+static constexpr const int TIMER_ID_PDCP_REORDERING = 5;
 
-static constexpr const int TIMER_PERIOD_ACK_CONTROL = 1500;
-static constexpr const int TIMER_PERIOD_ACK_SEND = 2250;
+static constexpr const int TIMER_PERIOD_ACK_CONTROL = 10; // granularity of the retransmission timers
+static constexpr const int TIMER_PERIOD_ACK_SEND = 20; // delay of acks not sent immediately
+static constexpr const int TIMER_PERIOD_RLC_IDLE = 10; // slot period while no bearer has anything to send
 
 namespace nr::rgnb
 {
 
+static const rls::PdcpConfig &PdcpConfigOf(const RGnbGnbConfig &config)
+{
+    static const rls::PdcpConfig defaultConfig{};
+    return config.pdcp ? *config.pdcp : defaultConfig;
+}
+
 UeRlsControlTask::UeRlsControlTask(TaskBase *base, RlsSharedContext *shCtx)
-    : m_shCtx{shCtx}, m_servingCell{}, m_mainTask{}, m_udpTask{}, m_pduMap{}, m_pendingAck{}
+    : m_shCtx{shCtx}, m_servingCell{}, m_mainTask{}, m_udpTask{}, m_ackTimerArmed{}, m_arqTimerArmed{},
+      m_compressRelay{base->gnbConfig->backhaul.headerCompression}, m_compressor{}, m_decompressor{},
+      m_aggregator{}, m_aggregationWindow{base->gnbConfig->aggregation.window}, m_aggregationTimerArmed{},
+      m_rlc{shCtx->sti, base->gnbConfig->rlc.value_or(rls::RlcConfig{})},
+      m_rlcEnabled{base->gnbConfig->rlc.has_value()}, m_rlcSlotTime{}, m_pdcp{true, PdcpConfigOf(*base->gnbConfig)},
+      m_pdcpEnabled{base->gnbConfig->pdcp.has_value()}, m_pdcpReorderTime{}
 {
     m_logger = base->logBase->makeUniqueLogger(base->ueConfig->getLoggerPrefix() + "rls-ctl");
+
+    if (base->gnbConfig->aggregation.mtu > 0)
+        m_aggregator = std::make_unique<rls::PduAggregator>(shCtx->sti, base->gnbConfig->aggregation.mtu);
 }
 
-void UeRlsControlTask::initialize(NtsTask *mainTask, UeRlsUdpTask *udpTask)
+void UeRlsControlTask::initialize(FusableTask *mainTask, UeRlsUdpTask *udpTask)
 {
     m_mainTask = mainTask;
     m_udpTask = udpTask;
@@ -36,20 +57,14 @@ void UeRlsControlTask::initialize(NtsTask *mainTask, UeRlsUdpTask *udpTask)
 
 void UeRlsControlTask::onStart()
 {
-    setTimer(TIMER_ID_ACK_CONTROL, TIMER_PERIOD_ACK_CONTROL);
-    setTimer(TIMER_ID_ACK_SEND, TIMER_PERIOD_ACK_SEND);
 }
 
-void UeRlsControlTask::onLoop()
+void UeRlsControlTask::handleMessage(NtsMessage &msg)
 {
-    auto msg = take();
-    if (!msg)
-        return;
-
-    switch (msg->msgType)
+    switch (msg.msgType)
     {
     case NtsMessageType::UE_RLS_TO_RLS: {
-        auto &w = dynamic_cast<NmUeRlsToRls &>(*msg);
+        auto &w = dynamic_cast<NmUeRlsToRls &>(msg);
         switch (w.present)
         {
         case NmUeRlsToRls::SIGNAL_CHANGED:
@@ -64,31 +79,78 @@ void UeRlsControlTask::onLoop()
         case NmUeRlsToRls::UPLINK_RRC:
             handleUplinkRrcDelivery(w.cellId, w.pduId, w.rrcChannel, std::move(w.data));
             break;
+        case NmUeRlsToRls::UPLINK_RELAY:
+            handleUplinkRelayDelivery(w.bapContext, std::move(w.data));
+            break;
+        case NmUeRlsToRls::CREDIT_STATUS: {
+            rls::RlsCreditStatus status{m_shCtx->sti};
+            status.sentBytes = w.credit;
+            m_udpTask->send(m_servingCell, status);
+            break;
+        }
         case NmUeRlsToRls::ASSIGN_CURRENT_CELL:
+            if (w.cellId == m_servingCell)
+                break;
+
+            flushAggregates(m_servingCell);
+            m_rlc.remove(m_servingCell); // the radio bearer belongs to the old link, what it still holds is lost
+            m_pdcp.remove(m_servingCell);
+            m_udpTask->resetCell(m_servingCell); // so that the old parent drops its end of the bearer as well
             m_servingCell = w.cellId;
+            m_shCtx->servingCell = w.cellId;
+
+            // Compression contexts are per link and the new parent knows none of them
+            m_compressor.reset();
+            m_decompressor.reset();
             break;
         default:
-            m_logger->unhandledNts(*msg);
+            m_logger->unhandledNts(msg);
             break;
         }
         break;
     }
     case NtsMessageType::TIMER_EXPIRED: {
-        auto &w = dynamic_cast<NmTimerExpired &>(*msg);
+        auto &w = dynamic_cast<NmTimerExpired &>(msg);
         if (w.timerId == TIMER_ID_ACK_CONTROL)
         {
-            setTimer(TIMER_ID_ACK_CONTROL, TIMER_PERIOD_ACK_CONTROL);
+            m_arqTimerArmed = false;
             onAckControlTimerExpired();
         }
         else if (w.timerId == TIMER_ID_ACK_SEND)
         {
-            setTimer(TIMER_ID_ACK_SEND, TIMER_PERIOD_ACK_SEND);
+            m_ackTimerArmed = false;
             onAckSendTimerExpired();
         }
+        else if (w.timerId == TIMER_ID_AGGREGATION)
+        {
+            m_aggregationTimerArmed = false;
+            flushAggregates(0);
+        }
+        else if (w.timerId == TIMER_ID_RLC_SLOT)
+        {
+            // Timers of superseded slots are left running, they are recognized by their early expiry
+            if (m_rlcSlotTime != 0 && utils::CurrentTimeMillis() >= m_rlcSlotTime)
+            {
+                m_rlcSlotTime = 0;
+                onRlcSlotTimerExpired();
+            }
+        }
+        else if (w.timerId == TIMER_ID_PDCP_REORDERING)
+        {
+            if (m_pdcpReorderTime != 0 && utils::CurrentTimeMillis() >= m_pdcpReorderTime)
+            {
+                m_pdcpReorderTime = 0;
+
+                std::vector<rls::PdcpSdu> sdus;
+                m_pdcp.runTimers(utils::CurrentTimeMillis(), sdus);
+                deliverPdcpSdus(sdus);
+                armPdcpTimer();
+            }
+        }
         break;
     }
     default:
-        m_logger->unhandledNts(*msg);
+        m_logger->unhandledNts(msg);
         break;
     }
 }
@@ -103,13 +165,19 @@ void UeRlsControlTask::handleRlsMessage(int cellId, rls::RlsMessage &msg)
     {
         auto &m = (rls::RlsPduTransmissionAck &)msg;
         for (auto pduId : m.pduIds)
-            m_pduMap.erase(pduId);
+            m_shCtx->acks.acknowledge(cellId, pduId);
     }
     else if (msg.msgType == rls::EMessageType::PDU_TRANSMISSION)
     {
         auto &m = (rls::RlsPduTransmission &)msg;
         if (m.pduId != 0)
-            m_pendingAck[cellId].push_back(m.pduId);
+        {
+            // RRC is acknowledged right away so that procedures do not wait for the ack delay
+            bool isNew = m_shCtx->acks.receive(cellId, m.pduId);
+            scheduleAck(cellId, m.pduType == rls::EPduType::RRC);
+            if (!isNew)
+                return;
+        }
 
         if (m.pduType == rls::EPduType::DATA)
         {
@@ -123,7 +191,17 @@ void UeRlsControlTask::handleRlsMessage(int cellId, rls::RlsMessage &msg)
             auto w = std::make_unique<NmUeRlsToRls>(NmUeRlsToRls::DOWNLINK_DATA);
             w->psi = static_cast<int>(m.payload);
             w->data = std::move(m.pdu);
-            m_mainTask->push(std::move(w));
+            m_mainTask->deliver(std::move(w));
+        }
+        else if (m.pduType == rls::EPduType::DATA_PDCP)
+        {
+            if (cellId != m_servingCell)
+                return;
+
+            std::vector<rls::PdcpSdu> sdus;
+            m_pdcp.receive(utils::CurrentTimeMillis(), cellId, m.payload, m.pdu, sdus);
+            deliverPdcpSdus(sdus);
+            armPdcpTimer();
         }
         else if (m.pduType == rls::EPduType::RRC)
         {
@@ -131,13 +209,62 @@ void UeRlsControlTask::handleRlsMessage(int cellId, rls::RlsMessage &msg)
             w->cellId = cellId;
             w->rrcChannel = static_cast<rrc::RrcChannel>(m.payload);
             w->data = std::move(m.pdu);
-            m_mainTask->push(std::move(w));
+            m_mainTask->deliver(std::move(w));
+        }
+        else if (m.pduType == rls::EPduType::RELAY || m.pduType == rls::EPduType::RELAY_COMPRESSED)
+        {
+            if (cellId != m_servingCell)
+                return;
+
+            if (m.pduType == rls::EPduType::RELAY_COMPRESSED)
+            {
+                OctetString pdu;
+                if (!m_decompressor.decompress(m.pdu, rls::BAP_HEADER_SIZE, pdu))
+                {
+                    m_logger->debug("Compressed RELAY PDU could not be decompressed");
+                    return;
+                }
+                m.pdu = std::move(pdu);
+            }
+
+            auto w = std::make_unique<NmUeRlsToRls>(NmUeRlsToRls::DOWNLINK_RELAY);
+            w->bapContext = m.payload;
+            w->data = std::move(m.pdu);
+            m_mainTask->deliver(std::move(w));
+        }
+        else if (m.pduType == rls::EPduType::RLC)
+        {
+            // User PDUs are only carried by the bearer of the serving cell
+            if (cellId != m_servingCell)
+                return;
+
+            std::vector<rls::RlsPduTransmission> sdus;
+            m_rlc.receive(utils::CurrentTimeMillis(), cellId, m, sdus);
+            for (auto &sdu : sdus)
+                handleRlsMessage(cellId, sdu);
+
+            // Status reports triggered by the PDU go out in the next slot
+            armRlcSlotTimer(true);
         }
         else
         {
             m_logger->err("Unhandled RLS PDU type");
         }
     }
+    else if (msg.msgType == rls::EMessageType::PDU_AGGREGATE)
+    {
+        for (auto &pdu : ((rls::RlsPduAggregate &)msg).pdus)
+            handleRlsMessage(cellId, pdu);
+    }
+    else if (msg.msgType == rls::EMessageType::CREDIT_GRANT)
+    {
+        if (cellId != m_servingCell)
+            return;
+
+        auto w = std::make_unique<NmUeRlsToRls>(NmUeRlsToRls::CREDIT_GRANT);
+        w->credit = ((const rls::RlsCreditGrant &)msg).creditLimit;
+        m_mainTask->deliver(std::move(w));
+    }
     else
     {
         m_logger->err("Unhandled RLS message type");
@@ -146,49 +273,52 @@ void UeRlsControlTask::handleRlsMessage(int cellId, rls::RlsMessage &msg)
 
 void UeRlsControlTask::handleSignalChange(int cellId, int dbm)
 {
+    // A lost cell comes back under a new id and a new link session, the state of its bearers ends with it
+    if (dbm == INT32_MIN)
+    {
+        m_rlc.remove(cellId);
+        m_pdcp.remove(cellId);
+    }
+
     auto w = std::make_unique<NmUeRlsToRls>(NmUeRlsToRls::SIGNAL_CHANGED);
     w->cellId = cellId;
     w->dbm = dbm;
-    m_mainTask->push(std::move(w));
+    m_mainTask->deliver(std::move(w));
 }
 
 void UeRlsControlTask::handleUplinkRrcDelivery(int cellId, uint32_t pduId, rrc::RrcChannel channel, OctetString &&data)
 {
-    if (pduId != 0)
+    // RRC is sent reliably, pduId of the upper layer is only kept to report transmission failures
+    uint32_t seq = 0;
     {
-        if (m_pduMap.count(pduId))
+        rls::PduInfo info{};
+        info.endPointId = cellId;
+        info.id = pduId;
+        info.pdu = data.copy();
+        info.rrcChannel = channel;
+        info.sentTime = utils::CurrentTimeMillis();
+        seq = m_shCtx->acks.track(cellId, std::move(info));
+        if (seq == 0)
         {
-            m_pduMap.clear();
-
-            auto w = std::make_unique<NmUeRlsToRls>(NmUeRlsToRls::RADIO_LINK_FAILURE);
-            w->rlfCause = rls::ERlfCause::PDU_ID_EXISTS;
-            m_mainTask->push(std::move(w));
-            return;
-        }
-
-        if (m_pduMap.size() > MAX_PDU_COUNT)
-        {
-            m_pduMap.clear();
+            m_shCtx->acks.clearUnacked(cellId);
 
             auto w = std::make_unique<NmUeRlsToRls>(NmUeRlsToRls::RADIO_LINK_FAILURE);
             w->rlfCause = rls::ERlfCause::PDU_ID_FULL;
-            m_mainTask->push(std::move(w));
+            m_mainTask->deliver(std::move(w));
             return;
         }
 
-        m_pduMap[pduId].endPointId = cellId;
-        m_pduMap[pduId].id = pduId;
-        m_pduMap[pduId].pdu = data.copy();
-        m_pduMap[pduId].rrcChannel = channel;
-        m_pduMap[pduId].sentTime = utils::CurrentTimeMillis();
+        armRetransmissionTimer();
     }
 
     rls::RlsPduTransmission msg{m_shCtx->sti};
     msg.pduType = rls::EPduType::RRC;
     msg.pdu = std::move(data);
     msg.payload = static_cast<uint32_t>(channel);
-    msg.pduId = pduId;
+    msg.pduId = seq;
 
+    // Keep the order of the user PDUs already queued for the cell
+    flushAggregates(cellId);
     m_udpTask->send(cellId, msg);
 }
 
@@ -196,56 +326,209 @@ void UeRlsControlTask::handleUplinkDataDelivery(int psi, OctetString &&data)
 {
     rls::RlsPduTransmission msg{m_shCtx->sti};
     msg.pduType = rls::EPduType::DATA;
-    msg.pdu = std::move(data);
     msg.payload = static_cast<uint32_t>(psi);
     msg.pduId = 0;
 
-    m_udpTask->send(m_servingCell, msg);
+    if (m_pdcpEnabled)
+    {
+        msg.pduType = rls::EPduType::DATA_PDCP;
+        msg.payload = m_pdcp.protect(m_servingCell, psi, data);
+    }
+
+    msg.pdu = std::move(data);
+
+    sendUserPdu(m_servingCell, std::move(msg));
+}
+
+void UeRlsControlTask::handleUplinkRelayDelivery(uint32_t bapContext, OctetString &&pdu)
+{
+    rls::RlsPduTransmission msg{m_shCtx->sti};
+    msg.pduType = rls::EPduType::RELAY;
+
+    OctetString compressed;
+    if (m_compressRelay && m_compressor.compress(pdu, rls::BAP_HEADER_SIZE, compressed))
+    {
+        msg.pduType = rls::EPduType::RELAY_COMPRESSED;
+        pdu = std::move(compressed);
+    }
+
+    msg.pdu = std::move(pdu);
+    msg.payload = bapContext;
+    msg.pduId = 0;
+
+    sendUserPdu(m_servingCell, std::move(msg));
+}
+
+void UeRlsControlTask::sendUserPdu(int cellId, rls::RlsPduTransmission &&msg)
+{
+    if (!m_rlcEnabled)
+    {
+        sendPdu(cellId, std::move(msg));
+        return;
+    }
+
+    m_rlc.submit(cellId, msg);
+    armRlcSlotTimer(true);
+}
+
+void UeRlsControlTask::sendPdu(int cellId, rls::RlsPduTransmission &&msg)
+{
+    if (!m_aggregator)
+    {
+        m_udpTask->send(cellId, msg);
+        return;
+    }
+
+    for (auto &ready : m_aggregator->add(cellId, std::move(msg)))
+        m_udpTask->send(cellId, *ready);
+
+    if (!m_aggregationTimerArmed && !m_aggregator->empty())
+    {
+        m_aggregationTimerArmed = true;
+        setTimer(TIMER_ID_AGGREGATION, m_aggregationWindow);
+    }
+}
+
+void UeRlsControlTask::flushAggregates(int cellId)
+{
+    if (!m_aggregator)
+        return;
+
+    if (cellId != 0)
+    {
+        auto msg = m_aggregator->take(cellId);
+        if (msg)
+            m_udpTask->send(cellId, *msg);
+        return;
+    }
+
+    for (auto &item : m_aggregator->takeAll())
+        m_udpTask->send(item.first, *item.second);
+}
+
+void UeRlsControlTask::deliverPdcpSdus(std::vector<rls::PdcpSdu> &sdus)
+{
+    for (auto &sdu : sdus)
+    {
+        auto w = std::make_unique<NmUeRlsToRls>(NmUeRlsToRls::DOWNLINK_DATA);
+        w->psi = sdu.psi;
+        w->data = std::move(sdu.data);
+        m_mainTask->deliver(std::move(w));
+    }
+}
+
+void UeRlsControlTask::armPdcpTimer()
+{
+    int64_t expiry = m_pdcp.nextExpiry();
+    if (expiry == 0 || (m_pdcpReorderTime != 0 && m_pdcpReorderTime <= expiry))
+        return;
+
+    m_pdcpReorderTime = expiry;
+    setTimerAbsolute(TIMER_ID_PDCP_REORDERING, expiry);
+}
+
+void UeRlsControlTask::onRlcSlotTimerExpired()
+{
+    std::vector<std::pair<int, rls::RlsPduTransmission>> pdus;
+    bool backlogged = m_rlc.runSlot(utils::CurrentTimeMillis(), pdus);
+    for (auto &item : pdus)
+        sendPdu(item.first, std::move(item.second));
+
+    for (int cellId : m_rlc.takeFailures())
+    {
+        m_logger->warn("RLC maximum retransmissions reached for cell[%d]", cellId);
+        m_rlc.remove(cellId);
+        m_udpTask->resetCell(cellId);
+
+        auto w = std::make_unique<NmUeRlsToRls>(NmUeRlsToRls::RADIO_LINK_FAILURE);
+        w->rlfCause = rls::ERlfCause::RLC_MAX_RETRANSMISSION;
+        m_mainTask->deliver(std::move(w));
+    }
+
+    armRlcSlotTimer(backlogged);
+}
+
+void UeRlsControlTask::armRlcSlotTimer(bool busy)
+{
+    if (m_rlc.empty())
+        return;
+
+    // Bearers keep ticking while idle, their poll and reassembly timers run on the slot clock
+    int period = busy ? m_rlc.slot() : std::max(m_rlc.slot(), TIMER_PERIOD_RLC_IDLE);
+    int64_t time = utils::CurrentTimeMillis() + period;
+    if (m_rlcSlotTime != 0 && m_rlcSlotTime <= time)
+        return;
+
+    m_rlcSlotTime = time;
+    setTimerAbsolute(TIMER_ID_RLC_SLOT, time);
 }
 
 void UeRlsControlTask::onAckControlTimerExpired()
 {
     int64_t current = utils::CurrentTimeMillis();
 
-    std::vector<uint32_t> transmissionFailureIds;
+    std::vector<rls::RlsRetransmission> retransmissions;
     std::vector<rls::PduInfo> transmissionFailures;
+    m_shCtx->acks.poll(current, MAX_PDU_TTL, retransmissions, transmissionFailures);
 
-    for (auto &pdu : m_pduMap)
+    for (auto &item : retransmissions)
     {
-        auto delta = current - pdu.second.sentTime;
-        if (delta > MAX_PDU_TTL)
-        {
-            transmissionFailureIds.push_back(pdu.first);
-            transmissionFailures.push_back(std::move(pdu.second));
-        }
+        rls::RlsPduTransmission msg{m_shCtx->sti};
+        msg.pduType = rls::EPduType::RRC;
+        msg.pdu = std::move(item.pdu);
+        msg.payload = static_cast<uint32_t>(item.rrcChannel);
+        msg.pduId = item.seq;
+        m_udpTask->send(item.peer, msg);
     }
 
-    for (auto id : transmissionFailureIds)
-        m_pduMap.erase(id);
-
     if (!transmissionFailures.empty())
     {
         auto w = std::make_unique<NmUeRlsToRls>(NmUeRlsToRls::TRANSMISSION_FAILURE);
         w->pduList = std::move(transmissionFailures);
-        m_mainTask->push(std::move(w));
+        m_mainTask->deliver(std::move(w));
+    }
+
+    armRetransmissionTimer();
+}
+
+void UeRlsControlTask::armRetransmissionTimer()
+{
+    if (!m_arqTimerArmed && m_shCtx->acks.unackedCount() > 0)
+    {
+        m_arqTimerArmed = true;
+        setTimer(TIMER_ID_ACK_CONTROL, TIMER_PERIOD_ACK_CONTROL);
     }
 }
 
 void UeRlsControlTask::onAckSendTimerExpired()
 {
-    auto copy = m_pendingAck;
-    m_pendingAck.clear();
+    for (int peer : m_shCtx->acks.owingPeers())
+        sendAck(peer);
+}
 
-    for (auto &item : copy)
+void UeRlsControlTask::scheduleAck(int cellId, bool immediate)
+{
+    if (immediate)
     {
-        if (!item.second.empty())
-            continue;
-
-        rls::RlsPduTransmissionAck msg{m_shCtx->sti};
-        msg.pduIds = std::move(item.second);
+        sendAck(cellId);
+        return;
+    }
 
-        m_udpTask->send(item.first, msg);
+    if (!m_ackTimerArmed)
+    {
+        m_ackTimerArmed = true;
+        setTimer(TIMER_ID_ACK_SEND, TIMER_PERIOD_ACK_SEND);
     }
 }
 
+void UeRlsControlTask::sendAck(int cellId)
+{
+    // The radio link task attaches the owed ack block to whatever is sent, so nothing to do if it already left
+    if (!m_shCtx->acks.isOwed(cellId))
+        return;
+
+    rls::RlsPduTransmissionAck msg{m_shCtx->sti};
+    m_udpTask->send(cellId, msg);
+}
+
 } // namespace nr::rgnb
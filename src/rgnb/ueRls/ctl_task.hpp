@@ -13,24 +13,41 @@
 #include <unordered_map>
 #include <vector>
 
+#include <lib/rls/rls_aggregator.hpp>
+#include <lib/rls/rls_pdcp.hpp>
+#include <lib/rls/rls_rlc.hpp>
+#include <lib/rls/rls_rohc.hpp>
 #include <lib/rrc/rrc.hpp>
 #include <rgnb/nts.hpp>
+#include <rgnb/fused.hpp>
 #include <rgnb/types.hpp>
 #include <utils/nts.hpp>
 
 namespace nr::rgnb
 {
 
-class UeRlsControlTask : public NtsTask
+class UeRlsControlTask : public FusableTask
 {
   private:
     std::unique_ptr<Logger> m_logger;
     RlsSharedContext *m_shCtx;
     int m_servingCell;
-    NtsTask *m_mainTask;
+    FusableTask *m_mainTask;
     UeRlsUdpTask *m_udpTask;
-    std::unordered_map<uint32_t, rls::PduInfo> m_pduMap;
-    std::unordered_map<int, std::vector<uint32_t>> m_pendingAck;
+    bool m_ackTimerArmed;
+    bool m_arqTimerArmed;
+    bool m_compressRelay;
+    rls::HeaderCompressor m_compressor;     // uplink towards the serving cell
+    rls::HeaderDecompressor m_decompressor; // downlink from the serving cell
+    std::unique_ptr<rls::PduAggregator> m_aggregator;
+    int m_aggregationWindow;
+    bool m_aggregationTimerArmed;
+    rls::RlcBearers m_rlc;
+    bool m_rlcEnabled;     // user PDUs sent by this node go through RLC, received RLC PDUs are always handled
+    int64_t m_rlcSlotTime; // time of the next slot, 0 if the slot timer is not armed
+    rls::PdcpEntities m_pdcp;
+    bool m_pdcpEnabled;        // user PDUs sent by this node are protected, received PDCP PDUs are always handled
+    int64_t m_pdcpReorderTime; // expiry of the t-Reordering timer, 0 if it is not armed
 
   public:
     explicit UeRlsControlTask(TaskBase *base, RlsSharedContext *shCtx);
@@ -38,19 +55,30 @@ class UeRlsControlTask : public NtsTask
 
   protected:
     void onStart() override;
-    void onLoop() override;
+    void handleMessage(NtsMessage &msg) override;
     void onQuit() override;
 
   public:
-    void initialize(NtsTask *mainTask, UeRlsUdpTask *udpTask);
+    void initialize(FusableTask *mainTask, UeRlsUdpTask *udpTask);
 
   private:
     void handleRlsMessage(int cellId, rls::RlsMessage &msg);
     void handleSignalChange(int cellId, int dbm);
     void handleUplinkRrcDelivery(int cellId, uint32_t pduId, rrc::RrcChannel channel, OctetString &&data);
     void handleUplinkDataDelivery(int psi, OctetString &&data);
+    void handleUplinkRelayDelivery(uint32_t bapContext, OctetString &&pdu);
+    void sendUserPdu(int cellId, rls::RlsPduTransmission &&msg);
+    void sendPdu(int cellId, rls::RlsPduTransmission &&msg);
+    void flushAggregates(int cellId);
+    void deliverPdcpSdus(std::vector<rls::PdcpSdu> &sdus);
+    void armPdcpTimer();
+    void onRlcSlotTimerExpired();
+    void armRlcSlotTimer(bool busy);
     void onAckControlTimerExpired();
+    void armRetransmissionTimer();
     void onAckSendTimerExpired();
+    void scheduleAck(int cellId, bool immediate);
+    void sendAck(int cellId);
 };
 
 } // namespace nr::rgnb
\ No newline at end of file
@@ -8,14 +8,21 @@
 
 #include "task.hpp"
 
+#include <cstdint>
+
+#include <lib/rls/rls_bap.hpp>
+#include <rgnb/gnbRls/task.hpp>
 #include <rgnb/ueRrc/task.hpp>
 #include <utils/common.hpp>
 #include <utils/random.hpp>
 
+// Longest time the radio link is waited for in fused mode before queued messages are looked at again
+static constexpr const int FUSED_RECEIVE_TIMEOUT = 1;
+
 namespace nr::rgnb
 {
 
-UeRlsTask::UeRlsTask(TaskBase *base) : m_base{base}
+UeRlsTask::UeRlsTask(TaskBase *base) : m_base{base}, m_servingCell{}
 {
     m_logger = m_base->logBase->makeUniqueLogger(m_base->ueConfig->getLoggerPrefix() + "ueRls");
 
@@ -27,24 +34,43 @@ UeRlsTask::UeRlsTask(TaskBase *base) : m_base{base}
 
     m_udpTask->initialize(m_ctlTask);
     m_ctlTask->initialize(this, m_udpTask);
+
+    if (base->gnbConfig->fusedRls)
+        setFused();
 }
 
 void UeRlsTask::onStart()
 {
+    if (isFused())
+    {
+        m_ctlTask->startFused();
+        return;
+    }
+
     m_udpTask->start();
     m_ctlTask->start();
 }
 
 void UeRlsTask::onLoop()
 {
-    auto msg = take();
-    if (!msg)
+    if (!isFused())
+    {
+        FusableTask::onLoop();
         return;
+    }
+
+    // The whole RLS stack runs on this thread, the radio link is polled in between messages and timers
+    runPending();
+    m_ctlTask->runPending();
+    m_udpTask->serve(FUSED_RECEIVE_TIMEOUT);
+}
 
-    switch (msg->msgType)
+void UeRlsTask::handleMessage(NtsMessage &msg)
+{
+    switch (msg.msgType)
     {
     case NtsMessageType::UE_RLS_TO_RLS: {
-        auto &w = dynamic_cast<NmUeRlsToRls &>(*msg);
+        auto &w = dynamic_cast<NmUeRlsToRls &>(msg);
         switch (w.present)
         {
         case NmUeRlsToRls::SIGNAL_CHANGED: {
@@ -52,6 +78,12 @@ void UeRlsTask::onLoop()
             m->cellId = w.cellId;
             m->dbm = w.dbm;
             m_base->ueRrcTask->push(std::move(m));
+
+            if (w.cellId == m_servingCell && w.dbm == INT32_MIN)
+            {
+                m_servingCell = 0;
+                m_base->gnbRlsTask->push(std::make_unique<NmRgnbRlsToRls>(NmRgnbRlsToRls::UPSTREAM_LOST));
+            }
             break;
         }
         case NmUeRlsToRls::DOWNLINK_DATA: {
@@ -69,10 +101,26 @@ void UeRlsTask::onLoop()
             m_base->ueRrcTask->push(std::move(m));
             break;
         }
+        case NmUeRlsToRls::DOWNLINK_RELAY: {
+            auto m = std::make_unique<NmRgnbRlsToRls>(NmRgnbRlsToRls::DOWNLINK_RELAY);
+            m->bapContext = w.bapContext;
+            m->pdu = std::move(w.data);
+            m_base->gnbRlsTask->push(std::move(m));
+            break;
+        }
+        case NmUeRlsToRls::CREDIT_GRANT: {
+            auto m = std::make_unique<NmRgnbRlsToRls>(NmRgnbRlsToRls::UPSTREAM_CREDIT);
+            m->credit = w.credit;
+            m_base->gnbRlsTask->push(std::move(m));
+            break;
+        }
         case NmUeRlsToRls::RADIO_LINK_FAILURE: {
             auto m = std::make_unique<NmUeRlsToRrc>(NmUeRlsToRrc::RADIO_LINK_FAILURE);
             m->rlfCause = w.rlfCause;
             m_base->ueRrcTask->push(std::move(m));
+
+            m_servingCell = 0;
+            m_base->gnbRlsTask->push(std::make_unique<NmRgnbRlsToRls>(NmRgnbRlsToRls::UPSTREAM_LOST));
             break;
         }
         case NmUeRlsToRls::TRANSMISSION_FAILURE: {
@@ -80,20 +128,26 @@ void UeRlsTask::onLoop()
             break;
         }
         default: {
-            m_logger->unhandledNts(*msg);
+            m_logger->unhandledNts(msg);
             break;
         }
         }
         break;
     }
     case NtsMessageType::UE_RRC_TO_RLS: {
-        auto &w = dynamic_cast<NmUeRrcToRls &>(*msg);
+        auto &w = dynamic_cast<NmUeRrcToRls &>(msg);
         switch (w.present)
         {
         case NmUeRrcToRls::ASSIGN_CURRENT_CELL: {
             auto m = std::make_unique<NmUeRlsToRls>(NmUeRlsToRls::ASSIGN_CURRENT_CELL);
             m->cellId = w.cellId;
-            m_ctlTask->push(std::move(m));
+            m_ctlTask->deliver(std::move(m));
+
+            m_servingCell = w.cellId;
+            m_base->gnbRlsTask->push(std::make_unique<NmRgnbRlsToRls>(NmRgnbRlsToRls::UPSTREAM_CHANGED));
+
+            if (m_base->gnbConfig->bapAddress.has_value())
+                announceBapAddress();
             break;
         }
         case NmUeRrcToRls::RRC_PDU_DELIVERY: {
@@ -102,7 +156,7 @@ void UeRlsTask::onLoop()
             m->rrcChannel = w.channel;
             m->pduId = w.pduId;
             m->data = std::move(w.pdu);
-            m_ctlTask->push(std::move(m));
+            m_ctlTask->deliver(std::move(m));
             break;
         }
         case NmUeRrcToRls::RESET_STI: {
@@ -112,30 +166,61 @@ void UeRlsTask::onLoop()
         }
         break;
     }
+    case NtsMessageType::RGNB_RLS_TO_RLS: {
+        auto &w = dynamic_cast<NmRgnbRlsToRls &>(msg);
+        switch (w.present)
+        {
+        case NmRgnbRlsToRls::UPLINK_RELAY: {
+            auto m = std::make_unique<NmUeRlsToRls>(NmUeRlsToRls::UPLINK_RELAY);
+            m->bapContext = w.bapContext;
+            m->data = std::move(w.pdu);
+            m_ctlTask->deliver(std::move(m));
+            break;
+        }
+        case NmRgnbRlsToRls::CREDIT_STATUS: {
+            auto m = std::make_unique<NmUeRlsToRls>(NmUeRlsToRls::CREDIT_STATUS);
+            m->credit = w.credit;
+            m_ctlTask->deliver(std::move(m));
+            break;
+        }
+        default: {
+            m_logger->unhandledNts(msg);
+            break;
+        }
+        }
+        break;
+    }
     case NtsMessageType::UE_NAS_TO_RLS: {
-        auto &w = dynamic_cast<NmUeNasToRls &>(*msg);
+        auto &w = dynamic_cast<NmUeNasToRls &>(msg);
         switch (w.present)
         {
         case NmUeNasToRls::DATA_PDU_DELIVERY: { // TODO: will be received from RGNB GNB part instead
             auto m = std::make_unique<NmUeRlsToRls>(NmUeRlsToRls::UPLINK_DATA);
             m->psi = w.psi;
             m->data = std::move(w.pdu);
-            m_ctlTask->push(std::move(m));
+            m_ctlTask->deliver(std::move(m));
             break;
         }
         }
         break;
     }
     default:
-        m_logger->unhandledNts(*msg);
+        m_logger->unhandledNts(msg);
         break;
     }
 }
 
 void UeRlsTask::onQuit()
 {
-    m_udpTask->quit();
-    m_ctlTask->quit();
+    if (isFused())
+    {
+        m_ctlTask->quitFused();
+    }
+    else
+    {
+        m_udpTask->quit();
+        m_ctlTask->quit();
+    }
 
     delete m_udpTask;
     delete m_ctlTask;
@@ -143,4 +228,16 @@ void UeRlsTask::onQuit()
     delete m_shCtx;
 }
 
+void UeRlsTask::announceBapAddress()
+{
+    // Lets the parent learn the BAP address of this relay before any traffic flows
+    OctetString pdu;
+    rls::EncodeBapHeader(rls::BapHeader{false, 0, 0}, pdu);
+
+    auto m = std::make_unique<NmUeRlsToRls>(NmUeRlsToRls::UPLINK_RELAY);
+    m->bapContext = rls::EncodeBapContext(rls::BapContext{*m_base->gnbConfig->bapAddress, 0, 0});
+    m->data = std::move(pdu);
+    m_ctlTask->deliver(std::move(m));
+}
+
 } // namespace nr::rgnb
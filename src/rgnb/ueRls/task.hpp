@@ -20,6 +20,7 @@
 #include <lib/rls/rls_pdu.hpp>
 #include <lib/rrc/rrc.hpp>
 #include <lib/udp/server_task.hpp>
+#include <rgnb/fused.hpp>
 #include <rgnb/types.hpp>
 #include <utils/common_types.hpp>
 #include <utils/logger.hpp>
@@ -28,7 +29,7 @@
 namespace nr::rgnb
 {
 
-class UeRlsTask : public NtsTask
+class UeRlsTask : public FusableTask
 {
   private:
     TaskBase *m_base;
@@ -38,6 +39,8 @@ class UeRlsTask : public NtsTask
     UeRlsUdpTask *m_udpTask;
     UeRlsControlTask *m_ctlTask;
 
+    int m_servingCell;
+
     friend class UeCmdHandler;
 
   public:
@@ -47,7 +50,11 @@ class UeRlsTask : public NtsTask
   protected:
     void onStart() override;
     void onLoop() override;
+    void handleMessage(NtsMessage &msg) override;
     void onQuit() override;
+
+  private:
+    void announceBapAddress();
 };
 
 } // namespace nr::rgnb
\ No newline at end of file
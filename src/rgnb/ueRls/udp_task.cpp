@@ -17,24 +17,36 @@
 #include <utils/constants.hpp>
 
 static constexpr const int BUFFER_SIZE = 16384;
-static constexpr const int LOOP_PERIOD = 1000;
-static constexpr const int RECEIVE_TIMEOUT = 200;
-static constexpr const int HEARTBEAT_THRESHOLD = 2000; // (LOOP_PERIOD + RECEIVE_TIMEOUT)'dan büyük olmalı
+static constexpr const int RECEIVE_TIMEOUT = 50;
+static constexpr const int SERVING_PROBE_PERIOD = 100;
+static constexpr const int SERVING_LOSS_THRESHOLD = 350; // must be greater than (SERVING_PROBE_PERIOD + RECEIVE_TIMEOUT)
+
+static bool IsSameAddress(const InetAddress &a, const InetAddress &b)
+{
+    return a.getSockLen() == b.getSockLen() && std::memcmp(a.getSockAddr(), b.getSockAddr(), a.getSockLen()) == 0;
+}
 
 namespace nr::rgnb
 {
 
 UeRlsUdpTask::UeRlsUdpTask(TaskBase *base, RlsSharedContext *shCtx, const std::vector<std::string> &searchSpace)
-    : m_server{}, m_ctlTask{}, m_shCtx{shCtx}, m_searchSpace{}, m_cells{}, m_cellIdToSti{}, m_lastLoop{},
-      m_cellIdCounter{}
+    : m_transport{}, m_ctlTask{}, m_shCtx{shCtx}, m_searchSpace{}, m_sessions{}, m_sessionCounter{}, m_cells{},
+      m_cellIdToSti{}, m_pacer{}, m_now{}, m_lastProbe{}, m_cellIdCounter{}
 {
     m_logger = base->logBase->makeUniqueLogger(base->ueConfig->getLoggerPrefix() + "rls-udp");
 
-    m_server = new udp::UdpServer();
+    m_transport = rls::RlsTransport::Create(base->ueConfig->linkTransport);
+    if (base->gnbConfig->channel)
+        m_transport = std::make_unique<rls::ChannelTransport>(std::move(m_transport), *base->gnbConfig->channel,
+                                                              static_cast<uint64_t>(base->gnbConfig->nci) << 1 | 1);
 
     for (auto &ip : searchSpace)
         m_searchSpace.emplace_back(ip, cons::RadioLinkPort);
 
+    // Sessions of a restarted process must still look newer to the cells that remember the previous one
+    m_sessionCounter = static_cast<uint32_t>(utils::CurrentTimeMillis() / 1000) | 1;
+    m_sessions.assign(m_searchSpace.size(), m_sessionCounter);
+
     m_simPos = Vector3{};
 }
 
@@ -43,56 +55,114 @@ void UeRlsUdpTask::onStart()
 }
 
 void UeRlsUdpTask::onLoop()
+{
+    serve(RECEIVE_TIMEOUT);
+}
+
+void UeRlsUdpTask::serve(int receiveTimeout)
 {
     auto current = utils::CurrentTimeMillis();
-    if (current - m_lastLoop > LOOP_PERIOD)
+    m_now = current;
+    heartbeatCycle(current, m_simPos);
+
+    if (current - m_lastProbe > SERVING_PROBE_PERIOD)
     {
-        m_lastLoop = current;
-        heartbeatCycle(current, m_simPos);
+        m_lastProbe = current;
+        probeServingCell(current);
     }
 
     uint8_t buffer[BUFFER_SIZE];
     InetAddress peerAddress;
 
-    int size = m_server->Receive(buffer, BUFFER_SIZE, RECEIVE_TIMEOUT, peerAddress);
+    int size = m_transport->receive(buffer, BUFFER_SIZE, receiveTimeout, peerAddress);
     if (size > 0)
     {
-        auto rlsMsg = rls::DecodeRlsMessage(OctetView{buffer, static_cast<size_t>(size)});
-        if (rlsMsg == nullptr)
+        m_now = utils::CurrentTimeMillis();
+        receive(peerAddress, buffer, static_cast<size_t>(size));
+    }
+}
+
+void UeRlsUdpTask::receive(const InetAddress &addr, const uint8_t *data, size_t size)
+{
+    // User PDUs are decoded in place, the PDU is copied out of the buffer only if its cell is known
+    if (rls::PeekRlsMessageType(data, size) == rls::EMessageType::PDU_TRANSMISSION)
+    {
+        rls::RlsPduTransmissionView pdu{};
+        if (!rls::DecodeRlsPduTransmission(data, size, pdu))
+        {
             m_logger->err("Unable to decode RLS message");
-        else
-            receiveRlsPdu(peerAddress, std::move(rlsMsg));
+            return;
+        }
+
+        int cellId = acceptFromCell(pdu.sti, pdu.ack);
+        if (cellId == 0)
+            return;
+
+        auto w = std::make_unique<NmUeRlsToRls>(NmUeRlsToRls::RECEIVE_RLS_MESSAGE);
+        w->cellId = cellId;
+        w->msg = std::make_unique<rls::RlsPduTransmission>(pdu.toMessage());
+        m_ctlTask->deliver(std::move(w));
+        return;
     }
+
+    auto rlsMsg = rls::DecodeRlsMessage(data, size);
+    if (rlsMsg == nullptr)
+        m_logger->err("Unable to decode RLS message");
+    else
+        receiveRlsPdu(addr, std::move(rlsMsg));
 }
 
 void UeRlsUdpTask::onQuit()
 {
-    delete m_server;
+    m_transport.reset();
 }
 
-void UeRlsUdpTask::sendRlsPdu(const InetAddress &addr, const rls::RlsMessage &msg)
+void UeRlsUdpTask::sendRlsPdu(const InetAddress &addr, const rls::RlsMessage &msg, int cellId)
 {
     OctetString stream;
     rls::EncodeRlsMessage(msg, stream);
 
-    m_server->Send(addr, stream.data(), static_cast<size_t>(stream.length()));
+    // Acks owed to the cell ride on whatever is sent to it
+    auto ack = m_shCtx->acks.takeAck(cellId);
+    if (ack)
+        rls::EncodeRlsAckBlock(*ack, stream);
+
+    m_transport->send(addr, stream.data(), static_cast<size_t>(stream.length()));
 }
 
 void UeRlsUdpTask::send(int cellId, const rls::RlsMessage &msg)
 {
     if (m_cellIdToSti.count(cellId))
     {
-        auto sti = m_cellIdToSti[cellId];
-        sendRlsPdu(m_cells[sti].address, msg);
+        auto &cell = m_cells[m_cellIdToSti[cellId]];
+        cell.lastSent = m_now;
+        sendRlsPdu(cell.address, msg, cellId);
     }
 }
 
+void UeRlsUdpTask::resetCell(int cellId)
+{
+    // The cell learns of the reset by the newer session of the heartbeats that re-detect it
+    if (!m_cellIdToSti.count(cellId))
+        return;
+
+    dropCell(m_cellIdToSti[cellId]);
+    m_pacer.notifyChange();
+    onSignalChangeOrLost(cellId);
+}
+
 void UeRlsUdpTask::receiveRlsPdu(const InetAddress &addr, std::unique_ptr<rls::RlsMessage> &&msg)
 {
     if (msg->msgType == rls::EMessageType::HEARTBEAT_ACK)
     {
         if (!m_cells.count(msg->sti))
         {
+            // An ack of a heartbeat of the previous session may still be in flight, the cell has not reset yet
+            uint32_t session = ((const rls::RlsHeartBeatAck &)*msg).session;
+            uint32_t current = sessionOf(addr);
+            if (session != 0 && current != 0 && session != current)
+                return;
+
             m_cells[msg->sti].cellId = ++m_cellIdCounter;
             m_cellIdToSti[m_cells[msg->sti].cellId] = msg->sti;
         }
@@ -102,26 +172,48 @@ void UeRlsUdpTask::receiveRlsPdu(const InetAddress &addr, std::unique_ptr<rls::R
             oldDbm = m_cells[msg->sti].dbm;
 
         m_cells[msg->sti].address = addr;
-        m_cells[msg->sti].lastSeen = utils::CurrentTimeMillis();
+        m_cells[msg->sti].lastSeen = m_now;
 
         int newDbm = ((const rls::RlsHeartBeatAck &)*msg).dbm;
         m_cells[msg->sti].dbm = newDbm;
+        m_transport->setLinkQuality(msg->sti, newDbm);
+
+        if (msg->ack)
+            m_shCtx->acks.acknowledge(m_cells[msg->sti].cellId, *msg->ack);
 
         if (oldDbm != newDbm)
+        {
+            m_pacer.notifyChange();
             onSignalChangeOrLost(m_cells[msg->sti].cellId);
+        }
         return;
     }
 
-    if (!m_cells.count(msg->sti))
-    {
-        // if no HB-ACK received yet, and the message is not HB-ACK, then ignore the message
+    int cellId = acceptFromCell(msg->sti, msg->ack);
+    if (cellId == 0)
         return;
-    }
 
     auto w = std::make_unique<NmUeRlsToRls>(NmUeRlsToRls::RECEIVE_RLS_MESSAGE);
-    w->cellId = m_cells[msg->sti].cellId;
+    w->cellId = cellId;
     w->msg = std::move(msg);
-    m_ctlTask->push(std::move(w));
+    m_ctlTask->deliver(std::move(w));
+}
+
+int UeRlsUdpTask::acceptFromCell(uint64_t sti, const std::optional<rls::RlsAckBlock> &ack)
+{
+    auto it = m_cells.find(sti);
+    if (it == m_cells.end())
+    {
+        // if no HB-ACK received yet, and the message is not HB-ACK, then ignore the message
+        return 0;
+    }
+
+    // Any traffic of the cell keeps it alive
+    it->second.lastSeen = m_now;
+
+    if (ack)
+        m_shCtx->acks.acknowledge(it->second.cellId, *ack);
+    return it->second.cellId;
 }
 
 void UeRlsUdpTask::onSignalChangeOrLost(int cellId)
@@ -136,38 +228,116 @@ void UeRlsUdpTask::onSignalChangeOrLost(int cellId)
     auto w = std::make_unique<NmUeRlsToRls>(NmUeRlsToRls::SIGNAL_CHANGED);
     w->cellId = cellId;
     w->dbm = dbm;
-    m_ctlTask->push(std::move(w));
+    m_ctlTask->deliver(std::move(w));
 }
 
 void UeRlsUdpTask::heartbeatCycle(uint64_t time, const Vector3 &simPos)
 {
     std::set<std::pair<uint64_t, int>> toRemove;
 
+    int64_t threshold = rls::HeartbeatTimeout(m_pacer.interval());
     for (auto &cell : m_cells)
     {
-        auto delta = time - cell.second.lastSeen;
-        if (delta > HEARTBEAT_THRESHOLD)
+        auto delta = static_cast<int64_t>(time) - cell.second.lastSeen;
+        if (delta > threshold)
             toRemove.insert({cell.first, cell.second.cellId});
     }
 
     for (auto cell : toRemove)
-    {
-        m_cells.erase(cell.first);
-        m_cellIdToSti.erase(cell.second);
-    }
+        dropCell(cell.first);
 
     for (auto cell : toRemove)
         onSignalChangeOrLost(cell.second);
 
-    for (auto &addr : m_searchSpace)
+    if (!toRemove.empty())
+        m_pacer.notifyChange();
+
+    if (!m_pacer.isDue(static_cast<int64_t>(time)))
+        return;
+
+    int interval = m_pacer.startRound(static_cast<int64_t>(time), m_cells.empty());
+
+    for (size_t i = 0; i < m_searchSpace.size(); i++)
     {
+        auto &addr = m_searchSpace[i];
+
+        // Cells exchanging traffic with the relay need no heartbeat
+        bool isSuppressed = false;
+        for (auto &cell : m_cells)
+        {
+            if (IsSameAddress(cell.second.address, addr))
+                isSuppressed = m_pacer.isSuppressed(cell.second.lastSent, cell.second.lastSeen,
+                                                    static_cast<int64_t>(time));
+        }
+        if (isSuppressed)
+            continue;
+
         rls::RlsHeartBeat msg{m_shCtx->sti};
         msg.simPos = simPos;
-        sendRlsPdu(addr, msg);
+        msg.interval = interval;
+        msg.session = m_sessions[i];
+        sendRlsPdu(addr, msg, 0);
+    }
+}
+
+void UeRlsUdpTask::probeServingCell(int64_t time)
+{
+    int cellId = m_shCtx->servingCell;
+    if (cellId == 0 || !m_cellIdToSti.count(cellId))
+        return;
+
+    auto sti = m_cellIdToSti[cellId];
+    auto &cell = m_cells[sti];
+
+    // The parent is declared lost long before the regular heartbeat threshold, so that the standby can take over
+    if (time - cell.lastSeen > SERVING_LOSS_THRESHOLD)
+    {
+        m_logger->debug("Serving cell[%d] missed its heartbeats", cellId);
+        dropCell(sti);
+        onSignalChangeOrLost(cellId);
+        return;
     }
+
+    // Traffic in both directions proves the link as well as the probe would
+    if (time - cell.lastSent < SERVING_PROBE_PERIOD && time - cell.lastSeen < SERVING_PROBE_PERIOD)
+        return;
+
+    rls::RlsHeartBeat msg{m_shCtx->sti};
+    msg.simPos = m_simPos;
+    msg.interval = m_pacer.interval();
+    msg.session = sessionOf(cell.address);
+    sendRlsPdu(cell.address, msg, cellId);
+}
+
+uint32_t UeRlsUdpTask::sessionOf(const InetAddress &addr) const
+{
+    for (size_t i = 0; i < m_searchSpace.size(); i++)
+        if (IsSameAddress(m_searchSpace[i], addr))
+            return m_sessions[i];
+    return 0;
+}
+
+void UeRlsUdpTask::dropCell(uint64_t sti)
+{
+    auto &cell = m_cells[sti];
+
+    // The cell keeps its state of this node until it hears of a newer session, which the re-detection waits for
+    for (size_t i = 0; i < m_searchSpace.size(); i++)
+    {
+        if (IsSameAddress(m_searchSpace[i], cell.address))
+        {
+            if (++m_sessionCounter == 0)
+                m_sessionCounter = 1;
+            m_sessions[i] = m_sessionCounter;
+        }
+    }
+
+    m_cellIdToSti.erase(cell.cellId);
+    m_shCtx->acks.removePeer(cell.cellId);
+    m_cells.erase(sti);
 }
 
-void UeRlsUdpTask::initialize(NtsTask *ctlTask)
+void UeRlsUdpTask::initialize(FusableTask *ctlTask)
 {
     m_ctlTask = ctlTask;
 }
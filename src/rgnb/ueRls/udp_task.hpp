@@ -9,11 +9,14 @@
 #pragma once
 
 #include <cstdint>
+#include <memory>
 #include <unordered_map>
 #include <vector>
 
+#include <lib/rls/rls_heartbeat.hpp>
 #include <lib/rls/rls_pdu.hpp>
-#include <lib/udp/server.hpp>
+#include <lib/rls/rls_transport.hpp>
+#include <rgnb/fused.hpp>
 #include <rgnb/types.hpp>
 #include <utils/nts.hpp>
 
@@ -26,20 +29,25 @@ class UeRlsUdpTask : public NtsTask
     struct CellInfo
     {
         InetAddress address;
-        int64_t lastSeen{};
+        int64_t lastSeen{}; // last message received from the cell
+        int64_t lastSent{}; // last PDU sent to the cell, heartbeats excluded
         int dbm{};
         int cellId{};
     };
 
   private:
     std::unique_ptr<Logger> m_logger;
-    udp::UdpServer *m_server;
-    NtsTask *m_ctlTask;
+    std::unique_ptr<rls::RlsTransport> m_transport;
+    FusableTask *m_ctlTask;
     RlsSharedContext* m_shCtx;
     std::vector<InetAddress> m_searchSpace;
+    std::vector<uint32_t> m_sessions; // link session of each search space entry, see RlsHeartBeat
+    uint32_t m_sessionCounter;
     std::unordered_map<uint64_t, CellInfo> m_cells;
     std::unordered_map<int, uint64_t> m_cellIdToSti;
-    int64_t m_lastLoop;
+    rls::HeartbeatPacer m_pacer;
+    int64_t m_now;
+    int64_t m_lastProbe;
     Vector3 m_simPos;
     int m_cellIdCounter;
 
@@ -55,14 +63,21 @@ class UeRlsUdpTask : public NtsTask
     void onQuit() override;
 
   private:
-    void sendRlsPdu(const InetAddress &addr, const rls::RlsMessage &msg);
+    void sendRlsPdu(const InetAddress &addr, const rls::RlsMessage &msg, int cellId);
+    void receive(const InetAddress &addr, const uint8_t *data, size_t size);
     void receiveRlsPdu(const InetAddress &addr, std::unique_ptr<rls::RlsMessage> &&msg);
+    int acceptFromCell(uint64_t sti, const std::optional<rls::RlsAckBlock> &ack);
+    uint32_t sessionOf(const InetAddress &addr) const;
+    void dropCell(uint64_t sti);
     void onSignalChangeOrLost(int cellId);
     void heartbeatCycle(uint64_t time, const Vector3 &simPos);
+    void probeServingCell(int64_t time);
 
   public:
-    void initialize(NtsTask *ctlTask);
+    void initialize(FusableTask *ctlTask);
+    void serve(int receiveTimeout);
     void send(int cellId, const rls::RlsMessage &msg);
+    void resetCell(int cellId);
 };
 
 } // namespace nr::rgnb
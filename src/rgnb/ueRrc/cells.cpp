@@ -8,7 +8,10 @@
 
 #include "task.hpp"
 
+#include <algorithm>
+
 #include <lib/rrc/encode.hpp>
+#include <rgnb/ueRls/task.hpp>
 
 namespace nr::rgnb
 {
@@ -27,7 +30,10 @@ void UeRrcTask::handleCellSignalChange(int cellId, int dbm)
         if (considerLost)
             notifyCellLost(cellId);
         else
+        {
             m_cellDesc[cellId].dbm = dbm;
+            updateStandbyCells();
+        }
     }
 }
 
@@ -40,6 +46,7 @@ void UeRrcTask::notifyCellDetected(int cellId, int dbm)
                     static_cast<int>(m_cellDesc.size()));
 
     updateAvailablePlmns();
+    updateStandbyCells();
 }
 
 void UeRrcTask::notifyCellLost(int cellId)
@@ -63,7 +70,8 @@ void UeRrcTask::notifyCellLost(int cellId)
     m_logger->debug("Signal lost for cell[%d], total [%d] cells in coverage", cellId,
                     static_cast<int>(m_cellDesc.size()));
 
-    if (isActiveCell)
+    // Switching to the standby does not wait for the next cell selection cycle
+    if (isActiveCell && !performFailover(cellId))
     {
         if (m_state != ERrcState::RRC_IDLE)
             declareRadioLinkFailure(rls::ERlfCause::SIGNAL_LOST_TO_CONNECTED_CELL);
@@ -76,6 +84,7 @@ void UeRrcTask::notifyCellLost(int cellId)
     }
 
     updateAvailablePlmns();
+    updateStandbyCells();
 }
 
 bool UeRrcTask::hasSignalToCell(int cellId)
@@ -100,4 +109,56 @@ void UeRrcTask::updateAvailablePlmns()
 //    m_base->ueNasTask->push(std::make_unique<NmUeRrcToNas>(NmUeRrcToNas::NAS_NOTIFY)); // TODO: if it is more than a notification, this needs to be handled
 }
 
+void UeRrcTask::updateStandbyCells()
+{
+    int activeCell = m_base->shCtx.currentCell.get<int>([](auto &value) { return value.cellId; });
+    Plmn selectedPlmn = m_base->shCtx.selectedPlmn.get();
+
+    // Only the cells the selection could camp on are worth standing by
+    CellSelectionReport report{};
+    m_standbyCells.clear();
+    for (auto &item : m_cellDesc)
+    {
+        if (item.first != activeCell && isSelectableCell(item.second, selectedPlmn, report))
+            m_standbyCells.push_back(item.first);
+    }
+
+    std::sort(m_standbyCells.begin(), m_standbyCells.end(),
+              [this](int a, int b) { return m_cellDesc[b].dbm < m_cellDesc[a].dbm; });
+}
+
+bool UeRrcTask::performFailover(int lostCellId)
+{
+    // The forbidden tracking areas may have changed since the standby list was built
+    Plmn selectedPlmn = m_base->shCtx.selectedPlmn.get();
+    CellSelectionReport report{};
+    auto it = std::find_if(m_standbyCells.begin(), m_standbyCells.end(), [&](int cellId) {
+        return m_cellDesc.count(cellId) && isSelectableCell(m_cellDesc[cellId], selectedPlmn, report);
+    });
+    if (it == m_standbyCells.end())
+        return false;
+
+    int cellId = *it;
+    auto &cell = m_cellDesc[cellId];
+
+    ActiveCellInfo cellInfo{};
+    cellInfo.cellId = cellId;
+    cellInfo.plmn = cell.sib1.plmn;
+    cellInfo.tac = cell.sib1.tac;
+    cellInfo.category = selectedPlmn.hasValue() ? ECellCategory::SUITABLE_CELL : ECellCategory::ACCEPTABLE_CELL;
+    m_base->shCtx.currentCell.set(cellInfo);
+    updateStandbyCells();
+
+    // The RRC connection does not survive the parent change, it is released the same way as any lost radio link
+    if (m_state != ERrcState::RRC_IDLE)
+        declareRadioLinkFailure(rls::ERlfCause::SIGNAL_LOST_TO_CONNECTED_CELL);
+
+    m_logger->info("Cell[%d] lost, failing over to standby cell[%d]", lostCellId, cellId);
+
+    auto w = std::make_unique<NmUeRrcToRls>(NmUeRrcToRls::ASSIGN_CURRENT_CELL);
+    w->cellId = cellId;
+    m_base->ueRlsTask->push(std::move(w));
+    return true;
+}
+
 } // namespace nr::rgnb
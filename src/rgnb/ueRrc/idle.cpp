@@ -102,6 +102,8 @@ void UeRrcTask::performCellSelection()
 
     if (selectedCell != lastCell.cellId)
     {
+        updateStandbyCells();
+
         auto w1 = std::make_unique<NmUeRrcToRls>(NmUeRrcToRls::ASSIGN_CURRENT_CELL);
         w1->cellId = selectedCell;
         m_base->ueRlsTask->push(std::move(w1));
@@ -112,69 +114,74 @@ void UeRrcTask::performCellSelection()
     }
 }
 
-// Cell Selection: identify suitable cell with strongest signal
-bool UeRrcTask::lookForSuitableCell(ActiveCellInfo &cellInfo, CellSelectionReport &report)
+// Cell Selection: criteria of a cell to be camped on, the PLMN is only checked if one is given
+bool UeRrcTask::isSelectableCell(const UeCellDesc &cell, const Plmn &plmn, CellSelectionReport &report)
 {
-    Plmn selectedPlmn = m_base->shCtx.selectedPlmn.get();
-    if (!selectedPlmn.hasValue())
+    if (!cell.sib1.hasSib1)
+    {
+        report.siMissingCells++;
         return false;
+    }
 
-    std::vector<int> candidates;
+    if (!cell.mib.hasMib)
+    {
+        report.siMissingCells++;
+        return false;
+    }
 
-    for (auto &item : m_cellDesc)
+    if (plmn.hasValue() && cell.sib1.plmn != plmn)
     {
-        auto &cell = item.second;
+        report.outOfPlmnCells++;
+        return false;
+    }
 
-        if (!cell.sib1.hasSib1)
-        {
-            report.siMissingCells++;
-            continue;
-        }
+    if (cell.mib.isBarred)
+    {
+        report.barredCells++;
+        return false;
+    }
 
-        if (!cell.mib.hasMib)
-        {
-            report.siMissingCells++;
-            continue;
-        }
+    if (cell.sib1.isReserved)
+    {
+        report.reservedCells++;
+        return false;
+    }
 
-        if (cell.sib1.plmn != selectedPlmn)
-        {
-            report.outOfPlmnCells++;
-            continue;
-        }
+    Tai tai{cell.sib1.plmn, cell.sib1.tac};
 
-        if (cell.mib.isBarred)
-        {
-            report.barredCells++;
-            continue;
-        }
+    if (m_base->shCtx.forbiddenTaiRoaming.get<bool>([&tai](auto &item) {
+            return std::any_of(item.begin(), item.end(), [&tai](auto &element) { return element == tai; });
+        }))
+    {
+        report.forbiddenTaiCells++;
+        return false;
+    }
 
-        if (cell.sib1.isReserved)
-        {
-            report.reservedCells++;
-            continue;
-        }
+    if (m_base->shCtx.forbiddenTaiRps.get<bool>([&tai](auto &item) {
+            return std::any_of(item.begin(), item.end(), [&tai](auto &element) { return element == tai; });
+        }))
+    {
+        report.forbiddenTaiCells++;
+        return false;
+    }
 
-        Tai tai{cell.sib1.plmn, cell.sib1.tac};
+    return true;
+}
 
-        if (m_base->shCtx.forbiddenTaiRoaming.get<bool>([&tai](auto &item) {
-                return std::any_of(item.begin(), item.end(), [&tai](auto &element) { return element == tai; });
-            }))
-        {
-            report.forbiddenTaiCells++;
-            continue;
-        }
+// Cell Selection: identify suitable cell with strongest signal
+bool UeRrcTask::lookForSuitableCell(ActiveCellInfo &cellInfo, CellSelectionReport &report)
+{
+    Plmn selectedPlmn = m_base->shCtx.selectedPlmn.get();
+    if (!selectedPlmn.hasValue())
+        return false;
 
-        if (m_base->shCtx.forbiddenTaiRps.get<bool>([&tai](auto &item) {
-                return std::any_of(item.begin(), item.end(), [&tai](auto &element) { return element == tai; });
-            }))
-        {
-            report.forbiddenTaiCells++;
-            continue;
-        }
+    std::vector<int> candidates;
 
+    for (auto &item : m_cellDesc)
+    {
         // It seems suitable
-        candidates.push_back(item.first);
+        if (isSelectableCell(item.second, selectedPlmn, report))
+            candidates.push_back(item.first);
     }
 
     if (candidates.empty())
@@ -205,52 +212,9 @@ bool UeRrcTask::lookForAcceptableCell(ActiveCellInfo &cellInfo, CellSelectionRep
 
     for (auto &item : m_cellDesc)
     {
-        auto &cell = item.second;
-
-        if (!cell.sib1.hasSib1)
-        {
-            report.siMissingCells++;
-            continue;
-        }
-
-        if (!cell.mib.hasMib)
-        {
-            report.siMissingCells++;
-            continue;
-        }
-
-        if (cell.mib.isBarred)
-        {
-            report.barredCells++;
-            continue;
-        }
-
-        if (cell.sib1.isReserved)
-        {
-            report.reservedCells++;
-            continue;
-        }
-
-        Tai tai{cell.sib1.plmn, cell.sib1.tac};
-
-        if (m_base->shCtx.forbiddenTaiRoaming.get<bool>([&tai](auto &item) {
-                return std::any_of(item.begin(), item.end(), [&tai](auto &element) { return element == tai; });
-            }))
-        {
-            report.forbiddenTaiCells++;
-            continue;
-        }
-
-        if (m_base->shCtx.forbiddenTaiRps.get<bool>([&tai](auto &item) {
-                return std::any_of(item.begin(), item.end(), [&tai](auto &element) { return element == tai; });
-            }))
-        {
-            report.forbiddenTaiCells++;
-            continue;
-        }
-
         // It seems acceptable
-        candidates.push_back(item.first);
+        if (isSelectableCell(item.second, Plmn{}, report))
+            candidates.push_back(item.first);
     }
 
     if (candidates.empty())
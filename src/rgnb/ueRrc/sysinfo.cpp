@@ -31,6 +31,7 @@ void UeRrcTask::receiveMib(int cellId, const ASN_RRC_MIB &msg)
     desc.mib.hasMib = true;
 
     updateAvailablePlmns();
+    updateStandbyCells();
 }
 
 void UeRrcTask::receiveSib1(int cellId, const ASN_RRC_SIB1 &msg)
@@ -64,6 +65,7 @@ void UeRrcTask::receiveSib1(int cellId, const ASN_RRC_SIB1 &msg)
     desc.sib1.hasSib1 = true;
 
     updateAvailablePlmns();
+    updateStandbyCells();
 }
 
 } // namespace nr::rgnb
\ No newline at end of file
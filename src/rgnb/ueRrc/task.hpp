@@ -60,6 +60,7 @@ class UeRrcTask : public NtsTask
 
     /* Cell and PLMN related */
     std::unordered_map<int, UeCellDesc> m_cellDesc{};
+    std::vector<int> m_standbyCells{}; // ranked candidates to take over from the active cell
     int64_t m_lastTimePlmnSearchFailureLogged{};
 
     /* Procedure related */
@@ -111,6 +112,7 @@ class UeRrcTask : public NtsTask
     void performCellSelection();
     bool lookForSuitableCell(ActiveCellInfo &cellInfo, CellSelectionReport &report);
     bool lookForAcceptableCell(ActiveCellInfo &cellInfo, CellSelectionReport &report);
+    bool isSelectableCell(const UeCellDesc &cell, const Plmn &plmn, CellSelectionReport &report);
 
     /* Cell Management */
     void handleCellSignalChange(int cellId, int dbm);
@@ -119,6 +121,8 @@ class UeRrcTask : public NtsTask
     bool hasSignalToCell(int cellId);
     bool isActiveCell(int cellId);
     void updateAvailablePlmns();
+    void updateStandbyCells();
+    bool performFailover(int lostCellId);
 
     /* System Information and Broadcast */
     void receiveMib(int cellId, const ASN_RRC_MIB &msg);
@@ -6,6 +6,7 @@
 // See README, LICENSE, and CONTRIBUTING files for licensing details.
 //
 
+#include <algorithm>
 #include <chrono>
 #include <iostream>
 #include <stdexcept>
@@ -18,6 +19,8 @@
 #include <lib/app/cli_cmd.hpp>
 #include <lib/app/proc_table.hpp>
 #include <lib/app/ue_ctl.hpp>
+#include <ue/rls/coalescer.hpp>
+#include <ue/rls/endpoint.hpp>
 #include <ue/ue.hpp>
 #include <utils/common.hpp>
 #include <utils/concurrent_map.hpp>
@@ -30,6 +33,8 @@ static app::CliServer *g_cliServer = nullptr;
 static nr::ue::UeConfig *g_refConfig = nullptr;
 static ConcurrentMap<std::string, nr::ue::UserEquipment *> g_ueMap{};
 static app::CliResponseTask *g_cliRespTask = nullptr;
+static nr::ue::HeartbeatCoalescer *g_heartbeatCoalescer = nullptr;
+static nr::ue::RlsEndpointTask *g_rlsEndpoint = nullptr;
 
 static struct Options
 {
@@ -100,6 +105,48 @@ class UeControllerTask : public NtsTask
 
 static UeControllerTask *g_controllerTask;
 
+static rls::ELinkTransport ReadLinkTransport(const YAML::Node &config)
+{
+    std::string transport = yaml::GetString(config, "linkTransport");
+    if (transport == "udp")
+        return rls::ELinkTransport::UDP;
+    if (transport == "shm")
+        return rls::ELinkTransport::SHARED_MEMORY;
+    throw std::runtime_error("Invalid linkTransport: " + transport);
+}
+
+static rls::ChannelProfile ReadChannelProfile(const YAML::Node &band)
+{
+    rls::ChannelProfile p{};
+    if (yaml::HasField(band, "minDbm"))
+        p.minDbm = yaml::GetInt32(band, "minDbm", -120, 0);
+    if (yaml::HasField(band, "loss"))
+        p.loss = yaml::GetDouble(band, "loss", 0.0, 1.0);
+    if (yaml::HasField(band, "burst"))
+    {
+        auto burst = band["burst"];
+        p.burstEnter = yaml::GetDouble(burst, "enter", 0.0, 1.0);
+        p.burstExit = yaml::GetDouble(burst, "exit", 0.0, 1.0);
+        if (yaml::HasField(burst, "loss"))
+            p.burstLoss = yaml::GetDouble(burst, "loss", 0.0, 1.0);
+    }
+    if (yaml::HasField(band, "delay"))
+        p.delay = yaml::GetInt32(band, "delay", 0, 10000);
+    if (yaml::HasField(band, "jitter"))
+        p.jitter = yaml::GetInt32(band, "jitter", 0, 10000);
+    if (yaml::HasField(band, "reorder"))
+        p.reorder = yaml::GetDouble(band, "reorder", 0.0, 1.0);
+    if (yaml::HasField(band, "reorderDelay"))
+        p.reorderDelay = yaml::GetInt32(band, "reorderDelay", 1, 10000);
+    if (yaml::HasField(band, "rate"))
+        p.rate = yaml::GetInt32(band, "rate", 0, std::nullopt);
+    if (yaml::HasField(band, "bucket"))
+        p.burst = yaml::GetInt32(band, "bucket", 0, std::nullopt);
+    if (yaml::HasField(band, "queue"))
+        p.queue = yaml::GetInt32(band, "queue", 0, 10000);
+    return p;
+}
+
 static nr::ue::UeConfig *ReadConfigYaml()
 {
     auto *result = new nr::ue::UeConfig();
@@ -162,6 +209,24 @@ static nr::ue::UeConfig *ReadConfigYaml()
         result->imeiSv = yaml::GetString(config, "imeiSv", 16, 16);
     if (yaml::HasField(config, "tunName"))
         result->tunName = yaml::GetString(config, "tunName", 1, 12);
+    if (yaml::HasField(config, "tunQueues"))
+        result->tunQueues = yaml::GetInt32(config, "tunQueues", 1, 16);
+    if (yaml::HasField(config, "linkTransport"))
+        result->linkTransport = ReadLinkTransport(config);
+    if (yaml::HasField(config, "channel"))
+    {
+        auto channel = config["channel"];
+        rls::ChannelConfig c{};
+        if (yaml::HasField(channel, "seed"))
+            c.seed = static_cast<uint64_t>(yaml::GetInt64(channel, "seed", 0, std::nullopt));
+        for (auto &band : yaml::GetSequence(channel, "bands"))
+            c.bands.push_back(ReadChannelProfile(band));
+        if (c.bands.empty())
+            throw std::runtime_error("Channel emulation needs at least one band");
+
+        std::stable_sort(c.bands.begin(), c.bands.end(), [](auto &a, auto &b) { return a.minDbm > b.minDbm; });
+        result->channel = std::move(c);
+    }
 
     yaml::AssertHasField(config, "integrity");
     yaml::AssertHasField(config, "ciphering");
@@ -360,6 +425,9 @@ static nr::ue::UeConfig *GetConfigByUe(int ueIndex)
     c->homeNetworkPublicKeyId = g_refConfig->homeNetworkPublicKeyId;
     c->routingIndicator = g_refConfig->routingIndicator;
     c->tunName = g_refConfig->tunName;
+    c->tunQueues = g_refConfig->tunQueues;
+    c->linkTransport = g_refConfig->linkTransport;
+    c->channel = g_refConfig->channel;
     c->hplmn = g_refConfig->hplmn;
     c->configuredNssai = g_refConfig->configuredNssai;
     c->defaultConfiguredNssai = g_refConfig->defaultConfiguredNssai;
@@ -505,10 +573,23 @@ int main(int argc, char **argv)
         g_cliRespTask = new app::CliResponseTask(g_cliServer);
     }
 
+    // UEs of the same process send their heartbeats together, shared memory links make that unnecessary
+    if (g_options.count > 1 && g_refConfig->linkTransport == rls::ELinkTransport::UDP)
+    {
+        g_heartbeatCoalescer = new nr::ue::HeartbeatCoalescer(new LogBase("logs/ue-heartbeat.log"),
+                                                              g_refConfig->gnbSearchList);
+        g_heartbeatCoalescer->start();
+
+        // and receive over a single socket, instead of a socket pair per UE
+        g_rlsEndpoint = new nr::ue::RlsEndpointTask();
+        g_rlsEndpoint->start();
+    }
+
     for (int i = 0; i < g_options.count; i++)
     {
         auto *config = GetConfigByUe(i);
-        auto *ue = new nr::ue::UserEquipment(config, &g_ueController, nullptr, g_cliRespTask);
+        auto *ue = new nr::ue::UserEquipment(config, &g_ueController, nullptr, g_cliRespTask, g_heartbeatCoalescer,
+                                             g_rlsEndpoint);
         g_ueMap.put(config->getNodeName(), ue);
     }
 
@@ -183,8 +183,8 @@ void UeAppTask::setupTunInterface(const PduSession *pduSession)
     std::string requestedName = cons::TunNamePrefix;
     if (m_base->config->tunName.has_value())
         requestedName = *m_base->config->tunName;
-    int fd = tun::TunAllocate(requestedName.c_str(), allocatedName, error);
-    if (fd == 0 || error.length() > 0)
+    auto fds = tun::TunAllocate(requestedName.c_str(), m_base->config->tunQueues, allocatedName, error);
+    if (fds.empty() || error.length() > 0)
     {
         m_logger->err("TUN allocation failure [%s]", error.c_str());
         return;
@@ -199,7 +199,7 @@ void UeAppTask::setupTunInterface(const PduSession *pduSession)
         return;
     }
 
-    auto *task = new TunTask(m_base, psi, fd);
+    auto *task = new TunTask(m_base, psi, std::move(fds));
     m_tunTasks[psi] = task;
     task->start();
 
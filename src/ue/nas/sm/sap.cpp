@@ -13,11 +13,20 @@
 #include <lib/nas/proto_conf.hpp>
 #include <ue/app/task.hpp>
 #include <ue/nas/mm/mm.hpp>
+#include <ue/rls/fast_path.hpp>
 #include <ue/rls/task.hpp>
 
 namespace nr::ue
 {
 
+static bool IsDataAllowed(EMmSubState state)
+{
+    return state == EMmSubState::MM_REGISTERED_INITIATED_PS || state == EMmSubState::MM_REGISTERED_NORMAL_SERVICE ||
+           state == EMmSubState::MM_REGISTERED_NON_ALLOWED_SERVICE ||
+           state == EMmSubState::MM_REGISTERED_LIMITED_SERVICE || state == EMmSubState::MM_DEREGISTERED_INITIATED_PS ||
+           state == EMmSubState::MM_SERVICE_REQUEST_INITIATED_PS;
+}
+
 void NasSm::handleNasEvent(const NmUeNasToNas &msg)
 {
     if (m_mm->m_mmState == EMmState::MM_NULL)
@@ -49,11 +58,7 @@ void NasSm::onTimerTick()
 
 void NasSm::handleUplinkDataRequest(int psi, OctetString &&data)
 {
-    auto state = m_mm->m_mmSubState;
-    if (state != EMmSubState::MM_REGISTERED_INITIATED_PS && state != EMmSubState::MM_REGISTERED_NORMAL_SERVICE &&
-        state != EMmSubState::MM_REGISTERED_NON_ALLOWED_SERVICE &&
-        state != EMmSubState::MM_REGISTERED_LIMITED_SERVICE && state != EMmSubState::MM_DEREGISTERED_INITIATED_PS &&
-        state != EMmSubState::MM_SERVICE_REQUEST_INITIATED_PS)
+    if (!IsDataAllowed(m_mm->m_mmSubState))
         return;
 
     if (m_pduSessions[psi]->psState != EPsState::ACTIVE)
@@ -90,11 +95,7 @@ void NasSm::handleDownlinkDataRequest(int psi, OctetString &&data)
     if (m_mm->m_cmState == ECmState::CM_IDLE)
         return;
 
-    auto state = m_mm->m_mmSubState;
-    if (state != EMmSubState::MM_REGISTERED_INITIATED_PS && state != EMmSubState::MM_REGISTERED_NORMAL_SERVICE &&
-        state != EMmSubState::MM_REGISTERED_NON_ALLOWED_SERVICE &&
-        state != EMmSubState::MM_REGISTERED_LIMITED_SERVICE && state != EMmSubState::MM_DEREGISTERED_INITIATED_PS &&
-        state != EMmSubState::MM_SERVICE_REQUEST_INITIATED_PS)
+    if (!IsDataAllowed(m_mm->m_mmSubState))
         return;
 
     auto w = std::make_unique<NmUeNasToApp>(NmUeNasToApp::DOWNLINK_DATA_DELIVERY);
@@ -104,4 +105,18 @@ void NasSm::handleDownlinkDataRequest(int psi, OctetString &&data)
     m_base->appTask->push(std::move(w));
 }
 
+void NasSm::publishUserPlaneState()
+{
+    // Uplink of a session marked pending takes the slow path, which reports the change of its status
+    std::bitset<16> sessions{};
+    for (int psi = 1; psi < static_cast<int>(m_pduSessions.size()); psi++)
+    {
+        auto *session = m_pduSessions[psi];
+        sessions[psi] = session != nullptr && session->psState == EPsState::ACTIVE && !session->uplinkPending;
+    }
+
+    bool dataAllowed = IsDataAllowed(m_mm->m_mmSubState) && m_mm->m_cmState == ECmState::CM_CONNECTED;
+    m_base->fastPath->setNasState(dataAllowed, sessions);
+}
+
 } // namespace nr::ue
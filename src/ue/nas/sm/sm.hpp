@@ -94,6 +94,7 @@ class NasSm
     void onTimerTick();
     void handleUplinkDataRequest(int psi, OctetString &&data);
     void handleDownlinkDataRequest(int psi, OctetString &&data);
+    void publishUserPlaneState();
 };
 
 } // namespace nr::ue
\ No newline at end of file
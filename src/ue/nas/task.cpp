@@ -124,6 +124,9 @@ void NasTask::onLoop()
         logger->unhandledNts(*msg);
         break;
     }
+
+    // Any of the messages may change the state the user plane is forwarded by
+    sm->publishUserPlaneState();
 }
 
 void NasTask::performTick()
@@ -0,0 +1,145 @@
+//
+// This file is a part of UERANSIM project.
+// Copyright (c) 2023 ALİ GÜNGÖR.
+//
+// https://github.com/aligungr/UERANSIM/
+// See README, LICENSE, and CONTRIBUTING files for licensing details.
+//
+
+#include "coalescer.hpp"
+
+#include <utils/common.hpp>
+#include <utils/constants.hpp>
+
+static constexpr const int BUFFER_SIZE = 16384;
+static constexpr const int COALESCING_WINDOW = 50;
+static constexpr const int MAX_RECEIVE_PER_LOOP = 64;
+static constexpr const int DRAIN_TIMEOUT = 1; // ms, a zero timeout would wait indefinitely
+
+namespace nr::ue
+{
+
+HeartbeatCoalescer::HeartbeatCoalescer(LogBase *logBase, const std::vector<std::string> &searchSpace)
+    : m_server{}, m_searchSpace{}, m_mutex{}, m_pending{}, m_acks{}, m_lastFlush{}
+{
+    m_logger = logBase->makeUniqueLogger("rls-hb");
+
+    m_server = new udp::UdpServer();
+
+    for (auto &ip : searchSpace)
+        m_searchSpace.emplace_back(ip, cons::RadioLinkPort);
+}
+
+void HeartbeatCoalescer::onStart()
+{
+}
+
+void HeartbeatCoalescer::onLoop()
+{
+    auto current = utils::CurrentTimeMillis();
+    if (current - m_lastFlush >= COALESCING_WINDOW)
+    {
+        m_lastFlush = current;
+        flush();
+    }
+
+    uint8_t buffer[BUFFER_SIZE];
+    InetAddress peerAddress;
+
+    // Acks of all gNBs arrive at once after a flush
+    int timeout = COALESCING_WINDOW;
+    for (int i = 0; i < MAX_RECEIVE_PER_LOOP; i++)
+    {
+        int size = m_server->Receive(buffer, BUFFER_SIZE, timeout, peerAddress);
+        if (size <= 0)
+            break;
+        timeout = DRAIN_TIMEOUT;
+
+        auto rlsMsg = rls::DecodeRlsMessage(OctetView{buffer, static_cast<size_t>(size)});
+        if (rlsMsg == nullptr)
+            m_logger->err("Unable to decode RLS message");
+        else if (rlsMsg->msgType == rls::EMessageType::HEARTBEAT_ACK_AGGREGATE)
+            receiveAck(peerAddress, (const rls::RlsHeartBeatAckAggregate &)*rlsMsg);
+    }
+}
+
+void HeartbeatCoalescer::onQuit()
+{
+    delete m_server;
+}
+
+void HeartbeatCoalescer::publish(const Heartbeat &heartbeat)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_pending.push_back(heartbeat);
+}
+
+void HeartbeatCoalescer::takeAcks(uint64_t sti, std::vector<CellAck> &acks)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto it = m_acks.find(sti);
+    if (it == m_acks.end())
+        return;
+
+    for (auto &ack : it->second)
+        acks.push_back(std::move(ack));
+    m_acks.erase(it);
+}
+
+void HeartbeatCoalescer::flush()
+{
+    std::vector<Heartbeat> pending{};
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::swap(pending, m_pending);
+    }
+
+    if (pending.empty())
+        return;
+
+    for (auto &address : m_searchSpace)
+    {
+        bool isIpv4 = address.getIpVersion() == 4;
+
+        rls::RlsHeartBeatAggregate msg{0};
+        for (auto &heartbeat : pending)
+        {
+            uint16_t port = isIpv4 ? heartbeat.port4 : heartbeat.port6;
+            if (port == 0)
+                continue; // no socket of the UE for this IP version
+
+            rls::RlsHeartBeatEntry entry{};
+            entry.sti = heartbeat.sti;
+            entry.simPos = heartbeat.simPos;
+            entry.interval = heartbeat.interval;
+            entry.port = port;
+            msg.entries.push_back(entry);
+
+            if (msg.entries.size() == static_cast<size_t>(rls::MAX_AGGREGATE_HEARTBEATS))
+                sendAggregate(address, msg);
+        }
+
+        if (!msg.entries.empty())
+            sendAggregate(address, msg);
+    }
+}
+
+void HeartbeatCoalescer::sendAggregate(const InetAddress &address, rls::RlsHeartBeatAggregate &msg)
+{
+    OctetString stream;
+    rls::EncodeRlsMessage(msg, stream);
+    m_server->Send(address, stream.data(), static_cast<size_t>(stream.length()));
+
+    msg.entries.clear();
+}
+
+void HeartbeatCoalescer::receiveAck(const InetAddress &addr, const rls::RlsHeartBeatAckAggregate &msg)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    for (auto &entry : msg.entries)
+        m_acks[entry.sti].push_back(CellAck{msg.sti, addr, entry.dbm});
+}
+
+} // namespace nr::ue
@@ -0,0 +1,80 @@
+//
+// This file is a part of UERANSIM project.
+// Copyright (c) 2023 ALİ GÜNGÖR.
+//
+// https://github.com/aligungr/UERANSIM/
+// See README, LICENSE, and CONTRIBUTING files for licensing details.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <lib/rls/rls_pdu.hpp>
+#include <lib/udp/server.hpp>
+#include <utils/logger.hpp>
+#include <utils/nts.hpp>
+
+namespace nr::ue
+{
+
+/*
+ * Sends the heartbeats of all UEs of the process in one HEARTBEAT_AGGREGATE per gNB, and hands the entries of the
+ * aggregated acks over to the UEs. The UEs publish their heartbeats when their own pacing makes them due, and the ones
+ * published within a window travel together.
+ */
+class HeartbeatCoalescer : public NtsTask
+{
+  public:
+    struct Heartbeat
+    {
+        uint64_t sti{};
+        Vector3 simPos;
+        int interval{};
+        uint16_t port4{}; // local ports of the UE, the gNB sends to them at the address of the aggregate
+        uint16_t port6{};
+    };
+
+    struct CellAck
+    {
+        uint64_t sti{}; // of the cell
+        InetAddress address;
+        int dbm{};
+    };
+
+  private:
+    std::unique_ptr<Logger> m_logger;
+    udp::UdpServer *m_server;
+    std::vector<InetAddress> m_searchSpace;
+    std::mutex m_mutex;
+    std::vector<Heartbeat> m_pending;
+    std::unordered_map<uint64_t, std::vector<CellAck>> m_acks; // by UE
+    int64_t m_lastFlush;
+
+  public:
+    HeartbeatCoalescer(LogBase *logBase, const std::vector<std::string> &searchSpace);
+    ~HeartbeatCoalescer() override = default;
+
+  protected:
+    void onStart() override;
+    void onLoop() override;
+    void onQuit() override;
+
+  public:
+    /* Thread safe, the heartbeat is sent with the next aggregate */
+    void publish(const Heartbeat &heartbeat);
+    /* Thread safe, moves the acks received for the UE to the list */
+    void takeAcks(uint64_t sti, std::vector<CellAck> &acks);
+
+  private:
+    void flush();
+    void sendAggregate(const InetAddress &address, rls::RlsHeartBeatAggregate &msg);
+    void receiveAck(const InetAddress &addr, const rls::RlsHeartBeatAckAggregate &msg);
+};
+
+} // namespace nr::ue
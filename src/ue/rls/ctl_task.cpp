@@ -8,6 +8,7 @@
 
 #include "ctl_task.hpp"
 
+#include <ue/rls/fast_path.hpp>
 #include <utils/common.hpp>
 
 static constexpr const size_t MAX_PDU_COUNT = 128;
@@ -23,7 +24,7 @@ namespace nr::ue
 {
 
 RlsControlTask::RlsControlTask(TaskBase *base, RlsSharedContext *shCtx)
-    : m_shCtx{shCtx}, m_servingCell{}, m_mainTask{}, m_udpTask{}, m_pduMap{}, m_pendingAck{}
+    : m_shCtx{shCtx}, m_fastPath{base->fastPath}, m_servingCell{}, m_mainTask{}, m_udpTask{}, m_pduMap{}, m_pendingAck{}
 {
     m_logger = base->logBase->makeUniqueLogger(base->config->getLoggerPrefix() + "rls-ctl");
 }
@@ -66,6 +67,7 @@ void RlsControlTask::onLoop()
             break;
         case NmUeRlsToRls::ASSIGN_CURRENT_CELL:
             m_servingCell = w.cellId;
+            m_fastPath->setServingCell(w.cellId);
             break;
         default:
             m_logger->unhandledNts(*msg);
@@ -138,6 +140,11 @@ void RlsControlTask::handleRlsMessage(int cellId, rls::RlsMessage &msg)
             m_logger->err("Unhandled RLS PDU type");
         }
     }
+    else if (msg.msgType == rls::EMessageType::PDU_AGGREGATE)
+    {
+        for (auto &pdu : ((rls::RlsPduAggregate &)msg).pdus)
+            handleRlsMessage(cellId, pdu);
+    }
     else
     {
         m_logger->err("Unhandled RLS message type");
@@ -238,7 +245,7 @@ void RlsControlTask::onAckSendTimerExpired()
 
     for (auto &item : copy)
     {
-        if (!item.second.empty())
+        if (item.second.empty())
             continue;
 
         rls::RlsPduTransmissionAck msg{m_shCtx->sti};
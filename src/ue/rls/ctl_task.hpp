@@ -26,6 +26,7 @@ class RlsControlTask : public NtsTask
   private:
     std::unique_ptr<Logger> m_logger;
     RlsSharedContext *m_shCtx;
+    UserPlaneFastPath *m_fastPath;
     int m_servingCell;
     NtsTask *m_mainTask;
     RlsUdpTask *m_udpTask;
@@ -0,0 +1,38 @@
+//
+// This file is a part of UERANSIM project.
+// Copyright (c) 2023 ALİ GÜNGÖR.
+//
+// https://github.com/aligungr/UERANSIM/
+// See README, LICENSE, and CONTRIBUTING files for licensing details.
+//
+
+#include "endpoint.hpp"
+
+static constexpr const int RECEIVE_TIMEOUT = 200;
+
+namespace nr::ue
+{
+
+RlsEndpointTask::RlsEndpointTask() : m_endpoint{std::make_unique<rls::SharedUdpEndpoint>()}
+{
+}
+
+void RlsEndpointTask::onStart()
+{
+}
+
+void RlsEndpointTask::onLoop()
+{
+    m_endpoint->serve(RECEIVE_TIMEOUT);
+}
+
+void RlsEndpointTask::onQuit()
+{
+}
+
+rls::SharedUdpEndpoint *RlsEndpointTask::endpoint() const
+{
+    return m_endpoint.get();
+}
+
+} // namespace nr::ue
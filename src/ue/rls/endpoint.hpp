@@ -0,0 +1,38 @@
+//
+// This file is a part of UERANSIM project.
+// Copyright (c) 2023 ALİ GÜNGÖR.
+//
+// https://github.com/aligungr/UERANSIM/
+// See README, LICENSE, and CONTRIBUTING files for licensing details.
+//
+
+#pragma once
+
+#include <memory>
+
+#include <lib/rls/rls_transport.hpp>
+#include <utils/nts.hpp>
+
+namespace nr::ue
+{
+
+/* Serves the RLS socket shared by all UEs of the process, handing the received datagrams over to their UEs */
+class RlsEndpointTask : public NtsTask
+{
+  private:
+    std::unique_ptr<rls::SharedUdpEndpoint> m_endpoint;
+
+  public:
+    RlsEndpointTask();
+    ~RlsEndpointTask() override = default;
+
+  protected:
+    void onStart() override;
+    void onLoop() override;
+    void onQuit() override;
+
+  public:
+    [[nodiscard]] rls::SharedUdpEndpoint *endpoint() const;
+};
+
+} // namespace nr::ue
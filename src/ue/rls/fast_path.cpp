@@ -0,0 +1,124 @@
+//
+// This file is a part of UERANSIM project.
+// Copyright (c) 2023 ALİ GÜNGÖR.
+//
+// https://github.com/aligungr/UERANSIM/
+// See README, LICENSE, and CONTRIBUTING files for licensing details.
+//
+
+#include "fast_path.hpp"
+
+#include <unistd.h>
+
+#include <lib/rls/rls_pdu.hpp>
+
+namespace nr::ue
+{
+
+TunDescriptor::TunDescriptor(int fd) : m_fd{fd}
+{
+}
+
+TunDescriptor::~TunDescriptor()
+{
+    ::close(m_fd);
+}
+
+int TunDescriptor::fd() const
+{
+    return m_fd;
+}
+
+UserPlaneFastPath::UserPlaneFastPath()
+    : m_mutex{}, m_state{}, m_cells{}, m_servingCell{}, m_snapshot{std::make_shared<const Snapshot>()}
+{
+}
+
+void UserPlaneFastPath::setNasState(bool dataAllowed, const std::bitset<16> &sessions)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_state.dataAllowed == dataAllowed && m_state.sessions == sessions)
+        return;
+
+    m_state.dataAllowed = dataAllowed;
+    m_state.sessions = sessions;
+    publish();
+}
+
+void UserPlaneFastPath::setLink(std::shared_ptr<rls::RlsTransport> transport, uint64_t sti)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_state.transport = std::move(transport);
+    m_state.sti = sti;
+    publish();
+}
+
+void UserPlaneFastPath::setCell(int cellId, uint64_t sti, const InetAddress &address)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_cells[cellId] = Cell{sti, address};
+    if (cellId == m_servingCell)
+        publish();
+}
+
+void UserPlaneFastPath::removeCell(int cellId)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_cells.erase(cellId);
+    if (cellId == m_servingCell)
+        publish();
+}
+
+void UserPlaneFastPath::setServingCell(int cellId)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_servingCell = cellId;
+    publish();
+}
+
+void UserPlaneFastPath::setTunDevice(int psi, std::shared_ptr<TunDescriptor> device)
+{
+    if (psi < 0 || psi >= static_cast<int>(m_state.tunDevices.size()))
+        return;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_state.tunDevices[psi] = std::move(device);
+    publish();
+}
+
+void UserPlaneFastPath::publish()
+{
+    auto it = m_cells.find(m_servingCell);
+    m_state.hasServingCell = it != m_cells.end();
+    m_state.servingCell = m_state.hasServingCell ? it->second : Cell{};
+
+    std::atomic_store(&m_snapshot, std::shared_ptr<const Snapshot>(std::make_shared<Snapshot>(m_state)));
+}
+
+bool UserPlaneFastPath::sendUplink(int psi, uint8_t *frame, size_t pduLength)
+{
+    auto snapshot = std::atomic_load(&m_snapshot);
+    if (!snapshot->dataAllowed || !snapshot->hasServingCell || snapshot->transport == nullptr)
+        return false;
+    if (psi < 0 || psi >= static_cast<int>(snapshot->sessions.size()) || !snapshot->sessions.test(psi))
+        return false;
+
+    rls::EncodeRlsPduTransmissionHeader(snapshot->sti, rls::EPduType::DATA, 0, static_cast<uint32_t>(psi), pduLength,
+                                        frame);
+    snapshot->transport->send(snapshot->servingCell.address, frame, rls::PDU_TRANSMISSION_HEADER_SIZE + pduLength);
+    return true;
+}
+
+bool UserPlaneFastPath::deliverDownlink(uint64_t cellSti, int psi, const uint8_t *pdu, size_t pduLength)
+{
+    auto snapshot = std::atomic_load(&m_snapshot);
+    if (!snapshot->dataAllowed || !snapshot->hasServingCell || snapshot->servingCell.sti != cellSti)
+        return false;
+    if (psi < 0 || psi >= static_cast<int>(snapshot->tunDevices.size()) || snapshot->tunDevices[psi] == nullptr)
+        return false;
+
+    // A failed write is retried by the slow path, which reports the error
+    return ::write(snapshot->tunDevices[psi]->fd(), pdu, pduLength) >= 0;
+}
+
+} // namespace nr::ue
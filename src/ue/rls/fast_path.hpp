@@ -0,0 +1,99 @@
+//
+// This file is a part of UERANSIM project.
+// Copyright (c) 2023 ALİ GÜNGÖR.
+//
+// https://github.com/aligungr/UERANSIM/
+// See README, LICENSE, and CONTRIBUTING files for licensing details.
+//
+
+#pragma once
+
+#include <array>
+#include <bitset>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#include <lib/rls/rls_transport.hpp>
+#include <utils/network.hpp>
+
+namespace nr::ue
+{
+
+/* File descriptor of a TUN device, closed once neither its task nor the fast path refers to it anymore */
+class TunDescriptor
+{
+  private:
+    int m_fd;
+
+  public:
+    explicit TunDescriptor(int fd);
+    ~TunDescriptor();
+
+    TunDescriptor(const TunDescriptor &) = delete;
+    TunDescriptor &operator=(const TunDescriptor &) = delete;
+
+    [[nodiscard]] int fd() const;
+};
+
+/*
+ * User plane of the UE that bypasses the App, NAS and RLS tasks. The tasks publish the forwarding state they own, and
+ * the data path threads read it from an immutable snapshot that is swapped atomically on every change. A packet the
+ * snapshot does not allow, e.g. while the UE is CM-IDLE or an uplink is pending for its session, takes the slow path
+ * through the tasks, so that the procedures it triggers are not skipped.
+ */
+class UserPlaneFastPath
+{
+  private:
+    struct Cell
+    {
+        uint64_t sti{};
+        InetAddress address;
+    };
+
+    struct Snapshot
+    {
+        bool dataAllowed{};         // registered and CM-CONNECTED
+        std::bitset<16> sessions{}; // active PDU sessions with no uplink pending
+        bool hasServingCell{};
+        Cell servingCell{};
+        uint64_t sti{};
+        std::shared_ptr<rls::RlsTransport> transport{};
+        std::array<std::shared_ptr<TunDescriptor>, 16> tunDevices{};
+    };
+
+  private:
+    std::mutex m_mutex;
+    Snapshot m_state;                           // guarded by the mutex, the snapshots are copies of it
+    std::unordered_map<int, Cell> m_cells;      // by cell ID
+    int m_servingCell;
+    std::shared_ptr<const Snapshot> m_snapshot; // accessed atomically
+
+  public:
+    UserPlaneFastPath();
+
+    /* Called by the NAS task */
+    void setNasState(bool dataAllowed, const std::bitset<16> &sessions);
+    /* Called by the RLS tasks */
+    void setLink(std::shared_ptr<rls::RlsTransport> transport, uint64_t sti);
+    void setCell(int cellId, uint64_t sti, const InetAddress &address);
+    void removeCell(int cellId);
+    void setServingCell(int cellId);
+    /* Called by the TUN tasks */
+    void setTunDevice(int psi, std::shared_ptr<TunDescriptor> device);
+
+    /*
+     * Sends the uplink PDU of the session to the serving cell, the PDU is preceded by PDU_TRANSMISSION_HEADER_SIZE
+     * bytes of headroom at frame that the header is written to. Returns false if the PDU must take the slow path.
+     * The transport is sent to concurrently with the RLS task, which the RlsTransport contract allows.
+     */
+    bool sendUplink(int psi, uint8_t *frame, size_t pduLength);
+    /* Writes the downlink PDU of the cell to the TUN device of the session, false if it must take the slow path */
+    bool deliverDownlink(uint64_t cellSti, int psi, const uint8_t *pdu, size_t pduLength);
+
+  private:
+    void publish();
+};
+
+} // namespace nr::ue
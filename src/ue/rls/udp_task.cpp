@@ -10,27 +10,40 @@
 
 #include <cstdint>
 #include <cstring>
+#include <functional>
 #include <set>
+#include <string>
 
 #include <ue/nts.hpp>
+#include <ue/rls/endpoint.hpp>
+#include <ue/rls/fast_path.hpp>
 #include <utils/common.hpp>
 #include <utils/constants.hpp>
 
 static constexpr const int BUFFER_SIZE = 16384;
-static constexpr const int LOOP_PERIOD = 1000;
 static constexpr const int RECEIVE_TIMEOUT = 200;
-static constexpr const int HEARTBEAT_THRESHOLD = 2000; // (LOOP_PERIOD + RECEIVE_TIMEOUT)'dan büyük olmalı
+static constexpr const int MAX_RECEIVE_PER_LOOP = 64;
+static constexpr const int DRAIN_TIMEOUT = 1; // ms, a zero timeout would wait indefinitely
+
+static bool IsSameAddress(const InetAddress &a, const InetAddress &b)
+{
+    return a.getSockLen() == b.getSockLen() && std::memcmp(a.getSockAddr(), b.getSockAddr(), a.getSockLen()) == 0;
+}
 
 namespace nr::ue
 {
 
 RlsUdpTask::RlsUdpTask(TaskBase *base, RlsSharedContext *shCtx, const std::vector<std::string> &searchSpace)
-    : m_server{}, m_ctlTask{}, m_shCtx{shCtx}, m_searchSpace{}, m_cells{}, m_cellIdToSti{}, m_lastLoop{},
-      m_cellIdCounter{}
+    : m_transport{}, m_endpoint{}, m_config{base->config}, m_fastPath{base->fastPath}, m_sti{}, m_ctlTask{},
+      m_shCtx{shCtx}, m_coalescer{base->heartbeatCoalescer}, m_searchSpace{}, m_cells{}, m_cellIdToSti{}, m_pacer{},
+      m_now{}, m_coalescedAcks{}, m_cellIdCounter{}
 {
     m_logger = base->logBase->makeUniqueLogger(base->config->getLoggerPrefix() + "rls-udp");
 
-    m_server = new udp::UdpServer();
+    m_sti = shCtx->sti;
+    if (base->rlsEndpoint)
+        m_endpoint = base->rlsEndpoint->endpoint();
+    attachTransport();
 
     for (auto &ip : searchSpace)
         m_searchSpace.emplace_back(ip, cons::RadioLinkPort);
@@ -38,25 +51,67 @@ RlsUdpTask::RlsUdpTask(TaskBase *base, RlsSharedContext *shCtx, const std::vecto
     m_simPos = Vector3{};
 }
 
+void RlsUdpTask::attachTransport()
+{
+    std::unique_ptr<rls::RlsTransport> transport =
+        m_endpoint != nullptr ? m_endpoint->attach(m_sti) : rls::RlsTransport::Create(m_config->linkTransport);
+
+    // The cells only impair the uplink they receive, the downlink is impaired on this end
+    if (m_config->channel)
+    {
+        uint64_t stream = m_config->supi ? std::hash<std::string>{}(m_config->supi->value) : m_sti;
+        transport = std::make_unique<rls::ChannelTransport>(std::move(transport), *m_config->channel, stream);
+    }
+
+    m_transport = std::move(transport);
+    m_fastPath->setLink(m_transport, m_sti);
+}
+
 void RlsUdpTask::onStart()
 {
 }
 
 void RlsUdpTask::onLoop()
 {
-    auto current = utils::CurrentTimeMillis();
-    if (current - m_lastLoop > LOOP_PERIOD)
+    m_now = utils::CurrentTimeMillis();
+
+    // The cells address the UE by its STI, follow it when it is reset
+    if (m_shCtx->sti != m_sti)
+    {
+        m_sti = m_shCtx->sti;
+        if (m_endpoint != nullptr)
+            attachTransport();
+        else
+            m_fastPath->setLink(m_transport, m_sti);
+    }
+
+    heartbeatCycle(m_now, m_simPos);
+
+    if (m_coalescer != nullptr)
     {
-        m_lastLoop = current;
-        heartbeatCycle(current, m_simPos);
+        m_coalescer->takeAcks(m_shCtx->sti, m_coalescedAcks);
+        for (auto &ack : m_coalescedAcks)
+            receiveHeartbeatAck(ack.address, ack.sti, ack.dbm);
+        m_coalescedAcks.clear();
     }
 
     uint8_t buffer[BUFFER_SIZE];
     InetAddress peerAddress;
 
-    int size = m_server->Receive(buffer, BUFFER_SIZE, RECEIVE_TIMEOUT, peerAddress);
-    if (size > 0)
+    // Datagrams arriving back to back are handled in one pass, the downlink of the fast path in particular
+    int timeout = RECEIVE_TIMEOUT;
+    for (int i = 0; i < MAX_RECEIVE_PER_LOOP; i++)
     {
+        int size = m_transport->receive(buffer, BUFFER_SIZE, timeout, peerAddress);
+        if (size <= 0)
+            break;
+        timeout = DRAIN_TIMEOUT;
+
+        m_now = utils::CurrentTimeMillis();
+
+        if (receiveFastPath(buffer, static_cast<size_t>(size)))
+            continue;
+
         auto rlsMsg = rls::DecodeRlsMessage(OctetView{buffer, static_cast<size_t>(size)});
         if (rlsMsg == nullptr)
             m_logger->err("Unable to decode RLS message");
@@ -67,7 +122,8 @@ void RlsUdpTask::onLoop()
 
 void RlsUdpTask::onQuit()
 {
-    delete m_server;
+    m_fastPath->setLink(nullptr, 0);
+    m_transport.reset();
 }
 
 void RlsUdpTask::sendRlsPdu(const InetAddress &addr, const rls::RlsMessage &msg)
@@ -75,15 +131,16 @@ void RlsUdpTask::sendRlsPdu(const InetAddress &addr, const rls::RlsMessage &msg)
     OctetString stream;
     rls::EncodeRlsMessage(msg, stream);
 
-    m_server->Send(addr, stream.data(), static_cast<size_t>(stream.length()));
+    m_transport->send(addr, stream.data(), static_cast<size_t>(stream.length()));
 }
 
 void RlsUdpTask::send(int cellId, const rls::RlsMessage &msg)
 {
     if (m_cellIdToSti.count(cellId))
     {
-        auto sti = m_cellIdToSti[cellId];
-        sendRlsPdu(m_cells[sti].address, msg);
+        auto &cell = m_cells[m_cellIdToSti[cellId]];
+        cell.lastSent = m_now;
+        sendRlsPdu(cell.address, msg);
     }
 }
 
@@ -91,39 +148,72 @@ void RlsUdpTask::receiveRlsPdu(const InetAddress &addr, std::unique_ptr<rls::Rls
 {
     if (msg->msgType == rls::EMessageType::HEARTBEAT_ACK)
     {
-        if (!m_cells.count(msg->sti))
-        {
-            m_cells[msg->sti].cellId = ++m_cellIdCounter;
-            m_cellIdToSti[m_cells[msg->sti].cellId] = msg->sti;
-        }
-
-        int oldDbm = INT32_MIN;
-        if (m_cells.count(msg->sti))
-            oldDbm = m_cells[msg->sti].dbm;
-
-        m_cells[msg->sti].address = addr;
-        m_cells[msg->sti].lastSeen = utils::CurrentTimeMillis();
-
-        int newDbm = ((const rls::RlsHeartBeatAck &)*msg).dbm;
-        m_cells[msg->sti].dbm = newDbm;
-
-        if (oldDbm != newDbm)
-            onSignalChangeOrLost(m_cells[msg->sti].cellId);
+        receiveHeartbeatAck(addr, msg->sti, ((const rls::RlsHeartBeatAck &)*msg).dbm);
         return;
     }
 
-    if (!m_cells.count(msg->sti))
+    auto it = m_cells.find(msg->sti);
+    if (it == m_cells.end())
     {
         // if no HB-ACK received yet, and the message is not HB-ACK, then ignore the message
         return;
     }
 
+    // Any traffic of the cell keeps it alive
+    it->second.lastSeen = m_now;
+
     auto w = std::make_unique<NmUeRlsToRls>(NmUeRlsToRls::RECEIVE_RLS_MESSAGE);
-    w->cellId = m_cells[msg->sti].cellId;
+    w->cellId = it->second.cellId;
     w->msg = std::move(msg);
     m_ctlTask->push(std::move(w));
 }
 
+bool RlsUdpTask::receiveFastPath(const uint8_t *data, size_t size)
+{
+    // Only the user PDUs needing no acknowledgement bypass the control task
+    if (rls::PeekRlsMessageType(data, size) != rls::EMessageType::PDU_TRANSMISSION)
+        return false;
+
+    rls::RlsPduTransmissionView view{};
+    if (!rls::DecodeRlsPduTransmission(data, size, view) || view.pduType != rls::EPduType::DATA || view.pduId != 0)
+        return false;
+
+    auto it = m_cells.find(view.sti);
+    if (it == m_cells.end())
+        return false;
+
+    if (!m_fastPath->deliverDownlink(view.sti, static_cast<int>(view.payload), view.pdu, view.pduLength))
+        return false;
+
+    it->second.lastSeen = m_now;
+    return true;
+}
+
+void RlsUdpTask::receiveHeartbeatAck(const InetAddress &addr, uint64_t sti, int dbm)
+{
+    if (!m_cells.count(sti))
+    {
+        m_cells[sti].cellId = ++m_cellIdCounter;
+        m_cells[sti].dbm = INT32_MIN;
+        m_cellIdToSti[m_cells[sti].cellId] = sti;
+    }
+
+    m_transport->setLinkQuality(sti, dbm);
+
+    auto &cell = m_cells[sti];
+    if (!IsSameAddress(cell.address, addr))
+        m_fastPath->setCell(cell.cellId, sti, addr);
+    cell.address = addr;
+    cell.lastSeen = m_now;
+
+    if (cell.dbm != dbm)
+    {
+        cell.dbm = dbm;
+        m_pacer.notifyChange();
+        onSignalChangeOrLost(cell.cellId);
+    }
+}
+
 void RlsUdpTask::onSignalChangeOrLost(int cellId)
 {
     int dbm = INT32_MIN;
@@ -143,10 +233,11 @@ void RlsUdpTask::heartbeatCycle(uint64_t time, const Vector3 &simPos)
 {
     std::set<std::pair<uint64_t, int>> toRemove;
 
+    int64_t threshold = rls::HeartbeatTimeout(m_pacer.interval());
     for (auto &cell : m_cells)
     {
-        auto delta = time - cell.second.lastSeen;
-        if (delta > HEARTBEAT_THRESHOLD)
+        auto delta = static_cast<int64_t>(time) - cell.second.lastSeen;
+        if (delta > threshold)
             toRemove.insert({cell.first, cell.second.cellId});
     }
 
@@ -154,15 +245,54 @@ void RlsUdpTask::heartbeatCycle(uint64_t time, const Vector3 &simPos)
     {
         m_cells.erase(cell.first);
         m_cellIdToSti.erase(cell.second);
+        m_fastPath->removeCell(cell.second);
     }
 
     for (auto cell : toRemove)
         onSignalChangeOrLost(cell.second);
 
+    if (!toRemove.empty())
+        m_pacer.notifyChange();
+
+    if (!m_pacer.isDue(static_cast<int64_t>(time)))
+        return;
+
+    int interval = m_pacer.startRound(static_cast<int64_t>(time), m_cells.empty());
+
+    // Cells exchanging traffic with the UE need no heartbeat
+    std::vector<const InetAddress *> suppressed;
+    for (auto &cell : m_cells)
+        if (m_pacer.isSuppressed(cell.second.lastSent, cell.second.lastSeen, static_cast<int64_t>(time)))
+            suppressed.push_back(&cell.second.address);
+
+    // Once the cells are found, the heartbeats of the UE travel with the ones of the other UEs of the process
+    if (m_coalescer != nullptr && !m_cells.empty() && suppressed.size() < m_cells.size())
+    {
+        HeartbeatCoalescer::Heartbeat heartbeat{};
+        heartbeat.sti = m_shCtx->sti;
+        heartbeat.simPos = simPos;
+        heartbeat.interval = interval;
+        heartbeat.port4 = m_transport->localPort(4);
+        heartbeat.port6 = m_transport->localPort(6);
+
+        if (heartbeat.port4 != 0 || heartbeat.port6 != 0)
+        {
+            m_coalescer->publish(heartbeat);
+            return;
+        }
+    }
+
     for (auto &addr : m_searchSpace)
     {
+        bool isSuppressed = false;
+        for (auto *address : suppressed)
+            isSuppressed |= IsSameAddress(*address, addr);
+        if (isSuppressed)
+            continue;
+
         rls::RlsHeartBeat msg{m_shCtx->sti};
         msg.simPos = simPos;
+        msg.interval = interval;
         sendRlsPdu(addr, msg);
     }
 }
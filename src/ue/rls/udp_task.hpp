@@ -9,11 +9,14 @@
 #pragma once
 
 #include <cstdint>
+#include <memory>
 #include <unordered_map>
 #include <vector>
 
+#include <lib/rls/rls_heartbeat.hpp>
 #include <lib/rls/rls_pdu.hpp>
-#include <lib/udp/server.hpp>
+#include <lib/rls/rls_transport.hpp>
+#include <ue/rls/coalescer.hpp>
 #include <ue/types.hpp>
 #include <utils/nts.hpp>
 
@@ -26,20 +29,28 @@ class RlsUdpTask : public NtsTask
     struct CellInfo
     {
         InetAddress address;
-        int64_t lastSeen{};
+        int64_t lastSeen{}; // last message received from the cell
+        int64_t lastSent{}; // last PDU sent to the cell, heartbeats excluded
         int dbm{};
         int cellId{};
     };
 
   private:
     std::unique_ptr<Logger> m_logger;
-    udp::UdpServer *m_server;
+    std::shared_ptr<rls::RlsTransport> m_transport; // shared with the fast path
+    rls::SharedUdpEndpoint *m_endpoint;             // shared by the UEs of the process, if any
+    const UeConfig *m_config;
+    UserPlaneFastPath *m_fastPath;
+    uint64_t m_sti; // the link is set up with
     NtsTask *m_ctlTask;
     RlsSharedContext* m_shCtx;
+    HeartbeatCoalescer *m_coalescer;
     std::vector<InetAddress> m_searchSpace;
     std::unordered_map<uint64_t, CellInfo> m_cells;
     std::unordered_map<int, uint64_t> m_cellIdToSti;
-    int64_t m_lastLoop;
+    rls::HeartbeatPacer m_pacer;
+    int64_t m_now;
+    std::vector<HeartbeatCoalescer::CellAck> m_coalescedAcks;
     Vector3 m_simPos;
     int m_cellIdCounter;
 
@@ -55,8 +66,11 @@ class RlsUdpTask : public NtsTask
     void onQuit() override;
 
   private:
+    void attachTransport();
     void sendRlsPdu(const InetAddress &addr, const rls::RlsMessage &msg);
     void receiveRlsPdu(const InetAddress &addr, std::unique_ptr<rls::RlsMessage> &&msg);
+    bool receiveFastPath(const uint8_t *data, size_t size);
+    void receiveHeartbeatAck(const InetAddress &addr, uint64_t sti, int dbm);
     void onSignalChangeOrLost(int cellId);
     void heartbeatCycle(uint64_t time, const Vector3 &simPos);
 
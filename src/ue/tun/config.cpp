@@ -312,27 +312,17 @@ static void AddIpRoutes(const std::string &if_name, const std::string &table_nam
 namespace nr::ue::tun
 {
 
-int AllocateTun(const char *ifPrefix, char **allocatedName)
+static int OpenTunQueue(const char *tunName, short flags)
 {
-    // acquire the configuration lock
-    const std::lock_guard<std::mutex> lock(configMutex);
-
-    const char *ifName = NextInterfaceName(ifPrefix);
-    if (!ifName)
-        throw LibError("TUN interface name could not be allocated.", errno);
-
-    char tunName[IFNAMSIZ];
-    strcpy(tunName, ifName);
-
     ifreq ifr{};
     int fd;
 
-    if ((fd = open("/dev/net/tun", O_RDWR)) < 0)
+    if ((fd = open("/dev/net/tun", O_RDWR | O_NONBLOCK)) < 0)
         throw LibError("Open failure /dev/net/tun");
 
     memset(&ifr, 0, sizeof(ifr));
 
-    ifr.ifr_flags = IFF_TUN | IFF_NO_PI;
+    ifr.ifr_flags = flags;
 
     strncpy(ifr.ifr_name, tunName, IFNAMSIZ);
 
@@ -342,14 +332,49 @@ int AllocateTun(const char *ifPrefix, char **allocatedName)
         throw LibError("ioctl(TUNSETIFF)", errno);
     }
 
-    strcpy(tunName, ifr.ifr_name);
-    if (strcmp(tunName, ifName) != 0)
+    if (strncmp(ifr.ifr_name, tunName, IFNAMSIZ) != 0)
+    {
+        close(fd);
         throw LibError("TUN interface name could not be allocated.");
+    }
 
-    *allocatedName = strdup(tunName);
     return fd;
 }
 
+std::vector<int> AllocateTun(const char *ifPrefix, int queues, char **allocatedName)
+{
+    // acquire the configuration lock
+    const std::lock_guard<std::mutex> lock(configMutex);
+
+    const char *ifName = NextInterfaceName(ifPrefix);
+    if (!ifName)
+        throw LibError("TUN interface name could not be allocated.", errno);
+
+    char tunName[IFNAMSIZ];
+    strcpy(tunName, ifName);
+
+    // Every queue attached with the same name is one more queue of the device, the kernel spreads the flows over them
+    short flags = IFF_TUN | IFF_NO_PI;
+    if (queues > 1)
+        flags |= IFF_MULTI_QUEUE;
+
+    std::vector<int> fds;
+    try
+    {
+        for (int i = 0; i < queues; i++)
+            fds.push_back(OpenTunQueue(tunName, flags));
+    }
+    catch (const LibError &)
+    {
+        for (int fd : fds)
+            close(fd);
+        throw;
+    }
+
+    *allocatedName = strdup(tunName);
+    return fds;
+}
+
 void ConfigureTun(const char *tunName, const char *ipAddr, int mtu, bool configureRoute)
 {
     // acquire the configuration lock
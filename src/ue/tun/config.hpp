@@ -11,11 +11,13 @@
 #include <sstream>
 #include <string>
 #include <utility>
+#include <vector>
 
 namespace nr::ue::tun
 {
 
-int AllocateTun(const char *ifPrefix, char **allocatedName);
+/* Opens the given number of queues of a new TUN device in non-blocking mode, a multi-queue device if more than one */
+std::vector<int> AllocateTun(const char *ifPrefix, int queues, char **allocatedName);
 void ConfigureTun(const char *tunName, const char *ipAddr, int mtu, bool configureRoute);
 
 } // namespace nr::ue::tun
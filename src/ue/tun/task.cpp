@@ -7,21 +7,29 @@
 //
 
 #include "task.hpp"
+#include <cerrno>
 #include <cstring>
+#include <lib/rls/rls_pdu.hpp>
+#include <sys/epoll.h>
 #include <ue/app/task.hpp>
 #include <ue/nts.hpp>
+#include <ue/rls/fast_path.hpp>
 #include <unistd.h>
 #include <utils/libc_error.hpp>
 #include <utils/scoped_thread.hpp>
 
 // TODO: May be reduced to MTU 1500
 #define RECEIVER_BUFFER_SIZE 8000
+// Room for the RLS header in front of the packets, so that the fast path sends them without copying
+#define RECEIVER_HEADROOM rls::PDU_TRANSMISSION_HEADER_SIZE
 
 struct ReceiverArgs
 {
     int fd{};
+    int epoll{};
     int psi{};
     NtsTask *targetTask{};
+    nr::ue::UserPlaneFastPath *fastPath{};
 };
 
 static std::string GetErrorMessage(const std::string &cause)
@@ -42,27 +50,51 @@ static std::unique_ptr<nr::ue::NmUeTunToApp> NmError(std::string &&error)
     return m;
 }
 
+/* Event loop of a queue of the device, reading the packets at once whenever the queue becomes readable */
 static void ReceiverThread(ReceiverArgs *args)
 {
     int fd = args->fd;
+    int epoll = args->epoll;
     int psi = args->psi;
     NtsTask *targetTask = args->targetTask;
+    auto *fastPath = args->fastPath;
 
     delete args;
 
-    uint8_t buffer[RECEIVER_BUFFER_SIZE];
+    uint8_t frame[RECEIVER_HEADROOM + RECEIVER_BUFFER_SIZE];
+    uint8_t *buffer = frame + RECEIVER_HEADROOM;
 
     while (true)
     {
-        ssize_t n = ::read(fd, buffer, RECEIVER_BUFFER_SIZE);
-        if (n < 0)
+        epoll_event event{};
+        if (epoll_wait(epoll, &event, 1, -1) < 0)
         {
-            targetTask->push(NmError(GetErrorMessage("TUN device could not read")));
+            if (errno == EINTR)
+                continue;
+            targetTask->push(NmError(GetErrorMessage("TUN device could not be waited for")));
             return; // Abort receiver thread
         }
 
-        if (n > 0)
+        // The queue is non-blocking, it is drained until it would block
+        while (true)
         {
+            ssize_t n = ::read(fd, buffer, RECEIVER_BUFFER_SIZE);
+            if (n < 0)
+            {
+                if (errno == EAGAIN || errno == EWOULDBLOCK)
+                    break;
+                if (errno == EINTR)
+                    continue;
+                targetTask->push(NmError(GetErrorMessage("TUN device could not read")));
+                return; // Abort receiver thread
+            }
+
+            if (n == 0)
+                break;
+
+            if (fastPath->sendUplink(psi, frame, static_cast<size_t>(n)))
+                continue;
+
             auto m = std::make_unique<nr::ue::NmUeTunToApp>(nr::ue::NmUeTunToApp::DATA_PDU_DELIVERY);
             m->psi = psi;
             m->data = OctetString::FromArray(buffer, static_cast<size_t>(n));
@@ -74,32 +106,72 @@ static void ReceiverThread(ReceiverArgs *args)
 namespace nr::ue
 {
 
-ue::TunTask::TunTask(TaskBase *base, int psi, int fd) : m_base{base}, m_psi{psi}, m_fd{fd}, m_receiver{}
+ue::TunTask::TunTask(TaskBase *base, int psi, std::vector<int> &&fds)
+    : m_base{base}, m_psi{psi}, m_fd{fds[0]}, m_queues{}, m_receivers{}
 {
+    for (int fd : fds)
+        m_queues.push_back(Queue{std::make_shared<TunDescriptor>(fd), -1});
 }
 
 void TunTask::onStart()
 {
-    auto *receiverArgs = new ReceiverArgs();
-    receiverArgs->fd = m_fd;
-    receiverArgs->targetTask = this;
-    receiverArgs->psi = m_psi;
-    m_receiver =
-        new ScopedThread([](void *args) { ReceiverThread(reinterpret_cast<ReceiverArgs *>(args)); }, receiverArgs);
+    m_base->fastPath->setTunDevice(m_psi, m_queues[0].device);
+
+    for (auto &queue : m_queues)
+    {
+        queue.epoll = epoll_create1(EPOLL_CLOEXEC);
+        if (queue.epoll < 0)
+        {
+            push(NmError(GetErrorMessage("TUN event loop could not be created")));
+            continue;
+        }
+
+        epoll_event ev{};
+        ev.events = EPOLLIN;
+        ev.data.fd = queue.device->fd();
+        epoll_ctl(queue.epoll, EPOLL_CTL_ADD, queue.device->fd(), &ev);
+
+        auto *receiverArgs = new ReceiverArgs();
+        receiverArgs->fd = queue.device->fd();
+        receiverArgs->epoll = queue.epoll;
+        receiverArgs->targetTask = this;
+        receiverArgs->psi = m_psi;
+        receiverArgs->fastPath = m_base->fastPath;
+        m_receivers.push_back(new ScopedThread(
+            [](void *args) { ReceiverThread(reinterpret_cast<ReceiverArgs *>(args)); }, receiverArgs));
+    }
 }
 
 void TunTask::onQuit()
 {
-    delete m_receiver;
-    ::close(m_fd);
+    for (auto *receiver : m_receivers)
+        delete receiver;
+    m_receivers.clear();
+
+    // The devices are closed when the fast path is done with them as well
+    m_base->fastPath->setTunDevice(m_psi, nullptr);
+    for (auto &queue : m_queues)
+    {
+        if (queue.epoll >= 0)
+            ::close(queue.epoll);
+    }
+    m_queues.clear();
 }
 
 void TunTask::onLoop()
 {
     auto msg = take();
-    if (!msg)
-        return;
 
+    // The downlink PDUs queued meanwhile are written in the same pass
+    while (msg)
+    {
+        handleMessage(std::move(msg));
+        msg = poll();
+    }
+}
+
+void TunTask::handleMessage(std::unique_ptr<NtsMessage> &&msg)
+{
     switch (msg->msgType)
     {
     case NtsMessageType::UE_APP_TO_TUN: {
@@ -120,4 +192,4 @@ void TunTask::onLoop()
     }
 }
 
-} // namespace nr::ue
\ No newline at end of file
+} // namespace nr::ue
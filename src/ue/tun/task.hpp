@@ -10,6 +10,7 @@
 
 #include <memory>
 #include <thread>
+#include <ue/rls/fast_path.hpp>
 #include <ue/nts.hpp>
 #include <ue/types.hpp>
 #include <unordered_map>
@@ -22,22 +23,33 @@ namespace nr::ue
 
 class TunTask : public NtsTask
 {
+  private:
+    struct Queue
+    {
+        std::shared_ptr<TunDescriptor> device;
+        int epoll{}; // of the receiver of the queue
+    };
+
   private:
     TaskBase *m_base;
     int m_psi;
-    int m_fd;
-    ScopedThread *m_receiver;
+    int m_fd; // of the first queue, the downlink is written to
+    std::vector<Queue> m_queues;
+    std::vector<ScopedThread *> m_receivers;
 
     friend class UeCmdHandler;
 
   public:
-    explicit TunTask(TaskBase *taskBase, int psi, int fd);
+    explicit TunTask(TaskBase *taskBase, int psi, std::vector<int> &&fds);
     ~TunTask() override = default;
 
   protected:
     void onStart() override;
     void onLoop() override;
     void onQuit() override;
+
+  private:
+    void handleMessage(std::unique_ptr<NtsMessage> &&msg);
 };
 
 } // namespace nr::ue
@@ -8,28 +8,30 @@
 
 #include "tun.hpp"
 #include "config.hpp"
+#include <cstdlib>
 #include <utils/libc_error.hpp>
 
 namespace nr::ue::tun
 {
 
-int TunAllocate(const char *namePrefix, std::string &allocatedName, std::string &error)
+std::vector<int> TunAllocate(const char *namePrefix, int queues, std::string &allocatedName, std::string &error)
 {
-    int fd;
+    std::vector<int> fds;
     char *name = nullptr;
     try
     {
-        fd = tun::AllocateTun(namePrefix, &name);
+        fds = tun::AllocateTun(namePrefix, queues, &name);
         allocatedName = std::string{name};
+        free(name);
     }
     catch (const LibError &e)
     {
         error = e.what();
         allocatedName = "";
-        return 0;
+        return {};
     }
 
-    return fd;
+    return fds;
 }
 
 bool TunConfigure(const std::string &tunName, const std::string &ipAddress, int mtu, bool configureRouting, std::string &error)
@@ -9,11 +9,12 @@
 #pragma once
 
 #include <string>
+#include <vector>
 
 namespace nr::ue::tun
 {
 
-int TunAllocate(const char *namePrefix, std::string &allocatedName, std::string &error);
+std::vector<int> TunAllocate(const char *namePrefix, int queues, std::string &allocatedName, std::string &error);
 bool TunConfigure(const std::string &tunName, const std::string &ipAddress, int mtu, bool configureRouting, std::string &error);
 
 } // namespace nr::ue::tun
\ No newline at end of file
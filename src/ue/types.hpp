@@ -21,6 +21,8 @@
 #include <lib/app/monitor.hpp>
 #include <lib/app/ue_ctl.hpp>
 #include <lib/nas/nas.hpp>
+#include <lib/rls/rls_channel.hpp>
+#include <lib/rls/rls_transport.hpp>
 #include <utils/common_types.hpp>
 #include <utils/json.hpp>
 #include <utils/locked.hpp>
@@ -36,6 +38,9 @@ class NasTask;
 class UeRrcTask;
 class UeRlsTask;
 class UserEquipment;
+class HeartbeatCoalescer;
+class RlsEndpointTask;
+class UserPlaneFastPath;
 
 struct UeCellDesc
 {
@@ -111,6 +116,9 @@ struct UeConfig
     NetworkSlice defaultConfiguredNssai{};
     NetworkSlice configuredNssai{};
     std::optional<std::string> tunName{};
+    int tunQueues{1}; // of the TUN device of a PDU session, each served by a worker of its own
+    rls::ELinkTransport linkTransport{};
+    std::optional<rls::ChannelConfig> channel{}; // radio channel emulation of the links to the cells
 
     struct
     {
@@ -204,6 +212,9 @@ struct TaskBase
     app::IUeController *ueController{};
     app::INodeListener *nodeListener{};
     NtsTask *cliCallbackTask{};
+    HeartbeatCoalescer *heartbeatCoalescer{}; // shared by the UEs of the process, if any
+    RlsEndpointTask *rlsEndpoint{};           // same
+    UserPlaneFastPath *fastPath{};
 
     UeSharedContext shCtx{};
 
@@ -10,6 +10,7 @@
 
 #include "app/task.hpp"
 #include "nas/task.hpp"
+#include "rls/fast_path.hpp"
 #include "rls/task.hpp"
 #include "rrc/task.hpp"
 
@@ -17,7 +18,8 @@ namespace nr::ue
 {
 
 UserEquipment::UserEquipment(UeConfig *config, app::IUeController *ueController, app::INodeListener *nodeListener,
-                             NtsTask *cliCallbackTask)
+                             NtsTask *cliCallbackTask, HeartbeatCoalescer *heartbeatCoalescer,
+                             RlsEndpointTask *rlsEndpoint)
 {
     auto *base = new TaskBase();
     base->ue = this;
@@ -26,6 +28,9 @@ UserEquipment::UserEquipment(UeConfig *config, app::IUeController *ueController,
     base->ueController = ueController;
     base->nodeListener = nodeListener;
     base->cliCallbackTask = cliCallbackTask;
+    base->heartbeatCoalescer = heartbeatCoalescer;
+    base->rlsEndpoint = rlsEndpoint;
+    base->fastPath = new UserPlaneFastPath();
 
     base->nasTask = new NasTask(base);
     base->rrcTask = new UeRrcTask(base);
@@ -47,6 +52,8 @@ UserEquipment::~UserEquipment()
     delete taskBase->rlsTask;
     delete taskBase->appTask;
 
+    delete taskBase->fastPath;
+
     delete taskBase->logBase;
 
     delete taskBase;
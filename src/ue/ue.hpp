@@ -25,7 +25,7 @@ class UserEquipment
 
   public:
     UserEquipment(UeConfig *config, app::IUeController *ueController, app::INodeListener *nodeListener,
-                  NtsTask *cliCallbackTask);
+                  NtsTask *cliCallbackTask, HeartbeatCoalescer *heartbeatCoalescer, RlsEndpointTask *rlsEndpoint);
     virtual ~UserEquipment();
 
   public:
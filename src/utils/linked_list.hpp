@@ -170,13 +170,8 @@ class LinkedList
 
     void clearAndDelete()
     {
-        auto cursor = getFirst();
-        while (cursor != nullptr)
-        {
-            T *value = remove(cursor);
-            delete value;
-            cursor = cursor->getNext();
-        }
+        while (!isEmpty())
+            delete removeFirst();
     }
 
     // Same with remove, but increments the cursor (as if not deleted)
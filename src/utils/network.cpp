@@ -9,6 +9,7 @@
 #include "network.hpp"
 #include "libc_error.hpp"
 
+#include <algorithm>
 #include <cstring>
 
 #include <arpa/inet.h>
@@ -19,6 +20,8 @@
 #include <sys/types.h>
 #include <unistd.h>
 
+static constexpr const size_t MAX_SEND_BATCH = 1024;
+
 static std::string OctetStringToIpString(const OctetString &address)
 {
     if (address.length() != 4 && address.length() != 16 && address.length() != 20)
@@ -112,6 +115,16 @@ uint16_t InetAddress::getPort() const
     return 0;
 }
 
+InetAddress InetAddress::withPort(uint16_t port) const
+{
+    InetAddress res = *this;
+    if (storage.ss_family == AF_INET)
+        reinterpret_cast<sockaddr_in &>(res.storage).sin_port = htons(port);
+    else if (storage.ss_family == AF_INET6)
+        reinterpret_cast<sockaddr_in6 &>(res.storage).sin6_port = htons(port);
+    return res;
+}
+
 Socket::Socket(int domain, int type, int protocol)
 {
     int sd = socket(domain, type, protocol);
@@ -191,11 +204,51 @@ void Socket::send(const InetAddress &address, const uint8_t *buffer, size_t size
     }
 }
 
+void Socket::sendBatch(const std::vector<const InetAddress *> &addresses, const uint8_t *buffer, size_t size) const
+{
+    // Same buffer for every destination, handed to the kernel in batches of at most MAX_SEND_BATCH messages
+    iovec iov{const_cast<uint8_t *>(buffer), size};
+
+    std::vector<mmsghdr> messages(std::min(addresses.size(), MAX_SEND_BATCH));
+    for (size_t start = 0; start < addresses.size(); start += messages.size())
+    {
+        size_t count = std::min(messages.size(), addresses.size() - start);
+        for (size_t i = 0; i < count; i++)
+        {
+            auto &hdr = messages[i].msg_hdr;
+            std::memset(&hdr, 0, sizeof(hdr));
+            hdr.msg_name = const_cast<sockaddr *>(addresses[start + i]->getSockAddr());
+            hdr.msg_namelen = addresses[start + i]->getSockLen();
+            hdr.msg_iov = &iov;
+            hdr.msg_iovlen = 1;
+        }
+
+        size_t sent = 0;
+        while (sent < count)
+        {
+            int rc = sendmmsg(fd, messages.data() + sent, static_cast<unsigned int>(count - sent), MSG_DONTWAIT);
+            if (rc == -1)
+            {
+                int err = errno;
+                if (err == EAGAIN)
+                    break; // the rest is dropped as it would be by sendto
+                throw LibError("sendmmsg failed: ", errno);
+            }
+            sent += static_cast<size_t>(rc);
+        }
+    }
+}
+
 bool Socket::hasFd() const
 {
     return fd >= 0;
 }
 
+int Socket::getFd() const
+{
+    return fd;
+}
+
 Socket Socket::CreateAndBindUdp(const InetAddress &address)
 {
     Socket s(address.getSockAddr()->sa_family, SOCK_DGRAM, IPPROTO_UDP);
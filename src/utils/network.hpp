@@ -40,6 +40,7 @@ struct InetAddress
 
     [[nodiscard]] int getIpVersion() const;
     [[nodiscard]] uint16_t getPort() const;
+    [[nodiscard]] InetAddress withPort(uint16_t port) const;
 };
 
 class Socket
@@ -56,8 +57,10 @@ class Socket
     void bind(const InetAddress &address) const;
     int receive(uint8_t *buffer, size_t bufferSize, int timeoutMs, InetAddress &outAddress) const;
     void send(const InetAddress &address, const uint8_t *buffer, size_t size) const;
+    void sendBatch(const std::vector<const InetAddress *> &addresses, const uint8_t *buffer, size_t size) const;
     void close();
     [[nodiscard]] bool hasFd() const;
+    [[nodiscard]] int getFd() const;
     [[nodiscard]] InetAddress getAddress() const;
     [[nodiscard]] int getIpVersion() const;
 
@@ -61,6 +61,7 @@ enum class NtsMessageType
     UE_NAS_TO_RLS,
 
     RGNB_RRC_TO_RRC,
+    RGNB_RLS_TO_RLS,
 };
 
 struct NtsMessage
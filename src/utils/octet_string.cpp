@@ -16,6 +16,11 @@ void OctetString::append(const OctetString &v)
     m_data.insert(m_data.end(), v.m_data.begin(), v.m_data.end());
 }
 
+void OctetString::append(const uint8_t *data, size_t length)
+{
+    m_data.insert(m_data.end(), data, data + length);
+}
+
 void OctetString::appendUtf8(const std::string &v)
 {
     m_data.insert(m_data.end(), v.begin(), v.end());
@@ -128,6 +133,11 @@ void OctetString::appendPadding(int length)
         appendOctet(0);
 }
 
+void OctetString::reserve(size_t capacity)
+{
+    m_data.reserve(capacity);
+}
+
 OctetString OctetString::FromHex(const std::string &hex)
 {
     return OctetString{utils::HexStringToVector(hex)};
@@ -35,6 +35,7 @@ class OctetString
 
   public:
     void append(const OctetString &v);
+    void append(const uint8_t *data, size_t length);
     void appendUtf8(const std::string &v);
     void appendOctet(uint8_t v);
     void appendOctet(int v);
@@ -51,6 +52,7 @@ class OctetString
     void appendOctet8(int64_t v);
     void appendOctet8(uint64_t v);
     void appendPadding(int length);
+    void reserve(size_t capacity);
 
   public:
     [[nodiscard]] const uint8_t *data() const;
@@ -17,7 +17,7 @@
 
 class OctetString;
 
-// TODO: add bound check
+// Reads are not bound checked, decoders of untrusted input check remaining() before reading
 class OctetView
 {
     const uint8_t *data;
@@ -123,6 +123,21 @@ class OctetView
         return index < size;
     }
 
+    inline size_t remaining() const
+    {
+        return size - index;
+    }
+
+    inline const uint8_t *current() const
+    {
+        return data + index;
+    }
+
+    inline void skip(size_t length) const
+    {
+        index += length;
+    }
+
     OctetString readOctetString(int length) const;
     OctetString readOctetString(size_t length) const;
     OctetString readOctetString() const;
@@ -142,6 +142,28 @@ int64_t GetInt64(const YAML::Node &node, const std::string &name, std::optional<
     return value;
 }
 
+double GetDouble(const YAML::Node &node, const std::string &name, std::optional<double> minValue,
+                 std::optional<double> maxValue)
+{
+    AssertHasField(node, name);
+
+    double value{};
+    try
+    {
+        value = node[name].as<double>();
+    }
+    catch (const std::runtime_error &e)
+    {
+        FieldError(name, "has invalid type");
+    }
+
+    if (minValue.has_value() && value < minValue)
+        FieldError(name, "is too small");
+    if (maxValue.has_value() && value > maxValue)
+        FieldError(name, "is too big");
+    return value;
+}
+
 std::string GetIpAddress(const YAML::Node &node, const std::string &name)
 {
     std::string s = GetString(node, name);